@@ -45,6 +45,8 @@
 #include <glib/gi18n-lib.h>
 #include <glib/gstdio.h>
 
+#include <gio/gio.h>
+
 #include "brasero-burn.h"
 
 #include "libbrasero-marshal.h"
@@ -66,6 +68,8 @@
 #include "brasero-track-image.h"
 #include "brasero-track-disc.h"
 #include "brasero-session-helper.h"
+#include "burn-fanout.h"
+#include "burn-image-cache.h"
 
 G_DEFINE_TYPE (BraseroBurn, brasero_burn, G_TYPE_OBJECT);
 
@@ -89,7 +93,41 @@ struct _BraseroBurnPrivate {
 	guint64 session_start;
 	guint64 session_end;
 
+	/* used when recording on several drives at once */
+	BraseroBurn *producer;
+	BraseroFanout *fanout;
+	GSList *branches;
+	GMainLoop *branches_loop;
+
+	/* image built for this burn that didn't fit in the cache */
+	gchar *uncached_image;
+
 	guint mounted_by_us:1;
+	guint cached_image:1;
+	guint branches_stopped:1;
+
+	/* set for the BraseroBurn objects that a burn runs itself */
+	guint internal:1;
+};
+
+typedef struct _BraseroBurnBranch BraseroBurnBranch;
+struct _BraseroBurnBranch {
+	BraseroBurn *parent;
+	BraseroBurn *burn;
+	BraseroBurnSession *session;
+	BraseroDrive *drive;
+	guint index;
+
+	guint start_id;
+	BraseroBurnResult result;
+	GError *error;
+
+	gdouble progress;
+	glong remaining;
+
+	guint started:1;
+	guint released:1;
+	guint done:1;
 };
 
 #define BRASERO_BURN_NOT_SUPPORTED_LOG(burn)					\
@@ -150,6 +188,9 @@ static guint brasero_burn_signals [LAST_SIGNAL] = { 0 };
 
 #define MOUNT_TIMEOUT		500
 
+/* Size of the ring buffer of each drive when recording on several drives */
+#define FANOUT_RING_SIZE	(32 * 1024 * 1024)
+
 static GObjectClass *parent_class = NULL;
 
 static void
@@ -284,6 +325,143 @@ brasero_burn_sleep (BraseroBurn *burn, gint msec)
 	return BRASERO_BURN_CANCEL;
 }
 
+static void
+brasero_burn_state_changed_cb (BraseroBurn *burn)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+
+	/* The timeout is removed by brasero_burn_sleep () */
+	if (priv->sleep_loop)
+		g_main_loop_quit (priv->sleep_loop);
+}
+
+/**
+ * Like brasero_burn_sleep () but returns as soon as the state of the drive
+ * changes: a probe finished, a medium was inserted or removed or a volume
+ * was (un)mounted. @msec is the longest time to wait then.
+ */
+static BraseroBurnResult
+brasero_burn_wait (BraseroBurn *burn,
+		   BraseroDrive *drive,
+		   gint msec)
+{
+	GVolumeMonitor *monitor;
+	BraseroMedium *medium;
+	BraseroBurnResult result;
+
+	if (!drive)
+		return brasero_burn_sleep (burn, msec);
+
+	/* Keep references in case they are removed while we wait */
+	g_object_ref (drive);
+	g_signal_connect_swapped (drive,
+				  "medium-added",
+				  G_CALLBACK (brasero_burn_state_changed_cb),
+				  burn);
+	g_signal_connect_swapped (drive,
+				  "medium-removed",
+				  G_CALLBACK (brasero_burn_state_changed_cb),
+				  burn);
+
+	medium = brasero_drive_get_medium (drive);
+	if (medium) {
+		g_object_ref (medium);
+		g_signal_connect_swapped (medium,
+					  "probed",
+					  G_CALLBACK (brasero_burn_state_changed_cb),
+					  burn);
+	}
+
+	monitor = g_volume_monitor_get ();
+	g_signal_connect_swapped (monitor,
+				  "mount-added",
+				  G_CALLBACK (brasero_burn_state_changed_cb),
+				  burn);
+	g_signal_connect_swapped (monitor,
+				  "mount-removed",
+				  G_CALLBACK (brasero_burn_state_changed_cb),
+				  burn);
+	g_signal_connect_swapped (monitor,
+				  "mount-changed",
+				  G_CALLBACK (brasero_burn_state_changed_cb),
+				  burn);
+	g_signal_connect_swapped (monitor,
+				  "drive-changed",
+				  G_CALLBACK (brasero_burn_state_changed_cb),
+				  burn);
+
+	result = brasero_burn_sleep (burn, msec);
+
+	g_signal_handlers_disconnect_by_func (monitor,
+					      brasero_burn_state_changed_cb,
+					      burn);
+	g_object_unref (monitor);
+
+	if (medium) {
+		g_signal_handlers_disconnect_by_func (medium,
+						      brasero_burn_state_changed_cb,
+						      burn);
+		g_object_unref (medium);
+	}
+
+	g_signal_handlers_disconnect_by_func (drive,
+					      brasero_burn_state_changed_cb,
+					      burn);
+	g_object_unref (drive);
+
+	return result;
+}
+
+typedef gboolean (*BraseroBurnWaitFunc) (gpointer data);
+
+/**
+ * brasero_burn_wait () returns on any change, even unrelated ones (another
+ * device that was mounted for example). This waits for the whole @msec unless
+ * @done returns TRUE so that retry loops keep their intended grace period.
+ */
+
+static BraseroBurnResult
+brasero_burn_wait_until (BraseroBurn *burn,
+			 BraseroDrive *drive,
+			 gint msec,
+			 BraseroBurnWaitFunc done,
+			 gpointer data)
+{
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	GTimer *timer;
+
+	timer = g_timer_new ();
+	while (!done (data)) {
+		gint left;
+
+		left = msec - g_timer_elapsed (timer, NULL) * 1000.0;
+		if (left <= 0)
+			break;
+
+		result = brasero_burn_wait (burn, drive, left);
+		if (result != BRASERO_BURN_OK)
+			break;
+	}
+	g_timer_destroy (timer);
+
+	return result;
+}
+
+static gboolean
+brasero_burn_medium_unmounted (gpointer data)
+{
+	return !brasero_volume_is_mounted (BRASERO_VOLUME (data));
+}
+
+static gboolean
+brasero_burn_drive_ejected (gpointer data)
+{
+	BraseroDrive *drive = data;
+
+	/* A probe is handled by the caller */
+	return (!brasero_drive_get_medium (drive) || brasero_drive_probing (drive));
+}
+
 static BraseroBurnResult
 brasero_burn_reprobe (BraseroBurn *burn)
 {
@@ -297,7 +475,7 @@ brasero_burn_reprobe (BraseroBurn *burn)
 	/* reprobe the medium and wait for it to be probed */
 	brasero_drive_reprobe (priv->dest);
 	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 250);
+		result = brasero_burn_wait (burn, priv->dest, 250);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -343,7 +521,11 @@ brasero_burn_unmount (BraseroBurn *self,
 			g_error_free (ret_error);
 		}
 
-		result = brasero_burn_sleep (self, 500);
+		result = brasero_burn_wait_until (self,
+						  brasero_medium_get_drive (medium),
+						  500,
+						  brasero_burn_medium_unmounted,
+						  medium);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -419,7 +601,7 @@ brasero_burn_eject (BraseroBurn *self,
 
 		/* Don't interrupt a probe */
 		if (brasero_drive_probing (drive)) {
-			result = brasero_burn_sleep (self, 500);
+			result = brasero_burn_wait (self, drive, 500);
 			if (result != BRASERO_BURN_OK)
 				return result;
 
@@ -449,7 +631,11 @@ brasero_burn_eject (BraseroBurn *self,
 			g_error_free (ret_error);
 		}
 
-		result = brasero_burn_sleep (self, 500);
+		result = brasero_burn_wait_until (self,
+						  drive,
+						  500,
+						  brasero_burn_drive_ejected,
+						  drive);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -591,7 +777,7 @@ brasero_burn_lock_src_media (BraseroBurn *burn,
 again:
 
 	while (brasero_drive_probing (priv->src)) {
-		result = brasero_burn_sleep (burn, 500);
+		result = brasero_burn_wait (burn, priv->src, 500);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -682,7 +868,7 @@ brasero_burn_lock_rewritable_media (BraseroBurn *burn,
  again:
 
 	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 500);
+		result = brasero_burn_wait (burn, priv->dest, 500);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -774,7 +960,7 @@ brasero_burn_lock_dest_media (BraseroBurn *burn,
 	/* NOTE: don't lock the drive here yet as
 	 * otherwise we'd be probing forever. */
 	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 500);
+		result = brasero_burn_wait (burn, priv->dest, 500);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -940,7 +1126,7 @@ brasero_burn_lock_checksum_media (BraseroBurn *burn,
 again:
 
 	while (brasero_drive_probing (priv->dest)) {
-		result = brasero_burn_sleep (burn, 500);
+		result = brasero_burn_wait (burn, priv->dest, 500);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -1219,6 +1405,45 @@ brasero_burn_status (BraseroBurn *burn,
 	return BRASERO_BURN_OK;
 }
 
+/**
+ * brasero_burn_get_rate_estimate:
+ * @burn: a #BraseroBurn
+ * @smoothed: a #guint64 or NULL
+ * @instant: a #guint64 or NULL
+ * @confidence: a #gdouble or NULL
+ *
+ * Returns the rate (in bytes per second) at which data are written, both
+ * @smoothed over the last seconds and @instant (between the two last
+ * progress updates). @confidence ranges from 0.0 to 1.0 and tells how
+ * steady the rate has been, which is also how much the remaining time
+ * reported with #BraseroBurn::progress-changed can be trusted.
+ *
+ * Return value: a #BraseroBurnResult. BRASERO_BURN_OK if there is
+ * an ongoing operation with enough progress information;
+ * BRASERO_BURN_NOT_READY otherwise.
+ **/
+
+BraseroBurnResult
+brasero_burn_get_rate_estimate (BraseroBurn *burn,
+				guint64 *smoothed,
+				guint64 *instant,
+				gdouble *confidence)
+{
+	BraseroBurnPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_BURN (burn), BRASERO_BURN_ERR);
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+
+	if (!priv->task || !brasero_task_is_running (priv->task))
+		return BRASERO_BURN_NOT_READY;
+
+	return brasero_task_ctx_get_rate_estimate (BRASERO_TASK_CTX (priv->task),
+						   smoothed,
+						   instant,
+						   confidence);
+}
+
 static BraseroBurnResult
 brasero_burn_ask_for_joliet (BraseroBurn *burn)
 {
@@ -1364,6 +1589,13 @@ start:
 	if (!ret_error)
 		return result;
 
+	/* Internal burns can neither change their output nor the contents:
+	 * the BraseroBurn that started them deals with the error. */
+	if (priv->internal) {
+		g_propagate_error (error, ret_error);
+		return BRASERO_BURN_ERR;
+	}
+
 	if (brasero_burn_session_is_dest_file (priv->session)) {
 		gchar *image = NULL;
 		gchar *toc = NULL;
@@ -1460,8 +1692,8 @@ brasero_burn_can_use_drive_exclusively (BraseroBurn *burn,
 		return BRASERO_BURN_OK;
 
 	while (!brasero_drive_can_use_exclusively (drive)) {
-		BRASERO_BURN_LOG ("Device busy, retrying in 250 ms");
-		result = brasero_burn_sleep (burn, 250);
+		BRASERO_BURN_LOG ("Device busy, retrying in 250 ms at most");
+		result = brasero_burn_wait (burn, drive, 250);
 		if (result != BRASERO_BURN_OK)
 			return result;
 	}
@@ -2750,6 +2982,166 @@ again:
  * BRASERO_BURN_OK if it was successful.
  **/
 
+static BraseroBurn *
+brasero_burn_new_internal (BraseroBurn *parent);
+
+static void
+brasero_burn_image_cache_progress_cb (BraseroBurn *builder,
+				      gdouble overall_progress,
+				      gdouble action_progress,
+				      glong remaining,
+				      BraseroBurn *burn)
+{
+	g_signal_emit (burn,
+		       brasero_burn_signals [PROGRESS_CHANGED_SIGNAL],
+		       0,
+		       overall_progress,
+		       action_progress,
+		       remaining);
+}
+
+static void
+brasero_burn_image_cache_action_cb (BraseroBurn *builder,
+				    BraseroBurnAction action,
+				    BraseroBurn *burn)
+{
+	if (action != BRASERO_BURN_ACTION_FINISHED)
+		brasero_burn_action_changed_real (burn, action);
+}
+
+/**
+ * When the image of a data session is cached, it replaces the contents of
+ * the session until the end of the recording. On a miss, the image is built
+ * into the cache first by another BraseroBurn object.
+ */
+
+static BraseroBurnResult
+brasero_burn_use_image_cache (BraseroBurn *burn,
+			      GError **error)
+{
+	BraseroBurnSession *session;
+	BraseroBurnResult result;
+	BraseroBurnPrivate *priv;
+	BraseroTrackImage *track;
+	GError *ret_error = NULL;
+	BraseroBurn *builder;
+	struct stat info;
+	GSList *iter;
+	gchar *image;
+	gchar *key;
+	gchar *tmp;
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+
+	/* The image depends on the previous sessions of the medium then */
+	if (brasero_burn_session_get_flags (priv->session) & (BRASERO_BURN_FLAG_MERGE|BRASERO_BURN_FLAG_APPEND))
+		return BRASERO_BURN_OK;
+
+	key = brasero_image_cache_get_key (priv->session);
+	if (!key)
+		return BRASERO_BURN_OK;
+
+	image = brasero_image_cache_lookup (key);
+	if (image) {
+		BRASERO_BURN_DEBUG (burn, "Using cached image %s", image);
+		goto use_image;
+	}
+
+	tmp = brasero_image_cache_get_tmp_path (key);
+	if (!tmp) {
+		g_free (key);
+		return BRASERO_BURN_OK;
+	}
+
+	BRASERO_BURN_DEBUG (burn, "Building image %s for cache", tmp);
+
+	session = brasero_burn_session_new ();
+	brasero_burn_session_set_tmpdir (session, brasero_burn_session_get_tmpdir (priv->session));
+	brasero_burn_session_set_label (session, brasero_burn_session_get_label (priv->session));
+	for (iter = brasero_burn_session_get_tracks (priv->session); iter; iter = iter->next)
+		brasero_burn_session_add_track (session, iter->data, NULL);
+
+	brasero_burn_session_set_image_output_full (session,
+						    BRASERO_IMAGE_FORMAT_BIN,
+						    tmp,
+						    NULL);
+
+	builder = brasero_burn_new_internal (burn);
+	g_signal_connect (builder,
+			  "progress_changed",
+			  G_CALLBACK (brasero_burn_image_cache_progress_cb),
+			  burn);
+	g_signal_connect (builder,
+			  "action_changed",
+			  G_CALLBACK (brasero_burn_image_cache_action_cb),
+			  burn);
+
+	result = brasero_burn_record (builder, session, &ret_error);
+
+	g_signal_handlers_disconnect_matched (builder,
+					      G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL,
+					      burn);
+	g_object_unref (builder);
+	g_object_unref (session);
+
+	if (result != BRASERO_BURN_OK) {
+		g_remove (tmp);
+		g_free (tmp);
+		g_free (key);
+
+		if (result == BRASERO_BURN_CANCEL) {
+			g_propagate_error (error, ret_error);
+			return result;
+		}
+
+		/* Burn on the fly instead; the errors the builder can't
+		 * recover from on its own (Joliet, disk space) are then
+		 * dealt with as usual. */
+		BRASERO_BURN_DEBUG (burn,
+				    "Image for cache could not be built (%s); burning without cache",
+				    ret_error ? ret_error->message : "unknown error");
+		if (ret_error)
+			g_error_free (ret_error);
+
+		brasero_burn_action_changed_real (burn, BRASERO_BURN_ACTION_PREPARING);
+		return BRASERO_BURN_OK;
+	}
+
+	image = brasero_image_cache_add (key, tmp);
+	if (!image) {
+		/* Use it anyway but remove it afterwards */
+		priv->uncached_image = g_strdup (tmp);
+		image = tmp;
+		tmp = NULL;
+	}
+	g_free (tmp);
+
+use_image:
+
+	g_free (key);
+
+	if (g_stat (image, &info)) {
+		g_free (image);
+		return BRASERO_BURN_OK;
+	}
+
+	brasero_burn_session_push_tracks (priv->session);
+
+	track = brasero_track_image_new ();
+	brasero_track_image_set_source (track,
+					image,
+					NULL,
+					BRASERO_IMAGE_FORMAT_BIN);
+	brasero_track_image_set_block_num (track, BRASERO_BYTES_TO_SECTORS (info.st_size, 2048));
+	brasero_burn_session_add_track (priv->session, BRASERO_TRACK (track), NULL);
+	g_object_unref (track);
+	g_free (image);
+
+	priv->cached_image = TRUE;
+	return BRASERO_BURN_OK;
+}
+
 BraseroBurnResult 
 brasero_burn_record (BraseroBurn *burn,
 		     BraseroBurnSession *session,
@@ -2821,6 +3213,12 @@ brasero_burn_record (BraseroBurn *burn,
 		if (result != BRASERO_BURN_OK)
 			goto end;
 	}
+	else if (brasero_track_type_get_has_data (type)
+	     && !brasero_burn_session_is_dest_file (session)) {
+		result = brasero_burn_use_image_cache (burn, error);
+		if (result != BRASERO_BURN_OK)
+			goto end;
+	}
 
 	/* burn the session except if dummy session */
 	result = brasero_burn_record_session (burn, TRUE, NULL, error);
@@ -2866,6 +3264,17 @@ end:
 
 	brasero_burn_powermanagement (burn, FALSE);
 
+	if (priv->cached_image) {
+		brasero_burn_session_pop_tracks (priv->session);
+		priv->cached_image = FALSE;
+	}
+
+	if (priv->uncached_image) {
+		g_remove (priv->uncached_image);
+		g_free (priv->uncached_image);
+		priv->uncached_image = NULL;
+	}
+
 	/* release session */
 	g_object_unref (priv->session);
 	priv->session = NULL;
@@ -2873,6 +3282,686 @@ end:
 	return result;
 }
 
+/**
+ * Recording on several drives at once.
+ * The data are produced once (image builder, transcoder or source disc
+ * reader) into a named pipe and copied by a BraseroFanout object into one
+ * named pipe per drive, each one read by a separate BraseroBurn recording a
+ * BIN image. The recorders are started from the main loop while the producer
+ * runs so all these operations run concurrently in nested main loops.
+ * Since a nested loop only returns once those above it have, nothing may
+ * wait below another operation: the first recorder is started once the
+ * producer has passed all its own waits (it sent its first bytes) and each
+ * following one once the previous one is actually recording.
+ */
+
+static void
+brasero_burn_fanout_report_progress (BraseroBurn *burn)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+	gdouble progress = 1.0;
+	glong remaining = -1;
+	GSList *iter;
+
+	/* The set is as far as its slowest drive */
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+
+		if (branch->done && branch->result != BRASERO_BURN_OK)
+			continue;
+
+		progress = MIN (progress, MAX (branch->progress, 0.0));
+		remaining = MAX (remaining, branch->remaining);
+	}
+
+	g_signal_emit (burn,
+		       brasero_burn_signals [PROGRESS_CHANGED_SIGNAL],
+		       0,
+		       progress,
+		       progress,
+		       remaining);
+}
+
+static void
+brasero_burn_branch_progress_cb (BraseroBurn *burn,
+				 gdouble overall_progress,
+				 gdouble action_progress,
+				 glong remaining,
+				 BraseroBurnBranch *branch)
+{
+	branch->progress = overall_progress;
+	branch->remaining = remaining;
+	brasero_burn_fanout_report_progress (branch->parent);
+}
+
+static gboolean
+brasero_burn_branch_start (gpointer data);
+
+static gboolean
+brasero_burn_branches_done (BraseroBurn *burn)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+	GSList *iter;
+
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+
+		if (branch->started && !branch->done)
+			return FALSE;
+
+		if (!branch->started && !priv->branches_stopped)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+brasero_burn_branch_start_next (BraseroBurn *burn)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+	GSList *iter;
+
+	if (priv->branches_stopped)
+		return;
+
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+
+		/* Still waiting for this one to start recording */
+		if (branch->start_id || (branch->started && !branch->released))
+			return;
+
+		if (!branch->started) {
+			branch->start_id = g_idle_add (brasero_burn_branch_start, branch);
+			return;
+		}
+	}
+}
+
+static void
+brasero_burn_branch_stop (BraseroBurn *burn)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+	GSList *iter;
+
+	/* The recorders not started yet won't be */
+	priv->branches_stopped = TRUE;
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+
+		if (branch->start_id) {
+			g_source_remove (branch->start_id);
+			branch->start_id = 0;
+		}
+	}
+
+	if (priv->branches_loop && brasero_burn_branches_done (burn))
+		g_main_loop_quit (priv->branches_loop);
+}
+
+static void
+brasero_burn_branch_action_cb (BraseroBurn *burn,
+			       BraseroBurnAction action,
+			       BraseroBurnBranch *branch)
+{
+	/* Only the first drive tells the action so it does not flicker */
+	if (!branch->index && action != BRASERO_BURN_ACTION_FINISHED)
+		brasero_burn_action_changed_real (branch->parent, action);
+
+	/* Once its job runs it has passed all its waits (unmounting,
+	 * locking, asking for a disc) and the next one can start */
+	if (branch->released)
+		return;
+
+	if (action == BRASERO_BURN_ACTION_START_RECORDING
+	||  action == BRASERO_BURN_ACTION_RECORDING
+	||  action == BRASERO_BURN_ACTION_BLANKING
+	||  action == BRASERO_BURN_ACTION_LEADIN) {
+		branch->released = TRUE;
+		brasero_burn_branch_start_next (branch->parent);
+	}
+}
+
+static BraseroBurnResult
+brasero_burn_branch_insert_media_cb (BraseroBurn *burn,
+				     BraseroDrive *drive,
+				     BraseroBurnError error,
+				     BraseroMedia required_media,
+				     BraseroBurn *parent)
+{
+	return brasero_burn_ask_for_media (parent, drive, error, required_media, NULL);
+}
+
+static BraseroBurnResult
+brasero_burn_branch_eject_failure_cb (BraseroBurn *burn,
+				      BraseroDrive *drive,
+				      BraseroBurn *parent)
+{
+	return brasero_burn_emit_eject_failure_signal (parent, drive);
+}
+
+static BraseroBurnResult
+brasero_burn_branch_data_loss_cb (BraseroBurn *burn,
+				  BraseroBurn *parent)
+{
+	return brasero_burn_emit_signal (parent, WARN_DATA_LOSS_SIGNAL, BRASERO_BURN_CANCEL);
+}
+
+static BraseroBurnResult
+brasero_burn_branch_previous_session_loss_cb (BraseroBurn *burn,
+					      BraseroBurn *parent)
+{
+	return brasero_burn_emit_signal (parent, WARN_PREVIOUS_SESSION_LOSS_SIGNAL, BRASERO_BURN_CANCEL);
+}
+
+static BraseroBurnResult
+brasero_burn_branch_rewritable_cb (BraseroBurn *burn,
+				   BraseroBurn *parent)
+{
+	return brasero_burn_emit_signal (parent, WARN_REWRITABLE_SIGNAL, BRASERO_BURN_CANCEL);
+}
+
+static BraseroBurnResult
+brasero_burn_branch_blank_failure_cb (BraseroBurn *burn,
+				      BraseroBurn *parent)
+{
+	return brasero_burn_emit_signal (parent, BLANK_FAILURE_SIGNAL, BRASERO_BURN_ERR);
+}
+
+/**
+ * The questions asked by internal burns are asked to the user through their
+ * parent, except those about the contents (disabling Joliet) or the output
+ * (another location): these internal burns fail and their parent decides.
+ */
+
+static BraseroBurn *
+brasero_burn_new_internal (BraseroBurn *parent)
+{
+	BraseroBurnPrivate *priv;
+	BraseroBurn *burn;
+
+	burn = brasero_burn_new ();
+	priv = BRASERO_BURN_PRIVATE (burn);
+	priv->internal = TRUE;
+
+	g_signal_connect (burn,
+			  "insert_media",
+			  G_CALLBACK (brasero_burn_branch_insert_media_cb),
+			  parent);
+	g_signal_connect (burn,
+			  "eject_failure",
+			  G_CALLBACK (brasero_burn_branch_eject_failure_cb),
+			  parent);
+	g_signal_connect (burn,
+			  "warn_data_loss",
+			  G_CALLBACK (brasero_burn_branch_data_loss_cb),
+			  parent);
+	g_signal_connect (burn,
+			  "warn_previous_session_loss",
+			  G_CALLBACK (brasero_burn_branch_previous_session_loss_cb),
+			  parent);
+	g_signal_connect (burn,
+			  "warn_rewritable",
+			  G_CALLBACK (brasero_burn_branch_rewritable_cb),
+			  parent);
+	g_signal_connect (burn,
+			  "blank_failure",
+			  G_CALLBACK (brasero_burn_branch_blank_failure_cb),
+			  parent);
+	return burn;
+}
+
+static gboolean
+brasero_burn_fanout_source_started (gpointer data)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (data);
+	BraseroBurnPrivate *producer_priv;
+	goffset blocks = 0;
+	goffset bytes = 0;
+	GSList *iter;
+
+	/* The producer job writing to the fan-out is running. Its size was
+	 * computed by its fake run, which unlike the session estimate is
+	 * exact; the recorders must know it before they start. */
+	producer_priv = BRASERO_BURN_PRIVATE (priv->producer);
+	if (producer_priv->task)
+		brasero_task_ctx_get_session_output_size (BRASERO_TASK_CTX (producer_priv->task),
+							  &blocks,
+							  &bytes);
+
+	if (blocks <= 0 || bytes <= 0) {
+		BRASERO_BURN_LOG ("Producer size unknown; cancelling");
+		brasero_burn_branch_stop (data);
+		brasero_burn_cancel (priv->producer, FALSE);
+		return FALSE;
+	}
+
+	BRASERO_BURN_LOG ("Producer started (%lli blocks, %lli bytes)",
+			  (long long int) blocks,
+			  (long long int) bytes);
+
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+		GSList *tracks;
+
+		tracks = brasero_burn_session_get_tracks (branch->session);
+		brasero_track_image_set_block_num (BRASERO_TRACK_IMAGE (tracks->data), blocks);
+	}
+
+	brasero_fanout_set_size (priv->fanout, bytes);
+	brasero_burn_branch_start_next (data);
+	return FALSE;
+}
+
+static gboolean
+brasero_burn_fanout_source_failed (gpointer data)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (data);
+	GSList *iter;
+
+	/* The recorders must not finish a track with missing data */
+	BRASERO_BURN_LOG ("Producer failed; cancelling recorders");
+	brasero_burn_branch_stop (data);
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+
+		if (branch->started && !branch->done)
+			brasero_burn_cancel (branch->burn, FALSE);
+	}
+
+	return FALSE;
+}
+
+static gboolean
+brasero_burn_branch_start (gpointer data)
+{
+	BraseroBurnBranch *branch = data;
+	BraseroBurnPrivate *priv;
+
+	branch->start_id = 0;
+	branch->started = TRUE;
+
+	priv = BRASERO_BURN_PRIVATE (branch->parent);
+
+	BRASERO_BURN_LOG ("Starting recorder %i", branch->index);
+	branch->result = brasero_burn_record (branch->burn,
+					      branch->session,
+					      &branch->error);
+	branch->done = TRUE;
+
+	BRASERO_BURN_LOG ("Recorder %i finished (%i)", branch->index, branch->result);
+
+	/* Let the fan-out skip this drive from now on */
+	if (priv->fanout)
+		brasero_fanout_close_output (priv->fanout, branch->index);
+
+	brasero_burn_fanout_report_progress (branch->parent);
+
+	if (!branch->released) {
+		branch->released = TRUE;
+		brasero_burn_branch_start_next (branch->parent);
+	}
+
+	if (priv->branches_loop && brasero_burn_branches_done (branch->parent))
+		g_main_loop_quit (priv->branches_loop);
+
+	return FALSE;
+}
+
+static BraseroBurnBranch *
+brasero_burn_branch_new (BraseroBurn *parent,
+			 BraseroBurnSession *session,
+			 BraseroDrive *drive,
+			 guint index)
+{
+	BraseroBurnBranch *branch;
+
+	branch = g_new0 (BraseroBurnBranch, 1);
+	branch->parent = parent;
+	branch->index = index;
+	branch->progress = -1.0;
+	branch->remaining = -1;
+	branch->result = BRASERO_BURN_CANCEL;
+
+	branch->drive = g_object_ref (drive);
+
+	branch->session = brasero_burn_session_new ();
+	brasero_burn_session_set_burner (branch->session, drive);
+	brasero_burn_session_set_flags (branch->session,
+					brasero_burn_session_get_flags (session));
+	brasero_burn_session_set_rate (branch->session,
+				       brasero_burn_session_get_rate (session));
+	brasero_burn_session_set_tmpdir (branch->session,
+					 brasero_burn_session_get_tmpdir (session));
+	brasero_burn_session_set_label (branch->session,
+					brasero_burn_session_get_label (session));
+
+	branch->burn = brasero_burn_new_internal (parent);
+	g_signal_connect (branch->burn,
+			  "progress_changed",
+			  G_CALLBACK (brasero_burn_branch_progress_cb),
+			  branch);
+	g_signal_connect (branch->burn,
+			  "action_changed",
+			  G_CALLBACK (brasero_burn_branch_action_cb),
+			  branch);
+	return branch;
+}
+
+static void
+brasero_burn_branch_free (BraseroBurnBranch *branch)
+{
+	if (branch->start_id)
+		g_source_remove (branch->start_id);
+
+	if (branch->error)
+		g_error_free (branch->error);
+
+	g_signal_handlers_disconnect_matched (branch->burn,
+					      G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL,
+					      branch);
+	g_signal_handlers_disconnect_matched (branch->burn,
+					      G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL,
+					      branch->parent);
+	g_object_unref (branch->burn);
+	g_object_unref (branch->session);
+	g_object_unref (branch->drive);
+	g_free (branch);
+}
+
+/**
+ * brasero_burn_record_drives:
+ * @burn: a #BraseroBurn
+ * @session: a #BraseroBurnSession
+ * @drives: a #GSList of #BraseroDrive
+ * @error: a #GError
+ *
+ * Records the contents of @session on all the drives in @drives at the
+ * same time. The data are produced only once even when they need to be
+ * built (data projects) or read from a disc; audio and video projects are
+ * not supported.
+ * The burner set in @session is ignored. The progress reported is the one
+ * of the slowest drive; brasero_burn_get_drive_status () returns the status
+ * of each drive. If some drives fail, the first error is returned.
+ *
+ * Return value: a #BraseroBurnResult. The result of the operation. 
+ * BRASERO_BURN_OK if it was successful.
+ **/
+
+BraseroBurnResult
+brasero_burn_record_drives (BraseroBurn *burn,
+			    BraseroBurnSession *session,
+			    GSList *drives,
+			    GError **error)
+{
+	BraseroBurnSession *producer_session = NULL;
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	BraseroTrackType *type = NULL;
+	BraseroBurnResult producer_result;
+	BraseroBurnPrivate *priv;
+	GError *ret_error = NULL;
+	gchar *tmpdir = NULL;
+	GSList *tracks;
+	GSList *iter;
+	guint i;
+
+	g_return_val_if_fail (BRASERO_IS_BURN (burn), BRASERO_BURN_ERR);
+	g_return_val_if_fail (BRASERO_IS_BURN_SESSION (session), BRASERO_BURN_ERR);
+	g_return_val_if_fail (drives != NULL, BRASERO_BURN_ERR);
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+
+	if (!drives->next) {
+		brasero_burn_session_set_burner (session, drives->data);
+		return brasero_burn_record (burn, session, error);
+	}
+
+	type = brasero_track_type_new ();
+	brasero_burn_session_get_input_type (session, type);
+
+	if (brasero_track_type_get_has_stream (type)
+	|| (brasero_burn_session_get_flags (session) & (BRASERO_BURN_FLAG_DUMMY|BRASERO_BURN_FLAG_MERGE))) {
+		brasero_track_type_free (type);
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s", _("This project cannot be recorded on several drives at once"));
+		return BRASERO_BURN_NOT_SUPPORTED;
+	}
+
+	g_object_ref (session);
+	priv->session = session;
+
+	brasero_burn_powermanagement (burn, TRUE);
+	brasero_burn_action_changed_real (burn, BRASERO_BURN_ACTION_PREPARING);
+
+	/* An image can be read by all the recorders directly */
+	if (!brasero_track_type_get_has_image (type)) {
+		result = brasero_burn_session_get_tmp_dir (session, &tmpdir, error);
+		if (result != BRASERO_BURN_OK)
+			goto end;
+
+		priv->fanout = brasero_fanout_new (tmpdir,
+						   g_slist_length (drives),
+						   FANOUT_RING_SIZE,
+						   error);
+		g_free (tmpdir);
+
+		if (!priv->fanout) {
+			result = BRASERO_BURN_ERR;
+			goto end;
+		}
+
+		producer_session = brasero_burn_session_new ();
+		brasero_burn_session_set_tmpdir (producer_session,
+						 brasero_burn_session_get_tmpdir (session));
+		brasero_burn_session_set_label (producer_session,
+						brasero_burn_session_get_label (session));
+		brasero_burn_session_set_image_output_full (producer_session,
+							    BRASERO_IMAGE_FORMAT_BIN,
+							    brasero_fanout_get_source (priv->fanout),
+							    NULL);
+
+		priv->producer = brasero_burn_new_internal (burn);
+	}
+
+	tracks = brasero_burn_session_get_tracks (session);
+	for (iter = drives, i = 0; iter; iter = iter->next, i ++) {
+		BraseroBurnBranch *branch;
+		GSList *track_iter;
+
+		branch = brasero_burn_branch_new (burn, session, iter->data, i);
+		priv->branches = g_slist_append (priv->branches, branch);
+
+		if (!priv->fanout) {
+			for (track_iter = tracks; track_iter; track_iter = track_iter->next)
+				brasero_burn_session_add_track (branch->session,
+								track_iter->data,
+								NULL);
+		}
+		else {
+			BraseroTrackImage *track;
+
+			/* Its size is set once the producer knows it */
+			track = brasero_track_image_new ();
+			brasero_track_image_set_source (track,
+							brasero_fanout_get_output (priv->fanout, i),
+							NULL,
+							BRASERO_IMAGE_FORMAT_BIN);
+			brasero_burn_session_add_track (branch->session,
+							BRASERO_TRACK (track),
+							NULL);
+			g_object_unref (track);
+		}
+	}
+
+	if (priv->fanout) {
+		for (iter = tracks; iter; iter = iter->next)
+			brasero_burn_session_add_track (producer_session, iter->data, NULL);
+
+		result = brasero_fanout_start (priv->fanout,
+					       brasero_burn_fanout_source_started,
+					       brasero_burn_fanout_source_failed,
+					       burn,
+					       error);
+		if (result != BRASERO_BURN_OK)
+			goto end;
+	}
+
+	/* The recorders are started from the main loop, one after the other;
+	 * the first one once the producer has started writing, if any. They
+	 * run in the nested loop of the producer, of the previous recorder or
+	 * in the one below once they have returned. */
+	if (priv->producer) {
+		producer_result = brasero_burn_record (priv->producer,
+						       producer_session,
+						       &ret_error);
+		BRASERO_BURN_LOG ("Producer finished (%i)", producer_result);
+		if (producer_result != BRASERO_BURN_OK)
+			brasero_burn_branch_stop (burn);
+	}
+	else {
+		brasero_burn_branch_start_next (burn);
+		producer_result = BRASERO_BURN_OK;
+	}
+
+	if (!brasero_burn_branches_done (burn)) {
+		priv->branches_loop = g_main_loop_new (NULL, FALSE);
+		g_main_loop_run (priv->branches_loop);
+		g_main_loop_unref (priv->branches_loop);
+		priv->branches_loop = NULL;
+	}
+
+	result = producer_result;
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+
+		if (!branch->started)
+			continue;
+
+		if (branch->result == BRASERO_BURN_OK)
+			continue;
+
+		BRASERO_BURN_LOG ("Recording on drive %i failed", branch->index);
+		if (result == BRASERO_BURN_OK)
+			result = branch->result;
+
+		if (!ret_error && branch->error) {
+			ret_error = branch->error;
+			branch->error = NULL;
+		}
+	}
+
+	if (result != BRASERO_BURN_OK && ret_error) {
+		g_propagate_error (error, ret_error);
+		ret_error = NULL;
+	}
+
+end:
+
+	if (ret_error)
+		g_error_free (ret_error);
+
+	if (priv->fanout) {
+		brasero_fanout_free (priv->fanout);
+		priv->fanout = NULL;
+	}
+
+	if (priv->producer) {
+		g_signal_handlers_disconnect_matched (priv->producer,
+						      G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL,
+						      burn);
+		g_object_unref (priv->producer);
+		priv->producer = NULL;
+	}
+
+	if (producer_session)
+		g_object_unref (producer_session);
+
+	g_slist_foreach (priv->branches, (GFunc) brasero_burn_branch_free, NULL);
+	g_slist_free (priv->branches);
+	priv->branches = NULL;
+	priv->branches_stopped = FALSE;
+
+	brasero_track_type_free (type);
+
+	if (result == BRASERO_BURN_OK)
+		brasero_burn_action_changed_real (burn, BRASERO_BURN_ACTION_FINISHED);
+
+	brasero_burn_powermanagement (burn, FALSE);
+
+	g_object_unref (priv->session);
+	priv->session = NULL;
+
+	return result;
+}
+
+/**
+ * brasero_burn_get_drive_status:
+ * @burn: a #BraseroBurn
+ * @drive: a #BraseroDrive
+ * @progress: a #gdouble or NULL
+ * @written: a #goffset or NULL
+ * @buffer_fill: a #gdouble or NULL
+ *
+ * Returns the status of one of the drives being recorded by
+ * brasero_burn_record_drives (): its progress (@progress), the number of
+ * bytes passed to its recorder (@written) and how full the buffer holding
+ * the data waiting to be recorded on this drive is (@buffer_fill, between
+ * 0.0 and 1.0).
+ *
+ * Return value: a #BraseroBurnResult. BRASERO_BURN_OK if the drive is
+ * being recorded, BRASERO_BURN_ERR if recording it failed,
+ * BRASERO_BURN_NOT_RUNNING otherwise.
+ **/
+
+BraseroBurnResult
+brasero_burn_get_drive_status (BraseroBurn *burn,
+			       BraseroDrive *drive,
+			       gdouble *progress,
+			       goffset *written,
+			       gdouble *buffer_fill)
+{
+	BraseroBurnPrivate *priv;
+	GSList *iter;
+
+	g_return_val_if_fail (BRASERO_IS_BURN (burn), BRASERO_BURN_ERR);
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+	for (iter = priv->branches; iter; iter = iter->next) {
+		BraseroBurnBranch *branch = iter->data;
+
+		if (branch->drive != drive)
+			continue;
+
+		if (progress)
+			*progress = branch->progress;
+
+		if (written)
+			*written = 0;
+		if (buffer_fill)
+			*buffer_fill = 0.0;
+
+		if (priv->fanout
+		&&  brasero_fanout_get_status (priv->fanout,
+					       branch->index,
+					       written,
+					       buffer_fill) != BRASERO_BURN_OK)
+			return BRASERO_BURN_ERR;
+
+		if (branch->done && branch->result != BRASERO_BURN_OK)
+			return BRASERO_BURN_ERR;
+
+		return BRASERO_BURN_OK;
+	}
+
+	return BRASERO_BURN_NOT_RUNNING;
+}
+
 static BraseroBurnResult
 brasero_burn_blank_real (BraseroBurn *burn, GError **error)
 {
@@ -3026,6 +4115,35 @@ brasero_burn_cancel (BraseroBurn *burn, gboolean protect)
 	if (priv->task && brasero_task_is_running (priv->task))
 		result = brasero_task_cancel (priv->task, protect);
 
+	if (priv->branches) {
+		GSList *iter;
+
+		/* Either all drives are cancelled or none */
+		for (iter = priv->branches; protect && iter; iter = iter->next) {
+			BraseroBurnBranch *branch = iter->data;
+			BraseroBurnPrivate *branch_priv;
+
+			if (!branch->started || branch->done)
+				continue;
+
+			branch_priv = BRASERO_BURN_PRIVATE (branch->burn);
+			if (branch_priv->task
+			&&  brasero_task_ctx_get_dangerous (BRASERO_TASK_CTX (branch_priv->task)))
+				return BRASERO_BURN_DANGEROUS;
+		}
+
+		brasero_burn_branch_stop (burn);
+		for (iter = priv->branches; iter; iter = iter->next) {
+			BraseroBurnBranch *branch = iter->data;
+
+			if (branch->started && !branch->done)
+				brasero_burn_cancel (branch->burn, FALSE);
+		}
+
+		if (priv->producer)
+			brasero_burn_cancel (priv->producer, FALSE);
+	}
+
 	return result;
 }
 
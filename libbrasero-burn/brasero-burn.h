@@ -100,6 +100,19 @@ brasero_burn_record (BraseroBurn *burn,
 		     BraseroBurnSession *session,
 		     GError **error);
 
+BraseroBurnResult
+brasero_burn_record_drives (BraseroBurn *burn,
+			    BraseroBurnSession *session,
+			    GSList *drives,
+			    GError **error);
+
+BraseroBurnResult
+brasero_burn_get_drive_status (BraseroBurn *burn,
+			       BraseroDrive *drive,
+			       gdouble *progress,
+			       goffset *written,
+			       gdouble *buffer_fill);
+
 BraseroBurnResult
 brasero_burn_check (BraseroBurn *burn,
 		    BraseroBurnSession *session,
@@ -121,6 +134,12 @@ brasero_burn_status (BraseroBurn *burn,
 		     goffset *written,
 		     guint64 *rate);
 
+BraseroBurnResult
+brasero_burn_get_rate_estimate (BraseroBurn *burn,
+				guint64 *smoothed,
+				guint64 *instant,
+				gdouble *confidence);
+
 void
 brasero_burn_get_action_string (BraseroBurn *burn,
 				BraseroBurnAction action,
@@ -832,6 +832,70 @@ brasero_burn_caps_new_task (BraseroBurnCaps *self,
 	return retval;
 }
 
+/**
+ * Tells whether the plugin that will create an image out of the data of the
+ * session writes identical files only once. The links are looked for as in
+ * brasero_burn_caps_new_task () but without the initial blanking.
+ */
+
+gboolean
+brasero_burn_session_shares_duplicates (BraseroBurnSession *session)
+{
+	BraseroBurnFlag session_flags;
+	BraseroCapsLinkList *node;
+	BraseroPluginIOFlag flags;
+	BraseroTrackType output;
+	BraseroTrackType input;
+	BraseroCaps *last_caps;
+	BraseroBurnCaps *self;
+	BraseroMedia media;
+	gboolean retval;
+	GSList *list;
+
+	brasero_burn_session_get_input_type (session, &input);
+	if (!brasero_track_type_get_has_data (&input))
+		return FALSE;
+
+	brasero_burn_session_get_output_type (session, &output);
+	if (brasero_track_type_get_has_medium (&output))
+		media = brasero_track_type_get_medium_type (&output);
+	else
+		media = BRASERO_MEDIUM_FILE;
+
+	if (BRASERO_BURN_SESSION_NO_TMP_FILE (session))
+		flags = BRASERO_PLUGIN_IO_ACCEPT_PIPE;
+	else
+		flags = BRASERO_PLUGIN_IO_ACCEPT_FILE;
+
+	self = brasero_burn_caps_get_default ();
+	last_caps = brasero_burn_caps_find_start_caps (self, &output);
+	if (!last_caps) {
+		g_object_unref (self);
+		return FALSE;
+	}
+
+	session_flags = brasero_burn_session_get_flags (session);
+	list = brasero_caps_find_best_link (last_caps,
+					    self->priv->group_id,
+					    NULL,
+					    session_flags,
+					    media,
+					    &input,
+					    flags);
+	g_object_unref (self);
+
+	if (!list)
+		return FALSE;
+
+	/* The last link is the one whose input is the data */
+	node = g_slist_last (list)->data;
+	retval = brasero_plugin_get_shares_duplicates (node->plugin);
+
+	g_slist_foreach (list, (GFunc) g_free, NULL);
+	g_slist_free (list);
+	return retval;
+}
+
 BraseroTask *
 brasero_burn_caps_new_checksuming_task (BraseroBurnCaps *self,
 					BraseroBurnSession *session,
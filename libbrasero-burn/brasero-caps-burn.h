@@ -57,6 +57,9 @@ brasero_burn_caps_new_checksuming_task (BraseroBurnCaps *caps,
 					BraseroBurnSession *session,
 					GError **error);
 
+gboolean
+brasero_burn_session_shares_duplicates (BraseroBurnSession *session);
+
 
 G_END_DECLS
 
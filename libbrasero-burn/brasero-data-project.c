@@ -85,7 +85,32 @@ struct _BraseroDataProjectPrivate
 	/* This is a counter for the number of files to be loaded */
 	guint loading;
 
+	/* Nesting level of brasero_data_project_batch_begin () */
+	guint batch;
+
+	/* Nodes waiting for the end of the batch to be merged with the
+	 * children of their parent (parent => BraseroDataProjectBatch) */
+	GHashTable *batch_nodes;
+
 	guint is_loading_contents:1;
+	guint batch_size_changed:1;
+};
+
+typedef struct _BraseroDataProjectBatch BraseroDataProjectBatch;
+struct _BraseroDataProjectBatch
+{
+	guint reference;
+	GSList *pending;
+};
+
+typedef struct _BraseroDataProjectPending BraseroDataProjectPending;
+struct _BraseroDataProjectPending
+{
+	BraseroFileNode *node;
+	gchar *uri;
+
+	/* Set for symlinks whose target is to be grafted instead */
+	gchar *target;
 };
 
 #define BRASERO_DATA_PROJECT_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_DATA_PROJECT, BraseroDataProjectPrivate))
@@ -111,6 +136,7 @@ enum {
 	G2_FILE_SIGNAL,
 	PROJECT_LOADED_SIGNAL,
 	VIRTUAL_SIBLING_SIGNAL,
+	BATCH_END_SIGNAL,
 	LAST_SIGNAL
 };
 
@@ -1126,6 +1152,79 @@ brasero_data_project_monitor_cancel_foreach_cb (gpointer data,
 
 #endif
 
+static void
+brasero_data_project_size_changed (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	/* Signal it only once at the end of a batch */
+	if (priv->batch) {
+		priv->batch_size_changed = TRUE;
+		return;
+	}
+
+	g_signal_emit (self,
+		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
+		       0);
+}
+
+/**
+ * Used when a lot of nodes are added at once (like the contents of a
+ * directory). Between these two calls, the size change is signalled only
+ * once and "batch-end" tells views they can update what they deferred.
+ */
+
+void
+brasero_data_project_batch_begin (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	priv->batch ++;
+}
+
+static void
+brasero_data_project_batch_flush (BraseroDataProject *self);
+
+void
+brasero_data_project_batch_end (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	g_return_if_fail (priv->batch > 0);
+
+	/* Merge the nodes while still in the batch so that their parents are
+	 * only signalled as changed once with "batch-end" */
+	if (priv->batch == 1)
+		brasero_data_project_batch_flush (self);
+
+	priv->batch --;
+	if (priv->batch)
+		return;
+
+	g_signal_emit (self,
+		       brasero_data_project_signals [BATCH_END_SIGNAL],
+		       0);
+
+	if (priv->batch_size_changed) {
+		priv->batch_size_changed = FALSE;
+		brasero_data_project_size_changed (self);
+	}
+}
+
+gboolean
+brasero_data_project_in_batch (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	return (priv->batch > 0);
+}
+
 static void
 brasero_data_project_node_removed (BraseroDataProject *self,
 				   BraseroFileNode *node)
@@ -1236,9 +1335,7 @@ brasero_data_project_remove_real (BraseroDataProject *self,
 						 former_parent,
 						 priv->sort_func);
 
-	g_signal_emit (self,
-		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-		       0);
+	brasero_data_project_size_changed (self);
 }
 
 static void
@@ -1336,9 +1433,7 @@ brasero_data_project_destroy_node (BraseroDataProject *self,
 	stats = brasero_file_node_get_tree_stats (priv->root, NULL);
 	brasero_file_node_destroy (node, stats);
 
-	g_signal_emit (self,
-		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-		       0);
+	brasero_data_project_size_changed (self);
 
 	/* NOTE: no need to check for imported_sibling here since this function
 	 * actually destroys all nodes including imported ones and is mainly 
@@ -2109,9 +2204,7 @@ brasero_data_project_node_loaded (BraseroDataProject *self,
 	/* signal the changes */
 	brasero_data_project_node_changed (self, node);
 	if (size_changed)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 
 	return TRUE;
 }
@@ -2163,9 +2256,7 @@ brasero_data_project_node_reloaded (BraseroDataProject *self,
 
 	brasero_data_project_node_changed (self, node);
 	if (size_changed)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 }
 
 static BraseroFileNode *
@@ -2287,6 +2378,230 @@ brasero_data_project_directory_node_loaded (BraseroDataProject *self,
 	}
 }
 
+static BraseroFileNode *
+brasero_data_project_node_from_info_added (BraseroDataProject *self,
+					   BraseroFileNode *node,
+					   BraseroURINode *graft,
+					   const gchar *uri,
+					   const gchar *target)
+{
+	if (target) {
+		/* first we exclude the symlink, then we graft its target */
+		brasero_data_project_exclude_uri (self, uri);
+
+		/* then we add the node */
+		if (!brasero_data_project_add_node_real (self,
+		                                         node,
+		                                         graft,
+		                                         target))
+			return NULL;
+	}
+	else {
+		if (!brasero_data_project_add_node_real (self,
+		                                         node,
+		                                         graft,
+		                                         uri))
+			return NULL;
+	}
+
+	if (node->is_file)
+		brasero_data_project_size_changed (self);
+
+	/* at this point we know all we need to know about our node and in 
+	 * particular if it's a file or a directory, if it's grafted or not
+	 * That's why we can start monitoring it. */
+	if (!node->is_monitored) {
+
+#ifdef BUILD_INOTIFY
+
+		if (node->is_grafted)
+			brasero_file_monitor_single_file (BRASERO_FILE_MONITOR (self),
+							  uri,
+							  node);
+
+		if (!node->is_file)
+			brasero_file_monitor_directory_contents (BRASERO_FILE_MONITOR (self),
+								 uri,
+								 node);
+		node->is_monitored = TRUE;
+
+#endif
+
+	}
+
+	return node;
+}
+
+static void
+brasero_data_project_batch_add (BraseroDataProject *self,
+				BraseroFileNode *parent,
+				BraseroFileNode *node,
+				const gchar *uri,
+				GFileInfo *info)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroDataProjectPending *pending;
+	BraseroDataProjectBatch *batch;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	if (!priv->batch_nodes)
+		priv->batch_nodes = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	/* Parents are referenced in case they get removed in the meantime */
+	batch = g_hash_table_lookup (priv->batch_nodes, parent);
+	if (!batch) {
+		batch = g_new0 (BraseroDataProjectBatch, 1);
+		batch->reference = brasero_data_project_reference_new (self, parent);
+		g_hash_table_insert (priv->batch_nodes, parent, batch);
+	}
+
+	pending = g_new0 (BraseroDataProjectPending, 1);
+	pending->node = node;
+	pending->uri = g_strdup (uri);
+	if (g_file_info_get_is_symlink (info)
+	&&  g_file_info_get_file_type (info) != G_FILE_TYPE_SYMBOLIC_LINK)
+		pending->target = g_strdup (g_file_info_get_symlink_target (info));
+
+	batch->pending = g_slist_prepend (batch->pending, pending);
+}
+
+static void
+brasero_data_project_pending_free (BraseroDataProjectPending *pending,
+				   BraseroFileTreeStats *stats)
+{
+	if (pending->node)
+		brasero_file_node_destroy (pending->node, stats);
+
+	g_free (pending->uri);
+	g_free (pending->target);
+	g_free (pending);
+}
+
+static gint
+brasero_data_project_pending_sort_cb (gconstpointer a,
+				      gconstpointer b,
+				      gpointer sort_func)
+{
+	const BraseroDataProjectPending *pending_a = a;
+	const BraseroDataProjectPending *pending_b = b;
+
+	return ((GCompareFunc) sort_func) (pending_a->node, pending_b->node);
+}
+
+static void
+brasero_data_project_batch_merge (BraseroDataProject *self,
+				  BraseroDataProjectBatch *batch)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroFileTreeStats *stats;
+	BraseroFileNode *parent;
+	BraseroFileNode *hint;
+	GSList *iter;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	parent = brasero_data_project_reference_get (self, batch->reference);
+	brasero_data_project_reference_free (self, batch->reference);
+
+	/* Sort them once, then each node is inserted after the previous one
+	 * so the whole batch is merged with the children in one pass. Each
+	 * node is signalled as soon as it is inserted so that the tree stays
+	 * consistent for the views. */
+	batch->pending = g_slist_sort_with_data (batch->pending,
+						 brasero_data_project_pending_sort_cb,
+						 priv->sort_func);
+
+	stats = brasero_file_node_get_tree_stats (priv->root, NULL);
+
+	hint = NULL;
+	for (iter = batch->pending; iter; iter = iter->next) {
+		BraseroDataProjectPending *pending;
+		BraseroURINode *graft;
+		BraseroFileNode *node;
+
+		pending = iter->data;
+
+		/* The parent may have been removed or a node with the same
+		 * name added while we were waiting */
+		if (!parent
+		||  brasero_file_node_check_name_existence (parent, BRASERO_FILE_NODE_NAME (pending->node))) {
+			brasero_data_project_pending_free (pending, stats);
+			continue;
+		}
+
+		node = pending->node;
+		pending->node = NULL;
+
+		brasero_file_node_add_after (parent, hint, node, priv->sort_func);
+
+		graft = g_hash_table_lookup (priv->grafts, pending->uri);
+		if (brasero_data_project_node_from_info_added (self,
+							       node,
+							       graft,
+							       pending->uri,
+							       pending->target))
+			hint = node;
+		else
+			hint = NULL;
+
+		brasero_data_project_pending_free (pending, stats);
+	}
+
+	g_slist_free (batch->pending);
+	g_free (batch);
+}
+
+static void
+brasero_data_project_batch_flush (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	/* Nodes could be added while signalling the others */
+	while (priv->batch_nodes) {
+		GHashTable *batch_nodes;
+		GHashTableIter iter;
+		gpointer value;
+
+		batch_nodes = priv->batch_nodes;
+		priv->batch_nodes = NULL;
+
+		g_hash_table_iter_init (&iter, batch_nodes);
+		while (g_hash_table_iter_next (&iter, NULL, &value))
+			brasero_data_project_batch_merge (self, value);
+
+		g_hash_table_destroy (batch_nodes);
+	}
+}
+
+static void
+brasero_data_project_batch_drop (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+	GHashTableIter iter;
+	gpointer value;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	if (!priv->batch_nodes)
+		return;
+
+	/* The tree is being destroyed so there is no stats to update */
+	g_hash_table_iter_init (&iter, priv->batch_nodes);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		BraseroDataProjectBatch *batch = value;
+
+		g_slist_foreach (batch->pending, (GFunc) brasero_data_project_pending_free, NULL);
+		g_slist_free (batch->pending);
+		g_free (batch);
+	}
+
+	g_hash_table_destroy (priv->batch_nodes);
+	priv->batch_nodes = NULL;
+}
+
 /**
  * This function is only used by brasero-data-vfs.c to add the contents of a 
  * directory. That's why if a node with the same name is already grafted we 
@@ -2409,56 +2724,27 @@ brasero_data_project_add_node_from_info (BraseroDataProject *self,
 		brasero_file_node_set_from_info (node, stats, info);
 	}
 
-	brasero_file_node_add (parent, node, priv->sort_func);
-
-	if (g_file_info_get_is_symlink (info)
-	&&  g_file_info_get_file_type (info) != G_FILE_TYPE_SYMBOLIC_LINK) {
-		/* first we exclude the symlink, then we graft its target */
-		brasero_data_project_exclude_uri (self, uri);
-
-		/* then we add the node */
-		if (!brasero_data_project_add_node_real (self,
-		                                         node,
-		                                         graft,
-		                                         g_file_info_get_symlink_target (info)))
-			return NULL;
-	}
-	else {
-		if (!brasero_data_project_add_node_real (self,
-		                                         node,
-		                                         graft,
-		                                         uri))
-			return NULL;
+	if (priv->batch && !sibling) {
+		/* It will be merged with its siblings at the end of the batch */
+		brasero_data_project_batch_add (self, parent, node, uri, info);
+		return node;
 	}
 
-	if (type != G_FILE_TYPE_DIRECTORY)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
-
-	/* at this point we know all we need to know about our node and in 
-	 * particular if it's a file or a directory, if it's grafted or not
-	 * That's why we can start monitoring it. */
-	if (!node->is_monitored) {
-
-#ifdef BUILD_INOTIFY
+	brasero_file_node_add (parent, node, priv->sort_func);
 
-		if (node->is_grafted)
-			brasero_file_monitor_single_file (BRASERO_FILE_MONITOR (self),
+	if (g_file_info_get_is_symlink (info)
+	&&  g_file_info_get_file_type (info) != G_FILE_TYPE_SYMBOLIC_LINK)
+		return brasero_data_project_node_from_info_added (self,
+								  node,
+								  graft,
+								  uri,
+								  g_file_info_get_symlink_target (info));
+
+	return brasero_data_project_node_from_info_added (self,
+							  node,
+							  graft,
 							  uri,
-							  node);
-
-		if (!node->is_file)
-			brasero_file_monitor_directory_contents (BRASERO_FILE_MONITOR (self),
-								 uri,
-								 node);
-		node->is_monitored = TRUE;
-
-#endif
-
-	}
-
-	return node;
+							  NULL);
 }
 
 /**
@@ -3887,6 +4173,8 @@ brasero_data_project_clear (BraseroDataProject *self)
 				     (GHRFunc) brasero_data_project_clear_joliet_cb,
 				     NULL);
 
+	brasero_data_project_batch_drop (self);
+
 	g_hash_table_destroy (priv->reference);
 	priv->reference = g_hash_table_new (g_direct_hash, g_direct_equal);
 
@@ -4375,6 +4663,18 @@ brasero_data_project_file_modified (BraseroFileMonitor *monitor,
 	g_free (uri);
 }
 
+static void
+brasero_data_project_monitor_batch_begin (BraseroFileMonitor *monitor)
+{
+	brasero_data_project_batch_begin (BRASERO_DATA_PROJECT (monitor));
+}
+
+static void
+brasero_data_project_monitor_batch_end (BraseroFileMonitor *monitor)
+{
+	brasero_data_project_batch_end (BRASERO_DATA_PROJECT (monitor));
+}
+
 #endif
 
 static void
@@ -4459,6 +4759,17 @@ brasero_data_project_class_init (BraseroDataProjectClass *klass)
 			  G_TYPE_POINTER,
 			  G_TYPE_POINTER);
 
+	brasero_data_project_signals [BATCH_END_SIGNAL] = 
+	    g_signal_new ("batch-end",
+			  G_TYPE_FROM_CLASS (klass),
+			  G_SIGNAL_RUN_LAST|G_SIGNAL_NO_RECURSE,
+			  0,
+			  NULL, NULL,
+			  g_cclosure_marshal_VOID__VOID,
+			  G_TYPE_NONE,
+			  0,
+			  G_TYPE_NONE);
+
 #ifdef BUILD_INOTIFY
 
 	BraseroFileMonitorClass *monitor_class = BRASERO_FILE_MONITOR_CLASS (klass);
@@ -4468,6 +4779,8 @@ brasero_data_project_class_init (BraseroDataProjectClass *klass)
 	monitor_class->file_removed = brasero_data_project_file_removed;
 	monitor_class->file_renamed = brasero_data_project_file_renamed;
 	monitor_class->file_modified = brasero_data_project_file_modified;
+	monitor_class->batch_begin = brasero_data_project_monitor_batch_begin;
+	monitor_class->batch_end = brasero_data_project_monitor_batch_end;
 
 #endif
 }
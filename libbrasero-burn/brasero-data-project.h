@@ -173,6 +173,14 @@ brasero_data_project_add_node_from_info (BraseroDataProject *project,
 					 const gchar *uri,
 					 GFileInfo *info,
 					 BraseroFileNode *parent);
+
+void
+brasero_data_project_batch_begin (BraseroDataProject *project);
+void
+brasero_data_project_batch_end (BraseroDataProject *project);
+gboolean
+brasero_data_project_in_batch (BraseroDataProject *project);
+
 BraseroFileNode *
 brasero_data_project_add_empty_directory (BraseroDataProject *project,
 					  const gchar *name,
@@ -57,6 +57,15 @@ typedef struct _BraseroDataSessionPrivate BraseroDataSessionPrivate;
 struct _BraseroDataSessionPrivate
 {
 	BraseroIOJobBase *load_dir;
+	BraseroIOJobBase *import;
+
+	/* Imported directories not loaded yet (address -> reference) while
+	 * the whole session is imported in the background */
+	GHashTable *import_dirs;
+	guint import_address;
+	gint import_reference;
+	guint import_done;
+	guint import_total;
 
 	/* Multisession drives that are inserted */
 	GSList *media;
@@ -75,6 +84,7 @@ G_DEFINE_TYPE (BraseroDataSession, brasero_data_session, BRASERO_TYPE_DATA_PROJE
 enum {
 	AVAILABLE_SIGNAL,
 	LOADED_SIGNAL,
+	IMPORT_PROGRESS_SIGNAL,
 	LAST_SIGNAL
 };
 
@@ -92,6 +102,30 @@ struct _BraseroIOImageContentsData {
 };
 typedef struct _BraseroIOImageContentsData BraseroIOImageContentsData;
 
+#define BRASERO_DATA_SESSION_PARENT_ADDR	"image::parent-address"
+#define BRASERO_DATA_SESSION_LOADED_ADDR	"image::loaded-address"
+#define BRASERO_DATA_SESSION_DIRS_DONE		"image::directories-done"
+#define BRASERO_DATA_SESSION_DIRS_TOTAL		"image::directories-total"
+
+static GFileInfo *
+brasero_io_image_file_info_new (BraseroVolFile *file)
+{
+	GFileInfo *info;
+
+	info = g_file_info_new ();
+	g_file_info_set_file_type (info, file->isdir? G_FILE_TYPE_DIRECTORY:G_FILE_TYPE_REGULAR);
+	g_file_info_set_name (info, BRASERO_VOLUME_FILE_NAME (file));
+
+	if (file->isdir)
+		g_file_info_set_attribute_int64 (info,
+						 BRASERO_IO_DIR_CONTENTS_ADDR,
+						 file->specific.dir.address);
+	else
+		g_file_info_set_size (info, BRASERO_VOLUME_FILE_SIZE (file));
+
+	return info;
+}
+
 static void
 brasero_io_image_directory_contents_destroy (BraseroAsyncTaskManager *manager,
 					     gboolean cancelled,
@@ -149,22 +183,9 @@ brasero_io_image_directory_contents_thread (BraseroAsyncTaskManager *manager,
 	brasero_device_handle_close (handle);
 
 	for (iter = children; iter; iter = iter->next) {
-		BraseroVolFile *file;
 		GFileInfo *info;
 
-		file = iter->data;
-
-		info = g_file_info_new ();
-		g_file_info_set_file_type (info, file->isdir? G_FILE_TYPE_DIRECTORY:G_FILE_TYPE_REGULAR);
-		g_file_info_set_name (info, BRASERO_VOLUME_FILE_NAME (file));
-
-		if (file->isdir)
-			g_file_info_set_attribute_int64 (info,
-							 BRASERO_IO_DIR_CONTENTS_ADDR,
-							 file->specific.dir.address);
-		else
-			g_file_info_set_size (info, BRASERO_VOLUME_FILE_SIZE (file));
-
+		info = brasero_io_image_file_info_new (iter->data);
 		brasero_io_return_result (data->job.base,
 					  data->job.uri,
 					  info,
@@ -214,6 +235,490 @@ brasero_io_load_image_directory (const gchar *dev_image,
 
 }
 
+/**
+ * to import the whole tree of a session in the background; directories are
+ * read in the order of their addresses on the disc to avoid seeking.
+ */
+struct _BraseroIOImageImportData {
+	BraseroIOJob job;
+
+	gint64 session_block;
+
+	/* only used in the thread */
+	GCancellable *cancel;
+	guint root_address;
+	guint dirs_done;
+};
+typedef struct _BraseroIOImageImportData BraseroIOImageImportData;
+
+static void
+brasero_io_image_import_destroy (BraseroAsyncTaskManager *manager,
+				 gboolean cancelled,
+				 gpointer callback_data)
+{
+	BraseroIOImageImportData *data = callback_data;
+	brasero_io_job_free (cancelled, BRASERO_IO_JOB (data));
+}
+
+static gboolean
+brasero_io_image_import_directory (guint address,
+				   GList *children,
+				   guint remaining,
+				   gpointer user_data)
+{
+	BraseroIOImageImportData *data = user_data;
+	GFileInfo *info;
+	GList *iter;
+
+	/* root is always the first directory walked; its children have no
+	 * parent in the tree */
+	if (!data->dirs_done)
+		data->root_address = address;
+
+	if (address == data->root_address)
+		address = 0;
+
+	for (iter = children; iter; iter = iter->next) {
+		info = brasero_io_image_file_info_new (iter->data);
+		g_file_info_set_attribute_int64 (info,
+						 BRASERO_DATA_SESSION_PARENT_ADDR,
+						 address);
+		brasero_io_return_result (data->job.base,
+					  data->job.uri,
+					  info,
+					  NULL,
+					  data->job.callback_data);
+	}
+
+	g_list_foreach (children, (GFunc) brasero_volume_file_free, NULL);
+	g_list_free (children);
+
+	/* Tell that the directory is complete */
+	data->dirs_done ++;
+
+	info = g_file_info_new ();
+	g_file_info_set_attribute_int64 (info,
+					 BRASERO_DATA_SESSION_LOADED_ADDR,
+					 address);
+	g_file_info_set_attribute_uint32 (info,
+					  BRASERO_DATA_SESSION_DIRS_DONE,
+					  data->dirs_done);
+	g_file_info_set_attribute_uint32 (info,
+					  BRASERO_DATA_SESSION_DIRS_TOTAL,
+					  data->dirs_done + remaining);
+	brasero_io_return_result (data->job.base,
+				  data->job.uri,
+				  info,
+				  NULL,
+				  data->job.callback_data);
+
+	return !g_cancellable_is_cancelled (data->cancel);
+}
+
+static BraseroAsyncTaskResult
+brasero_io_image_import_thread (BraseroAsyncTaskManager *manager,
+				GCancellable *cancel,
+				gpointer callback_data)
+{
+	BraseroIOImageImportData *data = callback_data;
+	BraseroDeviceHandle *handle;
+	GError *error = NULL;
+	BraseroVolSrc *vol;
+
+	handle = brasero_device_handle_open (data->job.uri, FALSE, NULL);
+	if (!handle) {
+		error = g_error_new (BRASERO_BURN_ERROR,
+		                     BRASERO_BURN_ERROR_GENERAL,
+		                     _("The drive is busy"));
+
+		brasero_io_return_result (data->job.base,
+					  data->job.uri,
+					  NULL,
+					  error,
+					  data->job.callback_data);
+		return BRASERO_ASYNC_TASK_FINISHED;
+	}
+
+	vol = brasero_volume_source_open_device_handle (handle, &error);
+	if (!vol) {
+		brasero_device_handle_close (handle);
+		brasero_io_return_result (data->job.base,
+					  data->job.uri,
+					  NULL,
+					  error,
+					  data->job.callback_data);
+		return BRASERO_ASYNC_TASK_FINISHED;
+	}
+
+	data->cancel = cancel;
+	brasero_volume_walk_directories (vol,
+					 data->session_block,
+					 brasero_io_image_import_directory,
+					 data,
+					 &error);
+	data->cancel = NULL;
+
+	brasero_volume_source_close (vol);
+	brasero_device_handle_close (handle);
+
+	/* Only report errors if nothing could be read at all; directories
+	 * that were not imported will be loaded when they are explored */
+	if (error) {
+		if (!data->dirs_done)
+			brasero_io_return_result (data->job.base,
+						  data->job.uri,
+						  NULL,
+						  error,
+						  data->job.callback_data);
+		else
+			g_error_free (error);
+	}
+
+	return BRASERO_ASYNC_TASK_FINISHED;
+}
+
+static const BraseroAsyncTaskType image_import_type = {
+	brasero_io_image_import_thread,
+	brasero_io_image_import_destroy
+};
+
+static void
+brasero_io_import_image (const gchar *dev_image,
+			 gint64 session_block,
+			 const BraseroIOJobBase *base,
+			 BraseroIOFlags options,
+			 gpointer user_data)
+{
+	BraseroIOImageImportData *data;
+	BraseroIOResultCallbackData *callback_data = NULL;
+
+	if (user_data) {
+		callback_data = g_new0 (BraseroIOResultCallbackData, 1);
+		callback_data->callback_data = user_data;
+	}
+
+	data = g_new0 (BraseroIOImageImportData, 1);
+	data->session_block = session_block;
+
+	brasero_io_set_job (BRASERO_IO_JOB (data),
+			    base,
+			    dev_image,
+			    options,
+			    callback_data);
+
+	brasero_io_push_job (BRASERO_IO_JOB (data),
+			     &image_import_type);
+}
+
+static void
+brasero_data_session_import_release (BraseroDataSession *self)
+{
+	BraseroDataSessionPrivate *priv;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+	if (priv->import_reference > 0) {
+		brasero_data_project_reference_free (BRASERO_DATA_PROJECT (self), priv->import_reference);
+		priv->import_reference = 0;
+	}
+	priv->import_address = 0;
+}
+
+static void
+brasero_data_session_import_clear (BraseroDataSession *self)
+{
+	BraseroDataSessionPrivate *priv;
+	GHashTableIter iter;
+	gpointer reference;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+
+	brasero_data_session_import_release (self);
+
+	if (!priv->import_dirs)
+		return;
+
+	g_hash_table_iter_init (&iter, priv->import_dirs);
+	while (g_hash_table_iter_next (&iter, NULL, &reference))
+		brasero_data_project_reference_free (BRASERO_DATA_PROJECT (self), GPOINTER_TO_INT (reference));
+
+	g_hash_table_destroy (priv->import_dirs);
+	priv->import_dirs = NULL;
+}
+
+static void
+brasero_data_session_import_stop (BraseroDataSession *self)
+{
+	BraseroDataSessionPrivate *priv;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+
+	if (priv->import) {
+		brasero_io_cancel_by_base (priv->import);
+		brasero_io_job_base_free (priv->import);
+		priv->import = NULL;
+	}
+
+	brasero_data_session_import_clear (self);
+	priv->import_done = 0;
+	priv->import_total = 0;
+}
+
+static void
+brasero_data_session_import_register (BraseroDataSession *self,
+				      BraseroFileNode *node)
+{
+	BraseroDataSessionPrivate *priv;
+	gpointer key;
+	gint reference;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+	if (!priv->import_dirs)
+		return;
+
+	if (node->is_file || BRASERO_FILE_NODE_IMPORTED_ADDRESS (node) <= 0)
+		return;
+
+	key = GUINT_TO_POINTER (node->union3.imported_address);
+	reference = GPOINTER_TO_INT (g_hash_table_lookup (priv->import_dirs, key));
+	if (reference > 0)
+		brasero_data_project_reference_free (BRASERO_DATA_PROJECT (self), reference);
+
+	reference = brasero_data_project_reference_new (BRASERO_DATA_PROJECT (self), node);
+	g_hash_table_insert (priv->import_dirs, key, GINT_TO_POINTER (reference));
+}
+
+/* Returns the directory node whose children are being imported at address;
+ * NULL if it was removed or was already loaded on demand. */
+static BraseroFileNode *
+brasero_data_session_import_claim (BraseroDataSession *self,
+				   guint address)
+{
+	BraseroDataSessionPrivate *priv;
+	BraseroFileNode *node;
+	gpointer key;
+	gint reference;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+
+	if (priv->import_address == address) {
+		if (priv->import_reference <= 0)
+			return NULL;
+
+		return brasero_data_project_reference_get (BRASERO_DATA_PROJECT (self), priv->import_reference);
+	}
+
+	brasero_data_session_import_release (self);
+	priv->import_address = address;
+
+	if (!priv->import_dirs)
+		return NULL;
+
+	key = GUINT_TO_POINTER (address);
+	reference = GPOINTER_TO_INT (g_hash_table_lookup (priv->import_dirs, key));
+	if (reference <= 0)
+		return NULL;
+
+	g_hash_table_remove (priv->import_dirs, key);
+
+	node = brasero_data_project_reference_get (BRASERO_DATA_PROJECT (self), reference);
+	if (!node || !node->is_fake || !node->is_imported) {
+		brasero_data_project_reference_free (BRASERO_DATA_PROJECT (self), reference);
+		return NULL;
+	}
+
+	node->is_fake = FALSE;
+	node->is_exploring = TRUE;
+	priv->import_reference = reference;
+	return node;
+}
+
+static void
+brasero_data_session_add_imported_file (BraseroDataSession *self,
+					GFileInfo *info,
+					BraseroFileNode *parent)
+{
+	BraseroDataSessionPrivate *priv;
+	BraseroFileNode *node;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+
+	/* add all the files/folders at the root of the session */
+	node = brasero_data_project_add_imported_session_file (BRASERO_DATA_PROJECT (self),
+							       info,
+							       parent);
+	if (!node) {
+		/* This is not a problem, it could be simply that the user did 
+		 * not want to overwrite, so do not do the following (reminder):
+		g_signal_emit (self,
+			       brasero_data_session_signals [LOADED_SIGNAL],
+			       0,
+			       priv->loaded,
+			       (priv->nodes != NULL));
+		*/
+		return;
+ 	}
+
+	brasero_data_session_import_register (self, node);
+
+	/* Only if we're exploring root directory */
+	if (!parent) {
+		priv->nodes = g_slist_prepend (priv->nodes, node);
+
+		if (g_slist_length (priv->nodes) == 1) {
+			/* Only tell when the first top node is successfully loaded */
+			g_signal_emit (self,
+				       brasero_data_session_signals [LOADED_SIGNAL],
+				       0,
+				       priv->loaded,
+				       TRUE);
+		}
+	}
+}
+
+static void
+brasero_data_session_import_result (BraseroDataSession *self,
+				    GFileInfo *info)
+{
+	BraseroDataSessionPrivate *priv;
+	BraseroFileNode *parent;
+	guint address;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+
+	if (g_file_info_has_attribute (info, BRASERO_DATA_SESSION_LOADED_ADDR)) {
+		address = g_file_info_get_attribute_int64 (info, BRASERO_DATA_SESSION_LOADED_ADDR);
+		if (address) {
+			parent = brasero_data_session_import_claim (self, address);
+			if (parent)
+				brasero_data_project_directory_node_loaded (BRASERO_DATA_PROJECT (self), parent);
+		}
+		brasero_data_session_import_release (self);
+
+		priv->import_done = g_file_info_get_attribute_uint32 (info, BRASERO_DATA_SESSION_DIRS_DONE);
+		priv->import_total = g_file_info_get_attribute_uint32 (info, BRASERO_DATA_SESSION_DIRS_TOTAL);
+		g_signal_emit (self,
+			       brasero_data_session_signals [IMPORT_PROGRESS_SIGNAL],
+			       0,
+			       priv->import_done,
+			       priv->import_total);
+		return;
+	}
+
+	address = g_file_info_get_attribute_int64 (info, BRASERO_DATA_SESSION_PARENT_ADDR);
+	if (address) {
+		parent = brasero_data_session_import_claim (self, address);
+		if (!parent)
+			return;
+	}
+	else
+		parent = NULL;
+
+	brasero_data_session_add_imported_file (self, info, parent);
+}
+
+static void
+brasero_data_session_import_results (GObject *owner,
+				     const BraseroIOResult *results,
+				     guint num,
+				     gpointer data)
+{
+	BraseroDataSessionPrivate *priv;
+	guint i;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (owner);
+
+	brasero_data_project_batch_begin (BRASERO_DATA_PROJECT (owner));
+	for (i = 0; i < num; i ++) {
+		if (!results [i].info) {
+			g_signal_emit (owner,
+				       brasero_data_session_signals [LOADED_SIGNAL],
+				       0,
+				       priv->loaded,
+				       FALSE);
+
+			/* FIXME: tell the user the error message */
+			continue;
+		}
+
+		brasero_data_session_import_result (BRASERO_DATA_SESSION (owner), results [i].info);
+	}
+	brasero_data_project_batch_end (BRASERO_DATA_PROJECT (owner));
+}
+
+static void
+brasero_data_session_import_destroy (GObject *object,
+				     gboolean cancelled,
+				     gpointer data)
+{
+	/* Called once the import is over (data is self); whatever is left
+	 * will be loaded on demand */
+	brasero_data_session_import_clear (BRASERO_DATA_SESSION (object));
+}
+
+static gboolean
+brasero_data_session_import (BraseroDataSession *self,
+			     GError **error)
+{
+	BraseroDataSessionPrivate *priv;
+	goffset session_block;
+	const gchar *device;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+	device = brasero_drive_get_device (brasero_medium_get_drive (priv->loaded));
+	brasero_medium_get_last_data_track_address (priv->loaded,
+						    NULL,
+						    &session_block);
+
+	if (!priv->import)
+		priv->import = brasero_io_register_batch (G_OBJECT (self),
+							  brasero_data_session_import_results,
+							  brasero_data_session_import_destroy,
+							  NULL);
+
+	brasero_data_session_import_clear (self);
+	priv->import_dirs = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->import_done = 0;
+	priv->import_total = 0;
+
+	/* Idle so that directories explored by the user are served first */
+	brasero_io_import_image (device,
+				 session_block,
+				 priv->import,
+				 BRASERO_IO_INFO_IDLE,
+				 self);
+
+	return TRUE;
+}
+
+/**
+ * brasero_data_session_get_import_progress:
+ * @session: a #BraseroDataSession
+ * @done: a #guint or NULL
+ * @total: a #guint or NULL
+ *
+ * Returns the number of directories of the loaded session already imported
+ * and the number of directories known so far.
+ *
+ * Return value: TRUE if the import is still running.
+ **/
+
+gboolean
+brasero_data_session_get_import_progress (BraseroDataSession *self,
+					  guint *done,
+					  guint *total)
+{
+	BraseroDataSessionPrivate *priv;
+
+	priv = BRASERO_DATA_SESSION_PRIVATE (self);
+
+	if (done)
+		*done = priv->import_done;
+	if (total)
+		*total = priv->import_total;
+
+	return (priv->import_dirs != NULL);
+}
+
 void
 brasero_data_session_remove_last (BraseroDataSession *self)
 {
@@ -222,6 +727,8 @@ brasero_data_session_remove_last (BraseroDataSession *self)
 
 	priv = BRASERO_DATA_SESSION_PRIVATE (self);
 
+	brasero_data_session_import_stop (self);
+
 	if (!priv->nodes)
 		return;
 
@@ -277,7 +784,6 @@ brasero_data_session_load_dir_result (GObject *owner,
 {
 	BraseroDataSessionPrivate *priv;
 	BraseroFileNode *parent;
-	BraseroFileNode *node;
 	gint reference;
 
 	priv = BRASERO_DATA_SESSION_PRIVATE (owner);
@@ -300,35 +806,7 @@ brasero_data_session_load_dir_result (GObject *owner,
 	else
 		parent = NULL;
 
-	/* add all the files/folders at the root of the session */
-	node = brasero_data_project_add_imported_session_file (BRASERO_DATA_PROJECT (owner),
-							       info,
-							       parent);
-	if (!node) {
-		/* This is not a problem, it could be simply that the user did 
-		 * not want to overwrite, so do not do the following (reminder):
-		g_signal_emit (owner,
-			       brasero_data_session_signals [LOADED_SIGNAL],
-			       0,
-			       priv->loaded,
-			       (priv->nodes != NULL));
-		*/
-		return;
- 	}
-
-	/* Only if we're exploring root directory */
-	if (!parent) {
-		priv->nodes = g_slist_prepend (priv->nodes, node);
-
-		if (g_slist_length (priv->nodes) == 1) {
-			/* Only tell when the first top node is successfully loaded */
-			g_signal_emit (owner,
-				       brasero_data_session_signals [LOADED_SIGNAL],
-				       0,
-				       priv->loaded,
-				       TRUE);
-		}
-	}
+	brasero_data_session_add_imported_file (BRASERO_DATA_SESSION (owner), info, parent);
 }
 
 static gboolean
@@ -401,7 +879,9 @@ brasero_data_session_add_last (BraseroDataSession *self,
 	priv->loaded = medium;
 	g_object_ref (medium);
 
-	return brasero_data_session_load_directory_contents_real (self, NULL, error);
+	/* The whole session is imported in the background; directories the
+	 * user explores before that are loaded on demand. */
+	return brasero_data_session_import (self, error);
 }
 
 gboolean
@@ -561,6 +1041,8 @@ brasero_data_session_stop_io (BraseroDataSession *self)
 		brasero_io_job_base_free (priv->load_dir);
 		priv->load_dir = NULL;
 	}
+
+	brasero_data_session_import_stop (self);
 }
 
 static void
@@ -653,4 +1135,15 @@ brasero_data_session_class_init (BraseroDataSessionClass *klass)
 			  2,
 			  G_TYPE_OBJECT,
 			  G_TYPE_BOOLEAN);
+	brasero_data_session_signals [IMPORT_PROGRESS_SIGNAL] = 
+	    g_signal_new ("session_import_progress",
+			  G_TYPE_FROM_CLASS (klass),
+			  G_SIGNAL_RUN_LAST,
+			  0,
+			  NULL, NULL,
+			  brasero_marshal_VOID__UINT_UINT,
+			  G_TYPE_NONE,
+			  2,
+			  G_TYPE_UINT,
+			  G_TYPE_UINT);
 }
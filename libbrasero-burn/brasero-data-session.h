@@ -78,6 +78,11 @@ brasero_data_session_load_directory_contents (BraseroDataSession *session,
 GSList *
 brasero_data_session_get_available_media (BraseroDataSession *session);
 
+gboolean
+brasero_data_session_get_import_progress (BraseroDataSession *session,
+					  guint *done,
+					  guint *total);
+
 gboolean
 brasero_data_session_has_available_media (BraseroDataSession *session);
 
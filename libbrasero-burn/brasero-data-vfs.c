@@ -480,6 +480,25 @@ brasero_data_vfs_directory_load_result (GObject *owner,
 	}
 }
 
+static void
+brasero_data_vfs_directory_load_results (GObject *owner,
+					 const BraseroIOResult *results,
+					 guint num,
+					 gpointer data)
+{
+	guint i;
+
+	/* Add all the nodes then let the project signal the changes at once */
+	brasero_data_project_batch_begin (BRASERO_DATA_PROJECT (owner));
+	for (i = 0; i < num; i ++)
+		brasero_data_vfs_directory_load_result (owner,
+							results [i].error,
+							results [i].uri,
+							results [i].info,
+							data);
+	brasero_data_project_batch_end (BRASERO_DATA_PROJECT (owner));
+}
+
 static gboolean
 brasero_data_vfs_load_directory (BraseroDataVFS *self,
 				 BraseroFileNode *node,
@@ -509,10 +528,10 @@ brasero_data_vfs_load_directory (BraseroDataVFS *self,
 			     g_slist_prepend (NULL, GINT_TO_POINTER (reference)));
 
 	if (!priv->load_contents)
-		priv->load_contents = brasero_io_register (G_OBJECT (self),
-							   brasero_data_vfs_directory_load_result,
-							   brasero_data_vfs_directory_load_end,
-							   NULL);
+		priv->load_contents = brasero_io_register_batch (G_OBJECT (self),
+								 brasero_data_vfs_directory_load_results,
+								 brasero_data_vfs_directory_load_end,
+								 NULL);
 
 	/* no need to require mime types here as these rows won't be visible */
 	brasero_io_load_directory (uri,
@@ -34,6 +34,7 @@
 
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <glib/gi18n-lib.h>
@@ -59,8 +60,23 @@ struct _BraseroFileMonitorPrivate
 
 	/* This is used in the case of a MOVE_FROM event */
 	GSList *moved_list;
+
+	/* Events are read in bulk into this buffer */
+	gchar *buffer;
+
+	/* Changes inside watched directories that are reported together
+	 * after a short time (wd => BraseroInotifyDirChanges) */
+	GHashTable *pending;
+	GSList *pending_order;
+	guint pending_id;
 };
 
+/* Enough for a few hundred events with their names */
+#define BRASERO_INOTIFY_BUFFER_SIZE	65536
+
+/* Time (in ms) during which changes inside a directory are coalesced */
+#define BRASERO_INOTIFY_COALESCE_DELAY	200
+
 #define BRASERO_FILE_MONITOR_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_FILE_MONITOR, BraseroFileMonitorPrivate))
 
 G_DEFINE_TYPE (BraseroFileMonitor, brasero_file_monitor, G_TYPE_OBJECT);
@@ -80,6 +96,28 @@ struct _BraseroInotifyFileData {
 };
 typedef struct _BraseroInotifyFileData BraseroInotifyFileData;
 
+typedef enum {
+	BRASERO_INOTIFY_REMOVED		= 1,
+	BRASERO_INOTIFY_ADDED		= 1 << 1,
+	BRASERO_INOTIFY_MODIFIED	= 1 << 2
+} BraseroInotifyChangeFlags;
+
+struct _BraseroInotifyChange {
+	gchar *name;
+	BraseroInotifyChangeFlags flags;
+};
+typedef struct _BraseroInotifyChange BraseroInotifyChange;
+
+struct _BraseroInotifyDirChanges {
+	gint wd;
+	gpointer callback_data;
+
+	/* name => BraseroInotifyChange, kept in the order of the events */
+	GHashTable *names;
+	GPtrArray *changes;
+};
+typedef struct _BraseroInotifyDirChanges BraseroInotifyDirChanges;
+
 struct _BraseroFileMonitorCancelForeach {
 	gpointer callback_data;
 	BraseroMonitorFindFunc func;
@@ -471,111 +509,281 @@ brasero_file_monitor_inotify_file_event (BraseroFileMonitor *self,
 					      event);
 }
 
+static void
+brasero_file_monitor_dir_changes_free (BraseroInotifyDirChanges *dir)
+{
+	guint i;
+
+	for (i = 0; i < dir->changes->len; i ++) {
+		BraseroInotifyChange *change;
+
+		change = g_ptr_array_index (dir->changes, i);
+		g_free (change->name);
+		g_free (change);
+	}
+
+	g_ptr_array_free (dir->changes, TRUE);
+	g_hash_table_destroy (dir->names);
+	g_free (dir);
+}
+
+static void
+brasero_file_monitor_dir_changes_report (BraseroFileMonitor *self,
+					 BraseroInotifyDirChanges *dir)
+{
+	BraseroFileMonitorClass *klass;
+	guint i;
+
+	klass = BRASERO_FILE_MONITOR_GET_CLASS (self);
+
+	BRASERO_BURN_LOG ("File Monitoring (%u coalesced changes)", dir->changes->len);
+
+	for (i = 0; i < dir->changes->len; i ++) {
+		BraseroInotifyChange *change;
+
+		change = g_ptr_array_index (dir->changes, i);
+
+		/* A file replaced by another is removed first */
+		if ((change->flags & BRASERO_INOTIFY_REMOVED) && klass->file_removed)
+			klass->file_removed (self,
+					     BRASERO_FILE_MONITOR_FOLDER,
+					     dir->callback_data,
+					     change->name);
+
+		if ((change->flags & BRASERO_INOTIFY_ADDED) && klass->file_added)
+			klass->file_added (self, dir->callback_data, change->name);
+
+		if ((change->flags & BRASERO_INOTIFY_MODIFIED) && klass->file_modified)
+			klass->file_modified (self, dir->callback_data, change->name);
+	}
+}
+
+static void
+brasero_file_monitor_flush (BraseroFileMonitor *self)
+{
+	BraseroFileMonitorPrivate *priv;
+	BraseroFileMonitorClass *klass;
+
+	priv = BRASERO_FILE_MONITOR_PRIVATE (self);
+	klass = BRASERO_FILE_MONITOR_GET_CLASS (self);
+
+	if (priv->pending_id) {
+		g_source_remove (priv->pending_id);
+		priv->pending_id = 0;
+	}
+
+	if (!priv->pending_order)
+		return;
+
+	/* Directories are reported one at a time since reporting changes can
+	 * cancel the monitoring of other directories (and their changes) */
+	priv->pending_order = g_slist_reverse (priv->pending_order);
+
+	if (klass->batch_begin)
+		klass->batch_begin (self);
+
+	while (priv->pending_order) {
+		BraseroInotifyDirChanges *dir;
+
+		dir = priv->pending_order->data;
+		priv->pending_order = g_slist_delete_link (priv->pending_order, priv->pending_order);
+		g_hash_table_remove (priv->pending, GINT_TO_POINTER (dir->wd));
+
+		brasero_file_monitor_dir_changes_report (self, dir);
+		brasero_file_monitor_dir_changes_free (dir);
+	}
+
+	if (klass->batch_end)
+		klass->batch_end (self);
+}
+
 static gboolean
-brasero_file_monitor_inotify_monitor_cb (GIOChannel *channel,
-					 GIOCondition condition,
-					 BraseroFileMonitor *self)
+brasero_file_monitor_flush_cb (gpointer data)
 {
+	BraseroFileMonitor *self = BRASERO_FILE_MONITOR (data);
 	BraseroFileMonitorPrivate *priv;
-	struct inotify_event event;
-	gpointer callback_data;
-	GError *err = NULL;
-	GIOStatus status;
-	gchar *name;
-	gsize size;
 
 	priv = BRASERO_FILE_MONITOR_PRIVATE (self);
-	while (condition & G_IO_IN) {
-		callback_data = NULL;
-
-		status = g_io_channel_read_chars (channel,
-						  (char *) &event,
-						  sizeof (struct inotify_event),
-						  &size, &err);
-		if (status == G_IO_STATUS_EOF)
-			return TRUE;
-
-		if (event.len) {
-			name = g_new (char, event.len + 1);
-
-			name [event.len] = '\0';
-
-			status = g_io_channel_read_chars (channel,
-							  name,
-							  event.len,
-							  &size,
-							  &err);
-			if (status != G_IO_STATUS_NORMAL) {
-				g_warning ("Error reading inotify: %s\n",
-					   err ? "Unknown error" : err->message);
-				g_error_free (err);
-				return TRUE;
-			}
-		}
+	priv->pending_id = 0;
+
+	brasero_file_monitor_flush (self);
+	return FALSE;
+}
+
+/**
+ * When a watched tree is regenerated, the same files are usually created,
+ * modified and removed many times in a row. Only the final state of each
+ * file is reported once the storm is over.
+ */
+
+static gboolean
+brasero_file_monitor_coalesce_event (BraseroFileMonitor *self,
+				     gpointer callback_data,
+				     const gchar *name,
+				     struct inotify_event *event)
+{
+	BraseroFileMonitorPrivate *priv;
+	BraseroInotifyDirChanges *dir;
+	BraseroInotifyChange *change;
+
+	/* Moves must be matched with their cookie in the order they happen */
+	if (!(event->mask & (IN_CREATE|IN_DELETE|IN_MODIFY|IN_ATTRIB))
+	||   (event->mask & (IN_MOVED_FROM|IN_MOVED_TO|IN_UNMOUNT)))
+		return FALSE;
+
+	priv = BRASERO_FILE_MONITOR_PRIVATE (self);
+
+	dir = g_hash_table_lookup (priv->pending, GINT_TO_POINTER (event->wd));
+	if (!dir) {
+		dir = g_new0 (BraseroInotifyDirChanges, 1);
+		dir->wd = event->wd;
+		dir->callback_data = callback_data;
+		dir->names = g_hash_table_new (g_str_hash, g_str_equal);
+		dir->changes = g_ptr_array_new ();
+
+		g_hash_table_insert (priv->pending, GINT_TO_POINTER (event->wd), dir);
+		priv->pending_order = g_slist_prepend (priv->pending_order, dir);
+	}
+
+	change = g_hash_table_lookup (dir->names, name);
+	if (!change) {
+		change = g_new0 (BraseroInotifyChange, 1);
+		change->name = g_strdup (name);
+		g_hash_table_insert (dir->names, change->name, change);
+		g_ptr_array_add (dir->changes, change);
+	}
+
+	if (event->mask & IN_CREATE) {
+		change->flags |= BRASERO_INOTIFY_ADDED;
+		change->flags &= ~BRASERO_INOTIFY_MODIFIED;
+	}
+	else if (event->mask & IN_DELETE) {
+		/* A file created and removed in between is just forgotten */
+		if (change->flags & BRASERO_INOTIFY_ADDED)
+			change->flags &= ~BRASERO_INOTIFY_ADDED;
 		else
-			name = NULL;
+			change->flags = BRASERO_INOTIFY_REMOVED;
+	}
+	else if (!(change->flags & BRASERO_INOTIFY_ADDED))
+		change->flags |= BRASERO_INOTIFY_MODIFIED;
 
-		/* look for ignored signal usually following deletion */
-		if (event.mask & IN_IGNORED) {
-			GSList *list;
+	if (!priv->pending_id)
+		priv->pending_id = g_timeout_add (BRASERO_INOTIFY_COALESCE_DELAY,
+						  brasero_file_monitor_flush_cb,
+						  self);
+	return TRUE;
+}
 
-			list = g_hash_table_lookup (priv->files, GINT_TO_POINTER (event.wd));
-			if (list) {
-				g_slist_foreach (list, (GFunc) g_free, NULL);
-				g_slist_free (list);
-				g_hash_table_remove (priv->files, GINT_TO_POINTER (event.wd));
-			}
+static void
+brasero_file_monitor_inotify_event (BraseroFileMonitor *self,
+				    gint dev_fd,
+				    struct inotify_event *event)
+{
+	BraseroFileMonitorPrivate *priv;
+	gpointer callback_data;
+	const gchar *name;
 
-			g_hash_table_remove (priv->directories, GINT_TO_POINTER (event.wd));
+	priv = BRASERO_FILE_MONITOR_PRIVATE (self);
 
-			if (name) {
-				g_free (name);
-				name = NULL;
-			}
+	/* The name is padded with NUL bytes */
+	name = event->len? event->name:NULL;
 
-			condition = g_io_channel_get_buffer_condition (channel);
-			continue;
+	/* look for ignored signal usually following deletion */
+	if (event->mask & IN_IGNORED) {
+		GSList *list;
+
+		list = g_hash_table_lookup (priv->files, GINT_TO_POINTER (event->wd));
+		if (list) {
+			g_slist_foreach (list, (GFunc) g_free, NULL);
+			g_slist_free (list);
+			g_hash_table_remove (priv->files, GINT_TO_POINTER (event->wd));
 		}
 
-		callback_data = g_hash_table_lookup (priv->files, GINT_TO_POINTER (event.wd));
-		if (!callback_data) {
-			/* Retry with children */
-			callback_data = g_hash_table_lookup (priv->directories, GINT_TO_POINTER (event.wd));
-			if (name && callback_data) {
-				/* For directories we don't take heed of the SELF events.
-				 * All events are treated through the parent directory
-				 * events. */
-				brasero_file_monitor_directory_event (self,
-								      BRASERO_FILE_MONITOR_FOLDER,
-								      callback_data,
-								      name,
-								      &event);
-			}
-			else {
-				int dev_fd;
+		g_hash_table_remove (priv->directories, GINT_TO_POINTER (event->wd));
+		return;
+	}
 
-				dev_fd = g_io_channel_unix_get_fd (channel);
-				inotify_rm_watch (dev_fd, event.wd);
-			}
-		}
-		else {
-			GSList *list;
-
-			/* This is an event happening on the top directory there */
-			list = callback_data;
-			brasero_file_monitor_inotify_file_event (self,
-								 list,
-								 name,
-								 &event);
+	callback_data = g_hash_table_lookup (priv->files, GINT_TO_POINTER (event->wd));
+	if (!callback_data) {
+		/* Retry with children */
+		callback_data = g_hash_table_lookup (priv->directories, GINT_TO_POINTER (event->wd));
+		if (name && callback_data) {
+			if (brasero_file_monitor_coalesce_event (self, callback_data, name, event))
+				return;
+
+			/* Changes that were coalesced happened before */
+			brasero_file_monitor_flush (self);
+
+			/* For directories we don't take heed of the SELF events.
+			 * All events are treated through the parent directory
+			 * events. */
+			brasero_file_monitor_directory_event (self,
+							      BRASERO_FILE_MONITOR_FOLDER,
+							      callback_data,
+							      name,
+							      event);
 		}
+		else
+			inotify_rm_watch (dev_fd, event->wd);
+	}
+	else {
+		GSList *list;
 
-		if (name) {
-			g_free (name);
-			name = NULL;
-		}
+		brasero_file_monitor_flush (self);
 
-		condition = g_io_channel_get_buffer_condition (channel);
+		/* This is an event happening on the top directory there */
+		list = callback_data;
+		brasero_file_monitor_inotify_file_event (self,
+							 list,
+							 name,
+							 event);
 	}
+}
+
+static gboolean
+brasero_file_monitor_inotify_monitor_cb (GIOChannel *channel,
+					 GIOCondition condition,
+					 BraseroFileMonitor *self)
+{
+	BraseroFileMonitorPrivate *priv;
+	BraseroFileMonitorClass *klass;
+	gssize size;
+	gssize offset;
+	gint dev_fd;
+
+	if (!(condition & G_IO_IN))
+		return TRUE;
+
+	priv = BRASERO_FILE_MONITOR_PRIVATE (self);
+	klass = BRASERO_FILE_MONITOR_GET_CLASS (self);
+
+	/* Read all the events available at once; inotify only returns whole
+	 * events. If more are queued we'll be called again. */
+	dev_fd = g_io_channel_unix_get_fd (channel);
+	size = read (dev_fd, priv->buffer, BRASERO_INOTIFY_BUFFER_SIZE);
+	if (size <= 0) {
+		if (size < 0 && errno != EINTR && errno != EAGAIN)
+			g_warning ("Error reading inotify: %s\n", g_strerror (errno));
+
+		return TRUE;
+	}
+
+	if (klass->batch_begin)
+		klass->batch_begin (self);
+
+	for (offset = 0; offset + (gssize) sizeof (struct inotify_event) <= size;) {
+		struct inotify_event *event;
+
+		event = (struct inotify_event *) (priv->buffer + offset);
+		offset += sizeof (struct inotify_event) + event->len;
+		if (offset > size)
+			break;
+
+		brasero_file_monitor_inotify_event (self, dev_fd, event);
+	}
+
+	if (klass->batch_end)
+		klass->batch_end (self);
 
 	return TRUE;
 }
@@ -790,6 +998,19 @@ brasero_file_monitor_foreach_cancel (BraseroFileMonitor *self,
 				     brasero_file_monitor_foreach_cancel_directory_cb,
 				     &data);
 
+	/* Forget about the changes that were not reported yet */
+	for (iter = priv->pending_order; iter; iter = next) {
+		BraseroInotifyDirChanges *dir;
+
+		dir = iter->data;
+		next = iter->next;
+		if (func (dir->callback_data, callback_data)) {
+			priv->pending_order = g_slist_remove (priv->pending_order, dir);
+			g_hash_table_remove (priv->pending, GINT_TO_POINTER (dir->wd));
+			brasero_file_monitor_dir_changes_free (dir);
+		}
+	}
+
 	/* Finally get rid of moved that data in moved list */
 	for (iter = priv->moved_list; iter; iter = next) {
 		BraseroInotifyMovedData *data;
@@ -839,6 +1060,17 @@ brasero_file_monitor_reset (BraseroFileMonitor *self)
 	BraseroFileMonitorPrivate *priv;
 
 	priv = BRASERO_FILE_MONITOR_PRIVATE (self);
+
+	if (priv->pending_id) {
+		g_source_remove (priv->pending_id);
+		priv->pending_id = 0;
+	}
+
+	g_slist_foreach (priv->pending_order, (GFunc) brasero_file_monitor_dir_changes_free, NULL);
+	g_slist_free (priv->pending_order);
+	priv->pending_order = NULL;
+	g_hash_table_remove_all (priv->pending);
+
 	g_hash_table_foreach_remove (priv->files,
 				     brasero_file_monitor_foreach_file_reset_cb,
 				     GINT_TO_POINTER (g_io_channel_unix_get_fd (priv->notify)));
@@ -858,6 +1090,8 @@ brasero_file_monitor_init (BraseroFileMonitor *object)
 
 	priv->files = g_hash_table_new (g_direct_hash, g_direct_equal);
 	priv->directories = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->buffer = g_malloc (BRASERO_INOTIFY_BUFFER_SIZE);
 
 	/* start inotify monitoring backend */
 	fd = inotify_init ();
@@ -889,6 +1123,8 @@ brasero_file_monitor_finalize (GObject *object)
 
 	g_hash_table_destroy (priv->files);
 	g_hash_table_destroy (priv->directories);
+	g_hash_table_destroy (priv->pending);
+	g_free (priv->buffer);
 
 	G_OBJECT_CLASS (brasero_file_monitor_parent_class)->finalize (object);
 }
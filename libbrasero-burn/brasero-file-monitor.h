@@ -82,6 +82,10 @@ struct _BraseroFileMonitorClass
 	void		(*file_modified)	(BraseroFileMonitor *monitor,
 						 gpointer callback_data,
 						 const gchar *name);
+
+	/* Changes read or coalesced together are reported between these */
+	void		(*batch_begin)		(BraseroFileMonitor *monitor);
+	void		(*batch_end)		(BraseroFileMonitor *monitor);
 };
 
 struct _BraseroFileMonitor
@@ -39,11 +39,167 @@
 #include "brasero-misc.h"
 
 #include "burn-basics.h"
+#include "burn-iso-image.h"
 
 #include "brasero-file-node.h"
 #include "brasero-io.h"
 
 
+/**
+ * The records of a directory in an image only depend on the names and types
+ * of its children. So they are cached per directory and only the directories
+ * whose children changed (marked dirty) are computed again when the size of
+ * the image is asked.
+ * A dirty directory is laid out again with all its children: mangled names,
+ * their collision suffixes and the way records are packed into sectors all
+ * depend on the siblings, so the change of one child can't simply be added to
+ * or removed from the totals. Several changes to the same directory between
+ * two requests only cost one layout though.
+ */
+
+static void
+brasero_file_node_records_forget (BraseroFileTreeStats *stats,
+				  BraseroFileNode *node)
+{
+	BraseroIsoDirSize *size;
+
+	if (stats->dirty)
+		g_hash_table_remove (stats->dirty, node);
+
+	if (!stats->records)
+		return;
+
+	size = g_hash_table_lookup (stats->records, node);
+	if (!size)
+		return;
+
+	stats->iso_records -= size->records;
+	stats->joliet_records -= size->joliet_records;
+	stats->path_table -= size->path_table;
+	stats->joliet_path_table -= size->joliet_path_table;
+	g_hash_table_remove (stats->records, node);
+}
+
+static void
+brasero_file_node_records_changed (BraseroFileTreeStats *stats,
+				   BraseroFileNode *node)
+{
+	if (!stats || !node || node->is_file)
+		return;
+
+	if (!stats->dirty)
+		stats->dirty = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	g_hash_table_insert (stats->dirty, node, node);
+}
+
+/* Used when a directory enters or leaves the tree with all its descendants */
+static void
+brasero_file_node_records_subtree (BraseroFileTreeStats *stats,
+				   BraseroFileNode *node,
+				   gboolean added)
+{
+	BraseroFileNode *child;
+
+	if (!stats || node->is_file)
+		return;
+
+	if (added)
+		brasero_file_node_records_changed (stats, node);
+	else
+		brasero_file_node_records_forget (stats, node);
+
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next)
+		brasero_file_node_records_subtree (stats, child, added);
+}
+
+static void
+brasero_file_node_records_update (BraseroFileTreeStats *stats,
+				  BraseroFileNode *node)
+{
+	BraseroIsoDirSize *size;
+	BraseroFileNode *child;
+	gboolean *is_dir;
+	const gchar **names;
+	guint num = 0;
+
+	brasero_file_node_records_forget (stats, node);
+	if (node->is_file || BRASERO_FILE_NODE_VIRTUAL (node))
+		return;
+
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next)
+		num ++;
+
+	names = g_new (const gchar *, num + 1);
+	is_dir = g_new (gboolean, num + 1);
+
+	num = 0;
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next) {
+		if (BRASERO_FILE_NODE_VIRTUAL (child))
+			continue;
+
+		names [num] = BRASERO_FILE_NODE_NAME (child);
+		is_dir [num] = !child->is_file;
+		num ++;
+	}
+
+	size = g_new (BraseroIsoDirSize, 1);
+	brasero_iso_image_get_directory_size (names, is_dir, num, node->is_root, size);
+	g_free (names);
+	g_free (is_dir);
+
+	if (!stats->records)
+		stats->records = g_hash_table_new_full (g_direct_hash,
+							g_direct_equal,
+							NULL,
+							g_free);
+
+	g_hash_table_insert (stats->records, node, size);
+	stats->iso_records += size->records;
+	stats->joliet_records += size->joliet_records;
+	stats->path_table += size->path_table;
+	stats->joliet_path_table += size->joliet_path_table;
+}
+
+/**
+ * Returns the exact number of blocks of an image of the tree as created by
+ * burn-iso-image.c; data_blocks is the size of the contents of files.
+ */
+
+goffset
+brasero_file_node_get_image_blocks (BraseroFileNode *root,
+				    BraseroImageFS fs_type,
+				    goffset data_blocks)
+{
+	BraseroFileTreeStats *stats;
+
+	stats = BRASERO_FILE_NODE_STATS (root);
+	if (!stats)
+		return data_blocks;
+
+	if (stats->dirty) {
+		GHashTableIter iter;
+		GHashTable *dirty;
+		gpointer node;
+
+		dirty = stats->dirty;
+		stats->dirty = NULL;
+
+		g_hash_table_iter_init (&iter, dirty);
+		while (g_hash_table_iter_next (&iter, &node, NULL))
+			brasero_file_node_records_update (stats, node);
+
+		g_hash_table_destroy (dirty);
+	}
+
+	return brasero_iso_image_get_volume_size (fs_type,
+						  stats->iso_records,
+						  stats->joliet_records,
+						  stats->path_table,
+						  stats->joliet_path_table,
+						  data_blocks);
+}
+
 BraseroFileNode *
 brasero_file_node_root_new (void)
 {
@@ -54,6 +210,7 @@ brasero_file_node_root_new (void)
 	root->is_imported = TRUE;
 
 	root->union3.stats = g_new0 (BraseroFileTreeStats, 1);
+	brasero_file_node_records_changed (root->union3.stats, root);
 	return root;
 }
 
@@ -747,6 +904,10 @@ void
 brasero_file_node_rename (BraseroFileNode *node,
 			  const gchar *name)
 {
+	if (node->parent && !BRASERO_FILE_NODE_VIRTUAL (node))
+		brasero_file_node_records_changed (brasero_file_node_get_tree_stats (node->parent, NULL),
+						   node->parent);
+
 	g_free (BRASERO_FILE_NODE_NAME (node));
 	if (node->is_grafted)
 		node->union1.graft->name = g_strdup (name);
@@ -754,24 +915,71 @@ brasero_file_node_rename (BraseroFileNode *node,
 		node->union1.name = g_strdup (name);
 }
 
+static BraseroFileNode *
+brasero_file_node_insert_after (BraseroFileNode *head,
+				BraseroFileNode *hint,
+				BraseroFileNode *node,
+				GCompareFunc sort_func)
+{
+	BraseroFileNode *iter;
+
+	/* The search can only start from hint if it is a regular node that
+	 * is sorted before node; otherwise start from the beginning. */
+	if (!hint
+	||  hint->is_hidden
+	||  node->is_hidden
+	||  sort_func (hint, node) > 0)
+		return brasero_file_node_insert (head, node, sort_func, NULL);
+
+	for (iter = hint; iter->next; iter = iter->next) {
+		if (sort_func (iter->next, node) > 0)
+			break;
+	}
+
+	node->next = iter->next;
+	iter->next = node;
+	return head;
+}
+
 void
 brasero_file_node_add (BraseroFileNode *parent,
 		       BraseroFileNode *node,
 		       GCompareFunc sort_func)
+{
+	brasero_file_node_add_after (parent, NULL, node, sort_func);
+}
+
+/**
+ * Same as above except that the position is searched from hint which must be
+ * a child of parent. Adding a sorted list of nodes this way, each one after
+ * the previous one, merges it with the children in one pass.
+ */
+
+void
+brasero_file_node_add_after (BraseroFileNode *parent,
+			     BraseroFileNode *hint,
+			     BraseroFileNode *node,
+			     GCompareFunc sort_func)
 {
 	BraseroFileTreeStats *stats;
 	guint depth = 0;
 
-	parent->union2.children = brasero_file_node_insert (BRASERO_FILE_NODE_CHILDREN (parent),
-							    node,
-							    sort_func,
-							    NULL);
+	if (hint && hint->parent != parent)
+		hint = NULL;
+
+	parent->union2.children = brasero_file_node_insert_after (BRASERO_FILE_NODE_CHILDREN (parent),
+								  hint,
+								  node,
+								  sort_func);
 	node->parent = parent;
 
 	if (BRASERO_FILE_NODE_VIRTUAL (node))
 		return;
 
 	stats = brasero_file_node_get_tree_stats (node->parent, &depth);
+	brasero_file_node_records_changed (stats, parent);
+	brasero_file_node_records_subtree (stats, node, TRUE);
+
 	if (!node->is_imported) {
 		/* book keeping */
 		if (!node->is_file)
@@ -821,10 +1029,16 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 		if (!node->is_file && (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)) {
 			stats->children ++;
 			stats->num_dir --;
+
+			/* File names have a version number in records */
+			brasero_file_node_records_forget (stats, node);
+			brasero_file_node_records_changed (stats, node->parent);
 		}
 		else if (node->is_file && (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)) {
 			stats->children --;
 			stats->num_dir ++;
+
+			brasero_file_node_records_changed (stats, node->parent);
 		}
 	}
 
@@ -883,8 +1097,12 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 				break;
 		}
 	}
-	else	/* since that's directory then it must be explored now */
+	else {
+		/* since that's directory then it must be explored now */
 		node->is_exploring = TRUE;
+		if (node->parent)
+			brasero_file_node_records_changed (stats, node);
+	}
 }
 
 BraseroFileNode *
@@ -970,6 +1188,15 @@ brasero_file_node_unlink (BraseroFileNode *node)
 	if (!node->parent)
 		return;
 
+	if (!BRASERO_FILE_NODE_VIRTUAL (node)) {
+		BraseroFileTreeStats *stats;
+
+		/* The directory and its descendants leave the tree */
+		stats = brasero_file_node_get_tree_stats (node->parent, NULL);
+		brasero_file_node_records_changed (stats, node->parent);
+		brasero_file_node_records_subtree (stats, node, FALSE);
+	}
+
 	iter = BRASERO_FILE_NODE_CHILDREN (node->parent);
 
 	/* handle the size change for previous parent */
@@ -1077,6 +1304,9 @@ brasero_file_node_move_to (BraseroFileNode *node,
 	/* NOTE: here stats about the tree can change if the parent has a depth
 	 * > 6 and if previous didn't. Other stats remains unmodified. */
 	stats = brasero_file_node_get_tree_stats (node->parent, &depth);
+	brasero_file_node_records_changed (stats, node->parent);
+	brasero_file_node_records_subtree (stats, node, TRUE);
+
 	if (node->is_file) {
 		if (depth < 6)
 			return;
@@ -1126,6 +1356,9 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 		}
 	}
 
+	if (stats && !node->is_file)
+		brasero_file_node_records_forget (stats, node);
+
 	/* destruction */
 	import = BRASERO_FILE_NODE_IMPORT (node);
 	graft = BRASERO_FILE_NODE_GRAFT (node);
@@ -1158,8 +1391,17 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 	if (node->is_file && !node->is_imported && BRASERO_FILE_NODE_MIME (node))
 		brasero_utils_unregister_string (BRASERO_FILE_NODE_MIME (node));
 
-	if (node->is_root)
-		g_free (BRASERO_FILE_NODE_STATS (node));
+	if (node->is_root) {
+		BraseroFileTreeStats *root_stats;
+
+		root_stats = BRASERO_FILE_NODE_STATS (node);
+		if (root_stats->records)
+			g_hash_table_destroy (root_stats->records);
+		if (root_stats->dirty)
+			g_hash_table_destroy (root_stats->dirty);
+
+		g_free (root_stats);
+	}
 
 	g_free (node);
 }
@@ -68,6 +68,7 @@ typedef struct _BraseroImport BraseroImport;
  * - number of children (files+directories)
  * - number of deep directories
  * - number of files over 2 GiB
+ * - size of the directory records and path tables in an image
  */
 
 struct _BraseroFileTreeStats {
@@ -76,6 +77,16 @@ struct _BraseroFileTreeStats {
 	guint num_deep;
 	guint num_2GiB;
 	guint num_sym;
+
+	/* Records (BraseroIsoDirSize) of each directory and the directories
+	 * whose contents changed since they were last computed. */
+	GHashTable *records;
+	GHashTable *dirty;
+
+	guint64 iso_records;
+	guint64 joliet_records;
+	guint64 path_table;
+	guint64 joliet_path_table;
 };
 typedef struct _BraseroFileTreeStats BraseroFileTreeStats;
 
@@ -207,6 +218,11 @@ BraseroFileTreeStats *
 brasero_file_node_get_tree_stats (BraseroFileNode *node,
 				  guint *depth);
 
+goffset
+brasero_file_node_get_image_blocks (BraseroFileNode *root,
+				    BraseroImageFS fs_type,
+				    goffset data_blocks);
+
 BraseroFileNode *
 brasero_file_node_nth_child (BraseroFileNode *parent,
 			     guint nth);
@@ -246,6 +262,11 @@ void
 brasero_file_node_add (BraseroFileNode *parent,
 		       BraseroFileNode *child,
 		       GCompareFunc sort_func);
+void
+brasero_file_node_add_after (BraseroFileNode *parent,
+			     BraseroFileNode *hint,
+			     BraseroFileNode *child,
+			     GCompareFunc sort_func);
 
 BraseroFileNode *
 brasero_file_node_new (const gchar *name);
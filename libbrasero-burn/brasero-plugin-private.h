@@ -69,6 +69,9 @@ gboolean
 brasero_plugin_get_process_flags (BraseroPlugin *plugin,
 				  BraseroPluginProcessFlag *flags);
 
+gboolean
+brasero_plugin_get_shares_duplicates (BraseroPlugin *plugin);
+
 gboolean
 brasero_plugin_check_image_flags (BraseroPlugin *plugin,
 				  BraseroMedia media,
@@ -88,6 +91,12 @@ brasero_plugin_check_media_restrictions (BraseroPlugin *plugin,
 void
 brasero_plugin_check_plugin_ready (BraseroPlugin *plugin);
 
+void
+brasero_plugin_test_apps_defer (void);
+
+void
+brasero_plugin_test_apps_run (void);
+
 G_END_DECLS
 
 #endif
@@ -76,6 +76,10 @@ void
 brasero_plugin_set_compulsory (BraseroPlugin *self,
 			       gboolean compulsory);
 
+void
+brasero_plugin_set_shares_duplicates (BraseroPlugin *self,
+				      gboolean shares);
+
 void
 brasero_plugin_register_group (BraseroPlugin *plugin,
 			       const gchar *name);
@@ -52,9 +52,11 @@
 #include "brasero-tags.h"
 #include "brasero-track-image.h"
 #include "brasero-track-data-cfg.h"
+#include "brasero-track-data-cfg-private.h"
 #include "brasero-session-cfg.h"
 #include "brasero-burn-lib.h"
 #include "brasero-session-helper.h"
+#include "brasero-caps-burn.h"
 
 
 /**
@@ -67,6 +69,14 @@
  * made to the various parameters.
  **/
 
+typedef struct _BraseroSessionCfgTrack BraseroSessionCfgTrack;
+struct _BraseroSessionCfgTrack
+{
+	goffset blocks;
+	goffset bytes;
+	BraseroBurnResult status;
+};
+
 typedef struct _BraseroSessionCfgPrivate BraseroSessionCfgPrivate;
 struct _BraseroSessionCfgPrivate
 {
@@ -82,12 +92,25 @@ struct _BraseroSessionCfgPrivate
 	goffset session_blocks;
 	goffset session_size;
 
+	/* Size and status of each track kept up to date from the track
+	 * signals so that only the tracks that changed are looked at */
+	GHashTable *tracks;
+	goffset tracks_blocks;
+	goffset tracks_bytes;
+	guint tracks_not_ready;
+	guint tracks_error;
+
 	BraseroSessionError is_valid;
 
+	guint update_id;
+
 	guint CD_TEXT_modified:1;
 	guint configuring:1;
 	guint disabled:1;
 
+	guint update_full:1;
+	guint update_drive:1;
+
 	guint output_msdos:1;
 };
 
@@ -390,6 +413,28 @@ brasero_session_cfg_get_output_format (BraseroBurnSession *session)
 	return priv->output_format;
 }
 
+static void
+brasero_session_cfg_run_update (BraseroSessionCfg *self);
+
+/**
+ * Runs a pending idle update right away so that
+ * the status read afterwards is not outdated.
+ */
+
+static void
+brasero_session_cfg_flush_update (BraseroSessionCfg *self)
+{
+	BraseroSessionCfgPrivate *priv;
+
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+	if (!priv->update_id)
+		return;
+
+	g_source_remove (priv->update_id);
+	priv->update_id = 0;
+	brasero_session_cfg_run_update (self);
+}
+
 /**
  * brasero_session_cfg_get_error:
  * @session: a #BraseroSessionCfg
@@ -407,6 +452,9 @@ brasero_session_cfg_get_error (BraseroSessionCfg *session)
 
 	priv = BRASERO_SESSION_CFG_PRIVATE (session);
 
+	/* Don't return an outdated status */
+	brasero_session_cfg_flush_update (session);
+
 	if (priv->is_valid == BRASERO_SESSION_VALID
 	&&  priv->CD_TEXT_modified)
 		return BRASERO_SESSION_NO_CD_TEXT;
@@ -558,6 +606,9 @@ brasero_session_cfg_set_drive_properties_flags (BraseroSessionCfg *self,
 
 	priv = BRASERO_SESSION_CFG_PRIVATE (self);
 
+	/* Don't decide on an outdated status */
+	brasero_session_cfg_flush_update (self);
+
 	original_flags = brasero_burn_session_get_flags (BRASERO_BURN_SESSION (self));
 
 	/* If the session is invalid no need to check the flags: just add them.
@@ -837,10 +888,10 @@ brasero_session_cfg_check_size (BraseroSessionCfg *self)
 			priv->session_blocks = g_value_get_int64 (value);
 			priv->session_size = priv->session_blocks * 2352;
 		}
-		else
-			brasero_burn_session_get_size (BRASERO_BURN_SESSION (self),
-						       &priv->session_blocks,
-						       &priv->session_size);
+		else {
+			priv->session_blocks = priv->tracks_blocks;
+			priv->session_size = priv->tracks_bytes;
+		}
 	}
 
 	/* Get the disc and its size if need be */
@@ -930,12 +981,109 @@ brasero_session_cfg_set_tracks_audio_format (BraseroBurnSession *session,
 	}
 }
 
+static void
+brasero_session_cfg_track_forget (BraseroSessionCfg *self,
+				  BraseroSessionCfgTrack *info)
+{
+	BraseroSessionCfgPrivate *priv;
+
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+
+	priv->tracks_blocks -= info->blocks;
+	priv->tracks_bytes -= info->bytes;
+
+	if (info->status == BRASERO_BURN_NOT_READY || info->status == BRASERO_BURN_RUNNING)
+		priv->tracks_not_ready --;
+	else if (info->status != BRASERO_BURN_OK)
+		priv->tracks_error --;
+}
+
+static void
+brasero_session_cfg_track_refresh (BraseroSessionCfg *self,
+				   BraseroTrack *track)
+{
+	BraseroSessionCfgPrivate *priv;
+	BraseroSessionCfgTrack *info;
+	BraseroBurnResult result;
+	BraseroStatus *status;
+
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+
+	info = g_hash_table_lookup (priv->tracks, track);
+	if (info)
+		brasero_session_cfg_track_forget (self, info);
+	else {
+		info = g_new0 (BraseroSessionCfgTrack, 1);
+		g_hash_table_insert (priv->tracks, track, info);
+	}
+
+	/* Same as brasero_burn_session_get_size () */
+	info->blocks = 0;
+	info->bytes = 0;
+	result = brasero_track_get_size (track, &info->blocks, &info->bytes);
+	if (result != BRASERO_BURN_OK && result != BRASERO_BURN_NOT_READY) {
+		info->blocks = 0;
+		info->bytes = 0;
+	}
+
+	status = brasero_status_new ();
+	info->status = brasero_track_get_status (track, status);
+	g_object_unref (status);
+
+	priv->tracks_blocks += info->blocks;
+	priv->tracks_bytes += info->bytes;
+
+	if (info->status == BRASERO_BURN_NOT_READY || info->status == BRASERO_BURN_RUNNING)
+		priv->tracks_not_ready ++;
+	else if (info->status != BRASERO_BURN_OK)
+		priv->tracks_error ++;
+}
+
+static void
+brasero_session_cfg_track_remove (BraseroSessionCfg *self,
+				  BraseroTrack *track)
+{
+	BraseroSessionCfgPrivate *priv;
+	BraseroSessionCfgTrack *info;
+
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+
+	info = g_hash_table_lookup (priv->tracks, track);
+	if (!info)
+		return;
+
+	brasero_session_cfg_track_forget (self, info);
+	g_hash_table_remove (priv->tracks, track);
+}
+
+static void
+brasero_session_cfg_refresh_not_ready (BraseroSessionCfg *self)
+{
+	BraseroSessionCfgPrivate *priv;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+
+	/* Tracks that are not ready yet don't always signal their progress so
+	 * those are the only ones that need to be asked again */
+	g_hash_table_iter_init (&iter, priv->tracks);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		BraseroSessionCfgTrack *info = value;
+
+		if (info->status == BRASERO_BURN_NOT_READY
+		||  info->status == BRASERO_BURN_RUNNING)
+			brasero_session_cfg_track_refresh (self, key);
+	}
+}
+
 static gboolean
 brasero_session_cfg_can_update (BraseroSessionCfg *self)
 {
 	BraseroSessionCfgPrivate *priv;
 	BraseroBurnResult result;
 	BraseroStatus *status;
+	BraseroDrive *burner;
 
 	priv = BRASERO_SESSION_CFG_PRIVATE (self);
 
@@ -945,6 +1093,25 @@ brasero_session_cfg_can_update (BraseroSessionCfg *self)
 	if (priv->configuring)
 		return FALSE;
 
+	if (priv->tracks_not_ready)
+		brasero_session_cfg_refresh_not_ready (self);
+
+	/* Use our summary when no track failed; otherwise let the session
+	 * find the track with the error to know what happened */
+	if (!priv->tracks_error) {
+		burner = brasero_burn_session_get_burner (BRASERO_BURN_SESSION (self));
+		if (priv->tracks_not_ready
+		|| (burner && brasero_drive_probing (burner))) {
+			priv->is_valid = BRASERO_SESSION_NOT_READY;
+			g_signal_emit (self,
+				       session_cfg_signals [IS_VALID_SIGNAL],
+				       0);
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
 	/* Make sure the session is ready */
 	status = brasero_status_new ();
 	result = brasero_burn_session_get_status (BRASERO_BURN_SESSION (self), status);
@@ -981,6 +1148,22 @@ brasero_session_cfg_can_update (BraseroSessionCfg *self)
 	return TRUE;
 }
 
+static void
+brasero_session_cfg_set_shares_duplicates (BraseroSessionCfg *self)
+{
+	gboolean shares;
+	GSList *tracks;
+
+	/* Only some backends write identical files once so the tracks
+	 * can't know by themselves whether their size can be reduced */
+	shares = brasero_burn_session_shares_duplicates (BRASERO_BURN_SESSION (self));
+	tracks = brasero_burn_session_get_tracks (BRASERO_BURN_SESSION (self));
+	for (; tracks; tracks = tracks->next) {
+		if (BRASERO_IS_TRACK_DATA_CFG (tracks->data))
+			brasero_track_data_cfg_set_imager_shares_duplicates (tracks->data, shares);
+	}
+}
+
 static void
 brasero_session_cfg_update (BraseroSessionCfg *self)
 {
@@ -1215,6 +1398,8 @@ brasero_session_cfg_update (BraseroSessionCfg *self)
 
 	priv->configuring = FALSE;
 
+	brasero_session_cfg_set_shares_duplicates (self);
+
 	/* Finally check size */
 	if (brasero_burn_session_same_src_dest_drive (BRASERO_BURN_SESSION (self))) {
 		priv->is_valid = BRASERO_SESSION_VALID;
@@ -1260,18 +1445,103 @@ brasero_session_cfg_session_loaded (BraseroTrackDataCfg *track,
 }
 
 static void
-brasero_session_cfg_track_added (BraseroBurnSession *session,
-				 BraseroTrack *track)
+brasero_session_cfg_run_update (BraseroSessionCfg *self)
 {
 	BraseroSessionCfgPrivate *priv;
+	BraseroTrackType *current;
+	gboolean drive;
 
-	if (!brasero_session_cfg_can_update (BRASERO_SESSION_CFG (session)))
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+
+	drive = priv->update_drive;
+	priv->update_drive = FALSE;
+
+	if (!brasero_session_cfg_can_update (self)) {
+		priv->update_full = FALSE;
 		return;
+	}
 
-	priv = BRASERO_SESSION_CFG_PRIVATE (session);
+	if (!priv->update_full) {
+		current = brasero_track_type_new ();
+		brasero_burn_session_get_input_type (BRASERO_BURN_SESSION (self), current);
+		if (priv->source && brasero_track_type_equal (current, priv->source)) {
+			/* This is a shortcut if the source type has not changed */
+			brasero_track_type_free (current);
+			brasero_session_cfg_check_size (self);
+			g_signal_emit (self,
+				       session_cfg_signals [IS_VALID_SIGNAL],
+				       0);
+			return;
+		}
+		brasero_track_type_free (current);
+
+		/* when that happens it's mostly because a medium source
+		 * changed, or a new image was set. */
+		drive = TRUE;
+	}
+
+	priv->update_full = FALSE;
+
+	/* - check if all flags are supported
+	 * - check available formats for path
+	 * - set one path if need be */
+	brasero_session_cfg_update (self);
+	if (drive)
+		brasero_session_cfg_check_drive_settings (self);
+}
+
+static gboolean
+brasero_session_cfg_update_idle (gpointer data)
+{
+	BraseroSessionCfg *self = BRASERO_SESSION_CFG (data);
+	BraseroSessionCfgPrivate *priv;
+
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+	priv->update_id = 0;
+
+	brasero_session_cfg_run_update (self);
+	return FALSE;
+}
+
+/**
+ * Adding/removing/changing a lot of tracks in a row (like for a 99 track
+ * audio project) would otherwise mean as many full checks.
+ */
+
+static void
+brasero_session_cfg_schedule_update (BraseroSessionCfg *self,
+				     gboolean full,
+				     gboolean drive)
+{
+	BraseroSessionCfgPrivate *priv;
+
+	priv = BRASERO_SESSION_CFG_PRIVATE (self);
+
+	/* It is recomputed from the track sums which is cheap */
 	priv->session_blocks = 0;
 	priv->session_size = 0;
 
+	if (priv->disabled || priv->configuring)
+		return;
+
+	if (full)
+		priv->update_full = TRUE;
+	if (drive)
+		priv->update_drive = TRUE;
+
+	if (!priv->update_id)
+		priv->update_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+						   brasero_session_cfg_update_idle,
+						   self,
+						   NULL);
+}
+
+static void
+brasero_session_cfg_track_added (BraseroBurnSession *session,
+				 BraseroTrack *track)
+{
+	brasero_session_cfg_track_refresh (BRASERO_SESSION_CFG (session), track);
+
 	if (BRASERO_IS_TRACK_DATA_CFG (track))
 		g_signal_connect (track,
 				  "session-loaded",
@@ -1282,8 +1552,7 @@ brasero_session_cfg_track_added (BraseroBurnSession *session,
 	 * - check if all flags are supported
 	 * - check available formats for path
 	 * - set one path */
-	brasero_session_cfg_update (BRASERO_SESSION_CFG (session));
-	brasero_session_cfg_check_drive_settings (BRASERO_SESSION_CFG (session));
+	brasero_session_cfg_schedule_update (BRASERO_SESSION_CFG (session), TRUE, TRUE);
 }
 
 static void
@@ -1291,14 +1560,7 @@ brasero_session_cfg_track_removed (BraseroBurnSession *session,
 				   BraseroTrack *track,
 				   guint former_position)
 {
-	BraseroSessionCfgPrivate *priv;
-
-	if (!brasero_session_cfg_can_update (BRASERO_SESSION_CFG (session)))
-		return;
-
-	priv = BRASERO_SESSION_CFG_PRIVATE (session);
-	priv->session_blocks = 0;
-	priv->session_size = 0;
+	brasero_session_cfg_track_remove (BRASERO_SESSION_CFG (session), track);
 
 	/* Just in case */
 	g_signal_handlers_disconnect_by_func (track,
@@ -1308,43 +1570,17 @@ brasero_session_cfg_track_removed (BraseroBurnSession *session,
 	/* If there were several tracks and at least one remained there is no
 	 * use checking flags since the source type has not changed anyway.
 	 * If there is no more track, there is no use checking flags anyway. */
-	brasero_session_cfg_update (BRASERO_SESSION_CFG (session));
+	brasero_session_cfg_schedule_update (BRASERO_SESSION_CFG (session), TRUE, FALSE);
 }
 
 static void
 brasero_session_cfg_track_changed (BraseroBurnSession *session,
 				   BraseroTrack *track)
 {
-	BraseroSessionCfgPrivate *priv;
-	BraseroTrackType *current;
+	brasero_session_cfg_track_refresh (BRASERO_SESSION_CFG (session), track);
 
-	if (!brasero_session_cfg_can_update (BRASERO_SESSION_CFG (session)))
-		return;
-
-	priv = BRASERO_SESSION_CFG_PRIVATE (session);
-	priv->session_blocks = 0;
-	priv->session_size = 0;
-
-	current = brasero_track_type_new ();
-	brasero_burn_session_get_input_type (session, current);
-	if (brasero_track_type_equal (current, priv->source)) {
-		/* This is a shortcut if the source type has not changed */
-		brasero_track_type_free (current);
-		brasero_session_cfg_check_size (BRASERO_SESSION_CFG (session));
-		g_signal_emit (session,
-			       session_cfg_signals [IS_VALID_SIGNAL],
-			       0);
- 		return;
-	}
-	brasero_track_type_free (current);
-
-	/* when that happens it's mostly because a medium source changed, or
-	 * a new image was set. 
-	 * - check if all flags are supported
-	 * - check available formats for path
-	 * - set one path if need be */
-	brasero_session_cfg_update (BRASERO_SESSION_CFG (session));
-	brasero_session_cfg_check_drive_settings (BRASERO_SESSION_CFG (session));
+	/* Only the size needs checking again unless the source type changed */
+	brasero_session_cfg_schedule_update (BRASERO_SESSION_CFG (session), FALSE, FALSE);
 }
 
 static void
@@ -1523,6 +1759,11 @@ brasero_session_cfg_init (BraseroSessionCfg *object)
 	priv = BRASERO_SESSION_CFG_PRIVATE (object);
 
 	priv->is_valid = BRASERO_SESSION_EMPTY;
+	priv->tracks = g_hash_table_new_full (g_direct_hash,
+					      g_direct_equal,
+					      NULL,
+					      g_free);
+
 	manager = brasero_plugin_manager_get_default ();
 	g_signal_connect (manager,
 	                  "caps-changed",
@@ -1539,6 +1780,11 @@ brasero_session_cfg_finalize (GObject *object)
 
 	priv = BRASERO_SESSION_CFG_PRIVATE (object);
 
+	if (priv->update_id) {
+		g_source_remove (priv->update_id);
+		priv->update_id = 0;
+	}
+
 	tracks = brasero_burn_session_get_tracks (BRASERO_BURN_SESSION (object));
 	for (; tracks; tracks = tracks->next) {
 		BraseroTrack *track;
@@ -1564,6 +1810,11 @@ brasero_session_cfg_finalize (GObject *object)
 		priv->output = NULL;
 	}
 
+	if (priv->tracks) {
+		g_hash_table_destroy (priv->tracks);
+		priv->tracks = NULL;
+	}
+
 	G_OBJECT_CLASS (brasero_session_cfg_parent_class)->finalize (object);
 }
 
@@ -44,6 +44,7 @@
 #include "brasero-volume.h"
 
 #include "brasero-track-data-cfg.h"
+#include "brasero-track-data-cfg-private.h"
 
 #include "libbrasero-marshal.h"
 
@@ -51,6 +52,8 @@
 
 #include "brasero-misc.h"
 #include "burn-basics.h"
+#include "burn-debug.h"
+#include "burn-dedup.h"
 #include "brasero-data-project.h"
 #include "brasero-data-tree-model.h"
 
@@ -79,9 +82,22 @@ struct _BraseroTrackDataCfgPrivate
 
 	GSList *shown;
 
+	/* Parents whose row change is signalled at the end of a batch
+	 * (node => project reference) */
+	GHashTable *batch_parents;
+
 	gint sort_column;
 	GtkSortType sort_type;
 
+	/* Sectors of identical files whose data is only written once */
+	BraseroDedup *dedup;
+	GThread *dedup_thread;
+	guint dedup_id;
+	guint dedup_done_id;
+	goffset shared_sectors;
+
+	guint share_duplicates:1;
+	guint imager_shares_duplicates:1;
 	guint joliet_rename:1;
 
 	guint deep_directory:1;
@@ -90,6 +106,12 @@ struct _BraseroTrackDataCfgPrivate
 
 #define BRASERO_TRACK_DATA_CFG_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_TRACK_DATA_CFG, BraseroTrackDataCfgPrivate))
 
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_DEDUP_FILES		"dedup-files"
+
+/* Files are compared once the project has not changed for that long */
+#define BRASERO_DEDUP_DELAY		2
+
 
 static void
 brasero_track_data_cfg_drag_source_iface_init (gpointer g_iface, gpointer data);
@@ -298,6 +320,25 @@ brasero_track_data_cfg_get_n_children (const BraseroFileNode *node)
 	return num;
 }
 
+static gboolean
+brasero_track_data_cfg_has_one_child (const BraseroFileNode *node)
+{
+	BraseroFileNode *children;
+	guint num = 0;
+
+	/* Stop at the second child; there can be a lot of them */
+	for (children = BRASERO_FILE_NODE_CHILDREN (node); children; children = children->next) {
+		if (children->is_hidden)
+			continue;
+
+		num ++;
+		if (num > 1)
+			return FALSE;
+	}
+
+	return (num == 1);
+}
+
 static gint
 brasero_track_data_cfg_iter_n_children (GtkTreeModel *model,
 					 GtkTreeIter *iter)
@@ -1427,6 +1468,70 @@ brasero_track_data_cfg_clean_cache (BraseroTrackDataCfg *track)
 	}
 }
 
+static gboolean
+brasero_track_data_cfg_batch_parent_changed (BraseroTrackDataCfg *self,
+					     BraseroFileNode *parent)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	guint reference;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	if (!priv->batch_parents)
+		priv->batch_parents = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	if (g_hash_table_lookup (priv->batch_parents, parent))
+		return TRUE;
+
+	/* The parent could be removed before the end of the batch */
+	reference = brasero_data_project_reference_new (BRASERO_DATA_PROJECT (priv->tree), parent);
+	if (!reference)
+		return FALSE;
+
+	g_hash_table_insert (priv->batch_parents, parent, GUINT_TO_POINTER (reference));
+	return TRUE;
+}
+
+static void
+brasero_track_data_cfg_batch_end_cb (BraseroDataProject *project,
+				     BraseroTrackDataCfg *self)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	GHashTableIter hash_iter;
+	gpointer value;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+	if (!priv->batch_parents)
+		return;
+
+	/* Tell the tree that the parents changed (since the number of
+	 * children changed as well); once for all the nodes added. */
+	g_hash_table_iter_init (&hash_iter, priv->batch_parents);
+	while (g_hash_table_iter_next (&hash_iter, NULL, &value)) {
+		BraseroFileNode *parent;
+		GtkTreePath *path;
+		GtkTreeIter iter;
+		guint reference;
+
+		reference = GPOINTER_TO_UINT (value);
+		parent = brasero_data_project_reference_get (project, reference);
+		brasero_data_project_reference_free (project, reference);
+
+		if (!parent || !parent->parent)
+			continue;
+
+		iter.stamp = priv->stamp;
+		iter.user_data = parent;
+		iter.user_data2 = GINT_TO_POINTER (BRASERO_ROW_REGULAR);
+
+		path = brasero_track_data_cfg_node_to_path (self, parent);
+		gtk_tree_model_row_changed (GTK_TREE_MODEL (self), path, &iter);
+		gtk_tree_path_free (path);
+	}
+
+	g_hash_table_remove_all (priv->batch_parents);
+}
+
 static void
 brasero_track_data_cfg_node_added (BraseroDataProject *project,
 				   BraseroFileNode *node,
@@ -1499,22 +1604,33 @@ brasero_track_data_cfg_node_added (BraseroDataProject *project,
 
 	parent = node->parent;
 	if (!parent->is_root) {
-		/* Tell the tree that the parent changed (since the number of children
-		 * changed as well). */
-		iter.user_data = parent;
-		path = brasero_track_data_cfg_node_to_path (self, parent);
-
-		gtk_tree_model_row_changed (GTK_TREE_MODEL (self), path, &iter);
+		gboolean first_child;
+
+		first_child = brasero_track_data_cfg_has_one_child (parent);
+
+		/* When a lot of nodes are added at once, the parent row change
+		 * is signalled only once at the end (unless the BOGUS row has
+		 * to be removed). */
+		if (first_child
+		|| !brasero_data_project_in_batch (project)
+		|| !brasero_track_data_cfg_batch_parent_changed (self, parent)) {
+			/* Tell the tree that the parent changed (since the number of children
+			 * changed as well). */
+			iter.user_data = parent;
+			path = brasero_track_data_cfg_node_to_path (self, parent);
+
+			gtk_tree_model_row_changed (GTK_TREE_MODEL (self), path, &iter);
+
+			/* Check if the parent of this node is empty if so remove the BOGUS row.
+			 * Do it afterwards to prevent the parent row to be collapsed if it was
+			 * previously expanded. */
+			if (first_child) {
+				gtk_tree_path_append_index (path, 1);
+				gtk_tree_model_row_deleted (GTK_TREE_MODEL (self), path);
+			}
 
-		/* Check if the parent of this node is empty if so remove the BOGUS row.
-		 * Do it afterwards to prevent the parent row to be collapsed if it was
-		 * previously expanded. */
-		if (parent && brasero_track_data_cfg_get_n_children (parent) == 1) {
-			gtk_tree_path_append_index (path, 1);
-			gtk_tree_model_row_deleted (GTK_TREE_MODEL (self), path);
+			gtk_tree_path_free (path);
 		}
-
-		gtk_tree_path_free (path);
 	}
 
 	/* Now see if this is a directory which is empty and needs a BOGUS */
@@ -2039,6 +2155,9 @@ brasero_track_data_cfg_reset (BraseroTrackDataCfg *track)
 	priv->deep_directory = FALSE;
 	priv->joliet_rename = FALSE;
 
+	brasero_track_data_cfg_dedup_stop (track);
+	priv->shared_sectors = 0;
+
 	brasero_track_data_cfg_clean_cache (track);
 
 	brasero_track_changed (BRASERO_TRACK (track));
@@ -2367,6 +2486,129 @@ brasero_track_data_cfg_get_excluded (BraseroTrackData *track)
 	return priv->excluded;
 }
 
+/**
+ * The image is given the nodes of the project as they are so that the file
+ * system is not explored a second time. Files from a previous session are
+ * left out; their directories only hold what was added to them.
+ */
+
+static BraseroBurnResult
+brasero_track_data_cfg_add_node_to_image (BraseroIsoImage *image,
+					  BraseroIsoNode *parent,
+					  const gchar *parent_path,
+					  BraseroFileNode *node,
+					  GError **error)
+{
+	BraseroFileNode *child;
+	BraseroIsoNode *directory;
+	const gchar *name;
+	gchar *path = NULL;
+
+	name = BRASERO_FILE_NODE_NAME (node);
+	if (node->is_imported) {
+		if (node->is_file)
+			return BRASERO_BURN_OK;
+	}
+	else if (node->is_grafted) {
+		/* Created directories are grafted but have no URI */
+		if (!node->is_fake) {
+			path = g_filename_from_uri (BRASERO_FILE_NODE_GRAFT (node)->node->uri, NULL, NULL);
+			if (!path) {
+				g_set_error (error,
+					     BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_FILE_NOT_LOCAL,
+					     _("The file is not stored locally"));
+				return BRASERO_BURN_ERR;
+			}
+		}
+	}
+	else if (parent_path)
+		path = g_build_filename (parent_path, name, NULL);
+	else {
+		BRASERO_BURN_LOG ("Ignoring %s (no location)", name);
+		return BRASERO_BURN_OK;
+	}
+
+	if (node->is_file) {
+		brasero_iso_image_add_file (image,
+					    parent,
+					    name,
+					    path,
+					    BRASERO_FILE_NODE_SECTORS (node));
+		g_free (path);
+		return BRASERO_BURN_OK;
+	}
+
+	directory = brasero_iso_image_add_directory (image, parent, name, path);
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next) {
+		BraseroBurnResult result;
+
+		result = brasero_track_data_cfg_add_node_to_image (image,
+								   directory,
+								   path,
+								   child,
+								   error);
+		if (result != BRASERO_BURN_OK) {
+			g_free (path);
+			return result;
+		}
+	}
+
+	g_free (path);
+	return BRASERO_BURN_OK;
+}
+
+/**
+ * The sectors of identical files are only subtracted from the size when the
+ * backend creating the image writes them once.
+ */
+
+void
+brasero_track_data_cfg_set_imager_shares_duplicates (BraseroTrackDataCfg *track,
+						     gboolean shares)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	g_return_if_fail (BRASERO_IS_TRACK_DATA_CFG (track));
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	if (priv->imager_shares_duplicates == (shares != FALSE))
+		return;
+
+	priv->imager_shares_duplicates = (shares != FALSE);
+	if (priv->shared_sectors)
+		brasero_track_changed (BRASERO_TRACK (track));
+}
+
+BraseroBurnResult
+brasero_track_data_cfg_add_to_image (BraseroTrackDataCfg *track,
+				     BraseroIsoImage *image,
+				     GError **error)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	BraseroFileNode *root;
+	BraseroFileNode *node;
+
+	g_return_val_if_fail (BRASERO_IS_TRACK_DATA_CFG (track), BRASERO_BURN_ERR);
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+
+	root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
+	for (node = BRASERO_FILE_NODE_CHILDREN (root); node; node = node->next) {
+		BraseroBurnResult result;
+
+		result = brasero_track_data_cfg_add_node_to_image (image,
+								   brasero_iso_image_get_root (image),
+								   NULL,
+								   node,
+								   error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
 static guint64
 brasero_track_data_cfg_get_file_num (BraseroTrackData *track)
 {
@@ -2450,17 +2692,20 @@ brasero_track_data_cfg_get_size (BraseroTrack *track,
 	if (blocks) {
 		BraseroFileNode *root;
 		BraseroImageFS fs_type;
-		BraseroFileTreeStats *stats;
 
 		if (!sectors)
 			return sectors;
 
+		/* Only the directories that changed since last time have their
+		 * records computed again */
 		fs_type = brasero_track_data_cfg_get_fs (BRASERO_TRACK_DATA (track));
 		root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
-		stats = BRASERO_FILE_NODE_STATS (root);
-		sectors = brasero_data_project_improve_image_size_accuracy (sectors,
-									    stats->num_dir,
-									    fs_type);
+		if (priv->imager_shares_duplicates)
+			sectors -= priv->shared_sectors;
+
+		sectors = brasero_file_node_get_image_blocks (root,
+							      fs_type,
+							      sectors);
 		*blocks = sectors;
 	}
 
@@ -2878,10 +3123,202 @@ emit_signal:
 	brasero_track_changed (BRASERO_TRACK (self));
 }
 
+/* The idle returning the results is added from the dedup thread */
+G_LOCK_DEFINE_STATIC (dedup_done);
+
+static void
+brasero_track_data_cfg_dedup_stop (BraseroTrackDataCfg *self)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	if (priv->dedup_id) {
+		g_source_remove (priv->dedup_id);
+		priv->dedup_id = 0;
+	}
+
+	if (priv->dedup_thread) {
+		brasero_dedup_cancel (priv->dedup);
+		g_thread_join (priv->dedup_thread);
+		priv->dedup_thread = NULL;
+	}
+
+	G_LOCK (dedup_done);
+	if (priv->dedup_done_id) {
+		g_source_remove (priv->dedup_done_id);
+		priv->dedup_done_id = 0;
+	}
+	G_UNLOCK (dedup_done);
+
+	if (priv->dedup) {
+		brasero_dedup_free (priv->dedup);
+		priv->dedup = NULL;
+	}
+}
+
+static gboolean
+brasero_track_data_cfg_dedup_done (gpointer data)
+{
+	BraseroTrackDataCfg *self = BRASERO_TRACK_DATA_CFG (data);
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	/* This waits for the thread to have recorded the id */
+	G_LOCK (dedup_done);
+	priv->dedup_done_id = 0;
+	G_UNLOCK (dedup_done);
+
+	g_thread_join (priv->dedup_thread);
+	priv->dedup_thread = NULL;
+
+	priv->shared_sectors = brasero_dedup_get_shared_blocks (priv->dedup);
+	brasero_dedup_free (priv->dedup);
+	priv->dedup = NULL;
+
+	if (priv->shared_sectors)
+		brasero_track_changed (BRASERO_TRACK (self));
+
+	return FALSE;
+}
+
+static gpointer
+brasero_track_data_cfg_dedup_thread (gpointer data)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (data);
+
+	/* The idle may run before g_idle_add () returns */
+	if (brasero_dedup_run (priv->dedup) == BRASERO_BURN_OK) {
+		G_LOCK (dedup_done);
+		priv->dedup_done_id = g_idle_add (brasero_track_data_cfg_dedup_done, data);
+		G_UNLOCK (dedup_done);
+	}
+
+	return NULL;
+}
+
+static void
+brasero_track_data_cfg_dedup_collect (BraseroFileNode *node,
+				      GHashTable *buckets)
+{
+	for (node = BRASERO_FILE_NODE_CHILDREN (node); node; node = node->next) {
+		GSList *nodes;
+
+		if (!node->is_file) {
+			brasero_track_data_cfg_dedup_collect (node, buckets);
+			continue;
+		}
+
+		/* Only files whose size is known and that are to be written */
+		if (node->is_imported
+		||  node->is_fake
+		||  node->is_loading
+		||  node->is_reloading
+		|| !BRASERO_FILE_NODE_SECTORS (node))
+			continue;
+
+		nodes = g_hash_table_lookup (buckets, GUINT_TO_POINTER (node->union3.sectors));
+		nodes = g_slist_prepend (nodes, node);
+		g_hash_table_insert (buckets, GUINT_TO_POINTER (node->union3.sectors), nodes);
+	}
+}
+
+static gboolean
+brasero_track_data_cfg_dedup_start (gpointer data)
+{
+	BraseroTrackDataCfg *self = BRASERO_TRACK_DATA_CFG (data);
+	BraseroTrackDataCfgPrivate *priv;
+	GHashTableIter iter;
+	GHashTable *buckets;
+	GHashTable *paths;
+	gpointer value;
+	guint num = 0;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+	priv->dedup_id = 0;
+
+	if (priv->loading)
+		return FALSE;
+
+	/* Only files with the same size can be identical; the others are
+	 * not worth hashing */
+	buckets = g_hash_table_new (g_direct_hash, g_direct_equal);
+	brasero_track_data_cfg_dedup_collect (brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree)), buckets);
+
+	priv->dedup = brasero_dedup_new ();
+	paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	g_hash_table_iter_init (&iter, buckets);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		GSList *nodes = value;
+		GSList *node_iter;
+
+		if (!nodes->next) {
+			g_slist_free (nodes);
+			continue;
+		}
+
+		for (node_iter = nodes; node_iter; node_iter = node_iter->next) {
+			gchar *path;
+			gchar *uri;
+
+			uri = brasero_data_project_node_to_uri (BRASERO_DATA_PROJECT (priv->tree), node_iter->data);
+			path = uri? g_filename_from_uri (uri, NULL, NULL):NULL;
+			g_free (uri);
+
+			/* A URI grafted several times is already counted once */
+			if (!path || g_hash_table_lookup (paths, path)) {
+				g_free (path);
+				continue;
+			}
+
+			g_hash_table_insert (paths, path, GINT_TO_POINTER (1));
+			brasero_dedup_add (priv->dedup, path);
+			num ++;
+		}
+		g_slist_free (nodes);
+	}
+	g_hash_table_destroy (buckets);
+	g_hash_table_destroy (paths);
+
+	if (num < 2) {
+		brasero_dedup_free (priv->dedup);
+		priv->dedup = NULL;
+		return FALSE;
+	}
+
+	priv->dedup_thread = g_thread_create (brasero_track_data_cfg_dedup_thread,
+					      self,
+					      TRUE,
+					      NULL);
+	if (!priv->dedup_thread) {
+		brasero_dedup_free (priv->dedup);
+		priv->dedup = NULL;
+	}
+
+	return FALSE;
+}
+
 static void
 brasero_track_data_cfg_size_changed_cb (BraseroDataProject *project,
 					BraseroTrackDataCfg *self)
 {
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+	if (priv->share_duplicates) {
+		/* Until files are compared again, assume none is shared so
+		 * the size is never underestimated */
+		brasero_track_data_cfg_dedup_stop (self);
+		priv->shared_sectors = 0;
+		priv->dedup_id = g_timeout_add_seconds (BRASERO_DEDUP_DELAY,
+							brasero_track_data_cfg_dedup_start,
+							self);
+	}
+
 	brasero_track_data_cfg_clean_cache (self);
 	brasero_track_changed (BRASERO_TRACK (self));
 }
@@ -3289,9 +3726,14 @@ static void
 brasero_track_data_cfg_init (BraseroTrackDataCfg *object)
 {
 	BraseroTrackDataCfgPrivate *priv;
+	GSettings *settings;
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (object);
 
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	priv->share_duplicates = g_settings_get_boolean (settings, BRASERO_KEY_DEDUP_FILES);
+	g_object_unref (settings);
+
 	priv->sort_column = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
 	do {
 		priv->stamp = g_random_int ();
@@ -3321,6 +3763,10 @@ brasero_track_data_cfg_init (BraseroTrackDataCfg *object)
 			  "size-changed",
 			  G_CALLBACK (brasero_track_data_cfg_size_changed_cb),
 			  object);
+	g_signal_connect (priv->tree,
+			  "batch-end",
+			  G_CALLBACK (brasero_track_data_cfg_batch_end_cb),
+			  object);
 
 	g_signal_connect (priv->tree,
 			  "session-available",
@@ -3386,12 +3832,26 @@ brasero_track_data_cfg_finalize (GObject *object)
 
 	brasero_track_data_clean_autorun (BRASERO_TRACK_DATA_CFG (object));
 	brasero_track_data_cfg_clean_cache (BRASERO_TRACK_DATA_CFG (object));
+	brasero_track_data_cfg_dedup_stop (BRASERO_TRACK_DATA_CFG (object));
 
 	if (priv->shown) {
 		g_slist_free (priv->shown);
 		priv->shown = NULL;
 	}
 
+	if (priv->batch_parents) {
+		GHashTableIter hash_iter;
+		gpointer value;
+
+		g_hash_table_iter_init (&hash_iter, priv->batch_parents);
+		while (g_hash_table_iter_next (&hash_iter, NULL, &value))
+			brasero_data_project_reference_free (BRASERO_DATA_PROJECT (priv->tree),
+							     GPOINTER_TO_UINT (value));
+
+		g_hash_table_destroy (priv->batch_parents);
+		priv->batch_parents = NULL;
+	}
+
 	if (priv->tree) {
 		/* This object could outlive us just for some time
 		 * so we better remove all signals.
@@ -45,14 +45,15 @@
 #include "brasero-io.h"
 #include "brasero-tags.h"
 
-static BraseroIOJobCallbacks *io_methods = NULL;
-
 typedef struct _BraseroTrackStreamCfgPrivate BraseroTrackStreamCfgPrivate;
 struct _BraseroTrackStreamCfgPrivate
 {
-	BraseroIOJobBase *load_uri;
+	/* URI whose information was requested */
+	gchar *pending_uri;
 
-	GFileMonitor *monitor;
+	/* Entry in the shared directory monitors */
+	gchar *monitor_dir;
+	gchar *monitor_name;
 
 	GError *error;
 
@@ -63,40 +64,177 @@ struct _BraseroTrackStreamCfgPrivate
 
 G_DEFINE_TYPE (BraseroTrackStreamCfg, brasero_track_stream_cfg, BRASERO_TYPE_TRACK_STREAM);
 
+/**
+ * All stream tracks share one monitor per directory (instead of one per
+ * file) and their information is requested in batches, one BraseroIO job
+ * for all the tracks added during the same main loop iteration.
+ */
+
+struct _BraseroStreamDirMonitor {
+	GFileMonitor *monitor;
+
+	/* basename => GSList of tracks */
+	GHashTable *files;
+};
+typedef struct _BraseroStreamDirMonitor BraseroStreamDirMonitor;
+
+/* directory URI => BraseroStreamDirMonitor */
+static GHashTable *stream_monitors = NULL;
+
+/* URI => GSList of tracks waiting for its information */
+static GHashTable *stream_pending = NULL;
+static GSList *stream_queued = NULL;
+static guint stream_queued_id = 0;
+static BraseroIOJobBase *stream_io_base = NULL;
+
 static void
-brasero_track_stream_cfg_file_changed (GFileMonitor *monitor,
-								GFile *file,
-								GFile *other_file,
-								GFileMonitorEvent event,
-								BraseroTrackStream *track)
+brasero_track_stream_cfg_dir_changed (GFileMonitor *monitor,
+				      GFile *file,
+				      GFile *other_file,
+				      GFileMonitorEvent event,
+				      BraseroStreamDirMonitor *dir);
+
+static void
+brasero_track_stream_cfg_monitor_remove (BraseroTrackStreamCfg *track)
 {
 	BraseroTrackStreamCfgPrivate *priv;
+	BraseroStreamDirMonitor *dir;
+	GSList *tracks;
+
+	priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (track);
+	if (!priv->monitor_dir)
+		return;
+
+	dir = g_hash_table_lookup (stream_monitors, priv->monitor_dir);
+	if (dir) {
+		tracks = g_hash_table_lookup (dir->files, priv->monitor_name);
+		tracks = g_slist_remove (tracks, track);
+		if (tracks)
+			g_hash_table_insert (dir->files, g_strdup (priv->monitor_name), tracks);
+		else
+			g_hash_table_remove (dir->files, priv->monitor_name);
+
+		if (!g_hash_table_size (dir->files)) {
+			if (dir->monitor) {
+				g_signal_handlers_disconnect_by_func (dir->monitor,
+								      brasero_track_stream_cfg_dir_changed,
+								      dir);
+				g_file_monitor_cancel (dir->monitor);
+				g_object_unref (dir->monitor);
+			}
+
+			g_hash_table_destroy (dir->files);
+			g_hash_table_remove (stream_monitors, priv->monitor_dir);
+			g_free (dir);
+		}
+	}
+
+	g_free (priv->monitor_dir);
+	priv->monitor_dir = NULL;
+
+	g_free (priv->monitor_name);
+	priv->monitor_name = NULL;
+}
+
+static void
+brasero_track_stream_cfg_dir_changed (GFileMonitor *monitor,
+				      GFile *file,
+				      GFile *other_file,
+				      GFileMonitorEvent event,
+				      BraseroStreamDirMonitor *dir)
+{
+	GSList *tracks;
+	GSList *iter;
 	gchar *name;
 
+	if (event != G_FILE_MONITOR_EVENT_DELETED)
+		return;
+
+	name = g_file_get_basename (file);
+
+	/* Work on a copy as the last track removed frees dir */
+	tracks = g_slist_copy (g_hash_table_lookup (dir->files, name));
+	for (iter = tracks; iter; iter = iter->next) {
+		BraseroTrackStreamCfgPrivate *priv;
+		BraseroTrackStreamCfg *track;
+
+		track = iter->data;
+		priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (track);
+
+		brasero_track_stream_cfg_monitor_remove (track);
+
+		if (priv->error)
+			g_error_free (priv->error);
+
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_FILE_NOT_FOUND,
+					   /* Translators: %s is the name of the file that has just been deleted */
+					   _("\"%s\" was removed from the file system."),
+					   name);
+		brasero_track_changed (BRASERO_TRACK (track));
+	}
+	g_slist_free (tracks);
+	g_free (name);
+}
+
+static void
+brasero_track_stream_cfg_monitor_add (BraseroTrackStreamCfg *track,
+				      const gchar *uri)
+{
+	BraseroTrackStreamCfgPrivate *priv;
+	BraseroStreamDirMonitor *dir;
+	GFile *parent;
+	GSList *tracks;
+	GFile *file;
+
 	priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (track);
 
-        switch (event) {
- /*               case G_FILE_MONITOR_EVENT_CHANGED:
-                        return;
-*/
-                case G_FILE_MONITOR_EVENT_DELETED:
-                        g_object_unref (priv->monitor);
-                        priv->monitor = NULL;
-
-			name = g_file_get_basename (file);
-			priv->error = g_error_new (BRASERO_BURN_ERROR,
-								  BRASERO_BURN_ERROR_FILE_NOT_FOUND,
-								  /* Translators: %s is the name of the file that has just been deleted */
-								  _("\"%s\" was removed from the file system."),
-								 name);
-			g_free (name);
-                        break;
-
-                default:
-                        return;
-        }
-
-        brasero_track_changed (BRASERO_TRACK (track));
+	brasero_track_stream_cfg_monitor_remove (track);
+
+	file = g_file_new_for_uri (uri);
+	parent = g_file_get_parent (file);
+	if (!parent) {
+		g_object_unref (file);
+		return;
+	}
+
+	priv->monitor_dir = g_file_get_uri (parent);
+	priv->monitor_name = g_file_get_basename (file);
+	g_object_unref (file);
+
+	if (!stream_monitors)
+		stream_monitors = g_hash_table_new_full (g_str_hash,
+							 g_str_equal,
+							 g_free,
+							 NULL);
+
+	dir = g_hash_table_lookup (stream_monitors, priv->monitor_dir);
+	if (!dir) {
+		dir = g_new0 (BraseroStreamDirMonitor, 1);
+		dir->files = g_hash_table_new_full (g_str_hash,
+						    g_str_equal,
+						    g_free,
+						    NULL);
+
+		/* This can fail for some remote locations; the tracks are
+		 * still registered so that it is not tried again. */
+		dir->monitor = g_file_monitor_directory (parent,
+							 G_FILE_MONITOR_NONE,
+							 NULL,
+							 NULL);
+		if (dir->monitor)
+			g_signal_connect (dir->monitor,
+					  "changed",
+					  G_CALLBACK (brasero_track_stream_cfg_dir_changed),
+					  dir);
+
+		g_hash_table_insert (stream_monitors, g_strdup (priv->monitor_dir), dir);
+	}
+	g_object_unref (parent);
+
+	tracks = g_hash_table_lookup (dir->files, priv->monitor_name);
+	tracks = g_slist_prepend (tracks, track);
+	g_hash_table_insert (dir->files, g_strdup (priv->monitor_name), tracks);
 }
 
 static void
@@ -106,7 +244,6 @@ brasero_track_stream_cfg_results_cb (GObject *obj,
 				     GFileInfo *info,
 				     gpointer user_data)
 {
-	GFile *file;
 	guint64 len;
 	GObject *snapshot;
 	BraseroTrackStreamCfgPrivate *priv;
@@ -306,25 +443,112 @@ brasero_track_stream_cfg_results_cb (GObject *obj,
 					      g_file_info_get_attribute_string (info, BRASERO_IO_ISRC));
 
 	/* Start monitoring it */
-	file = g_file_new_for_uri (uri);
-	priv->monitor = g_file_monitor_file (file,
-	                                     G_FILE_MONITOR_NONE,
-	                                     NULL,
-	                                     NULL);
-	g_object_unref (file);
-
-	g_signal_connect (priv->monitor,
-	                  "changed",
-	                  G_CALLBACK (brasero_track_stream_cfg_file_changed),
-	                  obj);
+	brasero_track_stream_cfg_monitor_add (BRASERO_TRACK_STREAM_CFG (obj), uri);
 
 	brasero_track_changed (BRASERO_TRACK (obj));
 }
 
+static void
+brasero_track_stream_cfg_info_results (GObject *object,
+				       const BraseroIOResult *results,
+				       guint num,
+				       gpointer user_data)
+{
+	guint i;
+
+	for (i = 0; i < num; i ++) {
+		GSList *tracks = NULL;
+		gpointer key = NULL;
+		GSList *iter;
+
+		if (!g_hash_table_lookup_extended (stream_pending,
+						   results [i].uri,
+						   &key,
+						   (gpointer *) &tracks))
+			continue;
+
+		/* the tracks might ask again for the same URI in the callback */
+		g_hash_table_steal (stream_pending, results [i].uri);
+		g_free (key);
+
+		tracks = g_slist_reverse (tracks);
+		for (iter = tracks; iter; iter = iter->next) {
+			BraseroTrackStreamCfgPrivate *priv;
+
+			priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (iter->data);
+			g_free (priv->pending_uri);
+			priv->pending_uri = NULL;
+
+			brasero_track_stream_cfg_results_cb (iter->data,
+							     results [i].error,
+							     results [i].uri,
+							     results [i].info,
+							     NULL);
+		}
+		g_slist_free (tracks);
+	}
+}
+
+static gboolean
+brasero_track_stream_cfg_info_flush (gpointer NULL_data)
+{
+	GSList *uris;
+
+	stream_queued_id = 0;
+
+	if (!stream_io_base)
+		stream_io_base = brasero_io_register_batch (NULL,
+							    brasero_track_stream_cfg_info_results,
+							    NULL,
+							    NULL);
+
+	uris = g_slist_reverse (stream_queued);
+	stream_queued = NULL;
+
+	BRASERO_BURN_LOG ("Requesting information for %i stream tracks", g_slist_length (uris));
+	brasero_io_get_files_info (uris,
+				   stream_io_base,
+				   BRASERO_IO_INFO_PERM|
+				   BRASERO_IO_INFO_MIME|
+				   BRASERO_IO_INFO_URGENT|
+				   BRASERO_IO_INFO_METADATA|
+				   BRASERO_IO_INFO_METADATA_MISSING_CODEC|
+				   BRASERO_IO_INFO_METADATA_THUMBNAIL,
+				   NULL);
+
+	g_slist_foreach (uris, (GFunc) g_free, NULL);
+	g_slist_free (uris);
+	return FALSE;
+}
+
+static void
+brasero_track_stream_cfg_info_cancel (BraseroTrackStreamCfg *track)
+{
+	BraseroTrackStreamCfgPrivate *priv;
+	GSList *tracks;
+
+	priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (track);
+	if (!priv->pending_uri)
+		return;
+
+	/* The request itself goes on for the other tracks; the result is
+	 * simply ignored if no track is waiting for it anymore. */
+	tracks = g_hash_table_lookup (stream_pending, priv->pending_uri);
+	tracks = g_slist_remove (tracks, track);
+	if (tracks)
+		g_hash_table_insert (stream_pending, g_strdup (priv->pending_uri), tracks);
+	else
+		g_hash_table_remove (stream_pending, priv->pending_uri);
+
+	g_free (priv->pending_uri);
+	priv->pending_uri = NULL;
+}
+
 static void
 brasero_track_stream_cfg_get_info (BraseroTrackStreamCfg *track)
 {
 	BraseroTrackStreamCfgPrivate *priv;
+	GSList *tracks;
 	gchar *uri;
 
 	priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (track);
@@ -334,28 +558,29 @@ brasero_track_stream_cfg_get_info (BraseroTrackStreamCfg *track)
 		priv->error = NULL;
 	}
 
-	/* get info async for the file */
-	if (!priv->load_uri) {
-		if (!io_methods)
-			io_methods = brasero_io_register_job_methods (brasero_track_stream_cfg_results_cb,
-			                                              NULL,
-			                                              NULL);
+	brasero_track_stream_cfg_info_cancel (track);
 
-		priv->load_uri = brasero_io_register_with_methods (G_OBJECT (track), io_methods);
-	}
+	/* get info async for the file; it is queued with the requests of the
+	 * other tracks and shared with those that have the same URI */
+	if (!stream_pending)
+		stream_pending = g_hash_table_new_full (g_str_hash,
+							g_str_equal,
+							g_free,
+							NULL);
 
 	priv->loading = TRUE;
 	uri = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), TRUE);
-	brasero_io_get_file_info (uri,
-				  priv->load_uri,
-				  BRASERO_IO_INFO_PERM|
-				  BRASERO_IO_INFO_MIME|
-				  BRASERO_IO_INFO_URGENT|
-				  BRASERO_IO_INFO_METADATA|
-				  BRASERO_IO_INFO_METADATA_MISSING_CODEC|
-				  BRASERO_IO_INFO_METADATA_THUMBNAIL,
-				  track);
-	g_free (uri);
+	priv->pending_uri = g_strdup (uri);
+
+	tracks = g_hash_table_lookup (stream_pending, uri);
+	if (!tracks) {
+		stream_queued = g_slist_prepend (stream_queued, g_strdup (uri));
+		if (!stream_queued_id)
+			stream_queued_id = g_idle_add (brasero_track_stream_cfg_info_flush, NULL);
+	}
+
+	tracks = g_slist_prepend (tracks, track);
+	g_hash_table_insert (stream_pending, uri, tracks);
 }
 
 static BraseroBurnResult
@@ -365,13 +590,8 @@ brasero_track_stream_cfg_set_source (BraseroTrackStream *track,
 	BraseroTrackStreamCfgPrivate *priv;
 
 	priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (track);
-	if (priv->monitor) {
-		g_object_unref (priv->monitor);
-		priv->monitor = NULL;
-	}
-
-	if (priv->load_uri)
-		brasero_io_cancel_by_base (priv->load_uri);
+	brasero_track_stream_cfg_monitor_remove (BRASERO_TRACK_STREAM_CFG (track));
+	brasero_track_stream_cfg_info_cancel (BRASERO_TRACK_STREAM_CFG (track));
 
 	if (BRASERO_TRACK_STREAM_CLASS (brasero_track_stream_cfg_parent_class)->set_source)
 		BRASERO_TRACK_STREAM_CLASS (brasero_track_stream_cfg_parent_class)->set_source (track, uri);
@@ -420,20 +640,8 @@ brasero_track_stream_cfg_finalize (GObject *object)
 
 	priv = BRASERO_TRACK_STREAM_CFG_PRIVATE (object);
 
-	if (priv->load_uri) {
-		brasero_io_cancel_by_base (priv->load_uri);
-
-		if (io_methods->ref == 1)
-			io_methods = NULL;
-
-		brasero_io_job_base_free (priv->load_uri);
-		priv->load_uri = NULL;
-	}
-
-	if (priv->monitor) {
-		g_object_unref (priv->monitor);
-		priv->monitor = NULL;
-	}
+	brasero_track_stream_cfg_info_cancel (BRASERO_TRACK_STREAM_CFG (object));
+	brasero_track_stream_cfg_monitor_remove (BRASERO_TRACK_STREAM_CFG (object));
 
 	if (priv->error) {
 		g_error_free (priv->error);
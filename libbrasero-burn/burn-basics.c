@@ -249,6 +249,9 @@ brasero_burn_library_start (int *argc,
 	/* This is for missing codec automatic install */
 	gst_pb_utils_init ();
 
+	/* open the performance trace if one was requested */
+	brasero_burn_trace_setup ();
+
 	/* initialize the media library */
 	brasero_media_library_start ();
 
@@ -322,6 +325,8 @@ brasero_burn_library_stop (void)
 
 	/* Cleanup the io thing */
 	brasero_io_shutdown ();
+
+	brasero_burn_trace_shutdown ();
 }
 
 /**
@@ -34,6 +34,8 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <glib/gi18n-lib.h>
@@ -49,10 +51,19 @@
 
 static gboolean debug = FALSE;
 
+static gchar *trace_path = NULL;
+static FILE *trace_file = NULL;
+static gint64 trace_origin = 0;
+static gboolean trace_first = TRUE;
+G_LOCK_DEFINE_STATIC (trace);
+
 static const GOptionEntry options [] = {
 	{ "brasero-burn-debug", 'g', 0, G_OPTION_ARG_NONE, &debug,
 	  N_("Display debug statements on stdout for Brasero burn library"),
 	  NULL },
+	{ "brasero-burn-trace", 0, 0, G_OPTION_ARG_FILENAME, &trace_path,
+	  N_("Write a performance trace of burn sessions to FILE (Chrome trace format)"),
+	  N_("FILE") },
 	{ NULL }
 };
 
@@ -85,6 +96,212 @@ brasero_burn_library_get_option_group (void)
 	return group;
 }
 
+/**
+ * Performance tracing: events are written as a JSON array in the Chrome
+ * trace event format so that they can be loaded in chrome://tracing or
+ * any compatible viewer. Timestamps are in microseconds.
+ */
+
+static void
+brasero_burn_trace_append_escaped (GString *string,
+				   const gchar *text)
+{
+	for (; *text; text ++) {
+		guchar c = *text;
+
+		if (c == '"' || c == '\\')
+			g_string_append_printf (string, "\\%c", c);
+		else if (c < 0x20)
+			g_string_append_printf (string, "\\u%04x", c);
+		else
+			g_string_append_c (string, c);
+	}
+}
+
+static void
+brasero_burn_trace_write (gchar phase,
+			  const gchar *category,
+			  const gchar *name,
+			  gint64 timestamp,
+			  gint64 duration,
+			  const gchar *args)
+{
+	GString *event;
+
+	event = g_string_new (NULL);
+	g_string_append_printf (event, "{\"ph\":\"%c\",\"cat\":\"", phase);
+	brasero_burn_trace_append_escaped (event, category);
+	g_string_append (event, "\",\"name\":\"");
+	brasero_burn_trace_append_escaped (event, name);
+	g_string_append_printf (event,
+				"\",\"pid\":%i,\"tid\":%u,\"ts\":%" G_GINT64_FORMAT,
+				getpid (),
+				g_direct_hash (g_thread_self ()),
+				timestamp - trace_origin);
+
+	if (phase == 'X')
+		g_string_append_printf (event, ",\"dur\":%" G_GINT64_FORMAT, duration);
+	else if (phase == 'i')
+		g_string_append (event, ",\"s\":\"t\"");
+
+	if (args)
+		g_string_append_printf (event, ",\"args\":{%s}", args);
+
+	g_string_append_c (event, '}');
+
+	G_LOCK (trace);
+	if (trace_file) {
+		fputs (trace_first? "[\n":",\n", trace_file);
+		fputs (event->str, trace_file);
+		trace_first = FALSE;
+	}
+	G_UNLOCK (trace);
+
+	g_string_free (event, TRUE);
+}
+
+static gchar *
+brasero_burn_trace_detail (const gchar *detail)
+{
+	GString *args;
+
+	if (!detail)
+		return NULL;
+
+	args = g_string_new ("\"detail\":\"");
+	brasero_burn_trace_append_escaped (args, detail);
+	g_string_append_c (args, '"');
+	return g_string_free (args, FALSE);
+}
+
+static void
+brasero_burn_trace_scsi_command (guchar opcode,
+				 gint64 start,
+				 gint64 duration)
+{
+	gchar name [16];
+
+	g_snprintf (name, sizeof (name), "SCSI 0x%02X", opcode);
+	brasero_burn_trace_write ('X', "scsi", name, start, duration, NULL);
+}
+
+gboolean
+brasero_burn_trace_enabled (void)
+{
+	return trace_file != NULL;
+}
+
+void
+brasero_burn_trace_setup (void)
+{
+	if (!trace_path || trace_file)
+		return;
+
+	trace_file = fopen (trace_path, "w");
+	if (!trace_file) {
+		g_warning ("Trace file %s could not be opened (%s)",
+			   trace_path,
+			   g_strerror (errno));
+		return;
+	}
+
+	trace_origin = g_get_monotonic_time ();
+	trace_first = TRUE;
+
+	brasero_media_library_set_trace_func (brasero_burn_trace_scsi_command);
+}
+
+void
+brasero_burn_trace_shutdown (void)
+{
+	if (!trace_file)
+		return;
+
+	brasero_media_library_set_trace_func (NULL);
+
+	G_LOCK (trace);
+	fputs (trace_first? "[]\n":"\n]\n", trace_file);
+	fclose (trace_file);
+	trace_file = NULL;
+	G_UNLOCK (trace);
+}
+
+void
+brasero_burn_trace_flush (void)
+{
+	G_LOCK (trace);
+	if (trace_file)
+		fflush (trace_file);
+	G_UNLOCK (trace);
+}
+
+void
+brasero_burn_trace_begin (const gchar *category,
+			  const gchar *name,
+			  const gchar *detail)
+{
+	gchar *args;
+
+	if (!trace_file)
+		return;
+
+	args = brasero_burn_trace_detail (detail);
+	brasero_burn_trace_write ('B', category, name, g_get_monotonic_time (), 0, args);
+	g_free (args);
+}
+
+void
+brasero_burn_trace_end (const gchar *category,
+			const gchar *name)
+{
+	if (!trace_file)
+		return;
+
+	brasero_burn_trace_write ('E', category, name, g_get_monotonic_time (), 0, NULL);
+}
+
+void
+brasero_burn_trace_span (const gchar *category,
+			 const gchar *name,
+			 const gchar *detail,
+			 gint64 start)
+{
+	gchar *args;
+
+	if (!trace_file)
+		return;
+
+	args = brasero_burn_trace_detail (detail);
+	brasero_burn_trace_write ('X',
+				  category,
+				  name,
+				  start,
+				  g_get_monotonic_time () - start,
+				  args);
+	g_free (args);
+}
+
+void
+brasero_burn_trace_counter (const gchar *name,
+			    const gchar *series,
+			    gdouble value)
+{
+	gchar number [G_ASCII_DTOSTR_BUF_SIZE];
+	GString *args;
+
+	if (!trace_file)
+		return;
+
+	/* JSON numbers always use a dot whatever the locale */
+	g_ascii_formatd (number, sizeof (number), "%.2f", value);
+
+	args = g_string_new ("\"");
+	brasero_burn_trace_append_escaped (args, series);
+	g_string_append_printf (args, "\":%s", number);
+	brasero_burn_trace_write ('C', "counter", name, g_get_monotonic_time (), 0, args->str);
+	g_string_free (args, TRUE);
+}
+
 void
 brasero_burn_debug_setup_module (GModule *handle)
 {
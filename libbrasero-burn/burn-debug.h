@@ -93,6 +93,39 @@ brasero_burn_library_set_debug (gboolean value);
 void
 brasero_burn_debug_setup_module (GModule *handle);
 
+/**
+ * Performance trace (--brasero-burn-trace)
+ */
+
+gboolean
+brasero_burn_trace_enabled (void);
+
+void
+brasero_burn_trace_setup (void);
+
+void
+brasero_burn_trace_shutdown (void);
+
+void
+brasero_burn_trace_flush (void);
+
+void
+brasero_burn_trace_begin (const gchar *category,
+			  const gchar *name,
+			  const gchar *detail);
+void
+brasero_burn_trace_end (const gchar *category,
+			const gchar *name);
+void
+brasero_burn_trace_span (const gchar *category,
+			 const gchar *name,
+			 const gchar *detail,
+			 gint64 start);
+void
+brasero_burn_trace_counter (const gchar *name,
+			    const gchar *series,
+			    gdouble value);
+
 void
 brasero_burn_debug_track_type_struct_message (BraseroTrackType *type,
 					      BraseroPluginIOFlag flags,
@@ -0,0 +1,398 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "burn-basics.h"
+#include "burn-debug.h"
+#include "burn-dedup.h"
+
+#define DEDUP_READ_SIZE		(1024 * 1024)
+#define DEDUP_MAX_THREADS	8
+
+/* Digests remembered at most; the oldest ones are forgotten first */
+#define DEDUP_MAX_DIGESTS	65536
+
+typedef struct _BraseroDedupFile BraseroDedupFile;
+struct _BraseroDedupFile {
+	gchar *path;
+	guint order;
+
+	goffset size;
+	time_t mtime;
+	dev_t dev;
+	ino_t ino;
+
+	/* set by the hashing threads */
+	gchar *digest;
+	gint errsv;
+};
+
+struct _BraseroDedup {
+	GPtrArray *files;
+
+	/* path of a duplicate => path of the file whose data it shares */
+	GHashTable *originals;
+	goffset shared_blocks;
+
+	volatile gint cancel;
+};
+
+/* Digests computed so far (path => BraseroDedupFile) and
+ * their paths in the order they were first saved */
+static GHashTable *digests = NULL;
+static GQueue *digests_order = NULL;
+G_LOCK_DEFINE_STATIC (digests);
+
+static void
+brasero_dedup_file_free (BraseroDedupFile *file)
+{
+	g_free (file->path);
+	g_free (file->digest);
+	g_free (file);
+}
+
+BraseroDedup *
+brasero_dedup_new (void)
+{
+	BraseroDedup *dedup;
+
+	dedup = g_new0 (BraseroDedup, 1);
+	dedup->files = g_ptr_array_new ();
+	dedup->originals = g_hash_table_new (g_str_hash, g_str_equal);
+	return dedup;
+}
+
+void
+brasero_dedup_free (BraseroDedup *dedup)
+{
+	guint i;
+
+	for (i = 0; i < dedup->files->len; i ++)
+		brasero_dedup_file_free (g_ptr_array_index (dedup->files, i));
+
+	g_ptr_array_free (dedup->files, TRUE);
+	g_hash_table_destroy (dedup->originals);
+	g_free (dedup);
+}
+
+void
+brasero_dedup_cancel (BraseroDedup *dedup)
+{
+	g_atomic_int_set (&dedup->cancel, 1);
+}
+
+void
+brasero_dedup_add (BraseroDedup *dedup,
+		   const gchar *path)
+{
+	BraseroDedupFile *file;
+
+	file = g_new0 (BraseroDedupFile, 1);
+	file->path = g_strdup (path);
+	file->order = dedup->files->len;
+	g_ptr_array_add (dedup->files, file);
+}
+
+static gboolean
+brasero_dedup_digest_lookup (BraseroDedupFile *file)
+{
+	BraseroDedupFile *cached;
+
+	G_LOCK (digests);
+	cached = digests? g_hash_table_lookup (digests, file->path):NULL;
+	if (cached
+	&&  cached->size == file->size
+	&&  cached->mtime == file->mtime
+	&&  cached->dev == file->dev
+	&&  cached->ino == file->ino)
+		file->digest = g_strdup (cached->digest);
+	G_UNLOCK (digests);
+
+	return file->digest != NULL;
+}
+
+static void
+brasero_dedup_digest_save (BraseroDedupFile *file)
+{
+	BraseroDedupFile *cached;
+
+	G_LOCK (digests);
+	if (!digests) {
+		digests = g_hash_table_new_full (g_str_hash,
+						 g_str_equal,
+						 NULL,
+						 (GDestroyNotify) brasero_dedup_file_free);
+		digests_order = g_queue_new ();
+	}
+
+	/* A file that changed keeps its place in the queue */
+	cached = g_hash_table_lookup (digests, file->path);
+	if (!cached) {
+		if (g_queue_get_length (digests_order) >= DEDUP_MAX_DIGESTS) {
+			gchar *oldest;
+
+			/* The path is owned by the entry */
+			oldest = g_queue_pop_head (digests_order);
+			g_hash_table_remove (digests, oldest);
+		}
+
+		cached = g_new0 (BraseroDedupFile, 1);
+		cached->path = g_strdup (file->path);
+		g_hash_table_insert (digests, cached->path, cached);
+		g_queue_push_tail (digests_order, cached->path);
+	}
+
+	cached->size = file->size;
+	cached->mtime = file->mtime;
+	cached->dev = file->dev;
+	cached->ino = file->ino;
+
+	g_free (cached->digest);
+	cached->digest = g_strdup (file->digest);
+	G_UNLOCK (digests);
+}
+
+static void
+brasero_dedup_hash_thread (gpointer data,
+			   gpointer user_data)
+{
+	BraseroDedupFile *file = data;
+	BraseroDedup *dedup = user_data;
+	GChecksum *checksum;
+	guchar *buffer;
+	int fd;
+
+	if (g_atomic_int_get (&dedup->cancel))
+		return;
+
+	fd = g_open (file->path, O_RDONLY, 0);
+	if (fd < 0) {
+		file->errsv = errno;
+		return;
+	}
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	buffer = g_malloc (DEDUP_READ_SIZE);
+	while (1) {
+		gssize bytes;
+
+		if (g_atomic_int_get (&dedup->cancel))
+			break;
+
+		bytes = read (fd, buffer, DEDUP_READ_SIZE);
+		if (bytes < 0) {
+			if (errno == EINTR)
+				continue;
+
+			file->errsv = errno;
+			break;
+		}
+
+		if (!bytes) {
+			file->digest = g_strdup (g_checksum_get_string (checksum));
+			break;
+		}
+
+		g_checksum_update (checksum, buffer, bytes);
+	}
+
+	g_free (buffer);
+	g_checksum_free (checksum);
+	close (fd);
+}
+
+static gint
+brasero_dedup_sort_size (gconstpointer a, gconstpointer b)
+{
+	const BraseroDedupFile *file_a = *(BraseroDedupFile **) a;
+	const BraseroDedupFile *file_b = *(BraseroDedupFile **) b;
+
+	if (file_a->size != file_b->size)
+		return file_a->size < file_b->size? -1:1;
+
+	/* keep the order files were added in so that the first one added is
+	 * the original of the others */
+	return file_a->order < file_b->order? -1:1;
+}
+
+BraseroBurnResult
+brasero_dedup_run (BraseroDedup *dedup)
+{
+	GPtrArray *candidates;
+	GThreadPool *pool;
+	guint hashed = 0;
+	guint bucket = 0;
+	glong threads;
+	guint i, j;
+
+	/* Files are only compared with the ones of the same size */
+	candidates = g_ptr_array_sized_new (dedup->files->len);
+	for (i = 0; i < dedup->files->len; i ++) {
+		BraseroDedupFile *file;
+		struct stat info;
+
+		if (g_atomic_int_get (&dedup->cancel)) {
+			g_ptr_array_free (candidates, TRUE);
+			return BRASERO_BURN_CANCEL;
+		}
+
+		file = g_ptr_array_index (dedup->files, i);
+		file->digest = NULL;
+		if (g_stat (file->path, &info) || !S_ISREG (info.st_mode) || !info.st_size)
+			continue;
+
+		file->size = info.st_size;
+		file->mtime = info.st_mtime;
+		file->dev = info.st_dev;
+		file->ino = info.st_ino;
+		g_ptr_array_add (candidates, file);
+	}
+
+	g_ptr_array_sort (candidates, brasero_dedup_sort_size);
+
+	threads = sysconf (_SC_NPROCESSORS_ONLN);
+	pool = g_thread_pool_new (brasero_dedup_hash_thread,
+				  dedup,
+				  CLAMP (threads, 1, DEDUP_MAX_THREADS),
+				  FALSE,
+				  NULL);
+
+	for (i = 0; i < candidates->len; i = j) {
+		BraseroDedupFile *file;
+
+		file = g_ptr_array_index (candidates, i);
+		for (j = i + 1; j < candidates->len; j ++) {
+			BraseroDedupFile *next;
+
+			next = g_ptr_array_index (candidates, j);
+			if (next->size != file->size)
+				break;
+		}
+
+		/* a size no other file has */
+		if (j - i < 2)
+			continue;
+
+		for (; i < j; i ++) {
+			file = g_ptr_array_index (candidates, i);
+			if (brasero_dedup_digest_lookup (file))
+				continue;
+
+			if (pool) {
+				g_thread_pool_push (pool, file, NULL);
+				hashed ++;
+			}
+			else
+				brasero_dedup_hash_thread (file, dedup);
+		}
+	}
+
+	/* wait for all files to be hashed */
+	if (pool)
+		g_thread_pool_free (pool, FALSE, TRUE);
+
+	if (g_atomic_int_get (&dedup->cancel)) {
+		g_ptr_array_free (candidates, TRUE);
+		return BRASERO_BURN_CANCEL;
+	}
+
+	/* Same size and same digest means same contents. Hard links don't need
+	 * to be hashed to be found identical but they were anyway. */
+	g_hash_table_remove_all (dedup->originals);
+	dedup->shared_blocks = 0;
+	for (i = 0; i < candidates->len; i ++) {
+		BraseroDedupFile *file;
+
+		file = g_ptr_array_index (candidates, i);
+		if (file->size != ((BraseroDedupFile *) g_ptr_array_index (candidates, bucket))->size)
+			bucket = i;
+
+		if (!file->digest) {
+			if (file->errsv)
+				BRASERO_BURN_LOG ("File %s could not be hashed (%s)",
+						  file->path,
+						  g_strerror (file->errsv));
+			continue;
+		}
+
+		if (hashed)
+			brasero_dedup_digest_save (file);
+
+		for (j = bucket; j < i; j ++) {
+			BraseroDedupFile *original;
+
+			original = g_ptr_array_index (candidates, j);
+			/* The same file can be grafted several times */
+			if (!original->digest
+			||  !strcmp (original->path, file->path)
+			||  g_hash_table_lookup (dedup->originals, original->path)
+			||  strcmp (original->digest, file->digest))
+				continue;
+
+			g_hash_table_insert (dedup->originals, file->path, original->path);
+			dedup->shared_blocks += BRASERO_BYTES_TO_SECTORS (file->size, 2048);
+			break;
+		}
+	}
+
+	BRASERO_BURN_LOG ("%u files hashed, %u duplicates found (%" G_GOFFSET_FORMAT " blocks saved)",
+			  hashed,
+			  g_hash_table_size (dedup->originals),
+			  dedup->shared_blocks);
+
+	g_ptr_array_free (candidates, TRUE);
+	return BRASERO_BURN_OK;
+}
+
+const gchar *
+brasero_dedup_get_original (BraseroDedup *dedup,
+			    const gchar *path)
+{
+	return g_hash_table_lookup (dedup->originals, path);
+}
+
+goffset
+brasero_dedup_get_shared_blocks (BraseroDedup *dedup)
+{
+	return dedup->shared_blocks;
+}
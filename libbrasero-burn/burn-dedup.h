@@ -0,0 +1,77 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BURN_DEDUP_H
+#define _BURN_DEDUP_H
+
+#include <glib.h>
+
+#include "burn-basics.h"
+
+G_BEGIN_DECLS
+
+/**
+ * This finds the files with identical contents among a list of local files so
+ * that their data can be written only once in an image. Files are grouped by
+ * size and only the ones whose size is shared are hashed (with a pool of
+ * threads). Digests of the last files hashed are kept for the lifetime of
+ * the process as long as the file (device, inode, size and modification time)
+ * does not change.
+ * brasero_dedup_run () blocks; cancellation can be requested from any thread.
+ */
+
+typedef struct _BraseroDedup BraseroDedup;
+
+BraseroDedup *
+brasero_dedup_new (void);
+
+void
+brasero_dedup_free (BraseroDedup *dedup);
+
+void
+brasero_dedup_cancel (BraseroDedup *dedup);
+
+void
+brasero_dedup_add (BraseroDedup *dedup,
+		   const gchar *path);
+
+BraseroBurnResult
+brasero_dedup_run (BraseroDedup *dedup);
+
+const gchar *
+brasero_dedup_get_original (BraseroDedup *dedup,
+			    const gchar *path);
+
+goffset
+brasero_dedup_get_shared_blocks (BraseroDedup *dedup);
+
+G_END_DECLS
+
+#endif /* _BURN_DEDUP_H */
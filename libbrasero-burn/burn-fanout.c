@@ -0,0 +1,636 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+
+#include "brasero-error.h"
+#include "burn-basics.h"
+#include "burn-debug.h"
+#include "burn-fanout.h"
+
+#define FANOUT_CHUNK_SIZE	(64 * 1024)
+
+/* How often (ms) threads check whether they were cancelled while waiting for
+ * the other end of a pipe */
+#define FANOUT_POLL_TIMEOUT	250
+
+typedef struct _BraseroFanoutChunk BraseroFanoutChunk;
+struct _BraseroFanoutChunk {
+	gint ref;
+	gsize size;
+	guchar data [];
+};
+
+typedef struct _BraseroFanoutOutput BraseroFanoutOutput;
+struct _BraseroFanoutOutput {
+	BraseroFanout *fanout;
+	gchar *path;
+
+	GAsyncQueue *queue;
+	GThread *thread;
+
+	/* protected by the fanout lock */
+	guint queued;
+	goffset written;
+
+	/* set from other threads */
+	gint closed;
+	gint failed;
+};
+
+struct _BraseroFanout {
+	gchar *source;
+
+	BraseroFanoutOutput *outputs;
+	guint outputs_num;
+
+	/* number of chunks each output can have queued */
+	guint ring_chunks;
+	goffset size;
+
+	GThread *thread;
+	GMutex *lock;
+	GCond *cond;
+
+	GSourceFunc source_started;
+	GSourceFunc source_failed;
+	gpointer user_data;
+	guint source_started_id;
+	guint source_failed_id;
+
+	/* protected by the lock; set by brasero_fanout_set_size () */
+	guint size_known:1;
+
+	gint cancel;
+	gint short_source;
+};
+
+static BraseroFanoutChunk *
+brasero_fanout_chunk_new (gsize size)
+{
+	BraseroFanoutChunk *chunk;
+
+	chunk = g_malloc (sizeof (BraseroFanoutChunk) + size);
+	chunk->ref = 1;
+	chunk->size = 0;
+	return chunk;
+}
+
+static void
+brasero_fanout_chunk_unref (BraseroFanoutChunk *chunk)
+{
+	if (g_atomic_int_dec_and_test (&chunk->ref))
+		g_free (chunk);
+}
+
+static gboolean
+brasero_fanout_output_write (BraseroFanoutOutput *output,
+			     int fd,
+			     BraseroFanoutChunk *chunk)
+{
+	gsize done = 0;
+
+	while (done < chunk->size) {
+		gssize bytes;
+
+		bytes = write (fd, chunk->data + done, chunk->size - done);
+		if (bytes < 0) {
+			if (errno == EINTR)
+				continue;
+
+			/* EPIPE: the recorder went away */
+			BRASERO_BURN_LOG ("Fan-out output %s failed (%s)",
+					  output->path,
+					  g_strerror (errno));
+			return FALSE;
+		}
+
+		done += bytes;
+	}
+
+	return TRUE;
+}
+
+static gpointer
+brasero_fanout_output_thread (gpointer data)
+{
+	BraseroFanoutOutput *output = data;
+	BraseroFanout *fanout = output->fanout;
+	sigset_t set;
+	int fd = -1;
+
+	/* A recorder closing its end must not kill the whole process */
+	sigemptyset (&set);
+	sigaddset (&set, SIGPIPE);
+	pthread_sigmask (SIG_BLOCK, &set, NULL);
+
+	/* Wait for the recorder to open its end. This is not done with a
+	 * blocking open () as the recorder may fail before opening it. */
+	while (!g_atomic_int_get (&output->closed)
+	&&     !g_atomic_int_get (&fanout->cancel)) {
+		fd = open (output->path, O_WRONLY|O_NONBLOCK);
+		if (fd >= 0) {
+			fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_NONBLOCK);
+			break;
+		}
+
+		if (errno != ENXIO && errno != EINTR) {
+			BRASERO_BURN_LOG ("Fan-out output %s could not be opened (%s)",
+					  output->path,
+					  g_strerror (errno));
+			break;
+		}
+
+		g_usleep (FANOUT_POLL_TIMEOUT * 1000);
+	}
+
+	if (fd < 0)
+		g_atomic_int_set (&output->failed, 1);
+
+	/* Once the output failed, chunks are still taken out of the queue so
+	 * that the other outputs are not held up by this one. */
+	while (1) {
+		BraseroFanoutChunk *chunk;
+		gboolean success = FALSE;
+		gboolean end;
+
+		chunk = g_async_queue_pop (output->queue);
+		end = (chunk->size == 0);
+
+		if (!end
+		&&  !g_atomic_int_get (&output->failed)
+		&&  !g_atomic_int_get (&output->closed)) {
+			success = brasero_fanout_output_write (output, fd, chunk);
+			if (!success)
+				g_atomic_int_set (&output->failed, 1);
+		}
+
+		g_mutex_lock (fanout->lock);
+		output->queued --;
+		if (success)
+			output->written += chunk->size;
+		g_cond_broadcast (fanout->cond);
+		g_mutex_unlock (fanout->lock);
+
+		brasero_fanout_chunk_unref (chunk);
+		if (end)
+			break;
+	}
+
+	/* If the source ended before all the data were produced, don't let the
+	 * recorder see the end of its input: it could pad the track and carry
+	 * on. The pipe is kept open until the recorder is cancelled. */
+	while (fd >= 0
+	&&     g_atomic_int_get (&fanout->short_source)
+	&&    !g_atomic_int_get (&output->closed)
+	&&    !g_atomic_int_get (&fanout->cancel))
+		g_usleep (FANOUT_POLL_TIMEOUT * 1000);
+
+	if (fd >= 0)
+		close (fd);
+
+	return NULL;
+}
+
+static void
+brasero_fanout_dispatch (BraseroFanout *fanout,
+			 BraseroFanoutChunk *chunk)
+{
+	guint i;
+
+	/* Only wait when an output that is still working has a full ring */
+	g_mutex_lock (fanout->lock);
+	while (chunk->size && !g_atomic_int_get (&fanout->cancel)) {
+		gboolean full = FALSE;
+
+		for (i = 0; i < fanout->outputs_num; i ++) {
+			BraseroFanoutOutput *output;
+
+			output = fanout->outputs + i;
+			if (output->queued >= fanout->ring_chunks
+			&& !g_atomic_int_get (&output->failed)
+			&& !g_atomic_int_get (&output->closed)) {
+				full = TRUE;
+				break;
+			}
+		}
+
+		if (!full)
+			break;
+
+		g_cond_wait (fanout->cond, fanout->lock);
+	}
+
+	for (i = 0; i < fanout->outputs_num; i ++) {
+		fanout->outputs [i].queued ++;
+		g_atomic_int_inc (&chunk->ref);
+	}
+	g_mutex_unlock (fanout->lock);
+
+	for (i = 0; i < fanout->outputs_num; i ++)
+		g_async_queue_push (fanout->outputs [i].queue, chunk);
+
+	brasero_fanout_chunk_unref (chunk);
+}
+
+static gboolean
+brasero_fanout_source_started_cb (gpointer data)
+{
+	BraseroFanout *fanout = data;
+
+	g_mutex_lock (fanout->lock);
+	fanout->source_started_id = 0;
+	g_mutex_unlock (fanout->lock);
+
+	fanout->source_started (fanout->user_data);
+	return FALSE;
+}
+
+/**
+ * The producer knows the exact size of the data only once it runs. So wait
+ * for the first bytes and for our owner to tell us that size before
+ * passing on anything.
+ */
+
+static gboolean
+brasero_fanout_wait_for_size (BraseroFanout *fanout)
+{
+	g_mutex_lock (fanout->lock);
+	if (!g_atomic_int_get (&fanout->cancel))
+		fanout->source_started_id = g_idle_add (brasero_fanout_source_started_cb,
+							fanout);
+
+	while (!fanout->size_known && !g_atomic_int_get (&fanout->cancel))
+		g_cond_wait (fanout->cond, fanout->lock);
+	g_mutex_unlock (fanout->lock);
+
+	return !g_atomic_int_get (&fanout->cancel);
+}
+
+static gboolean
+brasero_fanout_source_failed_cb (gpointer data)
+{
+	BraseroFanout *fanout = data;
+
+	g_mutex_lock (fanout->lock);
+	fanout->source_failed_id = 0;
+	g_mutex_unlock (fanout->lock);
+
+	fanout->source_failed (fanout->user_data);
+	return FALSE;
+}
+
+static gpointer
+brasero_fanout_source_thread (gpointer data)
+{
+	BraseroFanout *fanout = data;
+	BraseroFanoutChunk *chunk;
+	goffset total = 0;
+	int fd;
+
+	chunk = brasero_fanout_chunk_new (FANOUT_CHUNK_SIZE);
+
+	/* Non blocking so that we can be cancelled before the producer opens
+	 * the other end. NOTE: poll () doesn't report anything before that. */
+	fd = open (fanout->source, O_RDONLY|O_NONBLOCK);
+	if (fd < 0) {
+		BRASERO_BURN_LOG ("Fan-out source could not be opened (%s)",
+				  g_strerror (errno));
+		goto end;
+	}
+
+	while (!g_atomic_int_get (&fanout->cancel)) {
+		struct pollfd pfd;
+		gssize bytes;
+
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll (&pfd, 1, FANOUT_POLL_TIMEOUT) <= 0)
+			continue;
+
+		bytes = read (fd,
+			      chunk->data + chunk->size,
+			      FANOUT_CHUNK_SIZE - chunk->size);
+		if (bytes < 0) {
+			if (errno == EAGAIN || errno == EINTR)
+				continue;
+
+			BRASERO_BURN_LOG ("Fan-out source could not be read (%s)",
+					  g_strerror (errno));
+			break;
+		}
+
+		if (!bytes)
+			break;
+
+		if (!total && !brasero_fanout_wait_for_size (fanout))
+			break;
+
+		chunk->size += bytes;
+		total += bytes;
+
+		if (chunk->size == FANOUT_CHUNK_SIZE) {
+			brasero_fanout_dispatch (fanout, chunk);
+			chunk = brasero_fanout_chunk_new (FANOUT_CHUNK_SIZE);
+		}
+	}
+
+	close (fd);
+
+	if (chunk->size) {
+		brasero_fanout_dispatch (fanout, chunk);
+		chunk = brasero_fanout_chunk_new (0);
+	}
+
+end:
+
+	/* Nothing at all means the producer failed before it started */
+	if (!total || total < fanout->size) {
+		BRASERO_BURN_LOG ("Fan-out source ended early (%lli / %lli bytes)",
+				  (long long int) total,
+				  (long long int) fanout->size);
+		g_atomic_int_set (&fanout->short_source, 1);
+
+		g_mutex_lock (fanout->lock);
+		if (!g_atomic_int_get (&fanout->cancel) && fanout->source_failed)
+			fanout->source_failed_id = g_idle_add (brasero_fanout_source_failed_cb,
+							       fanout);
+		g_mutex_unlock (fanout->lock);
+	}
+	else
+		BRASERO_BURN_LOG ("Fan-out source finished (%lli bytes)",
+				  (long long int) total);
+
+	/* The last chunk is empty and tells the outputs to stop */
+	chunk->size = 0;
+	brasero_fanout_dispatch (fanout, chunk);
+	return NULL;
+}
+
+/**
+ * @source_started is called in the main loop once the first bytes were
+ * received; brasero_fanout_set_size () must then be called for the data to
+ * be passed on. @source_failed is called if the source ends before that
+ * size was reached.
+ */
+
+BraseroBurnResult
+brasero_fanout_start (BraseroFanout *fanout,
+		      GSourceFunc source_started,
+		      GSourceFunc source_failed,
+		      gpointer user_data,
+		      GError **error)
+{
+	guint i;
+
+	fanout->source_started = source_started;
+	fanout->source_failed = source_failed;
+	fanout->user_data = user_data;
+
+	for (i = 0; i < fanout->outputs_num; i ++) {
+		BraseroFanoutOutput *output;
+
+		output = fanout->outputs + i;
+		output->thread = g_thread_create (brasero_fanout_output_thread,
+						  output,
+						  TRUE,
+						  error);
+		if (!output->thread)
+			return BRASERO_BURN_ERR;
+	}
+
+	fanout->thread = g_thread_create (brasero_fanout_source_thread,
+					  fanout,
+					  TRUE,
+					  error);
+	if (!fanout->thread)
+		return BRASERO_BURN_ERR;
+
+	return BRASERO_BURN_OK;
+}
+
+void
+brasero_fanout_set_size (BraseroFanout *fanout,
+			 goffset size)
+{
+	g_mutex_lock (fanout->lock);
+	fanout->size = size;
+	fanout->size_known = TRUE;
+	g_cond_broadcast (fanout->cond);
+	g_mutex_unlock (fanout->lock);
+}
+
+/**
+ * To be called once the recorder reading this output has returned.
+ */
+
+void
+brasero_fanout_close_output (BraseroFanout *fanout,
+			     guint output)
+{
+	g_return_if_fail (output < fanout->outputs_num);
+
+	g_mutex_lock (fanout->lock);
+	g_atomic_int_set (&fanout->outputs [output].closed, 1);
+	g_cond_broadcast (fanout->cond);
+	g_mutex_unlock (fanout->lock);
+}
+
+BraseroBurnResult
+brasero_fanout_get_status (BraseroFanout *fanout,
+			   guint output,
+			   goffset *written,
+			   gdouble *buffer_fill)
+{
+	BraseroFanoutOutput *fanout_output;
+
+	g_return_val_if_fail (output < fanout->outputs_num, BRASERO_BURN_ERR);
+
+	fanout_output = fanout->outputs + output;
+
+	g_mutex_lock (fanout->lock);
+	if (written)
+		*written = fanout_output->written;
+	if (buffer_fill)
+		*buffer_fill = (gdouble) MIN (fanout_output->queued, fanout->ring_chunks) /
+			       (gdouble) fanout->ring_chunks;
+	g_mutex_unlock (fanout->lock);
+
+	if (g_atomic_int_get (&fanout_output->failed))
+		return BRASERO_BURN_ERR;
+
+	return BRASERO_BURN_OK;
+}
+
+const gchar *
+brasero_fanout_get_source (BraseroFanout *fanout)
+{
+	return fanout->source;
+}
+
+const gchar *
+brasero_fanout_get_output (BraseroFanout *fanout,
+			   guint output)
+{
+	g_return_val_if_fail (output < fanout->outputs_num, NULL);
+	return fanout->outputs [output].path;
+}
+
+static gboolean
+brasero_fanout_make_pipe (const gchar *path,
+			  GError **error)
+{
+	if (!mkfifo (path, S_IRUSR|S_IWUSR))
+		return TRUE;
+
+	g_set_error (error,
+		     BRASERO_BURN_ERROR,
+		     BRASERO_BURN_ERROR_TMP_DIRECTORY,
+		     _("A named pipe could not be created (%s)"),
+		     g_strerror (errno));
+	return FALSE;
+}
+
+BraseroFanout *
+brasero_fanout_new (const gchar *tmpdir,
+		    guint outputs,
+		    gsize ring_size,
+		    GError **error)
+{
+	BraseroFanout *fanout;
+	guint i;
+
+	fanout = g_new0 (BraseroFanout, 1);
+	fanout->lock = g_mutex_new ();
+	fanout->cond = g_cond_new ();
+	fanout->ring_chunks = MAX (ring_size / FANOUT_CHUNK_SIZE, 2);
+
+	fanout->outputs_num = outputs;
+	fanout->outputs = g_new0 (BraseroFanoutOutput, outputs);
+
+	fanout->source = g_build_filename (tmpdir, "fanout-source", NULL);
+	if (!brasero_fanout_make_pipe (fanout->source, error)) {
+		g_free (fanout->source);
+		fanout->source = NULL;
+		brasero_fanout_free (fanout);
+		return NULL;
+	}
+
+	for (i = 0; i < outputs; i ++) {
+		BraseroFanoutOutput *output;
+		gchar *name;
+
+		output = fanout->outputs + i;
+		output->fanout = fanout;
+		output->queue = g_async_queue_new ();
+
+		name = g_strdup_printf ("fanout-%02i", i);
+		output->path = g_build_filename (tmpdir, name, NULL);
+		g_free (name);
+
+		if (!brasero_fanout_make_pipe (output->path, error)) {
+			g_free (output->path);
+			output->path = NULL;
+			brasero_fanout_free (fanout);
+			return NULL;
+		}
+	}
+
+	return fanout;
+}
+
+void
+brasero_fanout_free (BraseroFanout *fanout)
+{
+	guint i;
+
+	g_mutex_lock (fanout->lock);
+	g_atomic_int_set (&fanout->cancel, 1);
+	g_cond_broadcast (fanout->cond);
+	g_mutex_unlock (fanout->lock);
+
+	/* The source thread pushes the last chunk to every output */
+	if (fanout->thread)
+		g_thread_join (fanout->thread);
+
+	if (fanout->source_started_id)
+		g_source_remove (fanout->source_started_id);
+
+	if (fanout->source_failed_id)
+		g_source_remove (fanout->source_failed_id);
+
+	for (i = 0; i < fanout->outputs_num; i ++) {
+		BraseroFanoutOutput *output;
+
+		output = fanout->outputs + i;
+		if (output->thread) {
+			/* No source thread means no last chunk */
+			if (!fanout->thread)
+				g_async_queue_push (output->queue, brasero_fanout_chunk_new (0));
+
+			g_thread_join (output->thread);
+		}
+
+		if (output->queue)
+			g_async_queue_unref (output->queue);
+
+		if (output->path) {
+			g_remove (output->path);
+			g_free (output->path);
+		}
+	}
+	g_free (fanout->outputs);
+
+	if (fanout->source) {
+		g_remove (fanout->source);
+		g_free (fanout->source);
+	}
+
+	g_mutex_free (fanout->lock);
+	g_cond_free (fanout->cond);
+	g_free (fanout);
+}
@@ -0,0 +1,90 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BURN_FANOUT_H
+#define _BURN_FANOUT_H
+
+#include <glib.h>
+
+#include "burn-basics.h"
+
+G_BEGIN_DECLS
+
+/**
+ * This copies what is written in a named pipe (the source) to several other
+ * named pipes (the outputs) so that an image produced once can be recorded
+ * by several recorders at the same time.
+ * Each output has its own ring buffer and its own thread so that a drive
+ * that stalls does not stop the others as long as its buffer is not full.
+ * An output whose reader went away is skipped; the others go on.
+ */
+
+typedef struct _BraseroFanout BraseroFanout;
+
+BraseroFanout *
+brasero_fanout_new (const gchar *tmpdir,
+		    guint outputs,
+		    gsize ring_size,
+		    GError **error);
+
+void
+brasero_fanout_free (BraseroFanout *fanout);
+
+const gchar *
+brasero_fanout_get_source (BraseroFanout *fanout);
+
+const gchar *
+brasero_fanout_get_output (BraseroFanout *fanout,
+			   guint output);
+
+BraseroBurnResult
+brasero_fanout_start (BraseroFanout *fanout,
+		      GSourceFunc source_started,
+		      GSourceFunc source_failed,
+		      gpointer user_data,
+		      GError **error);
+
+void
+brasero_fanout_set_size (BraseroFanout *fanout,
+			 goffset size);
+
+void
+brasero_fanout_close_output (BraseroFanout *fanout,
+			     guint output);
+
+BraseroBurnResult
+brasero_fanout_get_status (BraseroFanout *fanout,
+			   guint output,
+			   goffset *written,
+			   gdouble *buffer_fill);
+
+G_END_DECLS
+
+#endif /* _BURN_FANOUT_H */
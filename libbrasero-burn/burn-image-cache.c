@@ -0,0 +1,457 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "burn-basics.h"
+#include "burn-debug.h"
+#include "brasero-session.h"
+#include "brasero-session-helper.h"
+#include "brasero-track-data.h"
+#include "burn-image-cache.h"
+
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_IMAGE_CACHE_SIZE	"image-cache-size"
+#define BRASERO_KEY_DEDUP_FILES		"dedup-files"
+
+#define IMAGE_CACHE_DIR			"images"
+#define IMAGE_CACHE_SUFFIX		".iso"
+#define IMAGE_CACHE_TMP_SUFFIX		".part"
+
+/* In seconds; an image being built is written to all the time so a
+ * temporary image that was not modified for that long was abandoned */
+#define IMAGE_CACHE_TMP_MAX_AGE		(24 * 60 * 60)
+
+static goffset
+brasero_image_cache_get_budget (void)
+{
+	GSettings *settings;
+	gint size;
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	size = g_settings_get_int (settings, BRASERO_KEY_IMAGE_CACHE_SIZE);
+	g_object_unref (settings);
+
+	return (goffset) MAX (size, 0) * 1024 * 1024;
+}
+
+/**
+ * The cache lives in the user cache directory rather than in a shared
+ * temporary directory where anybody could plant an image for us to burn.
+ */
+
+static gchar *
+brasero_image_cache_get_dir (void)
+{
+	struct stat info;
+	gchar *path;
+
+	path = g_build_filename (g_get_user_cache_dir (),
+				 "brasero",
+				 IMAGE_CACHE_DIR,
+				 NULL);
+
+	if (g_mkdir_with_parents (path, S_IRWXU)) {
+		BRASERO_BURN_LOG ("Image cache directory could not be created (%s)",
+				  g_strerror (errno));
+		g_free (path);
+		return NULL;
+	}
+
+	if (g_lstat (path, &info)
+	|| !S_ISDIR (info.st_mode)
+	||  info.st_uid != getuid ()
+	|| (info.st_mode & (S_IRWXG|S_IRWXO))) {
+		BRASERO_BURN_LOG ("Image cache directory %s is not private; not using it", path);
+		g_free (path);
+		return NULL;
+	}
+
+	return path;
+}
+
+static void
+brasero_image_cache_add_stat (GChecksum *checksum,
+			      const gchar *name,
+			      struct stat *info)
+{
+	gchar *string;
+
+	string = g_strdup_printf ("%s %o %lli %lli",
+				  name,
+				  info->st_mode,
+				  (long long int) info->st_size,
+				  (long long int) info->st_mtime);
+	g_checksum_update (checksum, (guchar *) string, strlen (string) + 1);
+	g_free (string);
+}
+
+static gboolean
+brasero_image_cache_add_tree (GChecksum *checksum,
+			      const gchar *path)
+{
+	struct stat info;
+	const gchar *name;
+	GSList *names = NULL;
+	GSList *iter;
+	GDir *dir;
+
+	/* NOTE: symlinks are followed as the images contain their target */
+	if (g_stat (path, &info))
+		return FALSE;
+
+	brasero_image_cache_add_stat (checksum, path, &info);
+	if (!S_ISDIR (info.st_mode))
+		return TRUE;
+
+	dir = g_dir_open (path, 0, NULL);
+	if (!dir)
+		return FALSE;
+
+	/* Sort so that the digest doesn't depend on the order of readdir () */
+	while ((name = g_dir_read_name (dir)))
+		names = g_slist_prepend (names, g_strdup (name));
+	g_dir_close (dir);
+
+	names = g_slist_sort (names, (GCompareFunc) strcmp);
+	for (iter = names; iter; iter = iter->next) {
+		gchar *child;
+		gboolean result;
+
+		child = g_build_filename (path, iter->data, NULL);
+		result = brasero_image_cache_add_tree (checksum, child);
+		g_free (child);
+
+		if (!result)
+			break;
+	}
+
+	g_slist_foreach (names, (GFunc) g_free, NULL);
+	g_slist_free (names);
+
+	return (iter == NULL);
+}
+
+/**
+ * Returns NULL if the session can't be cached: it is not a data session or
+ * some files are not local.
+ */
+
+gchar *
+brasero_image_cache_get_key (BraseroBurnSession *session)
+{
+	GSettings *settings;
+	GChecksum *checksum;
+	const gchar *label;
+	GSList *tracks;
+	GSList *iter;
+	gchar *key;
+
+	if (!brasero_image_cache_get_budget ())
+		return NULL;
+
+	tracks = brasero_burn_session_get_tracks (session);
+	if (!tracks)
+		return NULL;
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+	label = brasero_burn_session_get_label (session);
+	if (label)
+		g_checksum_update (checksum, (guchar *) label, strlen (label) + 1);
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	if (g_settings_get_boolean (settings, BRASERO_KEY_DEDUP_FILES))
+		g_checksum_update (checksum, (guchar *) "dedup", 6);
+	g_object_unref (settings);
+
+	for (iter = tracks; iter; iter = iter->next) {
+		BraseroTrackData *track;
+		BraseroImageFS fs;
+		GSList *grafts;
+		gchar *string;
+
+		if (!BRASERO_IS_TRACK_DATA (iter->data))
+			goto not_cacheable;
+
+		track = iter->data;
+		fs = brasero_track_data_get_fs (track);
+		string = g_strdup_printf ("fs %i", fs);
+		g_checksum_update (checksum, (guchar *) string, strlen (string) + 1);
+		g_free (string);
+
+		for (grafts = brasero_track_data_get_grafts (track); grafts; grafts = grafts->next) {
+			BraseroGraftPt *graft;
+			gchar *local;
+
+			graft = grafts->data;
+			g_checksum_update (checksum, (guchar *) graft->path, strlen (graft->path) + 1);
+
+			/* empty directories have no URI */
+			if (!graft->uri)
+				continue;
+
+			local = g_filename_from_uri (graft->uri, NULL, NULL);
+			if (!local) {
+				BRASERO_BURN_LOG ("Image not cacheable (%s is not local)", graft->uri);
+				goto not_cacheable;
+			}
+
+			if (!brasero_image_cache_add_tree (checksum, local)) {
+				BRASERO_BURN_LOG ("Image not cacheable (%s could not be read)", local);
+				g_free (local);
+				goto not_cacheable;
+			}
+			g_free (local);
+		}
+
+		for (grafts = brasero_track_data_get_excluded_list (track); grafts; grafts = grafts->next) {
+			const gchar *uri = grafts->data;
+
+			g_checksum_update (checksum, (guchar *) "excluded", 9);
+			g_checksum_update (checksum, (guchar *) uri, strlen (uri) + 1);
+		}
+	}
+
+	key = g_strdup (g_checksum_get_string (checksum));
+	g_checksum_free (checksum);
+	return key;
+
+not_cacheable:
+
+	g_checksum_free (checksum);
+	return NULL;
+}
+
+/**
+ * Returns the path of the image if it is in the cache and marks it as the
+ * most recently used one.
+ */
+
+gchar *
+brasero_image_cache_lookup (const gchar *key)
+{
+	gchar *path;
+	gchar *name;
+	gchar *dir;
+
+	dir = brasero_image_cache_get_dir ();
+	if (!dir)
+		return NULL;
+
+	name = g_strconcat (key, IMAGE_CACHE_SUFFIX, NULL);
+	path = g_build_filename (dir, name, NULL);
+	g_free (name);
+	g_free (dir);
+
+	if (!g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
+		g_free (path);
+		return NULL;
+	}
+
+	/* the modification time orders entries for eviction */
+	g_utime (path, NULL);
+	return path;
+}
+
+gchar *
+brasero_image_cache_get_tmp_path (const gchar *key)
+{
+	gchar *path;
+	gchar *name;
+	gchar *dir;
+
+	dir = brasero_image_cache_get_dir ();
+	if (!dir)
+		return NULL;
+
+	name = g_strconcat (key, IMAGE_CACHE_TMP_SUFFIX, NULL);
+	path = g_build_filename (dir, name, NULL);
+	g_free (name);
+	g_free (dir);
+
+	return path;
+}
+
+typedef struct _BraseroImageCacheEntry BraseroImageCacheEntry;
+struct _BraseroImageCacheEntry {
+	gchar *path;
+	goffset size;
+	time_t mtime;
+};
+
+static gint
+brasero_image_cache_entry_cmp (gconstpointer a,
+			       gconstpointer b)
+{
+	const BraseroImageCacheEntry *entry_a = a;
+	const BraseroImageCacheEntry *entry_b = b;
+
+	if (entry_a->mtime == entry_b->mtime)
+		return 0;
+
+	return entry_a->mtime < entry_b->mtime ? -1 : 1;
+}
+
+static void
+brasero_image_cache_evict (const gchar *dir_path,
+			   const gchar *keep,
+			   goffset budget)
+{
+	GSList *entries = NULL;
+	goffset total = 0;
+	const gchar *name;
+	GSList *iter;
+	time_t now;
+	GDir *dir;
+
+	dir = g_dir_open (dir_path, 0, NULL);
+	if (!dir)
+		return;
+
+	now = time (NULL);
+	while ((name = g_dir_read_name (dir))) {
+		BraseroImageCacheEntry *entry;
+		struct stat info;
+		gchar *path;
+
+		if (g_str_has_suffix (name, IMAGE_CACHE_TMP_SUFFIX)) {
+			/* Left by a build that was interrupted or that crashed */
+			path = g_build_filename (dir_path, name, NULL);
+			if (!g_lstat (path, &info)
+			&&  now - info.st_mtime > IMAGE_CACHE_TMP_MAX_AGE) {
+				BRASERO_BURN_LOG ("Removing stale %s from image cache", path);
+				g_remove (path);
+			}
+
+			g_free (path);
+			continue;
+		}
+
+		if (!g_str_has_suffix (name, IMAGE_CACHE_SUFFIX))
+			continue;
+
+		path = g_build_filename (dir_path, name, NULL);
+		if (g_stat (path, &info)) {
+			g_free (path);
+			continue;
+		}
+
+		total += info.st_size;
+		if (!strcmp (path, keep)) {
+			g_free (path);
+			continue;
+		}
+
+		entry = g_new0 (BraseroImageCacheEntry, 1);
+		entry->path = path;
+		entry->size = info.st_size;
+		entry->mtime = info.st_mtime;
+		entries = g_slist_prepend (entries, entry);
+	}
+	g_dir_close (dir);
+
+	/* Least recently used first; the new image is always kept: it is about
+	 * to be used and brasero_image_cache_add () made sure it fits. */
+	entries = g_slist_sort (entries, brasero_image_cache_entry_cmp);
+	for (iter = entries; iter && total > budget; iter = iter->next) {
+		BraseroImageCacheEntry *entry = iter->data;
+
+		BRASERO_BURN_LOG ("Removing %s from image cache", entry->path);
+		if (!g_remove (entry->path))
+			total -= entry->size;
+	}
+
+	for (iter = entries; iter; iter = iter->next) {
+		BraseroImageCacheEntry *entry = iter->data;
+
+		g_free (entry->path);
+		g_free (entry);
+	}
+	g_slist_free (entries);
+}
+
+/**
+ * Moves an image built at the path returned by
+ * brasero_image_cache_get_tmp_path () into the cache and returns its new
+ * path. Returns NULL and leaves the image where it is if it could not be
+ * added, for example when it is larger than the whole cache.
+ */
+
+gchar *
+brasero_image_cache_add (const gchar *key,
+			 const gchar *tmp_path)
+{
+	struct stat info;
+	goffset budget;
+	gchar *path;
+	gchar *name;
+	gchar *dir;
+
+	budget = brasero_image_cache_get_budget ();
+	if (g_stat (tmp_path, &info) || info.st_size > budget) {
+		BRASERO_BURN_LOG ("Image not added to cache (larger than the cache)");
+		return NULL;
+	}
+
+	dir = brasero_image_cache_get_dir ();
+	if (!dir)
+		return NULL;
+
+	name = g_strconcat (key, IMAGE_CACHE_SUFFIX, NULL);
+	path = g_build_filename (dir, name, NULL);
+	g_free (name);
+
+	if (g_rename (tmp_path, path)) {
+		BRASERO_BURN_LOG ("Image could not be added to cache (%s)",
+				  g_strerror (errno));
+		g_free (path);
+		g_free (dir);
+		return NULL;
+	}
+
+	brasero_image_cache_evict (dir, path, budget);
+	g_free (dir);
+
+	return path;
+}
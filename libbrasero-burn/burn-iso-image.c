@@ -0,0 +1,2351 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+
+#include "burn-basics.h"
+#include "burn-debug.h"
+#include "brasero-track-data.h"
+#include "burn-iso-image.h"
+#include "burn-dedup.h"
+
+#define ISO_BLOCK_SIZE			2048
+#define ISO_SYSTEM_AREA_BLOCKS		16
+
+/* Like mkisofs, pad the end of the volume to work around the read ahead
+ * problems of some drives/kernels with CDs */
+#define ISO_PADDING_BLOCKS		150
+
+#define ISO_RECORD_BASE			33
+#define ISO_RECORD_MAX			255
+
+/* ISO9660 level 2 */
+#define ISO_FILE_NAME_MAX		30
+#define ISO_DIR_NAME_MAX		31
+#define ISO_EXT_MAX			8
+
+#define ISO_DIRS_MAX			65535
+
+#define JOLIET_NAME_MAX			64
+
+#define RR_NAME_MAX			255
+#define RR_NM_CHUNK			250
+#define RR_SP_LEN			7
+#define RR_PX_LEN			36
+#define RR_TF_LEN			12
+#define SUSP_CE_LEN			28
+
+#define RR_ER_ID			"RRIP_1991A"
+#define RR_ER_DESC			"THE ROCK RIDGE INTERCHANGE PROTOCOL PROVIDES SUPPORT FOR POSIX FILE SYSTEM SEMANTICS"
+#define RR_ER_SRC			"PLEASE CONTACT DISC PUBLISHER FOR SPECIFICATION SOURCE.  SEE PUBLISHER IDENTIFIER IN PRIMARY VOLUME DESCRIPTOR FOR CONTACT INFORMATION."
+#define RR_ER_LEN			(8 + strlen (RR_ER_ID) + strlen (RR_ER_DESC) + strlen (RR_ER_SRC))
+
+/* Metadata is output 64 KiB at a time and files are read 1 MiB at a time */
+#define ISO_WRITE_BUFFER_SIZE		(32 * ISO_BLOCK_SIZE)
+#define ISO_READ_BUFFER_SIZE		(512 * ISO_BLOCK_SIZE)
+
+#define ISO_ROUND_BLOCKS(size)		(((size) + ISO_BLOCK_SIZE - 1) / ISO_BLOCK_SIZE)
+
+/* Files are recorded as a single extent whose size is a 32 bit value */
+#define ISO_FILE_SIZE_MAX		((guint64) G_MAXUINT32)
+#define ISO_FILE_BLOCKS_MAX		ISO_ROUND_BLOCKS (ISO_FILE_SIZE_MAX)
+
+typedef enum {
+	ISO_RECORD_SELF,
+	ISO_RECORD_PARENT,
+	ISO_RECORD_CHILD
+} BraseroIsoRecordType;
+
+struct _BraseroIsoNode {
+	BraseroIsoNode *parent;
+
+	/* name in the image (UTF-8) and location on disc */
+	gchar *name;
+	gchar *path;
+
+	/* only used while the tree is built */
+	GHashTable *names;
+	GSList *children;
+
+	/* set when the volume is laid out */
+	BraseroIsoNode **iso_children;
+	BraseroIsoNode **joliet_children;
+	guint children_num;
+	guint subdirs_num;
+
+	gchar *iso_name;
+	guchar *joliet_name;
+	guint joliet_len;
+
+	guint64 size;
+	time_t mtime;
+	guint32 mode;
+
+	/* blocks used by the data of files */
+	guint32 blocks;
+
+	/* data for files, ISO9660 directory records for directories */
+	guint32 extent;
+	guint32 dir_size;
+
+	guint32 joliet_extent;
+	guint32 joliet_dir_size;
+
+	/* numbers in the path tables */
+	guint16 number;
+	guint16 joliet_number;
+
+	/* Rock Ridge names too long to fit in the directory record */
+	guint32 ce_block;
+	guint16 ce_offset;
+	guint16 ce_len;
+
+	/* for directories, blocks holding the continuation areas of children */
+	guint16 ce_blocks;
+
+	guint is_dir:1;
+	guint grafted:1;
+	guint scan:1;
+
+	/* size, date and mode are read from disc when the records are written */
+	guint stat:1;
+};
+
+struct _BraseroIsoImage {
+	BraseroIsoNode *root;
+
+	BraseroImageFS fs;
+	gchar *label;
+	time_t now;
+
+	GHashTable *excluded;
+	/* directories being scanned, to detect symlink loops */
+	GHashTable *visited;
+
+	/* in path table order */
+	GPtrArray *dirs;
+	GPtrArray *joliet_dirs;
+
+	/* in the order their data is written */
+	GPtrArray *files;
+
+	/* files with the same contents as another file share its data */
+	BraseroDedup *dedup;
+	GHashTable *originals;
+
+	guint32 path_table_size;
+	guint32 path_table_l;
+	guint32 path_table_m;
+
+	guint32 joliet_path_table_size;
+	guint32 joliet_path_table_l;
+	guint32 joliet_path_table_m;
+
+	guint32 er_block;
+	guint16 er_offset;
+
+	guint32 blocks;
+	guint64 file_num;
+
+	/* used while writing */
+	guchar *buffer;
+	gsize buffer_len;
+	guint64 position;
+	BraseroIsoImageWriteFunc func;
+	gpointer user_data;
+
+	volatile gint cancel;
+};
+
+/**
+ * Helpers to write the numerical values of ECMA-119 (section 7)
+ */
+
+static void
+brasero_iso_image_set_721 (guchar *buffer, guint16 value)
+{
+	buffer [0] = value & 0xFF;
+	buffer [1] = (value >> 8) & 0xFF;
+}
+
+static void
+brasero_iso_image_set_722 (guchar *buffer, guint16 value)
+{
+	buffer [0] = (value >> 8) & 0xFF;
+	buffer [1] = value & 0xFF;
+}
+
+static void
+brasero_iso_image_set_723 (guchar *buffer, guint16 value)
+{
+	brasero_iso_image_set_721 (buffer, value);
+	brasero_iso_image_set_722 (buffer + 2, value);
+}
+
+static void
+brasero_iso_image_set_731 (guchar *buffer, guint32 value)
+{
+	buffer [0] = value & 0xFF;
+	buffer [1] = (value >> 8) & 0xFF;
+	buffer [2] = (value >> 16) & 0xFF;
+	buffer [3] = (value >> 24) & 0xFF;
+}
+
+static void
+brasero_iso_image_set_732 (guchar *buffer, guint32 value)
+{
+	buffer [0] = (value >> 24) & 0xFF;
+	buffer [1] = (value >> 16) & 0xFF;
+	buffer [2] = (value >> 8) & 0xFF;
+	buffer [3] = value & 0xFF;
+}
+
+static void
+brasero_iso_image_set_733 (guchar *buffer, guint32 value)
+{
+	brasero_iso_image_set_731 (buffer, value);
+	brasero_iso_image_set_732 (buffer + 4, value);
+}
+
+static void
+brasero_iso_image_set_string (guchar *buffer,
+			      const gchar *string,
+			      gsize len)
+{
+	gsize string_len = 0;
+
+	if (string) {
+		const gchar *end;
+
+		/* don't cut a UTF-8 character in the middle */
+		string_len = strlen (string);
+		if (string_len > len) {
+			end = g_utf8_find_prev_char (string, string + len + 1);
+			string_len = end? end - string:len;
+		}
+
+		memcpy (buffer, string, string_len);
+	}
+
+	memset (buffer + string_len, ' ', len - string_len);
+}
+
+static void
+brasero_iso_image_set_joliet_string (guchar *buffer,
+				     const gchar *string,
+				     gsize len)
+{
+	gunichar2 *utf16 = NULL;
+	glong utf16_len = 0;
+	gsize i;
+
+	if (string)
+		utf16 = g_utf8_to_utf16 (string, -1, NULL, &utf16_len, NULL);
+
+	for (i = 0; i + 1 < len; i += 2) {
+		gunichar2 c = ' ';
+
+		if (i / 2 < utf16_len)
+			c = utf16 [i / 2];
+
+		brasero_iso_image_set_722 (buffer + i, c);
+	}
+
+	g_free (utf16);
+}
+
+static void
+brasero_iso_image_set_date (guchar *buffer, time_t date)
+{
+	struct tm tm;
+
+	/* dates are always recorded in GMT */
+	gmtime_r (&date, &tm);
+	buffer [0] = tm.tm_year;
+	buffer [1] = tm.tm_mon + 1;
+	buffer [2] = tm.tm_mday;
+	buffer [3] = tm.tm_hour;
+	buffer [4] = tm.tm_min;
+	buffer [5] = tm.tm_sec;
+	buffer [6] = 0;
+}
+
+static void
+brasero_iso_image_set_dec_date (guchar *buffer, time_t date)
+{
+	gchar string [17];
+	struct tm tm;
+
+	gmtime_r (&date, &tm);
+	g_snprintf (string, sizeof (string),
+		    "%04i%02i%02i%02i%02i%02i00",
+		    tm.tm_year + 1900,
+		    tm.tm_mon + 1,
+		    tm.tm_mday,
+		    tm.tm_hour,
+		    tm.tm_min,
+		    tm.tm_sec);
+	memcpy (buffer, string, 16);
+	buffer [16] = 0;
+}
+
+/**
+ * Tree
+ */
+
+static BraseroIsoNode *
+brasero_iso_image_node_new (BraseroIsoNode *parent,
+			    const gchar *name,
+			    gboolean is_dir)
+{
+	BraseroIsoNode *node;
+
+	node = g_new0 (BraseroIsoNode, 1);
+	node->name = g_strdup (name);
+	node->is_dir = is_dir;
+
+	if (is_dir)
+		node->names = g_hash_table_new (g_str_hash, g_str_equal);
+
+	if (parent) {
+		node->parent = parent;
+		parent->children = g_slist_prepend (parent->children, node);
+		g_hash_table_insert (parent->names, node->name, node);
+	}
+
+	return node;
+}
+
+static void
+brasero_iso_image_node_free (BraseroIsoNode *node)
+{
+	GSList *iter;
+
+	for (iter = node->children; iter; iter = iter->next)
+		brasero_iso_image_node_free (iter->data);
+
+	g_slist_free (node->children);
+
+	if (node->names)
+		g_hash_table_destroy (node->names);
+
+	g_free (node->iso_children);
+	g_free (node->joliet_children);
+	g_free (node->iso_name);
+	g_free (node->joliet_name);
+	g_free (node->name);
+	g_free (node->path);
+	g_free (node);
+}
+
+static void
+brasero_iso_image_node_remove (BraseroIsoNode *node)
+{
+	BraseroIsoNode *parent;
+
+	parent = node->parent;
+	parent->children = g_slist_remove (parent->children, node);
+	g_hash_table_remove (parent->names, node->name);
+	brasero_iso_image_node_free (node);
+}
+
+static void
+brasero_iso_image_node_set_info (BraseroIsoNode *node,
+				 const gchar *path,
+				 struct stat *info)
+{
+	g_free (node->path);
+	node->path = g_strdup (path);
+	node->mtime = info->st_mtime;
+	node->mode = info->st_mode;
+	node->stat = FALSE;
+
+	if (!node->is_dir) {
+		node->size = info->st_size;
+		node->blocks = ISO_ROUND_BLOCKS (MIN (node->size, ISO_FILE_SIZE_MAX + 1));
+	}
+	else
+		node->scan = TRUE;
+}
+
+static gboolean
+brasero_iso_image_check_file_size (BraseroIsoNode *node,
+				   GError **error)
+{
+	if (node->size <= ISO_FILE_SIZE_MAX && node->blocks <= ISO_FILE_BLOCKS_MAX)
+		return TRUE;
+
+	BRASERO_BURN_LOG ("%s is too large to be written", node->path);
+	g_set_error (error,
+		     BRASERO_BURN_ERROR,
+		     BRASERO_BURN_ERROR_FILE_INVALID,
+		     _("\"%s\" is 4 GiB or larger and cannot be written to this image"),
+		     node->path);
+	return FALSE;
+}
+
+/**
+ * Gets the size, date and mode of a node given without them. Its data
+ * must still fit in the blocks it was given when the volume was laid out.
+ */
+
+static gboolean
+brasero_iso_image_node_stat (BraseroIsoNode *node,
+			     GError **error)
+{
+	struct stat info;
+
+	if (!node->stat)
+		return TRUE;
+
+	node->stat = FALSE;
+	if (g_stat (node->path, &info) == -1) {
+		int errsv = errno;
+
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_FILE_NOT_FOUND,
+			     "%s (%s)",
+			     node->path,
+			     g_strerror (errsv));
+		return FALSE;
+	}
+
+	node->mtime = info.st_mtime;
+	node->mode = info.st_mode;
+	if (node->is_dir)
+		return TRUE;
+
+	node->size = info.st_size;
+	if (!brasero_iso_image_check_file_size (node, error))
+		return FALSE;
+
+	if (ISO_ROUND_BLOCKS (node->size) > node->blocks) {
+		BRASERO_BURN_LOG ("%s grew since it was added", node->path);
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_FILE_INVALID,
+			     _("\"%s\" was modified while the image was being created"),
+			     node->path);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BraseroIsoImage *
+brasero_iso_image_new (BraseroImageFS fs,
+		       const gchar *label)
+{
+	BraseroIsoImage *image;
+
+	image = g_new0 (BraseroIsoImage, 1);
+	image->fs = fs;
+	image->label = g_strdup (label);
+	image->now = time (NULL);
+
+	image->root = brasero_iso_image_node_new (NULL, "", TRUE);
+	image->root->mtime = image->now;
+
+	image->excluded = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	image->visited = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	return image;
+}
+
+void
+brasero_iso_image_free (BraseroIsoImage *image)
+{
+	if (image->dirs)
+		g_ptr_array_free (image->dirs, TRUE);
+	if (image->joliet_dirs)
+		g_ptr_array_free (image->joliet_dirs, TRUE);
+	if (image->files)
+		g_ptr_array_free (image->files, TRUE);
+
+	brasero_iso_image_node_free (image->root);
+	g_hash_table_destroy (image->excluded);
+	g_hash_table_destroy (image->visited);
+	if (image->dedup)
+		brasero_dedup_free (image->dedup);
+	if (image->originals)
+		g_hash_table_destroy (image->originals);
+	g_free (image->buffer);
+	g_free (image->label);
+	g_free (image);
+}
+
+void
+brasero_iso_image_cancel (BraseroIsoImage *image)
+{
+	g_atomic_int_set (&image->cancel, 1);
+	if (image->dedup)
+		brasero_dedup_cancel (image->dedup);
+}
+
+void
+brasero_iso_image_share_duplicates (BraseroIsoImage *image)
+{
+	if (!image->dedup)
+		image->dedup = brasero_dedup_new ();
+}
+
+static gboolean
+brasero_iso_image_is_cancelled (BraseroIsoImage *image)
+{
+	return g_atomic_int_get (&image->cancel) != 0;
+}
+
+static BraseroBurnResult
+brasero_iso_image_scan (BraseroIsoImage *image,
+			BraseroIsoNode *node,
+			GError **error);
+
+static BraseroBurnResult
+brasero_iso_image_scan_directory (BraseroIsoImage *image,
+				  BraseroIsoNode *node,
+				  GError **error)
+{
+	const gchar *entry;
+	struct stat info;
+	GSList *iter;
+	gchar *key;
+	GDir *dir;
+
+	node->scan = FALSE;
+
+	/* Avoid looping forever with symlinks pointing to a parent */
+	if (g_stat (node->path, &info) == -1)
+		return BRASERO_BURN_OK;
+
+	key = g_strdup_printf ("%lu:%lu", (gulong) info.st_dev, (gulong) info.st_ino);
+	if (g_hash_table_lookup (image->visited, key)) {
+		BRASERO_BURN_LOG ("Directory %s is one of its parents", node->path);
+		g_free (key);
+		return BRASERO_BURN_OK;
+	}
+
+	dir = g_dir_open (node->path, 0, error);
+	if (!dir) {
+		g_free (key);
+		return BRASERO_BURN_ERR;
+	}
+
+	g_hash_table_insert (image->visited, key, GINT_TO_POINTER (1));
+
+	while ((entry = g_dir_read_name (dir))) {
+		BraseroIsoNode *child;
+		gchar *path;
+		gchar *name;
+
+		if (brasero_iso_image_is_cancelled (image)) {
+			g_hash_table_remove (image->visited, key);
+			g_dir_close (dir);
+			return BRASERO_BURN_CANCEL;
+		}
+
+		path = g_build_filename (node->path, entry, NULL);
+		if (g_hash_table_lookup (image->excluded, path)) {
+			g_free (path);
+			continue;
+		}
+
+		name = g_filename_to_utf8 (entry, -1, NULL, NULL, NULL);
+		if (!name)
+			name = g_filename_display_name (entry);
+
+		if (g_stat (path, &info) == -1) {
+			BRASERO_BURN_LOG ("Ignoring %s (%s)", path, g_strerror (errno));
+			g_free (name);
+			g_free (path);
+			continue;
+		}
+
+		child = g_hash_table_lookup (node->names, name);
+		if (child) {
+			/* Grafts take precedence over what is on disc. The only
+			 * exception are the directories created to hold grafts
+			 * which get the contents of the directory on disc. */
+			if (!child->grafted && !child->path && child->is_dir && S_ISDIR (info.st_mode))
+				brasero_iso_image_node_set_info (child, path, &info);
+		}
+		else if (S_ISDIR (info.st_mode)) {
+			child = brasero_iso_image_node_new (node, name, TRUE);
+			brasero_iso_image_node_set_info (child, path, &info);
+		}
+		else if (S_ISREG (info.st_mode)) {
+			child = brasero_iso_image_node_new (node, name, FALSE);
+			brasero_iso_image_node_set_info (child, path, &info);
+		}
+
+		g_free (name);
+		g_free (path);
+	}
+	g_dir_close (dir);
+
+	for (iter = node->children; iter; iter = iter->next) {
+		BraseroBurnResult result;
+		BraseroIsoNode *child;
+
+		child = iter->data;
+		if (!child->is_dir)
+			continue;
+
+		result = brasero_iso_image_scan (image, child, error);
+		if (result != BRASERO_BURN_OK) {
+			g_hash_table_remove (image->visited, key);
+			return result;
+		}
+	}
+
+	g_hash_table_remove (image->visited, key);
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_iso_image_scan (BraseroIsoImage *image,
+			BraseroIsoNode *node,
+			GError **error)
+{
+	GSList *iter;
+
+	if (node->scan)
+		return brasero_iso_image_scan_directory (image, node, error);
+
+	/* Look for grafted directories below */
+	for (iter = node->children; iter; iter = iter->next) {
+		BraseroBurnResult result;
+		BraseroIsoNode *child;
+
+		child = iter->data;
+		if (!child->is_dir)
+			continue;
+
+		result = brasero_iso_image_scan (image, child, error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static gint
+brasero_iso_image_sort_grafts (gconstpointer a, gconstpointer b)
+{
+	const BraseroGraftPt *graft_a = a;
+	const BraseroGraftPt *graft_b = b;
+
+	/* parents first */
+	return strlen (graft_a->path) - strlen (graft_b->path);
+}
+
+static BraseroBurnResult
+brasero_iso_image_add_graft (BraseroIsoImage *image,
+			     BraseroGraftPt *graft,
+			     GError **error)
+{
+	BraseroIsoNode *parent;
+	BraseroIsoNode *node;
+	struct stat info;
+	gchar **names;
+	gchar *path = NULL;
+	guint i, num;
+
+	names = g_strsplit (graft->path, G_DIR_SEPARATOR_S, -1);
+	num = g_strv_length (names);
+	while (num && !names [num - 1][0])
+		num --;
+
+	if (!num) {
+		g_strfreev (names);
+		return BRASERO_BURN_OK;
+	}
+
+	if (graft->uri) {
+		path = g_filename_from_uri (graft->uri, NULL, NULL);
+		if (!path) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_FILE_NOT_LOCAL,
+				     _("The file is not stored locally"));
+			g_strfreev (names);
+			return BRASERO_BURN_ERR;
+		}
+
+		if (g_stat (path, &info) == -1) {
+			int errsv = errno;
+
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_FILE_NOT_FOUND,
+				     "%s (%s)",
+				     path,
+				     g_strerror (errsv));
+			g_free (path);
+			g_strfreev (names);
+			return BRASERO_BURN_ERR;
+		}
+	}
+
+	/* Create the directories leading to the graft if need be */
+	parent = image->root;
+	for (i = 0; i < num - 1; i ++) {
+		if (!names [i][0])
+			continue;
+
+		node = g_hash_table_lookup (parent->names, names [i]);
+		if (node && !node->is_dir) {
+			brasero_iso_image_node_remove (node);
+			node = NULL;
+		}
+
+		if (!node) {
+			node = brasero_iso_image_node_new (parent, names [i], TRUE);
+			node->mtime = image->now;
+		}
+
+		parent = node;
+	}
+
+	node = g_hash_table_lookup (parent->names, names [num - 1]);
+	if (node && (!node->is_dir || (path && !S_ISDIR (info.st_mode)))) {
+		brasero_iso_image_node_remove (node);
+		node = NULL;
+	}
+
+	if (!path) {
+		/* empty directory */
+		if (!node) {
+			node = brasero_iso_image_node_new (parent, names [num - 1], TRUE);
+			node->mtime = image->now;
+		}
+	}
+	else if (S_ISDIR (info.st_mode) || S_ISREG (info.st_mode)) {
+		if (!node)
+			node = brasero_iso_image_node_new (parent, names [num - 1], S_ISDIR (info.st_mode));
+
+		brasero_iso_image_node_set_info (node, path, &info);
+	}
+	else
+		BRASERO_BURN_LOG ("Ignoring graft %s (not a regular file)", path);
+
+	if (node)
+		node->grafted = TRUE;
+
+	g_free (path);
+	g_strfreev (names);
+	return BRASERO_BURN_OK;
+}
+
+BraseroBurnResult
+brasero_iso_image_add_grafts (BraseroIsoImage *image,
+			      GSList *grafts,
+			      GSList *excluded,
+			      GError **error)
+{
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	GSList *iter;
+
+	for (iter = excluded; iter; iter = iter->next) {
+		gchar *path;
+
+		path = g_filename_from_uri (iter->data, NULL, NULL);
+		if (path)
+			g_hash_table_insert (image->excluded, path, GINT_TO_POINTER (1));
+	}
+
+	grafts = g_slist_sort (g_slist_copy (grafts), brasero_iso_image_sort_grafts);
+	for (iter = grafts; iter; iter = iter->next) {
+		if (brasero_iso_image_is_cancelled (image)) {
+			result = BRASERO_BURN_CANCEL;
+			break;
+		}
+
+		result = brasero_iso_image_add_graft (image, iter->data, error);
+		if (result != BRASERO_BURN_OK)
+			break;
+	}
+	g_slist_free (grafts);
+
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	/* Now that all grafts are in place, add the contents of directories */
+	return brasero_iso_image_scan (image, image->root, error);
+}
+
+BraseroIsoNode *
+brasero_iso_image_get_root (BraseroIsoImage *image)
+{
+	return image->root;
+}
+
+static BraseroIsoNode *
+brasero_iso_image_add_node (BraseroIsoImage *image,
+			    BraseroIsoNode *parent,
+			    const gchar *name,
+			    const gchar *path,
+			    gboolean is_dir)
+{
+	BraseroIsoNode *node;
+
+	node = g_hash_table_lookup (parent->names, name);
+	if (node)
+		brasero_iso_image_node_remove (node);
+
+	node = brasero_iso_image_node_new (parent, name, is_dir);
+	node->grafted = TRUE;
+	if (path) {
+		node->path = g_strdup (path);
+		node->stat = TRUE;
+	}
+	else
+		node->mtime = image->now;
+
+	return node;
+}
+
+/**
+ * Unlike grafts, directories added this way are not explored and the files
+ * are not looked up on disc before their records are written.
+ * path is NULL for directories that only exist in the image.
+ */
+
+BraseroIsoNode *
+brasero_iso_image_add_directory (BraseroIsoImage *image,
+				 BraseroIsoNode *parent,
+				 const gchar *name,
+				 const gchar *path)
+{
+	return brasero_iso_image_add_node (image, parent, name, path, TRUE);
+}
+
+void
+brasero_iso_image_add_file (BraseroIsoImage *image,
+			    BraseroIsoNode *parent,
+			    const gchar *name,
+			    const gchar *path,
+			    guint32 blocks)
+{
+	BraseroIsoNode *node;
+
+	node = brasero_iso_image_add_node (image, parent, name, path, FALSE);
+	node->blocks = blocks;
+}
+
+/**
+ * Names
+ */
+
+static gchar *
+brasero_iso_image_iso_name (BraseroIsoNode *node,
+			    guint counter)
+{
+	const gchar *name, *dot = NULL;
+	GString *base, *ext;
+	gchar *suffix = NULL;
+	guint base_max;
+	gchar *retval;
+
+	base = g_string_new (NULL);
+	ext = g_string_new (NULL);
+
+	name = node->name;
+	if (!node->is_dir) {
+		dot = strrchr (name, '.');
+		if (dot == name)
+			dot = NULL;
+	}
+
+	/* Only d-characters; every non ASCII character becomes one '_' */
+	while (*name) {
+		GString *string;
+		gchar c;
+
+		if (name == dot) {
+			name ++;
+			continue;
+		}
+
+		string = (dot && name > dot)? ext:base;
+		c = *name;
+		if (g_ascii_isalnum (c))
+			g_string_append_c (string, g_ascii_toupper (c));
+		else
+			g_string_append_c (string, '_');
+
+		name = g_utf8_next_char (name);
+	}
+
+	if (ext->len > ISO_EXT_MAX)
+		g_string_truncate (ext, ISO_EXT_MAX);
+
+	if (counter)
+		suffix = g_strdup_printf ("%u", counter);
+
+	if (node->is_dir)
+		base_max = ISO_DIR_NAME_MAX;
+	else
+		base_max = ISO_FILE_NAME_MAX - ext->len - 1;
+
+	if (suffix) {
+		base_max -= strlen (suffix);
+		if (base->len > base_max)
+			g_string_truncate (base, base_max);
+
+		g_string_append (base, suffix);
+		g_free (suffix);
+	}
+	else if (base->len > base_max)
+		g_string_truncate (base, base_max);
+
+	if (!node->is_dir)
+		retval = g_strdup_printf ("%s.%s;1", base->str, ext->str);
+	else if (!base->len)
+		retval = g_strdup ("_");
+	else
+		retval = g_strdup (base->str);
+
+	g_string_free (base, TRUE);
+	g_string_free (ext, TRUE);
+	return retval;
+}
+
+static guchar *
+brasero_iso_image_joliet_name (BraseroIsoNode *node,
+			       guint counter,
+			       guint *bytes)
+{
+	gunichar2 *utf16;
+	gunichar2 *name;
+	glong utf16_len = 0;
+	glong ext_len = 0;
+	glong len, max, i;
+	guchar *retval;
+	gchar *suffix;
+
+	utf16 = g_utf8_to_utf16 (node->name, -1, NULL, &utf16_len, NULL);
+	if (!utf16) {
+		utf16 = g_new0 (gunichar2, 1);
+		utf16_len = 0;
+	}
+
+	for (i = 0; i < utf16_len; i ++) {
+		if (utf16 [i] < 0x20
+		||  utf16 [i] == '*'
+		||  utf16 [i] == '/'
+		||  utf16 [i] == ':'
+		||  utf16 [i] == ';'
+		||  utf16 [i] == '?'
+		||  utf16 [i] == '\\')
+			utf16 [i] = '_';
+	}
+
+	/* Keep the extension of files when the name must be shortened */
+	if (!node->is_dir) {
+		for (i = utf16_len - 1; i > 0 && utf16_len - i <= ISO_EXT_MAX + 1; i --) {
+			if (utf16 [i] == '.') {
+				ext_len = utf16_len - i;
+				break;
+			}
+		}
+	}
+
+	suffix = counter? g_strdup_printf ("%u", counter):g_strdup ("");
+
+	name = g_new0 (gunichar2, JOLIET_NAME_MAX + 2);
+	max = JOLIET_NAME_MAX - ext_len - strlen (suffix);
+	len = MIN (utf16_len - ext_len, max);
+
+	/* don't split surrogate pairs */
+	if (len > 0 && len < utf16_len - ext_len && (utf16 [len - 1] & 0xFC00) == 0xD800)
+		len --;
+
+	memcpy (name, utf16, len * sizeof (gunichar2));
+	for (i = 0; suffix [i]; i ++)
+		name [len ++] = suffix [i];
+
+	memcpy (name + len, utf16 + utf16_len - ext_len, ext_len * sizeof (gunichar2));
+	len += ext_len;
+
+	if (!node->is_dir) {
+		name [len ++] = ';';
+		name [len ++] = '1';
+	}
+
+	/* Joliet names are big endian */
+	retval = g_new (guchar, len * 2);
+	for (i = 0; i < len; i ++)
+		brasero_iso_image_set_722 (retval + i * 2, name [i]);
+
+	*bytes = len * 2;
+
+	g_free (suffix);
+	g_free (name);
+	g_free (utf16);
+	return retval;
+}
+
+static gint
+brasero_iso_image_compare_iso (gconstpointer a, gconstpointer b)
+{
+	const BraseroIsoNode *node_a = *(BraseroIsoNode **) a;
+	const BraseroIsoNode *node_b = *(BraseroIsoNode **) b;
+
+	return strcmp (node_a->iso_name, node_b->iso_name);
+}
+
+static gint
+brasero_iso_image_compare_joliet (gconstpointer a, gconstpointer b)
+{
+	const BraseroIsoNode *node_a = *(BraseroIsoNode **) a;
+	const BraseroIsoNode *node_b = *(BraseroIsoNode **) b;
+	gint retval;
+
+	retval = memcmp (node_a->joliet_name,
+			 node_b->joliet_name,
+			 MIN (node_a->joliet_len, node_b->joliet_len));
+	if (retval)
+		return retval;
+
+	return (gint) node_a->joliet_len - (gint) node_b->joliet_len;
+}
+
+static guint
+brasero_iso_image_joliet_hash (gconstpointer key)
+{
+	const BraseroIsoNode *node = key;
+	guint hash = 5381;
+	guint i;
+
+	for (i = 0; i < node->joliet_len; i ++)
+		hash = (hash << 5) + hash + node->joliet_name [i];
+
+	return hash;
+}
+
+static gboolean
+brasero_iso_image_joliet_equal (gconstpointer a, gconstpointer b)
+{
+	const BraseroIsoNode *node_a = a;
+	const BraseroIsoNode *node_b = b;
+
+	return node_a->joliet_len == node_b->joliet_len
+	    && !memcmp (node_a->joliet_name, node_b->joliet_name, node_a->joliet_len);
+}
+
+static void
+brasero_iso_image_set_children_names (BraseroIsoImage *image,
+				      BraseroIsoNode *node)
+{
+	GHashTable *joliet_names = NULL;
+	GHashTable *iso_names;
+	GSList *iter;
+	guint i;
+
+	node->children_num = g_slist_length (node->children);
+	node->iso_children = g_new (BraseroIsoNode *, node->children_num + 1);
+
+	iso_names = g_hash_table_new (g_str_hash, g_str_equal);
+	if (image->fs & BRASERO_IMAGE_FS_JOLIET) {
+		node->joliet_children = g_new (BraseroIsoNode *, node->children_num + 1);
+		joliet_names = g_hash_table_new (brasero_iso_image_joliet_hash,
+						 brasero_iso_image_joliet_equal);
+	}
+
+	for (i = 0, iter = node->children; iter; iter = iter->next, i ++) {
+		BraseroIsoNode *child;
+		guint counter;
+
+		child = iter->data;
+		node->iso_children [i] = child;
+		if (child->is_dir)
+			node->subdirs_num ++;
+
+		/* Mangled names must be unique in a directory */
+		child->iso_name = brasero_iso_image_iso_name (child, 0);
+		for (counter = 1; g_hash_table_lookup (iso_names, child->iso_name); counter ++) {
+			g_free (child->iso_name);
+			child->iso_name = brasero_iso_image_iso_name (child, counter);
+		}
+		g_hash_table_insert (iso_names, child->iso_name, child);
+
+		if (!joliet_names)
+			continue;
+
+		node->joliet_children [i] = child;
+		child->joliet_name = brasero_iso_image_joliet_name (child, 0, &child->joliet_len);
+		for (counter = 1; g_hash_table_lookup (joliet_names, child); counter ++) {
+			g_free (child->joliet_name);
+			child->joliet_name = brasero_iso_image_joliet_name (child, counter, &child->joliet_len);
+		}
+		g_hash_table_insert (joliet_names, child, child);
+	}
+
+	g_hash_table_destroy (iso_names);
+	qsort (node->iso_children,
+	       node->children_num,
+	       sizeof (BraseroIsoNode *),
+	       brasero_iso_image_compare_iso);
+
+	if (joliet_names) {
+		g_hash_table_destroy (joliet_names);
+		qsort (node->joliet_children,
+		       node->children_num,
+		       sizeof (BraseroIsoNode *),
+		       brasero_iso_image_compare_joliet);
+	}
+
+	/* not needed any more */
+	if (node->names) {
+		g_hash_table_destroy (node->names);
+		node->names = NULL;
+	}
+}
+
+static void
+brasero_iso_image_set_names (BraseroIsoImage *image,
+			     BraseroIsoNode *node)
+{
+	guint i;
+
+	brasero_iso_image_set_children_names (image, node);
+	for (i = 0; i < node->children_num; i ++) {
+		if (node->iso_children [i]->is_dir)
+			brasero_iso_image_set_names (image, node->iso_children [i]);
+	}
+}
+
+/**
+ * Records
+ */
+
+static guint
+brasero_iso_image_rr_name_len (BraseroIsoNode *node)
+{
+	const gchar *end;
+	guint len;
+
+	len = strlen (node->name);
+	if (len <= RR_NAME_MAX)
+		return len;
+
+	end = g_utf8_find_prev_char (node->name, node->name + RR_NAME_MAX + 1);
+	return end? end - node->name:RR_NAME_MAX;
+}
+
+/* The NM entries (split in several entries when the name is long) */
+static guint
+brasero_iso_image_rr_nm (BraseroIsoNode *node,
+			 guchar *buffer)
+{
+	guint written = 0;
+	guint name_len;
+	guint done = 0;
+
+	name_len = brasero_iso_image_rr_name_len (node);
+	do {
+		guint chunk;
+
+		chunk = MIN (name_len - done, RR_NM_CHUNK);
+		if (buffer) {
+			guchar *entry = buffer + written;
+
+			entry [0] = 'N';
+			entry [1] = 'M';
+			entry [2] = 5 + chunk;
+			entry [3] = 1;
+			entry [4] = (done + chunk < name_len)? 0x01:0x00;
+			memcpy (entry + 5, node->name + done, chunk);
+		}
+
+		written += 5 + chunk;
+		done += chunk;
+	} while (done < name_len);
+
+	return written;
+}
+
+static void
+brasero_iso_image_rr_px_tf (BraseroIsoImage *image,
+			    BraseroIsoNode *node,
+			    guchar *buffer)
+{
+	guint32 mode;
+	guint32 links;
+
+	/* Like mkisofs -r: files are owned by root and readable by all */
+	if (node->is_dir) {
+		mode = S_IFDIR|0555;
+		links = 2 + node->subdirs_num;
+	}
+	else {
+		mode = S_IFREG|0444;
+		if (node->mode & 0111)
+			mode |= 0111;
+		links = 1;
+	}
+
+	buffer [0] = 'P';
+	buffer [1] = 'X';
+	buffer [2] = RR_PX_LEN;
+	buffer [3] = 1;
+	brasero_iso_image_set_733 (buffer + 4, mode);
+	brasero_iso_image_set_733 (buffer + 12, links);
+	brasero_iso_image_set_733 (buffer + 20, 0);
+	brasero_iso_image_set_733 (buffer + 28, 0);
+
+	buffer += RR_PX_LEN;
+	buffer [0] = 'T';
+	buffer [1] = 'F';
+	buffer [2] = RR_TF_LEN;
+	buffer [3] = 1;
+	buffer [4] = 0x02;	/* modification time */
+	brasero_iso_image_set_date (buffer + 5, node->mtime? node->mtime:image->now);
+}
+
+static void
+brasero_iso_image_rr_ce (guchar *buffer,
+			 guint32 block,
+			 guint32 offset,
+			 guint32 len)
+{
+	buffer [0] = 'C';
+	buffer [1] = 'E';
+	buffer [2] = SUSP_CE_LEN;
+	buffer [3] = 1;
+	brasero_iso_image_set_733 (buffer + 4, block);
+	brasero_iso_image_set_733 (buffer + 12, offset);
+	brasero_iso_image_set_733 (buffer + 20, len);
+}
+
+static void
+brasero_iso_image_record_base (guchar *buffer,
+			       guint len,
+			       guint32 extent,
+			       guint32 size,
+			       time_t date,
+			       gboolean is_dir,
+			       const guchar *id,
+			       guint id_len)
+{
+	memset (buffer, 0, len);
+	buffer [0] = len;
+	brasero_iso_image_set_733 (buffer + 2, extent);
+	brasero_iso_image_set_733 (buffer + 10, size);
+	brasero_iso_image_set_date (buffer + 18, date);
+	buffer [25] = is_dir? 0x02:0x00;
+	brasero_iso_image_set_723 (buffer + 28, 1);
+	buffer [32] = id_len;
+	memcpy (buffer + 33, id, id_len);
+}
+
+/* Returns the length of the record; writes it if buffer is not NULL */
+static guint
+brasero_iso_image_record (BraseroIsoImage *image,
+			  BraseroIsoNode *node,
+			  BraseroIsoRecordType type,
+			  gboolean joliet,
+			  guchar *buffer)
+{
+	static const guchar self_id = 0;
+	static const guchar parent_id = 1;
+	const guchar *id;
+	guint id_len;
+	guint32 extent;
+	guint32 size;
+	guint len, su;
+
+	if (type == ISO_RECORD_SELF) {
+		id = &self_id;
+		id_len = 1;
+	}
+	else if (type == ISO_RECORD_PARENT) {
+		id = &parent_id;
+		id_len = 1;
+	}
+	else if (joliet) {
+		id = node->joliet_name;
+		id_len = node->joliet_len;
+	}
+	else {
+		id = (guchar *) node->iso_name;
+		id_len = strlen (node->iso_name);
+	}
+
+	len = ISO_RECORD_BASE + id_len;
+	if (len & 1)
+		len ++;
+
+	/* System Use area with Rock Ridge entries */
+	su = 0;
+	if (!joliet) {
+		su = RR_PX_LEN + RR_TF_LEN;
+		if (type == ISO_RECORD_SELF && node == image->root)
+			su += RR_SP_LEN + SUSP_CE_LEN;
+		else if (type == ISO_RECORD_CHILD) {
+			guint nm;
+
+			nm = brasero_iso_image_rr_nm (node, NULL);
+			if (len + su + nm > ISO_RECORD_MAX) {
+				/* goes into a continuation area */
+				su += SUSP_CE_LEN;
+				if (!buffer)
+					node->ce_len = nm;
+			}
+			else {
+				su += nm;
+				if (!buffer)
+					node->ce_len = 0;
+			}
+		}
+	}
+
+	if ((len + su) & 1)
+		su ++;
+
+	if (!buffer)
+		return len + su;
+
+	if (node->is_dir) {
+		extent = joliet? node->joliet_extent:node->extent;
+		size = joliet? node->joliet_dir_size:node->dir_size;
+	}
+	else {
+		extent = node->extent;
+		size = node->size;
+	}
+
+	brasero_iso_image_record_base (buffer,
+				       len + su,
+				       extent,
+				       size,
+				       node->mtime? node->mtime:image->now,
+				       node->is_dir,
+				       id,
+				       id_len);
+	if (joliet)
+		return len + su;
+
+	buffer += len;
+	if (type == ISO_RECORD_SELF && node == image->root) {
+		buffer [0] = 'S';
+		buffer [1] = 'P';
+		buffer [2] = RR_SP_LEN;
+		buffer [3] = 1;
+		buffer [4] = 0xBE;
+		buffer [5] = 0xEF;
+		buffer [6] = 0;
+		buffer += RR_SP_LEN;
+	}
+
+	brasero_iso_image_rr_px_tf (image, node, buffer);
+	buffer += RR_PX_LEN + RR_TF_LEN;
+
+	if (type == ISO_RECORD_SELF && node == image->root)
+		brasero_iso_image_rr_ce (buffer,
+					 image->er_block,
+					 image->er_offset,
+					 RR_ER_LEN);
+	else if (type == ISO_RECORD_CHILD) {
+		if (node->ce_len)
+			brasero_iso_image_rr_ce (buffer,
+						 node->ce_block,
+						 node->ce_offset,
+						 node->ce_len);
+		else
+			brasero_iso_image_rr_nm (node, buffer);
+	}
+
+	return len + su;
+}
+
+/* Returns the size of the directory records; writes them if buffer is
+ * not NULL. Records never cross a block boundary. */
+static guint32
+brasero_iso_image_directory (BraseroIsoImage *image,
+			     BraseroIsoNode *node,
+			     gboolean joliet,
+			     guchar *buffer)
+{
+	BraseroIsoNode **children;
+	guint32 offset = 0;
+	guint i;
+
+	children = joliet? node->joliet_children:node->iso_children;
+	for (i = 0; i < node->children_num + 2; i ++) {
+		BraseroIsoRecordType type;
+		BraseroIsoNode *record;
+		guint len;
+
+		if (i == 0) {
+			type = ISO_RECORD_SELF;
+			record = node;
+		}
+		else if (i == 1) {
+			type = ISO_RECORD_PARENT;
+			record = node->parent? node->parent:node;
+		}
+		else {
+			type = ISO_RECORD_CHILD;
+			record = children [i - 2];
+		}
+
+		len = brasero_iso_image_record (image, record, type, joliet, NULL);
+		if ((offset % ISO_BLOCK_SIZE) + len > ISO_BLOCK_SIZE)
+			offset = ISO_ROUND_BLOCKS (offset) * ISO_BLOCK_SIZE;
+
+		if (buffer)
+			brasero_iso_image_record (image, record, type, joliet, buffer + offset);
+
+		offset += len;
+	}
+
+	return ISO_ROUND_BLOCKS (offset) * ISO_BLOCK_SIZE;
+}
+
+/* Returns the size of the path table; writes it if buffer is not NULL */
+static guint32
+brasero_iso_image_path_table (BraseroIsoImage *image,
+			      gboolean joliet,
+			      gboolean msb,
+			      guchar *buffer)
+{
+	GPtrArray *dirs;
+	guint32 size = 0;
+	guint i;
+
+	dirs = joliet? image->joliet_dirs:image->dirs;
+	for (i = 0; i < dirs->len; i ++) {
+		BraseroIsoNode *node;
+		const guchar *id;
+		guint16 parent;
+		guint32 extent;
+		guint id_len;
+
+		node = g_ptr_array_index (dirs, i);
+		if (node == image->root) {
+			id = (guchar *) "";
+			id_len = 1;
+			parent = 1;
+		}
+		else if (joliet) {
+			id = node->joliet_name;
+			id_len = node->joliet_len;
+			parent = node->parent->joliet_number;
+		}
+		else {
+			id = (guchar *) node->iso_name;
+			id_len = strlen (node->iso_name);
+			parent = node->parent->number;
+		}
+
+		if (buffer) {
+			guchar *entry = buffer + size;
+
+			extent = joliet? node->joliet_extent:node->extent;
+			entry [0] = id_len;
+			entry [1] = 0;
+			if (msb) {
+				brasero_iso_image_set_732 (entry + 2, extent);
+				brasero_iso_image_set_722 (entry + 6, parent);
+			}
+			else {
+				brasero_iso_image_set_731 (entry + 2, extent);
+				brasero_iso_image_set_721 (entry + 6, parent);
+			}
+			memcpy (entry + 8, id, id_len);
+			if (id_len & 1)
+				entry [8 + id_len] = 0;
+		}
+
+		size += 8 + id_len + (id_len & 1);
+	}
+
+	return size;
+}
+
+/**
+ * Layout
+ */
+
+/* Like mkisofs, continuation areas come right after the records of their
+ * directory (some readers rely on that). The one of root starts with the
+ * ER entry. None can cross a block. Returns the number of blocks used. */
+static guint16
+brasero_iso_image_place_continuation (BraseroIsoImage *image,
+				      BraseroIsoNode *node,
+				      guint32 block)
+{
+	guint32 ce_offset = 0;
+	guint i;
+
+	if (node == image->root) {
+		image->er_block = block;
+		image->er_offset = 0;
+		ce_offset = RR_ER_LEN;
+	}
+
+	for (i = 0; i < node->children_num; i ++) {
+		BraseroIsoNode *child;
+
+		child = node->iso_children [i];
+		if (!child->ce_len)
+			continue;
+
+		if ((ce_offset % ISO_BLOCK_SIZE) + child->ce_len > ISO_BLOCK_SIZE)
+			ce_offset = ISO_ROUND_BLOCKS (ce_offset) * ISO_BLOCK_SIZE;
+
+		child->ce_block = block + ce_offset / ISO_BLOCK_SIZE;
+		child->ce_offset = ce_offset % ISO_BLOCK_SIZE;
+		ce_offset += child->ce_len;
+	}
+
+	return ISO_ROUND_BLOCKS (ce_offset);
+}
+
+static GPtrArray *
+brasero_iso_image_number_dirs (BraseroIsoImage *image,
+			       gboolean joliet)
+{
+	GPtrArray *dirs;
+	guint i;
+
+	/* Breadth first so that directories are sorted by level, then parent
+	 * number and name as required for the path tables */
+	dirs = g_ptr_array_new ();
+	g_ptr_array_add (dirs, image->root);
+	for (i = 0; i < dirs->len; i ++) {
+		BraseroIsoNode **children;
+		BraseroIsoNode *node;
+		guint j;
+
+		node = g_ptr_array_index (dirs, i);
+		if (joliet)
+			node->joliet_number = i + 1;
+		else
+			node->number = i + 1;
+
+		children = joliet? node->joliet_children:node->iso_children;
+		for (j = 0; j < node->children_num; j ++) {
+			if (children [j]->is_dir)
+				g_ptr_array_add (dirs, children [j]);
+		}
+	}
+
+	return dirs;
+}
+
+static gboolean
+brasero_iso_image_place_files (BraseroIsoImage *image,
+			       BraseroIsoNode *node,
+			       guint32 *block,
+			       GSList **shared,
+			       GError **error)
+{
+	guint i;
+
+	/* Files are written in the order of the tree which is close to the
+	 * order they have on the disc they are read from */
+	for (i = 0; i < node->children_num; i ++) {
+		BraseroIsoNode *child;
+
+		child = node->iso_children [i];
+		if (child->is_dir) {
+			if (!brasero_iso_image_place_files (image, child, block, shared, error))
+				return FALSE;
+
+			continue;
+		}
+
+		image->file_num ++;
+		if (!brasero_iso_image_check_file_size (child, error))
+			return FALSE;
+
+		if (!child->blocks)
+			continue;
+
+		/* A file grafted several times is also written only once */
+		if (image->dedup
+		&& (brasero_dedup_get_original (image->dedup, child->path)
+		||  g_hash_table_lookup (image->originals, child->path))) {
+			*shared = g_slist_prepend (*shared, child);
+			continue;
+		}
+
+		child->extent = *block;
+		*block += child->blocks;
+		g_ptr_array_add (image->files, child);
+
+		if (image->dedup)
+			g_hash_table_insert (image->originals, child->path, child);
+	}
+
+	return TRUE;
+}
+
+static void
+brasero_iso_image_collect_files (BraseroIsoImage *image,
+				 BraseroIsoNode *node)
+{
+	guint i;
+
+	for (i = 0; i < node->children_num; i ++) {
+		BraseroIsoNode *child;
+
+		child = node->iso_children [i];
+		if (child->is_dir)
+			brasero_iso_image_collect_files (image, child);
+		else if (child->blocks && child->path)
+			brasero_dedup_add (image->dedup, child->path);
+	}
+}
+
+/* Duplicates point to the data of the file they are identical to */
+static BraseroBurnResult
+brasero_iso_image_share_extents (BraseroIsoImage *image,
+				 GSList *shared)
+{
+	GSList *iter;
+
+	for (iter = shared; iter; iter = iter->next) {
+		BraseroIsoNode *original;
+		BraseroIsoNode *node;
+		const gchar *path;
+
+		node = iter->data;
+		path = brasero_dedup_get_original (image->dedup, node->path);
+		original = g_hash_table_lookup (image->originals, path? path:node->path);
+		if (!original)
+			return BRASERO_BURN_ERR;
+
+		node->extent = original->extent;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+BraseroBurnResult
+brasero_iso_image_layout (BraseroIsoImage *image,
+			  GError **error)
+{
+	GSList *shared = NULL;
+	guint32 block;
+	guint i;
+
+	brasero_iso_image_set_names (image, image->root);
+
+	image->dirs = brasero_iso_image_number_dirs (image, FALSE);
+	if (image->fs & BRASERO_IMAGE_FS_JOLIET)
+		image->joliet_dirs = brasero_iso_image_number_dirs (image, TRUE);
+
+	if (image->dirs->len > ISO_DIRS_MAX) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_IMAGE_INVALID,
+			     _("There are too many directories"));
+		return BRASERO_BURN_ERR;
+	}
+
+	if (brasero_iso_image_is_cancelled (image))
+		return BRASERO_BURN_CANCEL;
+
+	/* System area, then primary, Joliet and terminator descriptors */
+	block = ISO_SYSTEM_AREA_BLOCKS + 2;
+	if (image->joliet_dirs)
+		block ++;
+
+	image->path_table_size = brasero_iso_image_path_table (image, FALSE, FALSE, NULL);
+	image->path_table_l = block;
+	block += ISO_ROUND_BLOCKS (image->path_table_size);
+	image->path_table_m = block;
+	block += ISO_ROUND_BLOCKS (image->path_table_size);
+
+	if (image->joliet_dirs) {
+		image->joliet_path_table_size = brasero_iso_image_path_table (image, TRUE, FALSE, NULL);
+		image->joliet_path_table_l = block;
+		block += ISO_ROUND_BLOCKS (image->joliet_path_table_size);
+		image->joliet_path_table_m = block;
+		block += ISO_ROUND_BLOCKS (image->joliet_path_table_size);
+	}
+
+	/* Directory records; sizing them also tells which Rock Ridge names
+	 * need a continuation area */
+	for (i = 0; i < image->dirs->len; i ++) {
+		BraseroIsoNode *node;
+
+		node = g_ptr_array_index (image->dirs, i);
+		node->dir_size = brasero_iso_image_directory (image, node, FALSE, NULL);
+		node->extent = block;
+		block += node->dir_size / ISO_BLOCK_SIZE;
+
+		node->ce_blocks = brasero_iso_image_place_continuation (image, node, block);
+		block += node->ce_blocks;
+	}
+
+	if (image->joliet_dirs) {
+		for (i = 0; i < image->joliet_dirs->len; i ++) {
+			BraseroIsoNode *node;
+
+			node = g_ptr_array_index (image->joliet_dirs, i);
+			node->joliet_dir_size = brasero_iso_image_directory (image, node, TRUE, NULL);
+			node->joliet_extent = block;
+			block += node->joliet_dir_size / ISO_BLOCK_SIZE;
+		}
+	}
+
+	if (image->dedup) {
+		BraseroBurnResult result;
+
+		brasero_iso_image_collect_files (image, image->root);
+		result = brasero_dedup_run (image->dedup);
+		if (result != BRASERO_BURN_OK)
+			return result;
+
+		image->originals = g_hash_table_new (g_str_hash, g_str_equal);
+	}
+
+	image->files = g_ptr_array_new ();
+	if (!brasero_iso_image_place_files (image, image->root, &block, &shared, error)) {
+		g_slist_free (shared);
+		return BRASERO_BURN_ERR;
+	}
+
+	if (shared) {
+		BraseroBurnResult result;
+
+		result = brasero_iso_image_share_extents (image, shared);
+		g_slist_free (shared);
+
+		if (result != BRASERO_BURN_OK) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     "%s",
+				     _("An internal error occurred"));
+			return BRASERO_BURN_ERR;
+		}
+	}
+
+	image->blocks = block + ISO_PADDING_BLOCKS;
+
+	BRASERO_BURN_LOG ("ISO9660 image laid out: %u directories, %" G_GUINT64_FORMAT " files, %u blocks",
+			  image->dirs->len,
+			  image->file_num,
+			  image->blocks);
+	return BRASERO_BURN_OK;
+}
+
+/**
+ * Computes what the records of a directory would use in an image given the
+ * names of its children. The names are mangled, sorted and packed exactly as
+ * brasero_iso_image_layout () does, so that the size of a volume can be known
+ * without building it (see brasero_iso_image_get_volume_size ()).
+ */
+
+void
+brasero_iso_image_get_directory_size (const gchar **names,
+				      const gboolean *is_dir,
+				      guint num,
+				      gboolean is_root,
+				      BraseroIsoDirSize *size)
+{
+	BraseroIsoNode *children;
+	BraseroIsoImage image;
+	BraseroIsoNode node;
+	guint i;
+
+	memset (&image, 0, sizeof (BraseroIsoImage));
+	memset (&node, 0, sizeof (BraseroIsoNode));
+	memset (size, 0, sizeof (BraseroIsoDirSize));
+
+	image.fs = BRASERO_IMAGE_FS_ISO|BRASERO_IMAGE_FS_JOLIET;
+	if (is_root)
+		image.root = &node;
+
+	node.is_dir = TRUE;
+	children = g_new0 (BraseroIsoNode, num);
+	for (i = num; i > 0; i --) {
+		BraseroIsoNode *child;
+
+		child = children + i - 1;
+		child->parent = &node;
+		child->name = (gchar *) names [i - 1];
+		child->is_dir = is_dir [i - 1];
+		node.children = g_slist_prepend (node.children, child);
+	}
+
+	brasero_iso_image_set_children_names (&image, &node);
+
+	size->records = brasero_iso_image_directory (&image, &node, FALSE, NULL) / ISO_BLOCK_SIZE;
+	size->records += brasero_iso_image_place_continuation (&image, &node, 0);
+	size->joliet_records = brasero_iso_image_directory (&image, &node, TRUE, NULL) / ISO_BLOCK_SIZE;
+
+	/* The entry of root in the path tables has a one byte identifier */
+	if (is_root) {
+		size->path_table = 10;
+		size->joliet_path_table = 10;
+	}
+
+	for (i = 0; i < num; i ++) {
+		BraseroIsoNode *child;
+		guint id_len;
+
+		child = children + i;
+		if (child->is_dir) {
+			id_len = strlen (child->iso_name);
+			size->path_table += 8 + id_len + (id_len & 1);
+			size->joliet_path_table += 8 + child->joliet_len;
+		}
+
+		g_free (child->iso_name);
+		g_free (child->joliet_name);
+	}
+
+	g_free (node.iso_children);
+	g_free (node.joliet_children);
+	g_slist_free (node.children);
+	g_free (children);
+}
+
+goffset
+brasero_iso_image_get_volume_size (BraseroImageFS fs,
+				   guint64 records,
+				   guint64 joliet_records,
+				   guint64 path_table,
+				   guint64 joliet_path_table,
+				   goffset data_blocks)
+{
+	goffset blocks;
+
+	/* Same order as in brasero_iso_image_layout () */
+	blocks = ISO_SYSTEM_AREA_BLOCKS + 2;
+	blocks += ISO_ROUND_BLOCKS (path_table) * 2;
+	blocks += records;
+
+	if (fs & BRASERO_IMAGE_FS_JOLIET) {
+		blocks ++;
+		blocks += ISO_ROUND_BLOCKS (joliet_path_table) * 2;
+		blocks += joliet_records;
+	}
+
+	return blocks + data_blocks + ISO_PADDING_BLOCKS;
+}
+
+goffset
+brasero_iso_image_get_blocks (BraseroIsoImage *image)
+{
+	return image->blocks;
+}
+
+guint64
+brasero_iso_image_get_file_num (BraseroIsoImage *image)
+{
+	return image->file_num;
+}
+
+/**
+ * Output
+ */
+
+static gboolean
+brasero_iso_image_flush (BraseroIsoImage *image,
+			 GError **error)
+{
+	if (!image->buffer_len)
+		return TRUE;
+
+	if (!image->func (image->buffer, image->buffer_len, image->user_data, error))
+		return FALSE;
+
+	image->buffer_len = 0;
+	return TRUE;
+}
+
+static gboolean
+brasero_iso_image_output (BraseroIsoImage *image,
+			  const guchar *data,
+			  gsize len,
+			  GError **error)
+{
+	image->position += len;
+	while (len) {
+		gsize bytes;
+
+		bytes = MIN (len, ISO_WRITE_BUFFER_SIZE - image->buffer_len);
+		if (data)
+			memcpy (image->buffer + image->buffer_len, data, bytes);
+		else
+			memset (image->buffer + image->buffer_len, 0, bytes);
+
+		image->buffer_len += bytes;
+		len -= bytes;
+		if (data)
+			data += bytes;
+
+		if (image->buffer_len == ISO_WRITE_BUFFER_SIZE
+		&& !brasero_iso_image_flush (image, error))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_iso_image_check_position (BraseroIsoImage *image,
+				  guint32 block,
+				  GError **error)
+{
+	if (image->position == (guint64) block * ISO_BLOCK_SIZE)
+		return TRUE;
+
+	BRASERO_BURN_LOG ("Wrong position in image (%" G_GUINT64_FORMAT " instead of %u)",
+			  image->position / ISO_BLOCK_SIZE,
+			  block);
+	g_set_error (error,
+		     BRASERO_BURN_ERROR,
+		     BRASERO_BURN_ERROR_GENERAL,
+		     _("An internal error occurred"));
+	return FALSE;
+}
+
+static void
+brasero_iso_image_volume_descriptor (BraseroIsoImage *image,
+				     gboolean joliet,
+				     guchar *buffer)
+{
+	gchar *application;
+	guchar *root;
+
+	memset (buffer, 0, ISO_BLOCK_SIZE);
+	buffer [0] = joliet? 2:1;
+	memcpy (buffer + 1, "CD001", 5);
+	buffer [6] = 1;
+
+	application = g_strdup_printf ("BRASERO-%i.%i.%i",
+				       BRASERO_MAJOR_VERSION,
+				       BRASERO_MINOR_VERSION,
+				       BRASERO_SUB);
+
+	if (joliet) {
+		brasero_iso_image_set_joliet_string (buffer + 8, "LINUX", 32);
+		brasero_iso_image_set_joliet_string (buffer + 40, image->label, 32);
+
+		/* UCS-2 level 3 */
+		buffer [88] = '%';
+		buffer [89] = '/';
+		buffer [90] = 'E';
+
+		brasero_iso_image_set_joliet_string (buffer + 190, NULL, 128);
+		brasero_iso_image_set_joliet_string (buffer + 318, NULL, 128);
+		brasero_iso_image_set_joliet_string (buffer + 446, NULL, 128);
+		brasero_iso_image_set_joliet_string (buffer + 574, application, 128);
+		brasero_iso_image_set_joliet_string (buffer + 702, NULL, 37);
+		brasero_iso_image_set_joliet_string (buffer + 739, NULL, 37);
+		brasero_iso_image_set_joliet_string (buffer + 776, NULL, 37);
+	}
+	else {
+		brasero_iso_image_set_string (buffer + 8, "LINUX", 32);
+		brasero_iso_image_set_string (buffer + 40, image->label, 32);
+		brasero_iso_image_set_string (buffer + 190, NULL, 128);
+		brasero_iso_image_set_string (buffer + 318, NULL, 128);
+		brasero_iso_image_set_string (buffer + 446, NULL, 128);
+		brasero_iso_image_set_string (buffer + 574, application, 128);
+		brasero_iso_image_set_string (buffer + 702, NULL, 37);
+		brasero_iso_image_set_string (buffer + 739, NULL, 37);
+		brasero_iso_image_set_string (buffer + 776, NULL, 37);
+	}
+	g_free (application);
+
+	brasero_iso_image_set_733 (buffer + 80, image->blocks);
+	brasero_iso_image_set_723 (buffer + 120, 1);
+	brasero_iso_image_set_723 (buffer + 124, 1);
+	brasero_iso_image_set_723 (buffer + 128, ISO_BLOCK_SIZE);
+
+	if (joliet) {
+		brasero_iso_image_set_733 (buffer + 132, image->joliet_path_table_size);
+		brasero_iso_image_set_731 (buffer + 140, image->joliet_path_table_l);
+		brasero_iso_image_set_732 (buffer + 148, image->joliet_path_table_m);
+	}
+	else {
+		brasero_iso_image_set_733 (buffer + 132, image->path_table_size);
+		brasero_iso_image_set_731 (buffer + 140, image->path_table_l);
+		brasero_iso_image_set_732 (buffer + 148, image->path_table_m);
+	}
+
+	root = buffer + 156;
+	brasero_iso_image_record_base (root,
+				       34,
+				       joliet? image->root->joliet_extent:image->root->extent,
+				       joliet? image->root->joliet_dir_size:image->root->dir_size,
+				       image->now,
+				       TRUE,
+				       (guchar *) "",
+				       1);
+
+	brasero_iso_image_set_dec_date (buffer + 813, image->now);
+	brasero_iso_image_set_dec_date (buffer + 830, image->now);
+	memset (buffer + 847, '0', 16);
+	memset (buffer + 864, '0', 16);
+	buffer [881] = 1;
+}
+
+static BraseroBurnResult
+brasero_iso_image_write_descriptors (BraseroIsoImage *image,
+				     GError **error)
+{
+	guchar block [ISO_BLOCK_SIZE];
+
+	if (!brasero_iso_image_output (image, NULL, ISO_SYSTEM_AREA_BLOCKS * ISO_BLOCK_SIZE, error))
+		return BRASERO_BURN_ERR;
+
+	brasero_iso_image_volume_descriptor (image, FALSE, block);
+	if (!brasero_iso_image_output (image, block, ISO_BLOCK_SIZE, error))
+		return BRASERO_BURN_ERR;
+
+	if (image->joliet_dirs) {
+		brasero_iso_image_volume_descriptor (image, TRUE, block);
+		if (!brasero_iso_image_output (image, block, ISO_BLOCK_SIZE, error))
+			return BRASERO_BURN_ERR;
+	}
+
+	memset (block, 0, ISO_BLOCK_SIZE);
+	block [0] = 255;
+	memcpy (block + 1, "CD001", 5);
+	block [6] = 1;
+	if (!brasero_iso_image_output (image, block, ISO_BLOCK_SIZE, error))
+		return BRASERO_BURN_ERR;
+
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_iso_image_write_path_tables (BraseroIsoImage *image,
+				     gboolean joliet,
+				     GError **error)
+{
+	guint32 size;
+	guchar *table;
+	guint i;
+
+	size = joliet? image->joliet_path_table_size:image->path_table_size;
+	size = ISO_ROUND_BLOCKS (size) * ISO_BLOCK_SIZE;
+	table = g_malloc (size);
+
+	/* Little endian one then big endian one */
+	for (i = 0; i < 2; i ++) {
+		memset (table, 0, size);
+		brasero_iso_image_path_table (image, joliet, i == 1, table);
+		if (!brasero_iso_image_output (image, table, size, error)) {
+			g_free (table);
+			return BRASERO_BURN_ERR;
+		}
+	}
+
+	g_free (table);
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_iso_image_continuation_area (BraseroIsoImage *image,
+				     BraseroIsoNode *node,
+				     guchar *area)
+{
+	guint32 start;
+	guint i;
+
+	start = node->extent + node->dir_size / ISO_BLOCK_SIZE;
+	if (node == image->root) {
+		guchar *er;
+
+		er = area + (image->er_block - start) * ISO_BLOCK_SIZE + image->er_offset;
+		er [0] = 'E';
+		er [1] = 'R';
+		er [2] = RR_ER_LEN;
+		er [3] = 1;
+		er [4] = strlen (RR_ER_ID);
+		er [5] = strlen (RR_ER_DESC);
+		er [6] = strlen (RR_ER_SRC);
+		er [7] = 1;
+
+		er += 8;
+		memcpy (er, RR_ER_ID, strlen (RR_ER_ID));
+		er += strlen (RR_ER_ID);
+		memcpy (er, RR_ER_DESC, strlen (RR_ER_DESC));
+		er += strlen (RR_ER_DESC);
+		memcpy (er, RR_ER_SRC, strlen (RR_ER_SRC));
+	}
+
+	for (i = 0; i < node->children_num; i ++) {
+		BraseroIsoNode *child;
+
+		child = node->iso_children [i];
+		if (!child->ce_len)
+			continue;
+
+		brasero_iso_image_rr_nm (child,
+					 area +
+					 (child->ce_block - start) * ISO_BLOCK_SIZE +
+					 child->ce_offset);
+	}
+}
+
+static BraseroBurnResult
+brasero_iso_image_write_directories (BraseroIsoImage *image,
+				     gboolean joliet,
+				     GError **error)
+{
+	GPtrArray *dirs;
+	guint i;
+
+	dirs = joliet? image->joliet_dirs:image->dirs;
+	for (i = 0; i < dirs->len; i ++) {
+		BraseroIsoNode *node;
+		guchar *records;
+		guint32 size;
+
+		if (brasero_iso_image_is_cancelled (image))
+			return BRASERO_BURN_CANCEL;
+
+		node = g_ptr_array_index (dirs, i);
+		if (!brasero_iso_image_check_position (image, joliet? node->joliet_extent:node->extent, error))
+			return BRASERO_BURN_ERR;
+
+		/* The Joliet records are written after these ones */
+		if (!joliet) {
+			guint j;
+
+			for (j = 0; j < node->children_num; j ++) {
+				if (!brasero_iso_image_node_stat (node->iso_children [j], error))
+					return BRASERO_BURN_ERR;
+			}
+		}
+
+		size = joliet? node->joliet_dir_size:node->dir_size;
+		if (!joliet)
+			size += node->ce_blocks * ISO_BLOCK_SIZE;
+
+		records = g_malloc0 (size);
+		brasero_iso_image_directory (image, node, joliet, records);
+		if (!joliet && node->ce_blocks)
+			brasero_iso_image_continuation_area (image, node, records + node->dir_size);
+
+		if (!brasero_iso_image_output (image, records, size, error)) {
+			g_free (records);
+			return BRASERO_BURN_ERR;
+		}
+		g_free (records);
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_iso_image_write_file (BraseroIsoImage *image,
+			      BraseroIsoNode *node,
+			      guchar *buffer,
+			      GError **error)
+{
+	guint64 remaining;
+	int fd;
+
+	if (!brasero_iso_image_check_position (image, node->extent, error))
+		return BRASERO_BURN_ERR;
+
+	fd = g_open (node->path, O_RDONLY, 0);
+	if (fd == -1) {
+		int errsv = errno;
+
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("Data could not be read (%s)"),
+			     g_strerror (errsv));
+		return BRASERO_BURN_ERR;
+	}
+
+	/* Output the file in large chunks straight from the read buffer */
+	if (!brasero_iso_image_flush (image, error)) {
+		close (fd);
+		return BRASERO_BURN_ERR;
+	}
+
+	remaining = node->size;
+	while (remaining) {
+		gsize bytes;
+		gssize res;
+
+		if (brasero_iso_image_is_cancelled (image)) {
+			close (fd);
+			return BRASERO_BURN_CANCEL;
+		}
+
+		bytes = MIN (remaining, ISO_READ_BUFFER_SIZE);
+		res = read (fd, buffer, bytes);
+		if (res < 0) {
+			int errsv = errno;
+
+			if (errsv == EINTR)
+				continue;
+
+			close (fd);
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Data could not be read (%s)"),
+				     g_strerror (errsv));
+			return BRASERO_BURN_ERR;
+		}
+
+		if (res == 0) {
+			/* The file shrank since it was added; pad it */
+			BRASERO_BURN_LOG ("%s is shorter than expected", node->path);
+			memset (buffer, 0, bytes);
+			res = bytes;
+		}
+
+		/* Pad the last block */
+		if ((guint64) res == remaining && (res % ISO_BLOCK_SIZE)) {
+			gsize padding;
+
+			padding = ISO_BLOCK_SIZE - (res % ISO_BLOCK_SIZE);
+			memset (buffer + res, 0, padding);
+			if (!image->func (buffer, res + padding, image->user_data, error)) {
+				close (fd);
+				return BRASERO_BURN_ERR;
+			}
+
+			image->position += res + padding;
+		}
+		else {
+			if (!image->func (buffer, res, image->user_data, error)) {
+				close (fd);
+				return BRASERO_BURN_ERR;
+			}
+
+			image->position += res;
+		}
+
+		remaining -= res;
+	}
+
+	close (fd);
+
+	/* The file shrank since its blocks were reserved */
+	if (ISO_ROUND_BLOCKS (node->size) < node->blocks
+	&& !brasero_iso_image_output (image,
+				      NULL,
+				      (guint64) (node->blocks - ISO_ROUND_BLOCKS (node->size)) * ISO_BLOCK_SIZE,
+				      error))
+		return BRASERO_BURN_ERR;
+
+	return BRASERO_BURN_OK;
+}
+
+BraseroBurnResult
+brasero_iso_image_write (BraseroIsoImage *image,
+			 BraseroIsoImageWriteFunc func,
+			 gpointer user_data,
+			 GError **error)
+{
+	BraseroBurnResult result;
+	guchar *buffer;
+	guint i;
+
+	image->func = func;
+	image->user_data = user_data;
+	image->position = 0;
+	image->buffer_len = 0;
+	if (!image->buffer)
+		image->buffer = g_malloc (ISO_WRITE_BUFFER_SIZE);
+
+	result = brasero_iso_image_write_descriptors (image, error);
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	result = brasero_iso_image_write_path_tables (image, FALSE, error);
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	if (image->joliet_dirs) {
+		result = brasero_iso_image_write_path_tables (image, TRUE, error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+	}
+
+	result = brasero_iso_image_write_directories (image, FALSE, error);
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	if (image->joliet_dirs) {
+		result = brasero_iso_image_write_directories (image, TRUE, error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+	}
+
+	buffer = g_malloc (ISO_READ_BUFFER_SIZE);
+	for (i = 0; i < image->files->len; i ++) {
+		result = brasero_iso_image_write_file (image,
+						       g_ptr_array_index (image->files, i),
+						       buffer,
+						       error);
+		if (result != BRASERO_BURN_OK) {
+			g_free (buffer);
+			return result;
+		}
+	}
+	g_free (buffer);
+
+	if (!brasero_iso_image_output (image, NULL, ISO_PADDING_BLOCKS * ISO_BLOCK_SIZE, error))
+		return BRASERO_BURN_ERR;
+
+	if (!brasero_iso_image_flush (image, error))
+		return BRASERO_BURN_ERR;
+
+	if (!brasero_iso_image_check_position (image, image->blocks, error))
+		return BRASERO_BURN_ERR;
+
+	return BRASERO_BURN_OK;
+}
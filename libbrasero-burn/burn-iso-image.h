@@ -0,0 +1,139 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BURN_ISO_IMAGE_H
+#define _BURN_ISO_IMAGE_H
+
+#include <glib.h>
+
+#include "burn-basics.h"
+
+G_BEGIN_DECLS
+
+/**
+ * This builds an ISO9660 image (with Rock Ridge and optionally Joliet) out of
+ * graft points or of a tree given node by node without relying on any
+ * external program.
+ * The three steps (adding grafts, laying out the volume and writing it) are
+ * blocking and are meant to be run from a thread. Cancellation can be
+ * requested from any thread.
+ */
+
+typedef struct _BraseroIsoImage BraseroIsoImage;
+typedef struct _BraseroIsoNode BraseroIsoNode;
+
+typedef gboolean (*BraseroIsoImageWriteFunc)	(const guchar *buffer,
+						 gsize bytes,
+						 gpointer user_data,
+						 GError **error);
+
+BraseroIsoImage *
+brasero_iso_image_new (BraseroImageFS fs,
+		       const gchar *label);
+
+void
+brasero_iso_image_free (BraseroIsoImage *image);
+
+void
+brasero_iso_image_cancel (BraseroIsoImage *image);
+
+void
+brasero_iso_image_share_duplicates (BraseroIsoImage *image);
+
+BraseroBurnResult
+brasero_iso_image_add_grafts (BraseroIsoImage *image,
+			      GSList *grafts,
+			      GSList *excluded,
+			      GError **error);
+
+BraseroIsoNode *
+brasero_iso_image_get_root (BraseroIsoImage *image);
+
+BraseroIsoNode *
+brasero_iso_image_add_directory (BraseroIsoImage *image,
+				 BraseroIsoNode *parent,
+				 const gchar *name,
+				 const gchar *path);
+
+void
+brasero_iso_image_add_file (BraseroIsoImage *image,
+			    BraseroIsoNode *parent,
+			    const gchar *name,
+			    const gchar *path,
+			    guint32 blocks);
+
+BraseroBurnResult
+brasero_iso_image_layout (BraseroIsoImage *image,
+			  GError **error);
+
+goffset
+brasero_iso_image_get_blocks (BraseroIsoImage *image);
+
+guint64
+brasero_iso_image_get_file_num (BraseroIsoImage *image);
+
+BraseroBurnResult
+brasero_iso_image_write (BraseroIsoImage *image,
+			 BraseroIsoImageWriteFunc func,
+			 gpointer user_data,
+			 GError **error);
+
+/**
+ * Size of the records of a directory in blocks and of its subdirectories
+ * entries in the path tables in bytes. The ISO9660 records include the
+ * Rock Ridge continuation area.
+ */
+
+typedef struct _BraseroIsoDirSize BraseroIsoDirSize;
+struct _BraseroIsoDirSize {
+	guint32 records;
+	guint32 joliet_records;
+	guint32 path_table;
+	guint32 joliet_path_table;
+};
+
+void
+brasero_iso_image_get_directory_size (const gchar **names,
+				      const gboolean *is_dir,
+				      guint num,
+				      gboolean is_root,
+				      BraseroIsoDirSize *size);
+
+goffset
+brasero_iso_image_get_volume_size (BraseroImageFS fs,
+				   guint64 records,
+				   guint64 joliet_records,
+				   guint64 path_table,
+				   guint64 joliet_path_table,
+				   goffset data_blocks);
+
+G_END_DECLS
+
+#endif /* _BURN_ISO_IMAGE_H */
@@ -38,6 +38,7 @@
 #include <unistd.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/ioctl.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -838,6 +839,27 @@ brasero_job_item_clock_tick (BraseroTaskItem *item,
 	if (klass->clock_tick)
 		result = klass->clock_tick (self);
 
+#ifdef FIONREAD
+
+	/* Record how much data is waiting in the pipe that feeds this job.
+	 * A pipe that stays full means this job is the bottleneck while an
+	 * empty one means it is starved by the job feeding it. */
+	if (priv->input && priv->input->in > 0 && brasero_burn_trace_enabled ()) {
+		int pending = 0;
+
+		if (ioctl (priv->input->in, FIONREAD, &pending) == 0) {
+			gchar *series;
+
+			series = g_strdup_printf ("%s (%s)",
+						  G_OBJECT_TYPE_NAME (self),
+						  brasero_task_ctx_get_trace_label (ctx));
+			brasero_burn_trace_counter ("pipe input (B)", series, pending);
+			g_free (series);
+		}
+	}
+
+#endif
+
 	return result;
 }
 
@@ -1931,6 +1953,38 @@ brasero_job_set_output_size_for_current_track (BraseroJob *self,
 								   bytes);
 }
 
+BraseroBurnResult
+brasero_job_set_spool_depth (BraseroJob *self,
+			     guint tracks)
+{
+	BraseroJobPrivate *priv;
+
+	/* NOTE: unlike other progress values any active job can set this one
+	 * since it's usually the first job of a task that spools data for the
+	 * others. */
+	priv = BRASERO_JOB_PRIVATE (self);
+	if (!priv->ctx)
+		return BRASERO_BURN_NOT_RUNNING;
+
+	return brasero_task_ctx_set_spool_depth (priv->ctx, tracks);
+}
+
+BraseroBurnResult
+brasero_job_set_buffer_fill (BraseroJob *self,
+			     gint fifo,
+			     gint buffer)
+{
+	BraseroJobPrivate *priv;
+
+	BRASERO_JOB_DEBUG (self);
+
+	priv = BRASERO_JOB_PRIVATE (self);
+	if (!brasero_job_is_last_active (self))
+		return BRASERO_BURN_ERR;
+
+	return brasero_task_ctx_set_buffer_fill (priv->ctx, fifo, buffer);
+}
+
 BraseroBurnResult
 brasero_job_set_written_track (BraseroJob *self,
 			       goffset written)
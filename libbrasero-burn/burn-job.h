@@ -288,6 +288,25 @@ brasero_job_set_output_size_for_current_track (BraseroJob *job,
 					       goffset sectors,
 					       goffset bytes);
 
+/**
+ * Used by jobs that produce data ahead of the job they feed (like the
+ * transcoder when piping) to report how many tracks are ready to be consumed
+ */
+
+BraseroBurnResult
+brasero_job_set_spool_depth (BraseroJob *job,
+			     guint tracks);
+
+/**
+ * Used by recorders to report how full their fifo and the drive buffer are
+ * (in percent, -1 if unknown)
+ */
+
+BraseroBurnResult
+brasero_job_set_buffer_fill (BraseroJob *job,
+			     gint fifo,
+			     gint buffer);
+
 /**
  * Used to tell it's (or not) dangerous to interrupt this job
  */
@@ -381,11 +381,16 @@ brasero_plugin_manager_init (BraseroPluginManager *self)
 		}
 	}
 
+	/* The applications plugins rely on are all run at the same time once
+	 * every plugin has been loaded */
+	brasero_plugin_test_apps_defer ();
+
 	/* load all plugins from directory */
 	while ((name = g_dir_read_name (directory))) {
 		BraseroPluginRegisterType function;
 		BraseroPlugin *plugin;
 		GModule *handle;
+		gint64 start;
 		gchar *path;
 
 		/* the name must end with *.so */
@@ -395,6 +400,7 @@ brasero_plugin_manager_init (BraseroPluginManager *self)
 		path = g_module_build_path (BRASERO_PLUGIN_DIRECTORY, name);
 		BRASERO_BURN_LOG ("loading %s", path);
 
+		start = g_get_monotonic_time ();
 		handle = g_module_open (path, 0);
 		if (!handle) {
 			g_free (path);
@@ -413,6 +419,11 @@ brasero_plugin_manager_init (BraseroPluginManager *self)
 		/* now we can create the plugin */
 		plugin = brasero_plugin_new (path);
 		g_module_close (handle);
+
+		BRASERO_BURN_LOG ("%s loaded in %" G_GINT64_FORMAT " us",
+				  name,
+				  g_get_monotonic_time () - start);
+		brasero_burn_trace_span ("plugins", name, path, start);
 		g_free (path);
 
 		if (!plugin) {
@@ -438,6 +449,8 @@ brasero_plugin_manager_init (BraseroPluginManager *self)
 	}
 	g_dir_close (directory);
 
+	brasero_plugin_test_apps_run ();
+
 	brasero_plugin_manager_set_plugins_state (self);
 }
 
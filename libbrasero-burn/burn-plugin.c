@@ -33,11 +33,14 @@
 #endif
 
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <glib-object.h>
 #include <gmodule.h>
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
 
 #include <gst/gst.h>
 
@@ -122,6 +125,7 @@ struct _BraseroPluginPrivate
 	BraseroPluginProcessFlag process_flags;
 
 	guint compulsory:1;
+	guint shares_duplicates:1;
 };
 
 static const gchar *default_icon = "gtk-cdrom";
@@ -188,6 +192,265 @@ brasero_plugin_test_gstreamer_plugin (BraseroPlugin *plugin,
 		gst_object_unref (element);
 }
 
+/**
+ * The output of the applications run to get their version is saved between
+ * sessions and used again as long as the binary has not changed. While the
+ * plugins are loaded, the applications that need to be run are queued and
+ * then run at the same time.
+ */
+
+#define BRASERO_PLUGIN_APPS_CACHE			"apps"
+#define BRASERO_PLUGIN_APPS_OUTPUT_MAX			4096
+
+typedef struct _BraseroPluginAppTest BraseroPluginAppTest;
+struct _BraseroPluginAppTest {
+	BraseroPlugin *plugin;
+
+	gchar *name;
+	gchar *path;
+	gchar *version_arg;
+	gchar *version_format;
+	gint version [3];
+
+	gchar *stamp;
+	gchar *standard_output;
+	gchar *standard_error;
+	gboolean res;
+
+	GThread *thread;
+};
+
+static GKeyFile *apps_cache = NULL;
+static gboolean apps_cache_changed = FALSE;
+
+static gboolean apps_deferred = FALSE;
+static GSList *apps_tests = NULL;
+
+static gchar *
+brasero_plugin_apps_cache_path (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+				 "brasero",
+				 BRASERO_PLUGIN_APPS_CACHE,
+				 NULL);
+}
+
+static GKeyFile *
+brasero_plugin_apps_cache_get (void)
+{
+	gchar *path;
+
+	if (apps_cache)
+		return apps_cache;
+
+	apps_cache = g_key_file_new ();
+	path = brasero_plugin_apps_cache_path ();
+	g_key_file_load_from_file (apps_cache, path, G_KEY_FILE_NONE, NULL);
+	g_free (path);
+
+	return apps_cache;
+}
+
+static void
+brasero_plugin_apps_cache_save (void)
+{
+	gchar *directory;
+	gchar *contents;
+	gchar *path;
+	gsize size;
+
+	if (!apps_cache_changed)
+		return;
+
+	apps_cache_changed = FALSE;
+
+	path = brasero_plugin_apps_cache_path ();
+	directory = g_path_get_dirname (path);
+	g_mkdir_with_parents (directory, S_IRWXU);
+	g_free (directory);
+
+	contents = g_key_file_to_data (apps_cache, &size, NULL);
+	if (!g_file_set_contents (path, contents, size, NULL))
+		BRASERO_BURN_LOG ("Applications cache could not be saved to %s", path);
+
+	g_free (contents);
+	g_free (path);
+}
+
+/* The binary is considered unchanged as long as this is the same */
+static gchar *
+brasero_plugin_app_stamp (const gchar *path)
+{
+	struct stat info;
+
+	if (g_stat (path, &info))
+		return NULL;
+
+	return g_strdup_printf ("%lu:%lu:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+				(gulong) info.st_dev,
+				(gulong) info.st_ino,
+				(gint64) info.st_size,
+				(gint64) info.st_mtime);
+}
+
+static gboolean
+brasero_plugin_apps_cache_lookup (BraseroPluginAppTest *test)
+{
+	GKeyFile *cache;
+	gchar *group;
+	gchar *value;
+	gboolean found = FALSE;
+
+	if (!test->stamp)
+		return FALSE;
+
+	cache = brasero_plugin_apps_cache_get ();
+	group = g_strconcat (test->path, " ", test->version_arg, NULL);
+
+	value = g_key_file_get_string (cache, group, "stamp", NULL);
+	if (value && !strcmp (value, test->stamp)) {
+		found = TRUE;
+		test->res = g_key_file_get_boolean (cache, group, "spawned", NULL);
+		test->standard_output = g_key_file_get_string (cache, group, "output", NULL);
+		test->standard_error = g_key_file_get_string (cache, group, "error", NULL);
+	}
+
+	g_free (value);
+	g_free (group);
+	return found;
+}
+
+/* Returns FALSE if the output can't be stored as it is (not UTF-8) */
+static gboolean
+brasero_plugin_apps_cache_set_output (GKeyFile *cache,
+				      const gchar *group,
+				      const gchar *key,
+				      const gchar *output)
+{
+	gchar *value;
+	gsize len;
+
+	if (!output) {
+		g_key_file_remove_key (cache, group, key, NULL);
+		return TRUE;
+	}
+
+	if (!g_utf8_validate (output, -1, NULL))
+		return FALSE;
+
+	/* The version is at the beginning; don't cut a character in the
+	 * middle when keeping only that part */
+	len = strlen (output);
+	if (len > BRASERO_PLUGIN_APPS_OUTPUT_MAX) {
+		const gchar *end;
+
+		end = g_utf8_find_prev_char (output, output + BRASERO_PLUGIN_APPS_OUTPUT_MAX + 1);
+		len = end? end - output:0;
+	}
+
+	value = g_strndup (output, len);
+	g_key_file_set_string (cache, group, key, value);
+	g_free (value);
+	return TRUE;
+}
+
+static void
+brasero_plugin_apps_cache_store (BraseroPluginAppTest *test)
+{
+	GKeyFile *cache;
+	gchar *group;
+
+	if (!test->stamp)
+		return;
+
+	cache = brasero_plugin_apps_cache_get ();
+	group = g_strconcat (test->path, " ", test->version_arg, NULL);
+
+	/* Without its output an entry would make the test fail next time so
+	 * the application is run again instead */
+	if (!brasero_plugin_apps_cache_set_output (cache, group, "output", test->standard_output)
+	||  !brasero_plugin_apps_cache_set_output (cache, group, "error", test->standard_error)) {
+		BRASERO_BURN_LOG ("Output of %s not cached (invalid UTF-8)", test->path);
+		g_key_file_remove_group (cache, group, NULL);
+		apps_cache_changed = TRUE;
+		g_free (group);
+		return;
+	}
+
+	g_key_file_set_string (cache, group, "stamp", test->stamp);
+	g_key_file_set_boolean (cache, group, "spawned", test->res);
+	apps_cache_changed = TRUE;
+
+	g_free (group);
+}
+
+static void
+brasero_plugin_app_test_free (BraseroPluginAppTest *test)
+{
+	g_object_unref (test->plugin);
+	g_free (test->name);
+	g_free (test->path);
+	g_free (test->version_arg);
+	g_free (test->version_format);
+	g_free (test->stamp);
+	g_free (test->standard_output);
+	g_free (test->standard_error);
+	g_free (test);
+}
+
+static gpointer
+brasero_plugin_app_test_spawn (gpointer data)
+{
+	BraseroPluginAppTest *test = data;
+	gchar *argv [3];
+
+	argv [0] = test->path;
+	argv [1] = test->version_arg;
+	argv [2] = NULL;
+
+	test->res = g_spawn_sync (NULL,
+	                          argv,
+	                          NULL,
+	                          0,
+	                          NULL,
+	                          NULL,
+	                          &test->standard_output,
+	                          &test->standard_error,
+	                          NULL,
+	                          NULL);
+	return NULL;
+}
+
+static void
+brasero_plugin_app_test_check (BraseroPluginAppTest *test)
+{
+	guint major, minor, sub;
+	int i;
+
+	if (!test->res) {
+		brasero_plugin_add_error (test->plugin,
+		                          BRASERO_PLUGIN_ERROR_WRONG_APP_VERSION,
+		                          test->name);
+		return;
+	}
+
+	for (i = 0; i < 3 && test->version [i] >= 0; i++);
+
+	if ((test->standard_output && sscanf (test->standard_output, test->version_format, &major, &minor, &sub) == i)
+	||  (test->standard_error && sscanf (test->standard_error, test->version_format, &major, &minor, &sub) == i)) {
+		if (major < test->version [0]
+		||  (test->version [1] >= 0 && minor < test->version [1])
+		||  (test->version [2] >= 0 && sub < test->version [2]))
+			brasero_plugin_add_error (test->plugin,
+						  BRASERO_PLUGIN_ERROR_WRONG_APP_VERSION,
+						  test->name);
+	}
+	else
+		brasero_plugin_add_error (test->plugin,
+		                          BRASERO_PLUGIN_ERROR_WRONG_APP_VERSION,
+		                          test->name);
+}
+
 void
 brasero_plugin_test_app (BraseroPlugin *plugin,
                          const gchar *name,
@@ -195,13 +458,8 @@ brasero_plugin_test_app (BraseroPlugin *plugin,
                          const gchar *version_format,
                          gint version [3])
 {
-	gchar *standard_output = NULL;
-	gchar *standard_error = NULL;
-	guint major, minor, sub;
+	BraseroPluginAppTest *test;
 	gchar *prog_path;
-	GPtrArray *argv;
-	gboolean res;
-	int i;
 
 	/* First see if this plugin can be used, i.e. if cdrecord is in
 	 * the path */
@@ -249,50 +507,101 @@ brasero_plugin_test_app (BraseroPlugin *plugin,
 	}
 
 	/* Check version */
-	argv = g_ptr_array_new ();
-	g_ptr_array_add (argv, prog_path);
-	g_ptr_array_add (argv, (gchar *) version_arg);
-	g_ptr_array_add (argv, NULL);
-
-	res = g_spawn_sync (NULL,
-	                    (gchar **) argv->pdata,
-	                    NULL,
-	                    0,
-	                    NULL,
-	                    NULL,
-	                    &standard_output,
-	                    &standard_error,
-	                    NULL,
-	                    NULL);
-
-	g_ptr_array_free (argv, TRUE);
-	g_free (prog_path);
-
-	if (!res) {
-		brasero_plugin_add_error (plugin,
-		                          BRASERO_PLUGIN_ERROR_WRONG_APP_VERSION,
-		                          name);
+	test = g_new0 (BraseroPluginAppTest, 1);
+	test->plugin = g_object_ref (plugin);
+	test->name = g_strdup (name);
+	test->path = prog_path;
+	test->version_arg = g_strdup (version_arg);
+	test->version_format = g_strdup (version_format);
+	memcpy (test->version, version, sizeof (test->version));
+	test->stamp = brasero_plugin_app_stamp (prog_path);
+
+	if (brasero_plugin_apps_cache_lookup (test)) {
+		BRASERO_BURN_LOG ("Using cached version output for %s", name);
+		brasero_plugin_app_test_check (test);
+		brasero_plugin_app_test_free (test);
 		return;
 	}
 
-	for (i = 0; i < 3 && version [i] >= 0; i++);
+	if (apps_deferred) {
+		apps_tests = g_slist_prepend (apps_tests, test);
+		return;
+	}
 
-	if ((standard_output && sscanf (standard_output, version_format, &major, &minor, &sub) == i)
-	||  (standard_error && sscanf (standard_error, version_format, &major, &minor, &sub) == i)) {
-		if (major < version [0]
-		||  (version [1] >= 0 && minor < version [1])
-		||  (version [2] >= 0 && sub < version [2]))
-			brasero_plugin_add_error (plugin,
-						  BRASERO_PLUGIN_ERROR_WRONG_APP_VERSION,
-						  name);
+	brasero_plugin_app_test_spawn (test);
+	brasero_plugin_apps_cache_store (test);
+	brasero_plugin_app_test_check (test);
+	brasero_plugin_app_test_free (test);
+
+	brasero_plugin_apps_cache_save ();
+}
+
+/**
+ * brasero_plugin_test_apps_defer:
+ *
+ * Applications are not run any more by brasero_plugin_test_app () until
+ * brasero_plugin_test_apps_run () is called.
+ **/
+void
+brasero_plugin_test_apps_defer (void)
+{
+	apps_deferred = TRUE;
+}
+
+/**
+ * brasero_plugin_test_apps_run:
+ *
+ * Runs all the applications queued since brasero_plugin_test_apps_defer ()
+ * at the same time and checks their versions.
+ **/
+void
+brasero_plugin_test_apps_run (void)
+{
+	GSList *iter;
+	gint64 start;
+	guint num;
+
+	apps_deferred = FALSE;
+	if (!apps_tests)
+		return;
+
+	start = g_get_monotonic_time ();
+
+	apps_tests = g_slist_reverse (apps_tests);
+	for (iter = apps_tests; iter; iter = iter->next) {
+		BraseroPluginAppTest *test;
+
+		test = iter->data;
+		test->thread = g_thread_create (brasero_plugin_app_test_spawn,
+						test,
+						TRUE,
+						NULL);
+		if (!test->thread)
+			brasero_plugin_app_test_spawn (test);
+	}
+
+	num = g_slist_length (apps_tests);
+	for (iter = apps_tests; iter; iter = iter->next) {
+		BraseroPluginAppTest *test;
+
+		test = iter->data;
+		if (test->thread)
+			g_thread_join (test->thread);
+
+		brasero_plugin_apps_cache_store (test);
+		brasero_plugin_app_test_check (test);
+		brasero_plugin_app_test_free (test);
 	}
-	else
-		brasero_plugin_add_error (plugin,
-		                          BRASERO_PLUGIN_ERROR_WRONG_APP_VERSION,
-		                          name);
 
-	g_free (standard_output);
-	g_free (standard_error);
+	g_slist_free (apps_tests);
+	apps_tests = NULL;
+
+	BRASERO_BURN_LOG ("%u applications run in %" G_GINT64_FORMAT " ms",
+			  num,
+			  (g_get_monotonic_time () - start) / 1000);
+	brasero_burn_trace_span ("plugins", "applications", NULL, start);
+
+	brasero_plugin_apps_cache_save ();
 }
 
 void
@@ -314,6 +623,30 @@ brasero_plugin_get_compulsory (BraseroPlugin *self)
 	return priv->compulsory;
 }
 
+/**
+ * For plugins creating images from data that write the contents of identical
+ * files only once when the "dedup-files" setting is on.
+ */
+
+void
+brasero_plugin_set_shares_duplicates (BraseroPlugin *self,
+				      gboolean shares)
+{
+	BraseroPluginPrivate *priv;
+
+	priv = BRASERO_PLUGIN_PRIVATE (self);
+	priv->shares_duplicates = shares;
+}
+
+gboolean
+brasero_plugin_get_shares_duplicates (BraseroPlugin *self)
+{
+	BraseroPluginPrivate *priv;
+
+	priv = BRASERO_PLUGIN_PRIVATE (self);
+	return priv->shares_duplicates;
+}
+
 void
 brasero_plugin_set_active (BraseroPlugin *self, gboolean active)
 {
@@ -38,12 +38,23 @@
 #include <glib-object.h>
 #include <glib/gi18n-lib.h>
 
+#include "brasero-drive.h"
+
 #include "burn-basics.h"
 #include "brasero-session.h"
 #include "brasero-session-helper.h"
 #include "burn-debug.h"
 #include "burn-task-ctx.h"
 
+#define RATE_WINDOW_SIZE	20
+#define RATE_WINDOW_MIN		6
+
+typedef struct _BraseroTaskCtxSample BraseroTaskCtxSample;
+struct _BraseroTaskCtxSample {
+	gdouble elapsed;
+	gdouble position;
+};
+
 typedef struct _BraseroTaskCtxPrivate BraseroTaskCtxPrivate;
 struct _BraseroTaskCtxPrivate
 {
@@ -76,13 +87,29 @@ struct _BraseroTaskCtxPrivate
 	goffset last_written;
 	gdouble last_progress;
 
-	/* used for remaining time */
-	GSList *times;
+	/* used for remaining time when only a progress is reported */
+	guint total_time_samples;
 	gdouble total_time;
 
+	/* sliding window of positions (in bytes) sampled at each progress
+	 * report; a linear regression over it gives the smoothed rate */
+	BraseroTaskCtxSample samples [RATE_WINDOW_SIZE];
+	guint samples_num;
+	guint samples_next;
+
+	gdouble smoothed_rate;
+	gdouble confidence;
+
+	/* last progress notified and when (monotonic time) */
+	gdouble reported_progress;
+	gint64 reported_time;
+
 	/* used for rates that certain jobs are able to report */
 	guint64 rate;
 
+	/* data produced ahead by a job and not consumed yet */
+	guint spool_tracks;
+
 	/* the current action */
 	BraseroBurnAction current_action;
 	gchar *action_string;
@@ -96,6 +123,9 @@ struct _BraseroTaskCtxPrivate
 	guint written_changed:1;
 	guint progress_changed:1;
 	guint use_average_rate:1;
+
+	/* set when the rate keeps increasing (CAV/zone-CLV) */
+	guint ramping:1;
 };
 
 #define BRASERO_TASK_CTX_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_TASK_CTX, BraseroTaskCtxPrivate))
@@ -104,6 +134,21 @@ G_DEFINE_TYPE (BraseroTaskCtx, brasero_task_ctx, G_TYPE_OBJECT);
 
 #define MAX_VALUE_AVERAGE	16
 
+/* progress-changed is only emitted when the progress moved by at least that
+ * much or when the last one is older than PROGRESS_REPORT_MAX_DELAY (so that
+ * the rate and the remaining time are still refreshed on stalls). */
+#define PROGRESS_REPORT_THRESHOLD	0.002
+#define PROGRESS_REPORT_MAX_DELAY	(2 * G_USEC_PER_SEC)
+
+/* Weight of a new value in the exponentially weighted moving average of the
+ * total time (when only progress is known) */
+#define TOTAL_TIME_EWMA_WEIGHT	(2.0 / (MAX_VALUE_AVERAGE + 1))
+
+/* Radii (mm) of the recordable area of a 12 cm disc. On CAV the rate grows
+ * linearly with the radius between them. */
+#define DISC_INNER_RADIUS	24.0
+#define DISC_OUTER_RADIUS	58.0
+
 enum _BraseroTaskCtxSignalType {
 	ACTION_CHANGED_SIGNAL,
 	PROGRESS_CHANGED_SIGNAL,
@@ -141,6 +186,25 @@ brasero_task_ctx_get_dangerous (BraseroTaskCtx *self)
 	return priv->dangerous;
 }
 
+static void
+brasero_task_ctx_reset_estimate (BraseroTaskCtx *self)
+{
+	BraseroTaskCtxPrivate *priv;
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	g_mutex_lock (priv->lock);
+	priv->total_time = 0.0;
+	priv->total_time_samples = 0;
+
+	priv->samples_num = 0;
+	priv->samples_next = 0;
+	priv->smoothed_rate = 0.0;
+	priv->confidence = 0.0;
+	priv->ramping = 0;
+	g_mutex_unlock (priv->lock);
+}
+
 void
 brasero_task_ctx_reset (BraseroTaskCtx *self)
 {
@@ -177,16 +241,17 @@ brasero_task_ctx_reset (BraseroTaskCtx *self)
 	priv->track_bytes = -1;
 	priv->session_bytes = -1;
 	priv->written_changed = 0;
+	priv->reported_progress = -1.0;
+	priv->reported_time = 0;
 
 	priv->current_elapsed = 0;
 	priv->last_written = 0;
 	priv->last_elapsed = 0;
 	priv->last_progress = 0;
 
-	if (priv->times) {
-		g_slist_free (priv->times);
-		priv->times = NULL;
-	}
+	priv->spool_tracks = 0;
+
+	brasero_task_ctx_reset_estimate (self);
 
 	g_signal_emit (self,
 		       brasero_task_ctx_signals [PROGRESS_CHANGED_SIGNAL],
@@ -271,6 +336,27 @@ brasero_task_ctx_get_action (BraseroTaskCtx *self)
 	return priv->action;
 }
 
+/**
+ * Used to tell apart the drives in performance traces
+ */
+
+const gchar *
+brasero_task_ctx_get_trace_label (BraseroTaskCtx *self)
+{
+	BraseroTaskCtxPrivate *priv;
+	BraseroDrive *drive;
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+	if (!priv->session)
+		return "none";
+
+	drive = brasero_burn_session_get_burner (priv->session);
+	if (!drive || brasero_drive_is_fake (drive))
+		return "image";
+
+	return brasero_drive_get_device (drive);
+}
+
 /**
  * Used to report task status
  */
@@ -437,51 +523,251 @@ brasero_task_ctx_start_progress (BraseroTaskCtx *self,
 	return BRASERO_BURN_OK;
 }
 
-static gdouble
-brasero_task_ctx_get_average (GSList **values, gdouble value)
+static gboolean
+brasero_task_ctx_get_position (BraseroTaskCtx *self,
+			       gdouble *position)
 {
-	const unsigned int scale = 10000;
-	unsigned int num = 0;
-	gdouble average;
-	gint32 int_value;
-	GSList *l;
-
-	if (value * scale < G_MAXINT)
-		int_value = (gint32) ceil (scale * value);
-	else if (value / scale < G_MAXINT)
-		int_value = (gint32) ceil (-1.0 * value / scale);
-	else
-		return value;
-		
-	*values = g_slist_prepend (*values, GINT_TO_POINTER (int_value));
+	BraseroTaskCtxPrivate *priv;
 
-	average = 0;
-	for (l = *values; l; l = l->next) {
-		gdouble r = (gdouble) GPOINTER_TO_INT (l->data);
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
 
-		if (r < 0)
-			r *= scale * -1.0;
-		else
-			r /= scale;
+	if ((priv->session_bytes + priv->track_bytes) > 0) {
+		*position = priv->session_bytes + priv->track_bytes;
+		return TRUE;
+	}
 
-		average += r;
-		num++;
-		if (num == MAX_VALUE_AVERAGE && l->next)
-			l = g_slist_delete_link (l, l->next);
+	if (priv->progress > 0.0 && priv->size > 0) {
+		*position = priv->progress * priv->size;
+		return TRUE;
 	}
 
-	average /= num;
-	return average;
+	return FALSE;
 }
 
-void
+/**
+ * Least squares fit of position = rate * elapsed + b over samples [first,
+ * first + num) of the window. Returns the slope and the coefficient of
+ * determination (how well a constant rate explains the samples).
+ */
+
+static gboolean
+brasero_task_ctx_fit_samples (BraseroTaskCtxPrivate *priv,
+			      guint first,
+			      guint num,
+			      gdouble *rate,
+			      gdouble *r2)
+{
+	gdouble mean_t = 0.0, mean_p = 0.0;
+	gdouble stt = 0.0, spp = 0.0, stp = 0.0;
+	guint oldest;
+	guint i;
+
+	if (num < 2)
+		return FALSE;
+
+	oldest = (priv->samples_next + RATE_WINDOW_SIZE - priv->samples_num) % RATE_WINDOW_SIZE;
+	for (i = first; i < first + num; i ++) {
+		BraseroTaskCtxSample *sample;
+
+		sample = priv->samples + (oldest + i) % RATE_WINDOW_SIZE;
+		mean_t += sample->elapsed;
+		mean_p += sample->position;
+	}
+	mean_t /= num;
+	mean_p /= num;
+
+	for (i = first; i < first + num; i ++) {
+		BraseroTaskCtxSample *sample;
+		gdouble dt, dp;
+
+		sample = priv->samples + (oldest + i) % RATE_WINDOW_SIZE;
+		dt = sample->elapsed - mean_t;
+		dp = sample->position - mean_p;
+		stt += dt * dt;
+		spp += dp * dp;
+		stp += dt * dp;
+	}
+
+	if (stt <= 0.0)
+		return FALSE;
+
+	*rate = stp / stt;
+	if (r2)
+		*r2 = spp > 0.0 ? (stp * stp) / (stt * spp) : 0.0;
+
+	return TRUE;
+}
+
+static void
+brasero_task_ctx_add_sample (BraseroTaskCtx *self,
+			     gdouble elapsed)
+{
+	BraseroTaskCtxPrivate *priv;
+	BraseroTaskCtxSample *sample;
+	gdouble position;
+	gdouble rate, r2;
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	if (!brasero_task_ctx_get_position (self, &position))
+		return;
+
+	g_mutex_lock (priv->lock);
+
+	if (priv->samples_num) {
+		sample = priv->samples + (priv->samples_next + RATE_WINDOW_SIZE - 1) % RATE_WINDOW_SIZE;
+
+		/* A position going backward means a new track or action
+		 * restarted the count; start the window again. */
+		if (position < sample->position) {
+			priv->samples_num = 0;
+			priv->samples_next = 0;
+		}
+		else if (elapsed <= sample->elapsed) {
+			g_mutex_unlock (priv->lock);
+			return;
+		}
+	}
+
+	sample = priv->samples + priv->samples_next;
+	sample->elapsed = elapsed;
+	sample->position = position;
+
+	priv->samples_next = (priv->samples_next + 1) % RATE_WINDOW_SIZE;
+	if (priv->samples_num < RATE_WINDOW_SIZE)
+		priv->samples_num ++;
+
+	if (!brasero_task_ctx_fit_samples (priv, 0, priv->samples_num, &rate, &r2)) {
+		g_mutex_unlock (priv->lock);
+		return;
+	}
+
+	/* Confidence grows with the number of samples and with how well they
+	 * fit a constant rate; a pipe stall or a ramp lowers it. */
+	priv->smoothed_rate = MAX (rate, 0.0);
+	priv->confidence = r2 * (gdouble) priv->samples_num / (gdouble) RATE_WINDOW_SIZE;
+
+	/* See whether the rate keeps increasing across the window which is
+	 * what happens on CAV or zone-CLV drives until they reach their
+	 * maximum speed. */
+	priv->ramping = 0;
+	if (priv->samples_num == RATE_WINDOW_SIZE) {
+		gdouble first_half, second_half;
+
+		if (brasero_task_ctx_fit_samples (priv, 0, RATE_WINDOW_SIZE / 2, &first_half, NULL)
+		&&  brasero_task_ctx_fit_samples (priv, RATE_WINDOW_SIZE / 2, RATE_WINDOW_SIZE / 2, &second_half, NULL)
+		&&  first_half > 0.0
+		&&  second_half > first_half * 1.02)
+			priv->ramping = 1;
+	}
+
+	g_mutex_unlock (priv->lock);
+}
+
+/**
+ * Estimates the time needed to write the remaining bytes. When the drive is
+ * ramping up, the rate is modeled as growing with the radius (CAV) until it
+ * reaches the maximum speed reported for the medium (zone-CLV) and stays
+ * constant afterwards.
+ */
+
+static gboolean
+brasero_task_ctx_get_model_remaining_time (BraseroTaskCtx *self,
+					   gdouble *remaining)
+{
+	BraseroTaskCtxPrivate *priv;
+	BraseroTaskCtxSample *sample;
+	gdouble total, position, rate;
+	gdouble inner, a, p, end;
+	gdouble time;
+	guint64 max_rate = 0;
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	if (priv->samples_num < RATE_WINDOW_MIN || priv->smoothed_rate <= 0.0)
+		return FALSE;
+
+	total = priv->size;
+	if (total <= 0)
+		return FALSE;
+
+	sample = priv->samples + (priv->samples_next + RATE_WINDOW_SIZE - 1) % RATE_WINDOW_SIZE;
+	position = MIN (sample->position, total);
+	rate = priv->smoothed_rate;
+
+	if (priv->ramping
+	&&  priv->current_action == BRASERO_BURN_ACTION_RECORDING)
+		max_rate = brasero_burn_session_get_rate (priv->session);
+
+	if (max_rate <= rate * 1.05) {
+		*remaining = (total - position) / rate;
+		return TRUE;
+	}
+
+	/* With written fraction x, the radius is proportional to
+	 * sqrt (a + x), a being the share of the inner area */
+	inner = DISC_INNER_RADIUS * DISC_INNER_RADIUS;
+	a = inner / (DISC_OUTER_RADIUS * DISC_OUTER_RADIUS - inner);
+	p = position / total;
+
+	/* fraction at which the drive reaches its maximum speed */
+	end = (a + p) * ((gdouble) max_rate / rate) * ((gdouble) max_rate / rate) - a;
+	end = MIN (end, 1.0);
+
+	time = total * 2.0 * sqrt (a + p) / rate * (sqrt (a + end) - sqrt (a + p));
+	if (end < 1.0)
+		time += total * (1.0 - end) / (gdouble) max_rate;
+
+	*remaining = time;
+	return TRUE;
+}
+
+static void
+brasero_task_ctx_emit_progress (BraseroTaskCtx *self,
+				gboolean force)
+{
+	BraseroTaskCtxPrivate *priv;
+	gdouble progress;
+	gint64 now;
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	now = g_get_monotonic_time ();
+	if (brasero_task_ctx_get_progress (self, &progress) != BRASERO_BURN_OK)
+		progress = -1.0;
+
+	if (!force
+	&&   progress >= 0.0
+	&&   progress < 1.0
+	&&   priv->reported_progress >= 0.0
+	&&   fabs (progress - priv->reported_progress) < PROGRESS_REPORT_THRESHOLD
+	&&   now - priv->reported_time < PROGRESS_REPORT_MAX_DELAY)
+		return;
+
+	priv->progress_changed = 0;
+	priv->written_changed = 0;
+
+	priv->reported_progress = progress;
+	priv->reported_time = now;
+	g_signal_emit (self,
+		       brasero_task_ctx_signals [PROGRESS_CHANGED_SIGNAL],
+		       0);
+}
+
+/**
+ * Returns TRUE if a new action started since the last call.
+ */
+
+gboolean
 brasero_task_ctx_report_progress (BraseroTaskCtx *self)
 {
 	BraseroTaskCtxPrivate *priv;
 	gdouble progress, elapsed;
+	gboolean new_action;
 
 	priv = BRASERO_TASK_CTX_PRIVATE (self);
 
+	new_action = priv->action_changed;
 	if (priv->action_changed) {
 		/* Give a last progress-changed signal
 		 * setting previous action as completely
@@ -512,9 +798,7 @@ brasero_task_ctx_report_progress (BraseroTaskCtx *self)
 			       priv->current_action);
 
 		brasero_task_ctx_reset_progress (self);
-		g_signal_emit (self,
-			       brasero_task_ctx_signals [PROGRESS_CHANGED_SIGNAL],
-			       0);
+		brasero_task_ctx_emit_progress (self, TRUE);
 
 		priv->action_changed = 0;
 	}
@@ -529,30 +813,41 @@ brasero_task_ctx_report_progress (BraseroTaskCtx *self)
 
 	if (priv->timer) {
 		elapsed = g_timer_elapsed (priv->timer, NULL);
-		if (brasero_task_ctx_get_progress (self, &progress) == BRASERO_BURN_OK) {
+		if (brasero_task_ctx_get_progress (self, &progress) == BRASERO_BURN_OK
+		&&  progress > 0.0) {
 			gdouble total_time;
 
 			total_time = (gdouble) elapsed / (gdouble) progress;
 
 			g_mutex_lock (priv->lock);
-			priv->total_time = brasero_task_ctx_get_average (&priv->times,
-									 total_time);
+			if (priv->total_time_samples)
+				priv->total_time += TOTAL_TIME_EWMA_WEIGHT * (total_time - priv->total_time);
+			else
+				priv->total_time = total_time;
+			priv->total_time_samples ++;
 			g_mutex_unlock (priv->lock);
 		}
-	}
 
-	if (priv->progress_changed) {
-		priv->progress_changed = 0;
-		g_signal_emit (self,
-			       brasero_task_ctx_signals [PROGRESS_CHANGED_SIGNAL],
-			       0);
+		brasero_task_ctx_add_sample (self, elapsed);
 	}
-	else if (priv->written_changed) {
-		priv->written_changed = 0;
-		g_signal_emit (self,
-			       brasero_task_ctx_signals [PROGRESS_CHANGED_SIGNAL],
-			       0);
+
+	if (priv->progress_changed || priv->written_changed)
+		brasero_task_ctx_emit_progress (self, FALSE);
+
+	if (brasero_burn_trace_enabled ()) {
+		const gchar *label;
+		goffset written = 0;
+		guint64 rate = 0;
+
+		label = brasero_task_ctx_get_trace_label (self);
+		if (brasero_task_ctx_get_rate (self, &rate) == BRASERO_BURN_OK)
+			brasero_burn_trace_counter ("rate (B/s)", label, rate);
+		if (brasero_task_ctx_get_written (self, &written) == BRASERO_BURN_OK)
+			brasero_burn_trace_counter ("written (B)", label, written);
+		brasero_burn_trace_counter ("rate confidence", label, priv->confidence);
 	}
+
+	return new_action;
 }
 
 BraseroBurnResult
@@ -568,6 +863,48 @@ brasero_task_ctx_set_rate (BraseroTaskCtx *self,
 	return BRASERO_BURN_OK;
 }
 
+BraseroBurnResult
+brasero_task_ctx_set_buffer_fill (BraseroTaskCtx *self,
+				  gint fifo,
+				  gint buffer)
+{
+	const gchar *label;
+
+	g_return_val_if_fail (BRASERO_IS_TASK_CTX (self), BRASERO_BURN_ERR);
+
+	/* For the moment these are only used for performance tracing */
+	if (!brasero_burn_trace_enabled ())
+		return BRASERO_BURN_OK;
+
+	label = brasero_task_ctx_get_trace_label (self);
+	if (fifo >= 0)
+		brasero_burn_trace_counter ("fifo fill (%)", label, fifo);
+	if (buffer >= 0)
+		brasero_burn_trace_counter ("drive buffer fill (%)", label, buffer);
+
+	return BRASERO_BURN_OK;
+}
+
+BraseroBurnResult
+brasero_task_ctx_set_spool_depth (BraseroTaskCtx *self,
+				  guint tracks)
+{
+	BraseroTaskCtxPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TASK_CTX (self), BRASERO_BURN_ERR);
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	g_mutex_lock (priv->lock);
+	if (priv->spool_tracks != tracks)
+		priv->update_action_string = 1;
+
+	priv->spool_tracks = tracks;
+	g_mutex_unlock (priv->lock);
+
+	return BRASERO_BURN_OK;
+}
+
 /**
  * This is used by jobs that are imaging to tell what's going to be the output 
  * size for a particular track
@@ -719,10 +1056,7 @@ brasero_task_ctx_reset_progress (BraseroTaskCtx *self)
 	priv->last_elapsed = 0;
 	priv->last_progress = 0;
 
-	if (priv->times) {
-		g_slist_free (priv->times);
-		priv->times = NULL;
-	}
+	brasero_task_ctx_reset_estimate (self);
 
 	return BRASERO_BURN_OK;
 }
@@ -759,13 +1093,11 @@ brasero_task_ctx_set_current_action (BraseroTaskCtx *self,
 
 	priv->action_string = string ? g_strdup (string): NULL;
 
-	if (!force) {
-		g_slist_free (priv->times);
-		priv->times = NULL;
-	}
-
 	g_mutex_unlock (priv->lock);
 
+	if (!force)
+		brasero_task_ctx_reset_estimate (self);
+
 	return BRASERO_BURN_OK;
 }
 
@@ -786,6 +1118,32 @@ brasero_task_ctx_set_use_average (BraseroTaskCtx *self,
  * Used to retrieve the values for a given task
  */
 
+static BraseroBurnResult
+brasero_task_ctx_get_instant_rate (BraseroTaskCtx *self,
+				   guint64 *rate)
+{
+	BraseroTaskCtxPrivate *priv;
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	if (priv->current_elapsed <= priv->last_elapsed)
+		return BRASERO_BURN_NOT_READY;
+
+	if (priv->last_written > 0) {
+		*rate = (gdouble) (priv->track_bytes - priv->last_written) /
+			(gdouble) (priv->current_elapsed - priv->last_elapsed);
+	}
+	else if (priv->last_progress > 0.0) {
+		*rate = (gdouble)  priv->size *
+			(gdouble) (priv->progress - priv->last_progress) /
+			(gdouble) (priv->current_elapsed - priv->last_elapsed);
+	}
+	else
+		return BRASERO_BURN_NOT_READY;
+
+	return BRASERO_BURN_OK;
+}
+
 BraseroBurnResult
 brasero_task_ctx_get_rate (BraseroTaskCtx *self,
 			   guint64 *rate)
@@ -822,21 +1180,51 @@ brasero_task_ctx_get_rate (BraseroTaskCtx *self,
 			*rate = (gdouble) (priv->progress - priv->first_progress) * priv->size / elapsed;
 		else
 			return BRASERO_BURN_NOT_READY;
+
+		return BRASERO_BURN_OK;
 	}
-	else {
-		if (priv->last_written > 0) {			
-			*rate = (gdouble) (priv->track_bytes - priv->last_written) /
-				(gdouble) (priv->current_elapsed - priv->last_elapsed);
-		}
-		else if (priv->last_progress > 0.0) {
-			*rate = (gdouble)  priv->size *
-				(gdouble) (priv->progress - priv->last_progress) /
-				(gdouble) (priv->current_elapsed - priv->last_elapsed);
-		}
-		else
-			return BRASERO_BURN_NOT_READY;
+
+	/* Prefer the smoothed rate once there are enough samples */
+	if (priv->samples_num >= RATE_WINDOW_MIN) {
+		*rate = priv->smoothed_rate;
+		return BRASERO_BURN_OK;
 	}
 
+	return brasero_task_ctx_get_instant_rate (self, rate);
+}
+
+/**
+ * brasero_task_ctx_get_rate_estimate:
+ * @smoothed: the rate given by a linear fit over the last seconds
+ * @instant: the rate between the last two progress updates
+ * @confidence: between 0.0 (no idea) and 1.0 (constant rate for a while)
+ */
+
+BraseroBurnResult
+brasero_task_ctx_get_rate_estimate (BraseroTaskCtx *self,
+				    guint64 *smoothed,
+				    guint64 *instant,
+				    gdouble *confidence)
+{
+	BraseroTaskCtxPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TASK_CTX (self), BRASERO_BURN_ERR);
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	if (priv->samples_num < 2)
+		return BRASERO_BURN_NOT_READY;
+
+	g_mutex_lock (priv->lock);
+	if (smoothed)
+		*smoothed = priv->smoothed_rate;
+	if (confidence)
+		*confidence = priv->confidence;
+	g_mutex_unlock (priv->lock);
+
+	if (instant && brasero_task_ctx_get_instant_rate (self, instant) != BRASERO_BURN_OK)
+		*instant = priv->smoothed_rate;
+
 	return BRASERO_BURN_OK;
 }
 
@@ -845,19 +1233,28 @@ brasero_task_ctx_get_remaining_time (BraseroTaskCtx *self,
 				     long *remaining)
 {
 	BraseroTaskCtxPrivate *priv;
+	gdouble model = 0.0;
 	gdouble elapsed;
-	gint len;
+	guint samples;
 
 	g_return_val_if_fail (BRASERO_IS_TASK_CTX (self), BRASERO_BURN_ERR);
 	g_return_val_if_fail (remaining != NULL, BRASERO_BURN_ERR);
 
 	priv = BRASERO_TASK_CTX_PRIVATE (self);
 
+	/* Use the rate model if possible as it reacts better to drives
+	 * speeding up and is not thrown off by short stalls */
 	g_mutex_lock (priv->lock);
-	len = g_slist_length (priv->times);
+	if (brasero_task_ctx_get_model_remaining_time (self, &model)) {
+		g_mutex_unlock (priv->lock);
+		*remaining = model;
+		return BRASERO_BURN_OK;
+	}
+
+	samples = priv->total_time_samples;
 	g_mutex_unlock (priv->lock);
 
-	if (len < MAX_VALUE_AVERAGE)
+	if (samples < MAX_VALUE_AVERAGE || !priv->timer)
 		return BRASERO_BURN_NOT_READY;
 
 	elapsed = g_timer_elapsed (priv->timer, NULL);
@@ -917,6 +1314,7 @@ brasero_task_ctx_get_current_action_string (BraseroTaskCtx *self,
 					    gchar **string)
 {
 	BraseroTaskCtxPrivate *priv;
+	guint spool_tracks;
 
 	g_return_val_if_fail (string != NULL, BRASERO_BURN_ERR);
 
@@ -928,6 +1326,26 @@ brasero_task_ctx_get_current_action_string (BraseroTaskCtx *self,
 	*string = priv->action_string ? g_strdup (priv->action_string):
 					g_strdup (brasero_burn_action_to_string (priv->current_action));
 
+	/* This is set by the job from its thread */
+	g_mutex_lock (priv->lock);
+	spool_tracks = priv->spool_tracks;
+	g_mutex_unlock (priv->lock);
+
+	if (spool_tracks) {
+		gchar *tmp;
+
+		tmp = *string;
+		/* Translators: the first %s is the current action (like
+		 * "Writing tracks"); %i is the number of tracks that are
+		 * already decoded and waiting to be written */
+		*string = g_strdup_printf (ngettext ("%s (%i track ready ahead)",
+						     "%s (%i tracks ready ahead)",
+						     spool_tracks),
+					   tmp,
+					   spool_tracks);
+		g_free (tmp);
+	}
+
 	return BRASERO_BURN_OK;
 }
 
@@ -1036,12 +1454,9 @@ brasero_task_ctx_stop_progress (BraseroTaskCtx *self)
 		priv->action_string = NULL;
 	}
 
-	if (priv->times) {
-		g_slist_free (priv->times);
-		priv->times = NULL;
-	}
-
 	g_mutex_unlock (priv->lock);
+
+	brasero_task_ctx_reset_estimate (self);
 }
 
 static void
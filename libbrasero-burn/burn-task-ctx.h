@@ -102,6 +102,9 @@ brasero_task_ctx_get_session (BraseroTaskCtx *ctx);
 BraseroTaskAction
 brasero_task_ctx_get_action (BraseroTaskCtx *ctx);
 
+const gchar *
+brasero_task_ctx_get_trace_label (BraseroTaskCtx *ctx);
+
 BraseroBurnResult
 brasero_task_ctx_get_stored_tracks (BraseroTaskCtx *ctx,
 				    GSList **tracks);
@@ -138,7 +141,7 @@ BraseroBurnResult
 brasero_task_ctx_start_progress (BraseroTaskCtx *ctx,
 				 gboolean force);
 
-void
+gboolean
 brasero_task_ctx_report_progress (BraseroTaskCtx *ctx);
 
 void
@@ -175,6 +178,13 @@ BraseroBurnResult
 brasero_task_ctx_set_output_size_for_current_track (BraseroTaskCtx *ctx,
 						    goffset sectors,
 						    goffset bytes);
+BraseroBurnResult
+brasero_task_ctx_set_buffer_fill (BraseroTaskCtx *ctx,
+				  gint fifo,
+				  gint buffer);
+BraseroBurnResult
+brasero_task_ctx_set_spool_depth (BraseroTaskCtx *ctx,
+				  guint tracks);
 
 /**
  * task progress for library
@@ -184,6 +194,11 @@ BraseroBurnResult
 brasero_task_ctx_get_rate (BraseroTaskCtx *ctx,
 			   guint64 *rate);
 BraseroBurnResult
+brasero_task_ctx_get_rate_estimate (BraseroTaskCtx *ctx,
+				    guint64 *smoothed,
+				    guint64 *instant,
+				    gdouble *confidence);
+BraseroBurnResult
 brasero_task_ctx_get_remaining_time (BraseroTaskCtx *ctx,
 				     long *remaining);
 BraseroBurnResult
@@ -58,9 +58,14 @@ struct _BraseroTaskPrivate {
 	/* The loop for the task */
 	GMainLoop *loop;
 
-	/* used to poll for progress (every 0.5 sec) */
+	/* used to wait before retrying to start a job */
 	gint clock_id;
 
+	/* used to poll for progress (see brasero_task_clock_dispatch ()) */
+	gint64 next_tick;
+	gint64 phase_start;
+	guint tick_interval;
+
 	BraseroTaskItem *leader;
 	BraseroTaskItem *first;
 
@@ -77,6 +82,20 @@ static GObjectClass *parent_class = NULL;
 #define MAX_JOB_START_ATTEMPTS			5
 #define JOB_ATTEMPTS_WAIT_TIME			1
 
+/* Progress is polled every TASK_TICK_MIN ms at the start of an action; once
+ * it has lasted TASK_TICK_STABLE_TIME the interval grows up to TASK_TICK_MAX
+ * so that long writes do not wake up the process for nothing. All running
+ * tasks are polled from the same source; tasks due within TASK_TICK_SLACK ms
+ * are polled in the same dispatch. */
+#define TASK_TICK_MIN				250
+#define TASK_TICK_MAX				2000
+#define TASK_TICK_STABLE_TIME			(10 * G_USEC_PER_SEC)
+#define TASK_TICK_SLACK				(TASK_TICK_MIN / 2)
+
+static GSList *running_tasks = NULL;
+static guint tick_id = 0;
+static gint64 tick_deadline = 0;
+
 void
 brasero_task_add_item (BraseroTask *task, BraseroTaskItem *item)
 {
@@ -135,10 +154,10 @@ brasero_task_reset (BraseroTask *task)
 	brasero_task_reset_real (task);
 }
 
-static gboolean
-brasero_task_clock_tick (gpointer data)
+static void
+brasero_task_clock_tick (BraseroTask *task,
+			 gint64 now)
 {
-	BraseroTask *task = BRASERO_TASK (data);
 	BraseroTaskPrivate *priv;
 	BraseroTaskItem *item;
 
@@ -149,16 +168,115 @@ brasero_task_clock_tick (gpointer data)
 	 * progress/action changed so they can update the task on time */
 	for (item = priv->leader; item; item = brasero_task_item_previous (item)) {
 		BraseroTaskItemIFace *klass;
+		gint64 start;
 
 		klass = BRASERO_TASK_ITEM_GET_CLASS (item);
-		if (klass->clock_tick)
-			klass->clock_tick (item, BRASERO_TASK_CTX (task), NULL);
+		if (!klass->clock_tick)
+			continue;
+
+		start = g_get_monotonic_time ();
+		klass->clock_tick (item, BRASERO_TASK_CTX (task), NULL);
+		brasero_burn_trace_span ("clock tick", G_OBJECT_TYPE_NAME (item), NULL, start);
 	}
 
 	/* now call ctx to update progress */
-	brasero_task_ctx_report_progress (BRASERO_TASK_CTX (data));
+	if (brasero_task_ctx_report_progress (BRASERO_TASK_CTX (task))) {
+		/* a new action started: it may be a short one */
+		priv->phase_start = now;
+		priv->tick_interval = TASK_TICK_MIN;
+	}
+	else if (now - priv->phase_start >= TASK_TICK_STABLE_TIME)
+		priv->tick_interval = MIN (priv->tick_interval * 2, TASK_TICK_MAX);
+
+	priv->next_tick = now + (gint64) priv->tick_interval * 1000;
+}
+
+static gboolean brasero_task_clock_dispatch (gpointer NULL_data);
+
+static void
+brasero_task_clock_schedule (void)
+{
+	gint64 deadline = G_MAXINT64;
+	gint64 now;
+	GSList *iter;
+
+	for (iter = running_tasks; iter; iter = iter->next) {
+		BraseroTaskPrivate *priv;
+
+		priv = BRASERO_TASK_PRIVATE (iter->data);
+		deadline = MIN (deadline, priv->next_tick);
+	}
+
+	if (tick_id) {
+		if (tick_deadline == deadline)
+			return;
+
+		g_source_remove (tick_id);
+		tick_id = 0;
+	}
+
+	if (!running_tasks)
+		return;
+
+	now = g_get_monotonic_time ();
+	tick_deadline = deadline;
+	tick_id = g_timeout_add (MAX (deadline - now, 0) / 1000,
+				 brasero_task_clock_dispatch,
+				 NULL);
+}
+
+static gboolean
+brasero_task_clock_dispatch (gpointer NULL_data)
+{
+	GSList *tasks;
+	GSList *iter;
+	gint64 now;
+
+	tick_id = 0;
 
-	return TRUE;
+	/* A job may stop its task while it is polled */
+	tasks = g_slist_copy (running_tasks);
+	g_slist_foreach (tasks, (GFunc) g_object_ref, NULL);
+
+	now = g_get_monotonic_time ();
+	for (iter = tasks; iter; iter = iter->next) {
+		BraseroTaskPrivate *priv;
+
+		priv = BRASERO_TASK_PRIVATE (iter->data);
+		if (priv->next_tick <= now + TASK_TICK_SLACK * 1000)
+			brasero_task_clock_tick (iter->data, now);
+	}
+
+	g_slist_foreach (tasks, (GFunc) g_object_unref, NULL);
+	g_slist_free (tasks);
+
+	brasero_task_clock_schedule ();
+	return FALSE;
+}
+
+static void
+brasero_task_clock_start (BraseroTask *task)
+{
+	BraseroTaskPrivate *priv;
+
+	priv = BRASERO_TASK_PRIVATE (task);
+
+	priv->phase_start = g_get_monotonic_time ();
+	priv->tick_interval = TASK_TICK_MIN;
+	priv->next_tick = priv->phase_start + TASK_TICK_MIN * 1000;
+
+	running_tasks = g_slist_prepend (running_tasks, task);
+	brasero_task_clock_schedule ();
+}
+
+static void
+brasero_task_clock_stop (BraseroTask *task)
+{
+	if (!g_slist_find (running_tasks, task))
+		return;
+
+	running_tasks = g_slist_remove (running_tasks, task);
+	brasero_task_clock_schedule ();
 }
 
 /**
@@ -172,6 +290,7 @@ brasero_task_deactivate_item (BraseroTask *task,
 {
 	BraseroBurnResult result = BRASERO_BURN_OK;
 	BraseroTaskItemIFace *klass;
+	gint64 start;
 
 	if (!brasero_task_item_is_active (item)) {
 		BRASERO_BURN_LOG ("%s already stopped", G_OBJECT_TYPE_NAME (item));
@@ -181,12 +300,14 @@ brasero_task_deactivate_item (BraseroTask *task,
 	/* stop task for real now */
 	BRASERO_BURN_LOG ("stopping %s", G_OBJECT_TYPE_NAME (item));
 
+	start = g_get_monotonic_time ();
 	klass = BRASERO_TASK_ITEM_GET_CLASS (item);
 	if (klass->stop)
 		result = klass->stop (item,
 				      BRASERO_TASK_CTX (task),
 				      error);
 
+	brasero_burn_trace_span ("stop", G_OBJECT_TYPE_NAME (item), NULL, start);
 	BRASERO_BURN_LOG ("stopped %s", G_OBJECT_TYPE_NAME (item));
 	return result;
 }
@@ -282,6 +403,7 @@ brasero_task_start_item (BraseroTask *task,
 			 GError **error)
 {
 	guint attempts = 0;
+	gint64 start;
 	BraseroBurnResult result;
 	GError *ret_error = NULL;
 	BraseroTaskItemIFace *klass;
@@ -292,7 +414,9 @@ brasero_task_start_item (BraseroTask *task,
 
 	BRASERO_BURN_LOG ("::start method %s", G_OBJECT_TYPE_NAME (item));
 
+	start = g_get_monotonic_time ();
 	result = klass->start (item, &ret_error);
+	brasero_burn_trace_span ("start", G_OBJECT_TYPE_NAME (item), NULL, start);
 	while (result == BRASERO_BURN_RETRY) {
 		/* FIXME: a GError?? */
 		if (attempts >= MAX_JOB_START_ATTEMPTS) {
@@ -312,7 +436,10 @@ brasero_task_start_item (BraseroTask *task,
 			return result;
 
 		attempts ++;
+
+		start = g_get_monotonic_time ();
 		result = klass->start (item, &ret_error);
+		brasero_burn_trace_span ("start", G_OBJECT_TYPE_NAME (item), "retry", start);
 	}
 
 	if (ret_error)
@@ -328,6 +455,7 @@ brasero_task_activate_item (BraseroTask *task,
 {
 	BraseroTaskItemIFace *klass;
 	BraseroBurnResult result = BRASERO_BURN_OK;
+	gint64 start;
 
 	klass = BRASERO_TASK_ITEM_GET_CLASS (item);
 	if (!klass->activate)
@@ -335,7 +463,9 @@ brasero_task_activate_item (BraseroTask *task,
 
 	BRASERO_BURN_LOG ("::activate method %s", G_OBJECT_TYPE_NAME (item));
 
+	start = g_get_monotonic_time ();
 	result = klass->activate (item, BRASERO_TASK_CTX (task), error);
+	brasero_burn_trace_span ("activate", G_OBJECT_TYPE_NAME (item), NULL, start);
 	return result;
 }
 
@@ -429,19 +559,21 @@ brasero_task_run_loop (BraseroTask *self,
 	priv = BRASERO_TASK_PRIVATE (self);
 
 	brasero_task_ctx_report_progress (BRASERO_TASK_CTX (self));
-
-	priv->clock_id = g_timeout_add (500,
-					brasero_task_clock_tick,
-					self);
+	brasero_task_clock_start (self);
 
 	priv->loop = g_main_loop_new (NULL, FALSE);
 
 	BRASERO_BURN_LOG ("entering loop");
+	brasero_burn_trace_begin ("task",
+				  "run",
+				  brasero_task_ctx_get_trace_label (BRASERO_TASK_CTX (self)));
 
 	GDK_THREADS_LEAVE ();  
 	g_main_loop_run (priv->loop);
 	GDK_THREADS_ENTER ();
 
+	brasero_burn_trace_end ("task", "run");
+	brasero_burn_trace_flush ();
 	BRASERO_BURN_LOG ("got out of loop");
 	g_main_loop_unref (priv->loop);
 	priv->loop = NULL;
@@ -452,10 +584,7 @@ brasero_task_run_loop (BraseroTask *self,
 	}
 
 	/* stop all progress reporting thing */
-	if (priv->clock_id) {
-		g_source_remove (priv->clock_id);
-		priv->clock_id = 0;
-	}
+	brasero_task_clock_stop (self);
 
 	if (priv->retval == BRASERO_BURN_OK
 	&&  brasero_task_ctx_get_progress (BRASERO_TASK_CTX (self), NULL) == BRASERO_BURN_OK) {
@@ -709,6 +838,8 @@ brasero_task_finalize (GObject *object)
 	cobj = BRASERO_TASK (object);
 	priv = BRASERO_TASK_PRIVATE (cobj);
 
+	brasero_task_clock_stop (cobj);
+
 	if (priv->leader) {
 		g_object_unref (priv->leader);
 		priv->leader = NULL;
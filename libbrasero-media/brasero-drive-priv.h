@@ -29,6 +29,7 @@
  */
 
 #include "brasero-drive.h"
+#include "scsi-device.h"
 
 #ifndef _BURN_DRIVE_PRIV_H_
 #define _BURN_DRIVE_PRIV_H_
@@ -41,6 +42,12 @@ brasero_drive_probing (BraseroDrive *drive);
 gboolean
 brasero_medium_probing (BraseroMedium *medium);
 
+gboolean
+brasero_device_wait_media_event (BraseroDeviceHandle *handle,
+				 GMutex *mutex,
+				 GCond *cond,
+				 gulong timeout);
+
 G_END_DECLS
 
 #endif
@@ -119,6 +119,10 @@ G_DEFINE_TYPE (BraseroDrive, brasero_drive, G_TYPE_OBJECT);
 
 #define BRASERO_DRIVE_OPEN_ATTEMPTS			5
 
+/* In microseconds */
+#define BRASERO_DEVICE_EVENT_POLL_INTERVAL		200000
+#define BRASERO_DEVICE_OPEN_FIRST_DELAY			100000
+
 static void
 brasero_drive_probe_inside (BraseroDrive *drive);
 
@@ -914,6 +918,64 @@ brasero_drive_update_medium (BraseroDrive *drive)
 	}
 }
 
+/**
+ * This is not public API. Defined in brasero-drive-priv.h.
+ * Used by the probing threads to wait for a busy drive or a drive that is
+ * not ready yet. Rather than sleeping for a fixed time, the drive is polled
+ * for media events (GET EVENT STATUS NOTIFICATION) and the wait ends as soon
+ * as one is reported. Signalling @cond (on cancellation) ends it as well.
+ * Returns FALSE if @cond was signalled.
+ */
+gboolean
+brasero_device_wait_media_event (BraseroDeviceHandle *handle,
+				 GMutex *mutex,
+				 GCond *cond,
+				 gulong timeout)
+{
+	BraseroScsiMediaEventStatus status;
+	gboolean supported;
+	gulong waited = 0;
+
+	supported = (handle != NULL);
+	while (waited < timeout) {
+		GTimeVal wait_time;
+		gboolean signalled;
+		gulong step;
+
+		/* Without media events wait for the whole time */
+		step = timeout - waited;
+		if (supported)
+			step = MIN (step, BRASERO_DEVICE_EVENT_POLL_INTERVAL);
+
+		g_get_current_time (&wait_time);
+		g_time_val_add (&wait_time, step);
+
+		g_mutex_lock (mutex);
+		signalled = g_cond_timed_wait (cond, mutex, &wait_time);
+		g_mutex_unlock (mutex);
+
+		if (signalled)
+			return FALSE;
+
+		waited += step;
+		if (!supported)
+			continue;
+
+		if (brasero_mmc2_get_media_event (handle, &status, NULL) != BRASERO_SCSI_OK) {
+			BRASERO_MEDIA_LOG ("Media events not supported");
+			supported = FALSE;
+			continue;
+		}
+
+		if (status.desc.event_code != BRASERO_SCSI_MEDIA_EVENT_NO_CHANGE) {
+			BRASERO_MEDIA_LOG ("Media event %i", status.desc.event_code);
+			break;
+		}
+	}
+
+	return TRUE;
+}
+
 static gboolean
 brasero_drive_probed_inside (gpointer data)
 {
@@ -936,8 +998,8 @@ brasero_drive_probed_inside (gpointer data)
 static gpointer
 brasero_drive_probe_inside_thread (gpointer data)
 {
-	gint counter = 0;
-	GTimeVal wait_time;
+	gulong delay = BRASERO_DEVICE_OPEN_FIRST_DELAY;
+	gulong waited = 0;
 	const gchar *device;
 	BraseroScsiErrCode code;
 	BraseroDrivePrivate *priv;
@@ -947,22 +1009,27 @@ brasero_drive_probe_inside_thread (gpointer data)
 	priv = BRASERO_DRIVE_PRIVATE (drive);
 
 	/* the drive might be busy (a burning is going on) so we don't block
-	 * but we re-try to open it every second */
+	 * but we re-try to open it; first after a short time since it is
+	 * often released quickly then less and less often */
 	device = brasero_drive_get_device (drive);
 	BRASERO_MEDIA_LOG ("Trying to open device %s", device);
 
 	priv->has_medium = FALSE;
 
 	handle = brasero_device_handle_open (device, FALSE, &code);
-	while (!handle && counter <= BRASERO_DRIVE_OPEN_ATTEMPTS) {
-		sleep (1);
+	while (!handle && waited <= BRASERO_DRIVE_OPEN_ATTEMPTS * G_USEC_PER_SEC) {
+		brasero_device_wait_media_event (NULL,
+						 priv->mutex,
+						 priv->cond_probe,
+						 delay);
 
 		if (priv->probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Open () cancelled");
 			goto end;
 		}
 
-		counter ++;
+		waited += delay;
+		delay = MIN (delay * 2, G_USEC_PER_SEC);
 		handle = brasero_device_handle_open (device, FALSE, &code);
 	}
 
@@ -993,14 +1060,11 @@ brasero_drive_probe_inside_thread (gpointer data)
 			goto end;
 		}
 
-		g_get_current_time (&wait_time);
-		g_time_val_add (&wait_time, 2000000);
-
-		g_mutex_lock (priv->mutex);
-		g_cond_timed_wait (priv->cond_probe,
-		                   priv->mutex,
-		                   &wait_time);
-		g_mutex_unlock (priv->mutex);
+		/* Retry as soon as the drive reports a change */
+		brasero_device_wait_media_event (handle,
+						 priv->mutex,
+						 priv->cond_probe,
+						 2 * G_USEC_PER_SEC);
 
 		if (priv->probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Device probing cancelled");
@@ -1309,8 +1373,8 @@ brasero_drive_get_caps_2A (BraseroDrive *self,
 static gpointer
 brasero_drive_probe_thread (gpointer data)
 {
-	gint counter = 0;
-	GTimeVal wait_time;
+	gulong delay = BRASERO_DEVICE_OPEN_FIRST_DELAY;
+	gulong waited = 0;
 	const gchar *device;
 	BraseroScsiResult res;
 	BraseroScsiInquiry hdr;
@@ -1327,15 +1391,19 @@ brasero_drive_probe_thread (gpointer data)
 	BRASERO_MEDIA_LOG ("Trying to open device %s", device);
 
 	handle = brasero_device_handle_open (device, FALSE, &code);
-	while (!handle && counter <= BRASERO_DRIVE_OPEN_ATTEMPTS) {
-		sleep (1);
+	while (!handle && waited <= BRASERO_DRIVE_OPEN_ATTEMPTS * G_USEC_PER_SEC) {
+		brasero_device_wait_media_event (NULL,
+						 priv->mutex,
+						 priv->cond_probe,
+						 delay);
 
 		if (priv->initial_probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Open () cancelled");
 			goto end;
 		}
 
-		counter ++;
+		waited += delay;
+		delay = MIN (delay * 2, G_USEC_PER_SEC);
 		handle = brasero_device_handle_open (device, FALSE, &code);
 	}
 
@@ -1361,14 +1429,11 @@ brasero_drive_probe_thread (gpointer data)
 			goto end;
 		}
 
-		g_get_current_time (&wait_time);
-		g_time_val_add (&wait_time, 2000000);
-
-		g_mutex_lock (priv->mutex);
-		g_cond_timed_wait (priv->cond_probe,
-		                   priv->mutex,
-		                   &wait_time);
-		g_mutex_unlock (priv->mutex);
+		/* Retry as soon as the drive reports a change */
+		brasero_device_wait_media_event (handle,
+						 priv->mutex,
+						 priv->cond_probe,
+						 2 * G_USEC_PER_SEC);
 
 		if (priv->initial_probe_cancelled) {
 			brasero_device_handle_close (handle);
@@ -66,6 +66,21 @@ brasero_media_message (const gchar *location,
 		       const gchar *format,
 		       ...);
 
+/**
+ * Used to record how long each SCSI command took when tracing burns
+ */
+
+typedef void (*BraseroMediaTraceFunc) (guchar opcode,
+				       gint64 start,
+				       gint64 duration);
+
+void
+brasero_media_library_set_trace_func (BraseroMediaTraceFunc func);
+
+void
+brasero_media_trace_command (guchar opcode,
+			     gint64 start);
+
 G_END_DECLS
 
 #endif /* _BURN_MEDIA_PRIV_H_ */
@@ -42,6 +42,7 @@
 #include "brasero-media-private.h"
 
 static gboolean debug = 0;
+static BraseroMediaTraceFunc trace_func = NULL;
 
 #define BRASERO_MEDIUM_TRUE_RANDOM_WRITABLE(media)				\
 	(BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_DVDRW_RESTRICTED) ||		\
@@ -62,6 +63,22 @@ brasero_media_library_set_debug (gboolean value)
 	debug = value;
 }
 
+void
+brasero_media_library_set_trace_func (BraseroMediaTraceFunc func)
+{
+	trace_func = func;
+}
+
+void
+brasero_media_trace_command (guchar opcode,
+			     gint64 start)
+{
+	if (!trace_func)
+		return;
+
+	trace_func (opcode, start, g_get_monotonic_time () - start);
+}
+
 static GSList *
 brasero_media_add_to_list (GSList *retval,
 			   BraseroMedia media)
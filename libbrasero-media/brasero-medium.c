@@ -173,6 +173,9 @@ static gulong medium_signals [LAST_SIGNAL] = {0, };
 
 #define BRASERO_MEDIUM_OPEN_ATTEMPTS			5
 
+/* In microseconds */
+#define BRASERO_MEDIUM_OPEN_FIRST_DELAY			100000
+
 static GObjectClass* parent_class = NULL;
 
 
@@ -2999,8 +3002,8 @@ brasero_medium_probed (gpointer data)
 static gpointer
 brasero_medium_probe_thread (gpointer self)
 {
-	gint counter = 0;
-	GTimeVal wait_time;
+	gulong delay = BRASERO_MEDIUM_OPEN_FIRST_DELAY;
+	gulong waited = 0;
 	const gchar *device;
 	BraseroScsiErrCode code;
 	BraseroMediumPrivate *priv;
@@ -3011,18 +3014,23 @@ brasero_medium_probe_thread (gpointer self)
 	priv->info = BRASERO_MEDIUM_BUSY;
 
 	/* the drive might be busy (a burning is going on) so we don't block
-	 * but we re-try to open it every second */
+	 * but we re-try to open it; first after a short time since it is
+	 * often released quickly then less and less often */
 	device = brasero_drive_get_device (priv->drive);
 	BRASERO_MEDIA_LOG ("Trying to open device %s", device);
 
 	handle = brasero_device_handle_open (device, FALSE, &code);
-	while (!handle && counter <= BRASERO_MEDIUM_OPEN_ATTEMPTS) {
-		sleep (1);
+	while (!handle && waited <= BRASERO_MEDIUM_OPEN_ATTEMPTS * G_USEC_PER_SEC) {
+		brasero_device_wait_media_event (NULL,
+						 priv->mutex,
+						 priv->cond_probe,
+						 delay);
 
 		if (priv->probe_cancelled)
 			goto end;
 
-		counter ++;
+		waited += delay;
+		delay = MIN (delay * 2, G_USEC_PER_SEC);
 		handle = brasero_device_handle_open (device, FALSE, &code);
 	}
 
@@ -3055,14 +3063,11 @@ brasero_medium_probe_thread (gpointer self)
 			goto end;
 		}
 
-		g_get_current_time (&wait_time);
-		g_time_val_add (&wait_time, 2000000);
-
-		g_mutex_lock (priv->mutex);
-		g_cond_timed_wait (priv->cond_probe,
-		                   priv->mutex,
-		                   &wait_time);
-		g_mutex_unlock (priv->mutex);
+		/* Retry as soon as the drive reports a change */
+		brasero_device_wait_media_event (handle,
+						 priv->mutex,
+						 priv->cond_probe,
+						 2 * G_USEC_PER_SEC);
 
 		if (priv->probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Device probing cancelled");
@@ -53,8 +53,16 @@ struct _BraseroIsoCtx {
 
 	gchar buffer [ISO9660_BLOCK_SIZE];
 	gint offset;
+	gint address;
 	BraseroVolSrc *vol;
 
+	/* When set, blocks are read ISO9660_READAHEAD_BLOCKS at a time (but
+	 * never beyond the end of the volume) and served from there */
+	gchar *readahead;
+	gint readahead_address;
+	gint readahead_num;
+	gint vol_blocks;
+
 	gchar *spare_record;
 
 	guint64 data_blocks;
@@ -132,6 +140,10 @@ typedef enum {
 
 #define ISO9660_BYTES_TO_BLOCKS(size)			BRASERO_BYTES_TO_SECTORS ((size), ISO9660_BLOCK_SIZE)
 
+/* 64 KiB: directory extents are usually written next to each other so one
+ * read covers a lot of small directories */
+#define ISO9660_READAHEAD_BLOCKS			32
+
 static GList *
 brasero_iso9660_load_directory_records (BraseroIsoCtx *ctx,
 					BraseroVolFile *parent,
@@ -199,6 +211,44 @@ brasero_iso9660_get_label (const gchar *block,
 	return TRUE;	
 }
 
+static BraseroIsoResult
+brasero_iso9660_read_block (BraseroIsoCtx *ctx, gint address)
+{
+	if (ctx->readahead) {
+		if (address < ctx->readahead_address
+		||  address >= ctx->readahead_address + ctx->readahead_num) {
+			gint num = 1;
+
+			if (ctx->vol_blocks > address)
+				num = MIN (ISO9660_READAHEAD_BLOCKS, ctx->vol_blocks - address);
+
+			ctx->readahead_num = 0;
+			if (BRASERO_VOL_SRC_SEEK (ctx->vol, address, SEEK_SET, &(ctx->error)) == -1)
+				return BRASERO_ISO_ERROR;
+
+			if (!BRASERO_VOL_SRC_READ (ctx->vol, ctx->readahead, num, &(ctx->error)))
+				return BRASERO_ISO_ERROR;
+
+			ctx->readahead_address = address;
+			ctx->readahead_num = num;
+		}
+
+		memcpy (ctx->buffer,
+			ctx->readahead + (address - ctx->readahead_address) * ISO9660_BLOCK_SIZE,
+			ISO9660_BLOCK_SIZE);
+	}
+	else {
+		if (BRASERO_VOL_SRC_SEEK (ctx->vol, address, SEEK_SET, &(ctx->error)) == -1)
+			return BRASERO_ISO_ERROR;
+
+		if (!BRASERO_VOL_SRC_READ (ctx->vol, ctx->buffer, 1, &(ctx->error)))
+			return BRASERO_ISO_ERROR;
+	}
+
+	ctx->address = address;
+	return BRASERO_ISO_OK;
+}
+
 static BraseroIsoResult
 brasero_iso9660_seek (BraseroIsoCtx *ctx, gint address)
 {
@@ -209,13 +259,7 @@ brasero_iso9660_seek (BraseroIsoCtx *ctx, gint address)
 	 * by its address member. In a set of directory records the first two 
 	 * records are: '.' (id == 0) and '..' (id == 1). So since we've got
 	 * the address of the set load the block. */
-	if (BRASERO_VOL_SRC_SEEK (ctx->vol, address, SEEK_SET, &(ctx->error)) == -1)
-		return BRASERO_ISO_ERROR;
-
-	if (!BRASERO_VOL_SRC_READ (ctx->vol, ctx->buffer, 1, &(ctx->error)))
-		return BRASERO_ISO_ERROR;
-
-	return BRASERO_ISO_OK;
+	return brasero_iso9660_read_block (ctx, address);
 }
 
 static BraseroIsoResult
@@ -224,10 +268,9 @@ brasero_iso9660_next_block (BraseroIsoCtx *ctx)
 	ctx->offset = 0;
 	ctx->num_blocks ++;
 
-	if (!BRASERO_VOL_SRC_READ (ctx->vol, ctx->buffer, 1, &(ctx->error)))
-		return BRASERO_ISO_ERROR;
-
-	return BRASERO_ISO_OK;
+	/* NOTE: don't rely on the position of the source as reading a SUSP
+	 * continuation area may have moved it */
+	return brasero_iso9660_read_block (ctx, ctx->address + 1);
 }
 
 static gboolean
@@ -1056,6 +1099,130 @@ brasero_iso9660_get_file (BraseroVolSrc *vol,
 	return entry;
 }
 
+static gint
+brasero_iso9660_address_compare (gconstpointer a,
+				 gconstpointer b,
+				 gpointer user_data)
+{
+	guint address_a = GPOINTER_TO_UINT (a);
+	guint address_b = GPOINTER_TO_UINT (b);
+
+	return (address_a > address_b) - (address_a < address_b);
+}
+
+/**
+ * Reads all the directories of a volume in increasing block order, which
+ * avoids seeking back and forth on a disc, with large reads. @func is called
+ * for each directory (root first) with its contents; it takes ownership of
+ * the list. If it returns FALSE the walk stops.
+ */
+
+gboolean
+brasero_iso9660_walk_directories (BraseroVolSrc *vol,
+				  const gchar *vol_desc,
+				  BraseroIsoDirectoryFunc func,
+				  gpointer user_data,
+				  GError **error)
+{
+	BraseroIsoDirRec *record = NULL;
+	BraseroIsoPrimary *primary;
+	GHashTable *visited;
+	GSequence *queue;
+	BraseroIsoCtx ctx;
+	gboolean retval = TRUE;
+	guint address;
+
+	primary = (BraseroIsoPrimary *) vol_desc;
+	address = brasero_iso9660_get_733_val (primary->root_rec->address);
+
+	brasero_iso9660_ctx_init (&ctx, vol);
+	ctx.vol_blocks = brasero_iso9660_get_733_val (primary->vol_size);
+	ctx.readahead = g_malloc (ISO9660_READAHEAD_BLOCKS * ISO9660_BLOCK_SIZE);
+
+	if (brasero_iso9660_get_first_directory_record (&ctx, &record, address) != BRASERO_ISO_OK) {
+		retval = FALSE;
+		goto end;
+	}
+
+	brasero_iso9660_check_SUSP_RR_use (&ctx, record);
+
+	/* Directories are read in the order of their addresses. Keep track of
+	 * those already queued in case the volume is corrupted and loops. */
+	queue = g_sequence_new (NULL);
+	visited = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	g_sequence_insert_sorted (queue,
+				  GUINT_TO_POINTER (address),
+				  brasero_iso9660_address_compare,
+				  NULL);
+	g_hash_table_insert (visited, GUINT_TO_POINTER (address), GINT_TO_POINTER (1));
+
+	while (g_sequence_get_length (queue)) {
+		GSequenceIter *first;
+		GList *children;
+		GList *iter;
+
+		first = g_sequence_get_begin_iter (queue);
+		address = GPOINTER_TO_UINT (g_sequence_get (first));
+		g_sequence_remove (first);
+
+		if (brasero_iso9660_get_first_directory_record (&ctx, &record, address) != BRASERO_ISO_OK) {
+			retval = FALSE;
+			break;
+		}
+
+		children = brasero_iso9660_load_directory_records (&ctx,
+								   NULL,
+								   record,
+								   FALSE);
+		if (!children && ctx.error) {
+			retval = FALSE;
+			break;
+		}
+
+		for (iter = children; iter; iter = iter->next) {
+			BraseroVolFile *file;
+			gpointer key;
+
+			file = iter->data;
+			if (!file->isdir)
+				continue;
+
+			key = GUINT_TO_POINTER (file->specific.dir.address);
+			if (g_hash_table_lookup (visited, key))
+				continue;
+
+			g_hash_table_insert (visited, key, GINT_TO_POINTER (1));
+			g_sequence_insert_sorted (queue,
+						  key,
+						  brasero_iso9660_address_compare,
+						  NULL);
+		}
+
+		if (!func (address, children, g_sequence_get_length (queue), user_data))
+			break;
+	}
+
+	g_hash_table_destroy (visited);
+	g_sequence_free (queue);
+
+end:
+
+	if (ctx.spare_record)
+		g_free (ctx.spare_record);
+
+	g_free (ctx.readahead);
+
+	if (ctx.error) {
+		if (error)
+			g_propagate_error (error, ctx.error);
+		else
+			g_error_free (ctx.error);
+	}
+
+	return retval;
+}
+
 GList *
 brasero_iso9660_get_directory_contents (BraseroVolSrc *vol,
 					const gchar *vol_desc,
@@ -51,6 +51,8 @@ typedef enum {
 	BRASERO_ISO_FLAG_RR	= 1
 } BraseroIsoFlag;
 
+typedef BraseroVolDirectoryFunc BraseroIsoDirectoryFunc;
+
 gboolean
 brasero_iso9660_is_primary_descriptor (const gchar *buffer,
 				       GError **error);
@@ -80,6 +82,13 @@ brasero_iso9660_get_directory_contents (BraseroVolSrc *vol,
 					gint address,
 					GError **error);
 
+gboolean
+brasero_iso9660_walk_directories (BraseroVolSrc *vol,
+				  const gchar *vol_desc,
+				  BraseroIsoDirectoryFunc func,
+				  gpointer user_data,
+				  GError **error);
+
 BraseroVolFile *
 brasero_iso9660_get_file (BraseroVolSrc *src,
 			  const gchar *path,
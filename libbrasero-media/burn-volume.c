@@ -211,6 +211,31 @@ brasero_volume_load_directory_contents (BraseroVolSrc *vol,
 						       error);
 }
 
+gboolean
+brasero_volume_walk_directories (BraseroVolSrc *vol,
+				 gint64 session_block,
+				 BraseroVolDirectoryFunc func,
+				 gpointer user_data,
+				 GError **error)
+{
+	gchar buffer [ISO9660_BLOCK_SIZE];
+
+	if (BRASERO_VOL_SRC_SEEK (vol, session_block, SEEK_SET, error) == -1)
+		return FALSE;
+
+	if (!brasero_volume_get_primary_from_file (vol, buffer, error))
+		return FALSE;
+
+	if (!brasero_iso9660_is_primary_descriptor (buffer, error))
+		return FALSE;
+
+	return brasero_iso9660_walk_directories (vol,
+						 buffer,
+						 func,
+						 user_data,
+						 error);
+}
+
 BraseroVolFile *
 brasero_volume_get_file (BraseroVolSrc *vol,
 			 const gchar *path,
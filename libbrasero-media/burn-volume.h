@@ -109,6 +109,22 @@ brasero_volume_load_directory_contents (BraseroVolSrc *vol,
 					gint64 block,
 					GError **error);
 
+/**
+ * Called for every directory with its address, its contents (to be freed by
+ * the callee) and the number of directories still to be read
+ */
+typedef gboolean (*BraseroVolDirectoryFunc) (guint address,
+					     GList *children,
+					     guint remaining,
+					     gpointer user_data);
+
+gboolean
+brasero_volume_walk_directories (BraseroVolSrc *vol,
+				 gint64 session_block,
+				 BraseroVolDirectoryFunc func,
+				 gpointer user_data,
+				 GError **error);
+
 
 #define BRASERO_VOLUME_FILE_NAME(file)			((file)->rr_name?(file)->rr_name:(file)->name)
 #define BRASERO_VOLUME_FILE_SIZE(file)			((file)->isdir?0:(file)->specific.file.size_bytes)
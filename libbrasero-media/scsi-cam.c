@@ -84,7 +84,9 @@ brasero_scsi_command_issue_sync (gpointer command,
 				 int size,
 				 BraseroScsiErrCode *error)
 {
+	int res;
 	int timeout;
+	gint64 start;
 	BraseroScsiCmd *cmd;
 	union ccb cam_ccb;
 	int direction = -1;
@@ -119,7 +121,11 @@ brasero_scsi_command_issue_sync (gpointer command,
 	memcpy (cam_ccb.csio.cdb_io.cdb_bytes, cmd->cmd,
 		BRASERO_SCSI_CMD_MAX_LEN);
 
-	if (cam_send_ccb (cmd->handle->cam, &cam_ccb) == -1) {
+	start = g_get_monotonic_time ();
+	res = cam_send_ccb (cmd->handle->cam, &cam_ccb);
+	brasero_media_trace_command (cmd->info->opcode, start);
+
+	if (res == -1) {
 		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
 		return BRASERO_SCSI_FAILURE;
 	}
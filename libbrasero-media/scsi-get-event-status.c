@@ -0,0 +1,126 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "scsi-mmc2.h"
+
+#include "scsi-error.h"
+#include "scsi-utils.h"
+#include "scsi-base.h"
+#include "scsi-command.h"
+#include "scsi-opcodes.h"
+#include "scsi-get-event-status.h"
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+
+struct _BraseroScsiGetEventStatusCDB {
+	uchar opcode;
+
+	uchar polled		:1;
+	uchar res1		:7;
+
+	uchar res2		[2];
+	uchar class_request;
+	uchar res3		[2];
+	uchar len		[2];
+
+	uchar ctl;
+};
+
+#else
+
+struct _BraseroScsiGetEventStatusCDB {
+	uchar opcode;
+
+	uchar res1		:7;
+	uchar polled		:1;
+
+	uchar res2		[2];
+	uchar class_request;
+	uchar res3		[2];
+	uchar len		[2];
+
+	uchar ctl;
+};
+
+#endif
+
+typedef struct _BraseroScsiGetEventStatusCDB BraseroScsiGetEventStatusCDB;
+
+BRASERO_SCSI_COMMAND_DEFINE (BraseroScsiGetEventStatusCDB,
+			     GET_EVENT_STATUS_NOTIFICATION,
+			     BRASERO_SCSI_READ);
+
+/**
+ * Only the polled mode is supported (asynchronous mode is not available for
+ * ATAPI devices) and only media events are requested. Reading the event
+ * consumes it so that the next call reports the next change.
+ */
+
+BraseroScsiResult
+brasero_mmc2_get_media_event (BraseroDeviceHandle *handle,
+			      BraseroScsiMediaEventStatus *status,
+			      BraseroScsiErrCode *error)
+{
+	BraseroScsiGetEventStatusCDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+	g_return_val_if_fail (status != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_scsi_command_new (&info, handle);
+	cdb->polled = 1;
+	cdb->class_request = BRASERO_SCSI_EVENT_CLASS_MEDIA;
+	BRASERO_SET_16 (cdb->len, sizeof (BraseroScsiMediaEventStatus));
+
+	memset (status, 0, sizeof (BraseroScsiMediaEventStatus));
+	res = brasero_scsi_command_issue_sync (cdb,
+					       status,
+					       sizeof (BraseroScsiMediaEventStatus),
+					       error);
+	brasero_scsi_command_free (cdb);
+
+	if (res != BRASERO_SCSI_OK)
+		return res;
+
+	/* NEA (No Event Available) is set when the drive doesn't support
+	 * media events; the descriptor is not valid then. */
+	if (status->hdr.nea
+	|| (status->hdr.notification_class & 0x07) != BRASERO_SCSI_EVENT_NOTIFICATION_MEDIA) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	return BRASERO_SCSI_OK;
+}
@@ -0,0 +1,112 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+
+#ifndef _SCSI_GET_EVENT_STATUS_H
+#define _SCSI_GET_EVENT_STATUS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Notification class requested (bit field) and returned (value) */
+#define BRASERO_SCSI_EVENT_CLASS_MEDIA			0x10
+#define BRASERO_SCSI_EVENT_NOTIFICATION_MEDIA		0x04
+
+typedef enum {
+BRASERO_SCSI_MEDIA_EVENT_NO_CHANGE		= 0x00,
+BRASERO_SCSI_MEDIA_EVENT_EJECT_REQUEST		= 0x01,
+BRASERO_SCSI_MEDIA_EVENT_NEW_MEDIA		= 0x02,
+BRASERO_SCSI_MEDIA_EVENT_MEDIA_REMOVAL		= 0x03,
+BRASERO_SCSI_MEDIA_EVENT_MEDIA_CHANGED		= 0x04,
+BRASERO_SCSI_MEDIA_EVENT_BG_FORMAT_COMPLETED	= 0x05,
+BRASERO_SCSI_MEDIA_EVENT_BG_FORMAT_RESTARTED	= 0x06
+} BraseroScsiMediaEventCode;
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+
+struct _BraseroScsiEventStatusHdr {
+	uchar len			[2];
+
+	uchar notification_class	:3;
+	uchar res1			:4;
+	uchar nea			:1;
+
+	uchar supported_classes;
+};
+
+struct _BraseroScsiMediaEventDesc {
+	uchar event_code		:4;
+	uchar res1			:4;
+
+	uchar door_open			:1;
+	uchar media_present		:1;
+	uchar res2			:6;
+
+	uchar start_slot;
+	uchar end_slot;
+};
+
+#else
+
+struct _BraseroScsiEventStatusHdr {
+	uchar len			[2];
+
+	uchar nea			:1;
+	uchar res1			:4;
+	uchar notification_class	:3;
+
+	uchar supported_classes;
+};
+
+struct _BraseroScsiMediaEventDesc {
+	uchar res1			:4;
+	uchar event_code		:4;
+
+	uchar res2			:6;
+	uchar media_present		:1;
+	uchar door_open			:1;
+
+	uchar start_slot;
+	uchar end_slot;
+};
+
+#endif
+
+typedef struct _BraseroScsiEventStatusHdr BraseroScsiEventStatusHdr;
+typedef struct _BraseroScsiMediaEventDesc BraseroScsiMediaEventDesc;
+
+struct _BraseroScsiMediaEventStatus {
+	BraseroScsiEventStatusHdr hdr;
+	BraseroScsiMediaEventDesc desc;
+};
+typedef struct _BraseroScsiMediaEventStatus BraseroScsiMediaEventStatus;
+
+G_END_DECLS
+
+#endif /* _SCSI_GET_EVENT_STATUS_H */
@@ -37,6 +37,7 @@
 #include "scsi-get-configuration.h"
 #include "scsi-read-disc-structure.h"
 #include "scsi-read-format-capacities.h"
+#include "scsi-get-event-status.h"
 
 #ifndef _SCSI_MMC2_H
 #define _SCSI_MMC2_H
@@ -73,6 +74,11 @@ brasero_mmc2_read_format_capacities (BraseroDeviceHandle *handle,
 				     BraseroScsiFormatCapacitiesHdr **data,
 				     int *size,
 				     BraseroScsiErrCode *error);
+
+BraseroScsiResult
+brasero_mmc2_get_media_event (BraseroDeviceHandle *handle,
+			      BraseroScsiMediaEventStatus *status,
+			      BraseroScsiErrCode *error);
 G_END_DECLS
 
 #endif /* _SCSI_MMC2_H */
@@ -106,6 +106,7 @@ brasero_scsi_command_issue_sync (gpointer command,
 	scsireq_t req;
 	BraseroScsiResult res;
 	BraseroScsiCmd *cmd;
+	gint64 start;
 
 	cmd = command;
 	brasero_sg_command_setup (&req,
@@ -113,7 +114,9 @@ brasero_scsi_command_issue_sync (gpointer command,
 				  buffer,
 				  size);
 
+	start = g_get_monotonic_time ();
 	res = ioctl (cmd->handle->fd, SCIOCCOMMAND, &req);
+	brasero_media_trace_command (cmd->info->opcode, start);
 	if (res == -1) {
 		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
 		return BRASERO_SCSI_FAILURE;
@@ -76,6 +76,7 @@ G_BEGIN_DECLS
 #define BRASERO_READ_CAPACITY_OPCODE			0x25
 #define BRASERO_READ_FORMAT_CAPACITIES_OPCODE		0x23
 #define BRASERO_READ10_OPCODE				0x28
+#define BRASERO_GET_EVENT_STATUS_NOTIFICATION_OPCODE	0x4A
 
 /**
  *	MMC3
@@ -109,6 +109,7 @@ brasero_scsi_command_issue_sync (gpointer command,
 	struct sg_io_hdr transport;
 	BraseroScsiResult res;
 	BraseroScsiCmd *cmd;
+	gint64 start;
 
 	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
 
@@ -121,7 +122,9 @@ brasero_scsi_command_issue_sync (gpointer command,
 
 	/* NOTE on SG_IO: only for TEST UNIT READY, REQUEST/MODE SENSE, INQUIRY,
 	 * READ CAPACITY, READ BUFFER, READ and LOG SENSE are allowed with it */
+	start = g_get_monotonic_time ();
 	res = ioctl (cmd->handle->fd, SG_IO, &transport);
+	brasero_media_trace_command (cmd->info->opcode, start);
 	if (res) {
 		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
 		return BRASERO_SCSI_FAILURE;
@@ -100,6 +100,7 @@ brasero_scsi_command_issue_sync (gpointer command,
 	struct uscsi_cmd transport;
 	int res;
 	BraseroScsiCmd *cmd;
+	gint64 start;
 	short timeout = 4 * 60;
 
 	memset (&sense_buffer, 0, BRASERO_SENSE_DATA_SIZE);
@@ -126,7 +127,9 @@ brasero_scsi_command_issue_sync (gpointer command,
 
 	/* NOTE only for TEST UNIT READY, REQUEST/MODE SENSE, INQUIRY, READ
 	 * CAPACITY, READ BUFFER, READ and LOG SENSE are allowed with it */
+	start = g_get_monotonic_time ();
 	res = ioctl (cmd->handle->fd, USCSICMD, &transport);
+	brasero_media_trace_command (cmd->info->opcode, start);
 
 	DEBUG("ret: %d errno: %d (%s)", res,
 	    res != 0 ? errno : 0,
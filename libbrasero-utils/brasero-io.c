@@ -32,8 +32,17 @@
 #  include <config.h>
 #endif
 
+/* This is for statx () */
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -85,7 +94,7 @@ struct _BraseroIOPrivate
 	GSList *mounted;
 
 	/* used for returning results */
-	GSList *results;
+	GQueue *results;
 	gint results_id;
 
 	/* used for metadata */
@@ -318,6 +327,57 @@ brasero_io_job_result_free (BraseroIOJobResult *result)
 
 #define NUMBER_OF_RESULTS	25
 
+/* Maximum number of results for the same job that are returned at once and
+ * maximum time spent returning results before giving the main loop back */
+#define NUMBER_OF_BATCHED_RESULTS	512
+#define RESULTS_TIME_SLICE		(G_USEC_PER_SEC / 50)
+
+static void
+brasero_io_return_results (BraseroIOJobBase *base,
+			   GPtrArray *results)
+{
+	BraseroIOResultCallbackData *data;
+	BraseroIOResult *array;
+	guint num = 0;
+	guint i;
+
+	data = ((BraseroIOJobResult *) g_ptr_array_index (results, 0))->callback_data;
+
+	array = g_new (BraseroIOResult, results->len);
+	for (i = 0; i < results->len; i ++) {
+		BraseroIOJobResult *result;
+
+		result = g_ptr_array_index (results, i);
+		if (!result->uri && !result->info && !result->error)
+			continue;
+
+		array [num].uri = result->uri;
+		array [num].info = result->info;
+		array [num].error = result->error;
+		num ++;
+	}
+
+	if (num)
+		base->methods->results (base->object,
+					array,
+					num,
+					data? data->callback_data:NULL);
+	g_free (array);
+
+	for (i = 0; i < results->len; i ++) {
+		BraseroIOJobResult *result;
+
+		result = g_ptr_array_index (results, i);
+
+		/* call destroy () for callback data */
+		brasero_io_unref_result_callback_data (result->callback_data,
+						       base->object,
+						       base->methods->destroy,
+						       FALSE);
+		brasero_io_job_result_free (result);
+	}
+}
+
 static gboolean
 brasero_io_return_result_idle (gpointer callback_data)
 {
@@ -325,7 +385,9 @@ brasero_io_return_result_idle (gpointer callback_data)
 	BraseroIOResultCallbackData *data;
 	BraseroIOJobResult *result;
 	BraseroIOPrivate *priv;
+	gboolean interrupted;
 	guint results_id;
+	gint64 start;
 	int i;
 
 	priv = BRASERO_IO_PRIVATE (self);
@@ -339,26 +401,34 @@ brasero_io_return_result_idle (gpointer callback_data)
 	priv->results_id = 0;
 
 	/* Return several results at a time that can be a huge speed gain.
-	 * What should be the value that provides speed and responsiveness? */
-	for (i = 0; priv->results && i < NUMBER_OF_RESULTS;) {
+	 * Stop after a while though so that the main loop stays responsive. */
+	start = g_get_monotonic_time ();
+	interrupted = FALSE;
+	for (i = 0; !g_queue_is_empty (priv->results);) {
 		BraseroIOJobBase *base;
-		GSList *iter;
+		GPtrArray *batch;
+		GList *iter;
+
+		if (i >= NUMBER_OF_RESULTS
+		||  g_get_monotonic_time () - start > RESULTS_TIME_SLICE) {
+			interrupted = TRUE;
+			break;
+		}
 
 		/* Find the next result that can be returned */
-		result = NULL;
-		for (iter = priv->results; iter; iter = iter->next) {
+		for (iter = priv->results->head; iter; iter = iter->next) {
 			BraseroIOJobResult *tmp_result;
 
 			tmp_result = iter->data;
-			if (!tmp_result->base->methods->in_use) {
-				result = tmp_result;
+			if (!tmp_result->base->methods->in_use)
 				break;
-			}
 		}
 
-		if (!result)
+		if (!iter)
 			break;
 
+		result = iter->data;
+
 		/* Make sure another result is not returned for this base. This 
 		 * is to avoid BraseroDataDisc showing multiple dialogs for 
 		 * various problems; like one dialog for joliet, one for deep,
@@ -366,40 +436,72 @@ brasero_io_return_result_idle (gpointer callback_data)
 		base = (BraseroIOJobBase *) result->base;
 		base->methods->in_use = TRUE;
 
-		priv->results = g_slist_remove (priv->results, result);
+		/* Take the following results for the same base and callback
+		 * data as well if they can all be returned at once. They are
+		 * usually queued one after the other by the same thread. */
+		batch = NULL;
+		if (base->methods->results) {
+			batch = g_ptr_array_sized_new (64);
+			while (iter && batch->len < NUMBER_OF_BATCHED_RESULTS) {
+				BraseroIOJobResult *tmp_result;
+				GList *next;
+
+				tmp_result = iter->data;
+				if (tmp_result->base != base
+				||  tmp_result->callback_data != result->callback_data)
+					break;
+
+				next = iter->next;
+				g_queue_delete_link (priv->results, iter);
+				g_ptr_array_add (batch, tmp_result);
+				iter = next;
+			}
+		}
+		else
+			g_queue_delete_link (priv->results, iter);
 
 		/* This is to make sure the object
-		 *  lives as long as we need it. */
-		g_object_ref (base->object);
+		 *  lives as long as we need it. Batches
+		 * shared between objects have no owner. */
+		if (base->object)
+			g_object_ref (base->object);
 
 		g_mutex_unlock (priv->lock);
 
-		data = result->callback_data;
-
-		if (result->uri || result->info || result->error)
-			base->methods->callback (base->object,
-			                          result->error,
-			                          result->uri,
-			                          result->info,
-			                          data? data->callback_data:NULL);
-
-		/* call destroy () for callback data */
-		brasero_io_unref_result_callback_data (data,
-						       base->object,
-						       base->methods->destroy,
-						       FALSE);
-
-		brasero_io_job_result_free (result);
+		if (batch) {
+			brasero_io_return_results (base, batch);
+			g_ptr_array_free (batch, TRUE);
+		}
+		else {
+			data = result->callback_data;
+
+			if (result->uri || result->info || result->error)
+				base->methods->callback (base->object,
+							  result->error,
+							  result->uri,
+							  result->info,
+							  data? data->callback_data:NULL);
+
+			/* call destroy () for callback data */
+			brasero_io_unref_result_callback_data (data,
+							       base->object,
+							       base->methods->destroy,
+							       FALSE);
+
+			brasero_io_job_result_free (result);
+		}
 
 		g_mutex_lock (priv->lock);
 
 		i ++;
 
-		g_object_unref (base->object);
+		if (base->object)
+			g_object_unref (base->object);
+
 		base->methods->in_use = FALSE;
 	}
 
-	if (!priv->results_id && priv->results && i >= NUMBER_OF_RESULTS) {
+	if (!priv->results_id && !g_queue_is_empty (priv->results) && interrupted) {
 		/* There are still results and no idle call is scheduled so we
 		 * have to restart ourselves to make sure we empty the queue */
 		priv->results_id = results_id;
@@ -421,24 +523,46 @@ brasero_io_queue_result (BraseroIO *self,
 
 	/* insert the task in the results queue */
 	g_mutex_lock (priv->lock);
-	priv->results = g_slist_append (priv->results, result);
+	g_queue_push_tail (priv->results, result);
 	if (!priv->results_id)
 		priv->results_id = g_idle_add ((GSourceFunc) brasero_io_return_result_idle, self);
 	g_mutex_unlock (priv->lock);
 }
 
-void
-brasero_io_return_result (const BraseroIOJobBase *base,
-			  const gchar *uri,
-			  GFileInfo *info,
-			  GError *error,
-			  BraseroIOResultCallbackData *callback_data)
+/**
+ * Queues all the results at once, which saves taking the lock for each
+ * of them when a thread has a lot of results to return.
+ */
+
+static void
+brasero_io_queue_results (BraseroIO *self,
+			  GQueue *results)
 {
-	BraseroIO *self = brasero_io_get_default ();
 	BraseroIOJobResult *result;
+	BraseroIOPrivate *priv;
 
-	/* even if it is cancelled we let the result go through to be able to 
-	 * call its destroy callback in the main thread. */
+	if (g_queue_is_empty (results))
+		return;
+
+	priv = BRASERO_IO_PRIVATE (self);
+
+	g_mutex_lock (priv->lock);
+	while ((result = g_queue_pop_head (results)))
+		g_queue_push_tail (priv->results, result);
+
+	if (!priv->results_id)
+		priv->results_id = g_idle_add ((GSourceFunc) brasero_io_return_result_idle, self);
+	g_mutex_unlock (priv->lock);
+}
+
+static BraseroIOJobResult *
+brasero_io_job_result_new (const BraseroIOJobBase *base,
+			   const gchar *uri,
+			   GFileInfo *info,
+			   GError *error,
+			   BraseroIOResultCallbackData *callback_data)
+{
+	BraseroIOJobResult *result;
 
 	result = g_new0 (BraseroIOJobResult, 1);
 	result->base = base;
@@ -451,6 +575,22 @@ brasero_io_return_result (const BraseroIOJobBase *base,
 		result->callback_data = callback_data;
 	}
 
+	return result;
+}
+
+void
+brasero_io_return_result (const BraseroIOJobBase *base,
+			  const gchar *uri,
+			  GFileInfo *info,
+			  GError *error,
+			  BraseroIOResultCallbackData *callback_data)
+{
+	BraseroIO *self = brasero_io_get_default ();
+	BraseroIOJobResult *result;
+
+	/* even if it is cancelled we let the result go through to be able to 
+	 * call its destroy callback in the main thread. */
+	result = brasero_io_job_result_new (base, uri, info, error, callback_data);
 	brasero_io_queue_result (self, result);
 	g_object_unref (self);
 }
@@ -1250,12 +1390,13 @@ brasero_io_get_file_info_thread_real (BraseroAsyncTaskManager *manager,
 	return info;
 }
 
-static BraseroAsyncTaskResult
-brasero_io_get_file_info_thread (BraseroAsyncTaskManager *manager,
-				 GCancellable *cancel,
-				 gpointer callback_data)
+static void
+brasero_io_get_file_info_for_uri (BraseroAsyncTaskManager *manager,
+				  GCancellable *cancel,
+				  BraseroIOJob *job,
+				  const gchar *uri,
+				  gboolean keep_uri)
 {
-	BraseroIOJob *job = callback_data;
 	gchar *file_uri = NULL;
 	GError *error = NULL;
 	GFileInfo *info;
@@ -1269,15 +1410,15 @@ brasero_io_get_file_info_thread (BraseroAsyncTaskManager *manager,
 		 * unfortunately they are guint64 and can't be used in hash tables as keys.
 		 * Therefore we check parents up to root to see if there are symlinks and if so
 		 * we get a path without symlinks in it. This is done only for local file */
-		file_uri = brasero_io_check_for_parent_symlink (job->uri, cancel);
+		file_uri = brasero_io_check_for_parent_symlink (uri, cancel);
 	}
 
 	if (g_cancellable_is_cancelled (cancel)) {
 		g_free (file_uri);
-		return BRASERO_ASYNC_TASK_FINISHED;
+		return;
 	}
 
-	file = g_file_new_for_uri (file_uri?file_uri:job->uri);
+	file = g_file_new_for_uri (file_uri?file_uri:uri);
 	info = brasero_io_get_file_info_thread_real (manager,
 						     cancel,
 						     file,
@@ -1287,7 +1428,7 @@ brasero_io_get_file_info_thread (BraseroAsyncTaskManager *manager,
 	/* do this to have a very nice URI:
 	 * for example: file://pouet instead of file://../directory/pouet */
 	g_free (file_uri);
-	file_uri = g_file_get_uri (file);
+	file_uri = keep_uri? g_strdup (uri):g_file_get_uri (file);
 	g_object_unref (file);
 
 	brasero_io_return_result (job->base,
@@ -1297,6 +1438,20 @@ brasero_io_get_file_info_thread (BraseroAsyncTaskManager *manager,
 				  job->callback_data);
 
 	g_free (file_uri);
+}
+
+static BraseroAsyncTaskResult
+brasero_io_get_file_info_thread (BraseroAsyncTaskManager *manager,
+				 GCancellable *cancel,
+				 gpointer callback_data)
+{
+	BraseroIOJob *job = callback_data;
+
+	brasero_io_get_file_info_for_uri (manager,
+					  cancel,
+					  job,
+					  job->uri,
+					  FALSE);
 	return BRASERO_ASYNC_TASK_FINISHED;
 }
 
@@ -1341,6 +1496,100 @@ brasero_io_get_file_info (const gchar *uri,
 	g_object_unref (self);
 }
 
+/**
+ * Used to get information about a list of files with a single job
+ */
+
+struct _BraseroIOInfoListData {
+	BraseroIOJob job;
+	GSList *uris;
+};
+typedef struct _BraseroIOInfoListData BraseroIOInfoListData;
+
+static void
+brasero_io_get_files_info_destroy (BraseroAsyncTaskManager *manager,
+				   gboolean cancelled,
+				   gpointer callback_data)
+{
+	BraseroIOInfoListData *data = callback_data;
+
+	g_slist_foreach (data->uris, (GFunc) g_free, NULL);
+	g_slist_free (data->uris);
+
+	brasero_io_job_free (cancelled, callback_data);
+}
+
+static BraseroAsyncTaskResult
+brasero_io_get_files_info_thread (BraseroAsyncTaskManager *manager,
+				  GCancellable *cancel,
+				  gpointer callback_data)
+{
+	BraseroIOInfoListData *data = callback_data;
+	gchar *uri;
+
+	if (!data->uris)
+		return BRASERO_ASYNC_TASK_FINISHED;
+
+	/* One file at a time so that the job can be cancelled and that other
+	 * urgent jobs get a chance to run in between */
+	uri = data->uris->data;
+	data->uris = g_slist_delete_link (data->uris, data->uris);
+
+	brasero_io_get_file_info_for_uri (manager,
+					  cancel,
+					  BRASERO_IO_JOB (data),
+					  uri,
+					  TRUE);
+	g_free (uri);
+
+	return data->uris? BRASERO_ASYNC_TASK_RESCHEDULE:BRASERO_ASYNC_TASK_FINISHED;
+}
+
+static const BraseroAsyncTaskType info_list_type = {
+	brasero_io_get_files_info_thread,
+	brasero_io_get_files_info_destroy
+};
+
+/**
+ * brasero_io_get_files_info:
+ *
+ * Same as brasero_io_get_file_info () for all @uris but with a single job.
+ * There is one result per URI, in the same order; unlike
+ * brasero_io_get_file_info () the URI of each result is the one given so
+ * that callers can match them.
+ **/
+
+void
+brasero_io_get_files_info (GSList *uris,
+			   const BraseroIOJobBase *base,
+			   BraseroIOFlags options,
+			   gpointer user_data)
+{
+	BraseroIOInfoListData *data;
+	BraseroIO *self = brasero_io_get_default ();
+	BraseroIOResultCallbackData *callback_data = NULL;
+
+	if (user_data) {
+		callback_data = g_new0 (BraseroIOResultCallbackData, 1);
+		callback_data->callback_data = user_data;
+	}
+
+	data = g_new0 (BraseroIOInfoListData, 1);
+
+	for (; uris; uris = uris->next)
+		data->uris = g_slist_prepend (data->uris, g_strdup (uris->data));
+	data->uris = g_slist_reverse (data->uris);
+
+	brasero_io_set_job (BRASERO_IO_JOB (data),
+			    base,
+			    NULL,
+			    options,
+			    callback_data);
+
+	brasero_io_push_job (BRASERO_IO_JOB (data), &info_list_type);
+	g_object_unref (self);
+}
+
 /**
  * Used to parse playlists
  */
@@ -1970,6 +2219,247 @@ brasero_io_load_directory_playlist (BraseroIO *self,
 
 #endif
 
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (HAVE_FACCESSAT) && defined (HAVE_READLINKAT)
+
+/**
+ * Fast path for local directories: entries are read with readdir () over a
+ * directory file descriptor (which reads them in large getdents batches) and
+ * examined with fstatat ()/statx () relative to it. This avoids creating a
+ * GFile and a GFileEnumerator info query for every child. Results are queued
+ * by batches rather than one at a time.
+ */
+
+static gboolean
+brasero_io_stat_at (gint dir_fd,
+		    const gchar *name,
+		    gboolean follow,
+		    mode_t *mode,
+		    goffset *size)
+{
+#ifdef HAVE_STATX
+
+	struct statx buffer;
+
+	/* Only ask for what we use; on some filesystems this is cheaper */
+	if (statx (dir_fd,
+		   name,
+		   AT_NO_AUTOMOUNT|(follow? 0:AT_SYMLINK_NOFOLLOW),
+		   STATX_TYPE|STATX_MODE|STATX_SIZE,
+		   &buffer) == 0) {
+		*mode = buffer.stx_mode;
+		*size = buffer.stx_size;
+		return TRUE;
+	}
+
+	if (errno != ENOSYS)
+		return FALSE;
+
+#endif
+
+	{
+		struct stat buffer;
+
+		if (fstatat (dir_fd, name, &buffer, follow? 0:AT_SYMLINK_NOFOLLOW))
+			return FALSE;
+
+		*mode = buffer.st_mode;
+		*size = buffer.st_size;
+	}
+
+	return TRUE;
+}
+
+static GFileType
+brasero_io_file_type_from_mode (mode_t mode)
+{
+	if (S_ISREG (mode))
+		return G_FILE_TYPE_REGULAR;
+	if (S_ISDIR (mode))
+		return G_FILE_TYPE_DIRECTORY;
+	if (S_ISLNK (mode))
+		return G_FILE_TYPE_SYMBOLIC_LINK;
+
+	return G_FILE_TYPE_SPECIAL;
+}
+
+static GFileInfo *
+brasero_io_load_directory_local_info (gint dir_fd,
+				      const gchar *name,
+				      BraseroIOFlags options)
+{
+	GFileInfo *info;
+	goffset size;
+	mode_t mode;
+
+	if (!brasero_io_stat_at (dir_fd, name, FALSE, &mode, &size))
+		return NULL;
+
+	info = g_file_info_new ();
+	g_file_info_set_name (info, name);
+
+	if (S_ISLNK (mode)) {
+		gchar target [PATH_MAX + 1];
+		gssize length;
+
+		g_file_info_set_is_symlink (info, TRUE);
+
+		length = readlinkat (dir_fd, name, target, sizeof (target) - 1);
+		if (length >= 0) {
+			target [length] = '\0';
+			g_file_info_set_symlink_target (info, target);
+		}
+
+		/* Like GIO, keep the link information if the target is broken */
+		if (options & BRASERO_IO_INFO_FOLLOW_SYMLINK) {
+			goffset target_size;
+			mode_t target_mode;
+
+			if (brasero_io_stat_at (dir_fd, name, TRUE, &target_mode, &target_size)) {
+				mode = target_mode;
+				size = target_size;
+			}
+		}
+	}
+
+	g_file_info_set_file_type (info, brasero_io_file_type_from_mode (mode));
+	g_file_info_set_size (info, size);
+
+	if (options & BRASERO_IO_INFO_PERM)
+		g_file_info_set_attribute_boolean (info,
+						   G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
+						   faccessat (dir_fd, name, R_OK, 0) == 0);
+
+	return info;
+}
+
+static gboolean
+brasero_io_load_directory_local (BraseroIOContentsData *data,
+				 GCancellable *cancel,
+				 GFile *file)
+{
+	GQueue results = G_QUEUE_INIT;
+	struct dirent *entry;
+	GString *child_uri;
+	gchar *directory;
+	GFile *parent = NULL;
+	BraseroIO *self;
+	gsize uri_len;
+	gint dir_fd;
+	DIR *dir;
+
+	/* Only what can be gathered with stat () is handled here */
+	if (data->job.options & (BRASERO_IO_INFO_MIME|
+				 BRASERO_IO_INFO_ICON|
+				 BRASERO_IO_INFO_METADATA))
+		return FALSE;
+
+	directory = g_file_get_path (file);
+	if (!directory)
+		return FALSE;
+
+	dir_fd = open (directory, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+	if (dir_fd < 0) {
+		/* Let GIO report the error */
+		g_free (directory);
+		return FALSE;
+	}
+
+	dir = fdopendir (dir_fd);
+	if (!dir) {
+		close (dir_fd);
+		g_free (directory);
+		return FALSE;
+	}
+
+	/* Children URIs are all built in the same buffer from the URI of the
+	 * directory and the escaped name (the way g_filename_to_uri () does) */
+	child_uri = g_string_new (NULL);
+	g_string_append_uri_escaped (child_uri, directory, "!$&'()*+,-./:=@_~", FALSE);
+	g_string_prepend (child_uri, "file://");
+	if (child_uri->str [child_uri->len - 1] != '/')
+		g_string_append_c (child_uri, '/');
+
+	uri_len = child_uri->len;
+
+	self = brasero_io_get_default ();
+	while ((entry = readdir (dir))) {
+		const gchar *name;
+		GFileInfo *info;
+
+		if (g_cancellable_is_cancelled (cancel))
+			break;
+
+		name = entry->d_name;
+		if (name [0] == '.'
+		&& (name [1] == '\0'
+		|| (name [1] == '.' && name [2] == '\0')))
+			continue;
+
+		info = brasero_io_load_directory_local_info (dir_fd, name, data->job.options);
+		if (!info)
+			continue;
+
+		g_string_truncate (child_uri, uri_len);
+		g_string_append_uri_escaped (child_uri, name, "!$&'()*+,:=@", FALSE);
+
+		/* special case for symlinks; they are rare enough that the
+		 * GFile needed to resolve their target can be created lazily */
+		if (g_file_info_get_is_symlink (info)) {
+			if (!parent)
+				parent = g_file_new_for_path (directory);
+
+			if (!brasero_io_check_symlink_target (parent, info)) {
+				GError *error;
+
+				error = g_error_new (BRASERO_UTILS_ERROR,
+						     BRASERO_UTILS_ERROR_SYMLINK_LOOP,
+						     _("Recursive symbolic link"));
+
+				/* since we checked for the existence of the file
+				 * an error means a looping symbolic link */
+				g_queue_push_tail (&results,
+						   brasero_io_job_result_new (data->job.base,
+									      child_uri->str,
+									      NULL,
+									      error,
+									      data->job.callback_data));
+				g_object_unref (info);
+				continue;
+			}
+		}
+
+		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY
+		&& (data->job.options & BRASERO_IO_INFO_RECURSIVE))
+			data->children = g_slist_prepend (data->children,
+							  g_file_new_for_uri (child_uri->str));
+
+		g_queue_push_tail (&results,
+				   brasero_io_job_result_new (data->job.base,
+							      child_uri->str,
+							      info,
+							      NULL,
+							      data->job.callback_data));
+
+		if (g_queue_get_length (&results) >= NUMBER_OF_BATCHED_RESULTS)
+			brasero_io_queue_results (self, &results);
+	}
+
+	brasero_io_queue_results (self, &results);
+	g_object_unref (self);
+
+	/* This closes dir_fd as well */
+	closedir (dir);
+
+	if (parent)
+		g_object_unref (parent);
+
+	g_string_free (child_uri, TRUE);
+	g_free (directory);
+	return TRUE;
+}
+
+#endif
+
 static BraseroAsyncTaskResult
 brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 				  GCancellable *cancel,
@@ -2005,6 +2495,20 @@ brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 	else
 		file = g_file_new_for_uri (data->job.uri);
 
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (HAVE_FACCESSAT) && defined (HAVE_READLINKAT)
+
+	if (g_file_is_native (file)
+	&&  brasero_io_load_directory_local (data, cancel, file)) {
+		g_object_unref (file);
+
+		if (data->children)
+			return BRASERO_ASYNC_TASK_RESCHEDULE;
+
+		return BRASERO_ASYNC_TASK_FINISHED;
+	}
+
+#endif
+
 	enumerator = g_file_enumerate_children (file,
 						attributes,
 						(data->job.options & BRASERO_IO_INFO_FOLLOW_SYMLINK)?G_FILE_QUERY_INFO_NONE:G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,	/* follow symlinks by default*/
@@ -2190,7 +2694,7 @@ brasero_io_cancel_result (BraseroIO *self,
 	priv = BRASERO_IO_PRIVATE (self);
 
 	g_mutex_lock (priv->lock);
-	priv->results = g_slist_remove (priv->results, result);
+	g_queue_remove (priv->results, result);
 	g_mutex_unlock (priv->lock);
 
 	data = result->callback_data;
@@ -2218,8 +2722,8 @@ brasero_io_cancel_tasks_by_base_cb (BraseroAsyncTaskManager *manager,
 void
 brasero_io_cancel_by_base (BraseroIOJobBase *base)
 {
-	GSList *iter;
-	GSList *next;
+	GList *iter;
+	GList *next;
 	BraseroIOPrivate *priv;
 	BraseroIO *self = brasero_io_get_default ();
 
@@ -2234,7 +2738,7 @@ brasero_io_cancel_by_base (BraseroIOJobBase *base)
 							  base);
 
 	/* do it afterwards in case some results slipped through */
-	for (iter = priv->results; iter; iter = next) {
+	for (iter = priv->results->head; iter; iter = next) {
 		BraseroIOJobResult *result;
 
 		result = iter->data;
@@ -2321,6 +2825,19 @@ brasero_io_register_with_methods (GObject *object,
 	return base;
 }
 
+BraseroIOJobBase *
+brasero_io_register_batch (GObject *object,
+			   BraseroIOResultsCallback results,
+			   BraseroIODestroyCallback destroy,
+			   BraseroIOProgressCallback progress)
+{
+	BraseroIOJobCallbacks *methods;
+
+	methods = brasero_io_register_job_methods (NULL, destroy, progress);
+	methods->results = results;
+	return brasero_io_register_with_methods (object, methods);
+}
+
 BraseroIOJobBase *
 brasero_io_register (GObject *object,
 		     BraseroIOResultCallback callback,
@@ -2375,6 +2892,7 @@ brasero_io_init (BraseroIO *object)
 	priv->lock_metadata = g_mutex_new ();
 
 	priv->meta_buffer = g_queue_new ();
+	priv->results = g_queue_new ();
 
 	/* create metadatas now since it doesn't work well when it's created in 
 	 * a thread. */
@@ -2400,8 +2918,8 @@ brasero_io_free_async_queue (BraseroAsyncTaskManager *manager,
 static void
 brasero_io_finalize (GObject *object)
 {
+	BraseroIOJobResult *result;
 	BraseroIOPrivate *priv;
-	GSList *iter;
 
 	priv = BRASERO_IO_PRIVATE (object);
 
@@ -2432,13 +2950,10 @@ brasero_io_finalize (GObject *object)
 		priv->results_id = 0;
 	}
 
-	for (iter = priv->results; iter; iter = iter->next) {
-		BraseroIOJobResult *result;
-
-		result = iter->data;
+	while ((result = g_queue_pop_head (priv->results)) != NULL)
 		brasero_io_job_result_free (result);
-	}
-	g_slist_free (priv->results);
+
+	g_queue_free (priv->results);
 	priv->results = NULL;
 
 	if (priv->progress_id) {
@@ -2506,7 +3021,7 @@ brasero_io_cancel (BraseroAsyncTaskManager *manager,
 void
 brasero_io_shutdown (void)
 {
-	GSList *iter, *next;
+	GList *iter, *next;
 	BraseroIOPrivate *priv;
 
 	priv = BRASERO_IO_PRIVATE (singleton);
@@ -2520,7 +3035,7 @@ brasero_io_shutdown (void)
 							  NULL);
 
 	/* do it afterwards in case some results slipped through */
-	for (iter = priv->results; iter; iter = next) {
+	for (iter = priv->results->head; iter; iter = next) {
 		BraseroIOJobResult *result;
 
 		result = iter->data;
@@ -100,6 +100,19 @@ typedef void		(*BraseroIOResultCallback)	(GObject *object,
 							 GFileInfo *info,
 							 gpointer callback_data);
 
+/* Used to return several results for the same job at once */
+struct _BraseroIOResult {
+	const gchar *uri;
+	GFileInfo *info;
+	GError *error;
+};
+typedef struct _BraseroIOResult BraseroIOResult;
+
+typedef void		(*BraseroIOResultsCallback)	(GObject *object,
+							 const BraseroIOResult *results,
+							 guint num,
+							 gpointer callback_data);
+
 typedef void		(*BraseroIOProgressCallback)	(GObject *object,
 							 BraseroIOJobProgress *info,
 							 gpointer callback_data);
@@ -117,6 +130,9 @@ struct _BraseroIOJobCallbacks {
 	BraseroIODestroyCallback destroy;
 	BraseroIOProgressCallback progress;
 
+	/* If set, it is used instead of callback */
+	BraseroIOResultsCallback results;
+
 	guint ref;
 
 	/* Whether we are returning something for this base */
@@ -191,6 +207,12 @@ brasero_io_register (GObject *object,
 		     BraseroIODestroyCallback destroy,
 		     BraseroIOProgressCallback progress);
 
+BraseroIOJobBase *
+brasero_io_register_batch (GObject *object,
+			   BraseroIOResultsCallback results,
+			   BraseroIODestroyCallback destroy,
+			   BraseroIOProgressCallback progress);
+
 BraseroIOJobBase *
 brasero_io_register_with_methods (GObject *object,
                                   BraseroIOJobCallbacks *methods);
@@ -222,6 +244,12 @@ brasero_io_get_file_info (const gchar *uri,
 			  BraseroIOFlags options,
 			  gpointer callback_data);
 void
+brasero_io_get_files_info (GSList *uris,
+			   const BraseroIOJobBase *base,
+			   BraseroIOFlags options,
+			   gpointer callback_data);
+
+void
 brasero_io_get_file_count (GSList *uris,
 			   const BraseroIOJobBase *base,
 			   BraseroIOFlags options,
@@ -44,6 +44,26 @@
 
 #include "brasero-misc.h"
 
+/* A background image already scaled for a given size and mode */
+typedef struct _BraseroJacketSurface BraseroJacketSurface;
+struct _BraseroJacketSurface
+{
+	GdkPixbuf *image;
+	BraseroJacketImageStyle style;
+	gint width;
+	gint height;
+
+	cairo_surface_t *surface;
+};
+
+typedef struct _BraseroJacketScaleJob BraseroJacketScaleJob;
+struct _BraseroJacketScaleJob
+{
+	BraseroJacketView *self;
+	BraseroJacketSurface *entry;
+	guint generation;
+};
+
 typedef struct _BraseroJacketViewPrivate BraseroJacketViewPrivate;
 struct _BraseroJacketViewPrivate
 {
@@ -57,9 +77,15 @@ struct _BraseroJacketViewPrivate
 	BraseroJacketColorStyle color_style;
 
 	GdkPixbuf *image;
-	GdkPixbuf *scaled;
 	gchar *image_path;
 	BraseroJacketImageStyle image_style;
+
+	/* Most recently used first */
+	GSList *surfaces;
+	cairo_surface_t *surface;
+
+	guint generation;
+	guint scaling:1;
 };
 
 #define BRASERO_JACKET_VIEW_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_JACKET_VIEW, BraseroJacketViewPrivate))
@@ -79,6 +105,8 @@ G_DEFINE_TYPE (BraseroJacketView, brasero_jacket_view, GTK_TYPE_CONTAINER);
 
 #define BRASERO_JACKET_VIEW_MARGIN		20
 
+#define BRASERO_JACKET_VIEW_SURFACE_CACHE	4
+
 
 static GSList *
 brasero_jacket_view_tag_begins (GtkTextIter *iter,
@@ -362,10 +390,174 @@ brasero_jacket_view_render_body (BraseroJacketView *self,
 	}
 }
 
+static GdkPixbuf *
+brasero_jacket_view_scale_image (GdkPixbuf *image,
+				 guint width,
+				 guint height)
+{
+	return gdk_pixbuf_scale_simple (image,
+					width,
+					height,
+					GDK_INTERP_HYPER);
+}
+
+/* NOTE: this is run in a thread so it must only use what is in entry */
+static cairo_surface_t *
+brasero_jacket_view_render_image (BraseroJacketSurface *entry)
+{
+	cairo_surface_t *surface;
+	GdkPixbuf *pixbuf;
+	cairo_t *ctx;
+
+	if (entry->style == BRASERO_JACKET_IMAGE_STRETCH)
+		pixbuf = brasero_jacket_view_scale_image (entry->image,
+							  entry->width,
+							  entry->height);
+	else
+		pixbuf = g_object_ref (entry->image);
+
+	if (!pixbuf)
+		return NULL;
+
+	/* Convert it once to a format cairo can paint directly so that
+	 * drawing never has to go through the pixbuf again */
+	surface = cairo_image_surface_create (gdk_pixbuf_get_has_alpha (pixbuf) ? CAIRO_FORMAT_ARGB32:CAIRO_FORMAT_RGB24,
+					      gdk_pixbuf_get_width (pixbuf),
+					      gdk_pixbuf_get_height (pixbuf));
+	ctx = cairo_create (surface);
+	gdk_cairo_set_source_pixbuf (ctx, pixbuf, 0, 0);
+	cairo_paint (ctx);
+	cairo_destroy (ctx);
+
+	g_object_unref (pixbuf);
+	return surface;
+}
+
+static BraseroJacketSurface *
+brasero_jacket_surface_new (GdkPixbuf *image,
+			    BraseroJacketImageStyle style,
+			    gint width,
+			    gint height)
+{
+	BraseroJacketSurface *entry;
+
+	entry = g_new0 (BraseroJacketSurface, 1);
+	entry->image = g_object_ref (image);
+	entry->style = style;
+	entry->width = width;
+	entry->height = height;
+	return entry;
+}
+
+static void
+brasero_jacket_surface_free (BraseroJacketSurface *entry)
+{
+	if (entry->surface)
+		cairo_surface_destroy (entry->surface);
+
+	g_object_unref (entry->image);
+	g_free (entry);
+}
+
+static void
+brasero_jacket_view_get_image_size (BraseroJacketView *self,
+				    gdouble resolution_x,
+				    gdouble resolution_y,
+				    gint *width,
+				    gint *height)
+{
+	BraseroJacketViewPrivate *priv;
+
+	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
+
+	if (priv->image_style == BRASERO_JACKET_IMAGE_STRETCH) {
+		if (priv->side == BRASERO_JACKET_BACK) {
+			*width = resolution_x * COVER_WIDTH_BACK_INCH;
+			*height = resolution_y * COVER_HEIGHT_BACK_INCH;
+		}
+		else {
+			*width = resolution_x * COVER_WIDTH_FRONT_INCH;
+			*height = resolution_y * COVER_HEIGHT_FRONT_INCH;
+		}
+	}
+	else {
+		/* Centered images and tiles are used as they are whatever the
+		 * size; what lies outside the cover is clipped when painting */
+		*width = 0;
+		*height = 0;
+	}
+}
+
+static cairo_surface_t *
+brasero_jacket_view_lookup_surface (BraseroJacketView *self,
+				    gint width,
+				    gint height)
+{
+	BraseroJacketViewPrivate *priv;
+	GSList *iter;
+
+	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
+
+	for (iter = priv->surfaces; iter; iter = iter->next) {
+		BraseroJacketSurface *entry;
+
+		entry = iter->data;
+		if (entry->image != priv->image
+		||  entry->style != priv->image_style
+		||  entry->width != width
+		||  entry->height != height)
+			continue;
+
+		priv->surfaces = g_slist_delete_link (priv->surfaces, iter);
+		priv->surfaces = g_slist_prepend (priv->surfaces, entry);
+		return entry->surface;
+	}
+
+	return NULL;
+}
+
+static void
+brasero_jacket_view_add_surface (BraseroJacketView *self,
+				 BraseroJacketSurface *entry)
+{
+	BraseroJacketViewPrivate *priv;
+
+	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
+
+	priv->surfaces = g_slist_prepend (priv->surfaces, entry);
+	if (g_slist_length (priv->surfaces) > BRASERO_JACKET_VIEW_SURFACE_CACHE) {
+		GSList *last;
+
+		last = g_slist_last (priv->surfaces);
+		brasero_jacket_surface_free (last->data);
+		priv->surfaces = g_slist_delete_link (priv->surfaces, last);
+	}
+}
+
+static void
+brasero_jacket_view_clear_surfaces (BraseroJacketView *self)
+{
+	BraseroJacketViewPrivate *priv;
+
+	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
+
+	g_slist_foreach (priv->surfaces, (GFunc) brasero_jacket_surface_free, NULL);
+	g_slist_free (priv->surfaces);
+	priv->surfaces = NULL;
+
+	if (priv->surface) {
+		cairo_surface_destroy (priv->surface);
+		priv->surface = NULL;
+	}
+
+	/* Anything being scaled is now useless */
+	priv->generation ++;
+}
+
 static void
 brasero_jacket_view_render_background (BraseroJacketView *self,
 				       cairo_t *ctx,
-				       GdkPixbuf *scaled,
+				       cairo_surface_t *surface,
 				       gint x,
 				       gint y,
 				       gint width,
@@ -376,17 +568,39 @@ brasero_jacket_view_render_background (BraseroJacketView *self,
 	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
 
 	/* draw background when it is a pattern */
-	if (scaled) {
+	if (surface) {
+		gint surface_width, surface_height;
+
 		/* The problem is the resolution here. The one for the screen
-		 * may not be the one for the printer. So do not use our private
-		 * scaled image. */
+		 * may not be the one for the printer. So the caller must give
+		 * us a surface scaled for the right one. */
+		surface_width = cairo_image_surface_get_width (surface);
+		surface_height = cairo_image_surface_get_height (surface);
+
+		if (priv->image_style == BRASERO_JACKET_IMAGE_STRETCH
+		&& (surface_width != width || surface_height != height)) {
+			/* This is an outdated surface displayed while the
+			 * one for the new size is being prepared */
+			cairo_save (ctx);
+			cairo_rectangle (ctx, x, y, width, height);
+			cairo_clip (ctx);
+			cairo_translate (ctx, x, y);
+			cairo_scale (ctx,
+				     (gdouble) width / surface_width,
+				     (gdouble) height / surface_height);
+			cairo_set_source_surface (ctx, surface, 0, 0);
+			cairo_paint (ctx);
+			cairo_restore (ctx);
+			return;
+		}
+
 		if (priv->image_style == BRASERO_JACKET_IMAGE_CENTER)
-			gdk_cairo_set_source_pixbuf (ctx,
-						     scaled,
-						     x + (width - gdk_pixbuf_get_width (scaled)) / 2.0,
-						     y + (height - gdk_pixbuf_get_height (scaled)) / 2.0);
+			cairo_set_source_surface (ctx,
+						  surface,
+						  x + (width - surface_width) / 2.0,
+						  y + (height - surface_height) / 2.0);
 		else
-			gdk_cairo_set_source_pixbuf (ctx, scaled, x, y);
+			cairo_set_source_surface (ctx, surface, x, y);
 
 		if (priv->image_style == BRASERO_JACKET_IMAGE_TILE) {
 			cairo_pattern_t *pattern;
@@ -444,7 +658,7 @@ static void
 brasero_jacket_view_render (BraseroJacketView *self,
 			    cairo_t *ctx,
 			    PangoLayout *layout,
-			    GdkPixbuf *scaled,
+			    cairo_surface_t *surface,
 			    gdouble resolution_x,
 			    gdouble resolution_y,
 			    gint x,
@@ -465,7 +679,7 @@ brasero_jacket_view_render (BraseroJacketView *self,
 		height = COVER_HEIGHT_FRONT_INCH * resolution_y;
 	}
 
-	brasero_jacket_view_render_background (self, ctx, scaled, x, y, width, height);
+	brasero_jacket_view_render_background (self, ctx, surface, x, y, width, height);
 
 	if (priv->side == BRASERO_JACKET_BACK) {
 		gdouble line_x, line_y;
@@ -520,31 +734,6 @@ brasero_jacket_view_render (BraseroJacketView *self,
 	cairo_stroke (ctx);
 }
 
-static GdkPixbuf *
-brasero_jacket_view_scale_image (BraseroJacketView *self,
-				 gdouble resolution_x,
-				 gdouble resolution_y)
-{
-	BraseroJacketViewPrivate *priv;
-	guint width, height;
-
-	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
-
-	if (priv->side == BRASERO_JACKET_BACK) {
-		height = resolution_y * COVER_HEIGHT_BACK_INCH;
-		width = resolution_x * COVER_WIDTH_BACK_INCH;
-	}
-	else {
-		height = resolution_y * COVER_HEIGHT_FRONT_INCH;
-		width = resolution_x * COVER_WIDTH_FRONT_INCH;
-	}
-
-	return gdk_pixbuf_scale_simple (priv->image,
-					width,
-					height,
-					GDK_INTERP_HYPER);
-}
-
 guint
 brasero_jacket_view_print (BraseroJacketView *self,
 			   GtkPrintContext *context,
@@ -556,7 +745,7 @@ brasero_jacket_view_print (BraseroJacketView *self,
 	PangoLayout *layout;
 	gdouble resolution_x;
 	gdouble resolution_y;
-	GdkPixbuf *scaled = NULL;
+	cairo_surface_t *surface = NULL;
 	BraseroJacketViewPrivate *priv;
 
 	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
@@ -573,18 +762,34 @@ brasero_jacket_view_print (BraseroJacketView *self,
 		height = (resolution_y * COVER_HEIGHT_FRONT_INCH) + 1.0;
 
 	/* Make sure we scale the image with the correct resolution */
-	if (priv->image_style == BRASERO_JACKET_IMAGE_STRETCH)
-		scaled = brasero_jacket_view_scale_image (self,
-							  resolution_x,
-							  resolution_y);
-	else if (priv->scaled)
-		scaled = g_object_ref (priv->scaled);
+	if (priv->image) {
+		gint width, height;
+
+		brasero_jacket_view_get_image_size (self,
+						    resolution_x,
+						    resolution_y,
+						    &width,
+						    &height);
+		surface = brasero_jacket_view_lookup_surface (self, width, height);
+		if (!surface) {
+			BraseroJacketSurface *entry;
+
+			/* Printing cannot wait for a thread */
+			entry = brasero_jacket_surface_new (priv->image,
+							    priv->image_style,
+							    width,
+							    height);
+			entry->surface = brasero_jacket_view_render_image (entry);
+			brasero_jacket_view_add_surface (self, entry);
+			surface = entry->surface;
+		}
+	}
 
 	layout = gtk_print_context_create_pango_layout (context);
 	brasero_jacket_view_render (self,
 				    ctx,
 				    layout,
-				    scaled,
+				    surface,
 				    resolution_x,
 				    resolution_y,
 				    x,
@@ -602,10 +807,6 @@ brasero_jacket_view_print (BraseroJacketView *self,
 					 FALSE);
 
 	g_object_unref (layout);
-
-	if (scaled)
-		g_object_unref (scaled);
-
 	return height;
 }
 
@@ -895,7 +1096,7 @@ brasero_jacket_view_set_textview_background (BraseroJacketView *self)
        	if (priv->side == BRASERO_JACKET_BACK)
         	x += COVER_WIDTH_SIDE_INCH * resolution;
 
-	brasero_jacket_view_render_background (self, cr, priv->scaled, 0, 0, width, height);
+	brasero_jacket_view_render_background (self, cr, priv->surface, 0, 0, width, height);
 	subsurface = cairo_surface_create_for_rectangle (surface,
 							 x,
 							 y,
@@ -909,66 +1110,84 @@ brasero_jacket_view_set_textview_background (BraseroJacketView *self)
 	cairo_destroy (cr);
 }
 
-static GdkPixbuf *
-brasero_jacket_view_crop_image (BraseroJacketView *self,
-				guint width,
-                                guint height)
+static void
+brasero_jacket_view_set_surface (BraseroJacketView *self,
+				 cairo_surface_t *surface)
 {
 	BraseroJacketViewPrivate *priv;
-	gint x, y;
 
 	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
 
-	if (gdk_pixbuf_get_width (priv->image) > width) {
-		x = 0;
-		width = gdk_pixbuf_get_width (priv->image);
-	}
-	else
-		x = (gdk_pixbuf_get_width (priv->image) - width) / 2;
+	if (priv->surface)
+		cairo_surface_destroy (priv->surface);
+
+	priv->surface = surface? cairo_surface_reference (surface):NULL;
 
-	if (gdk_pixbuf_get_height (priv->image) > height) {
-		y = 0;
-		height = gdk_pixbuf_get_height (priv->image);
+	/* Create a pattern out of the image */
+	brasero_jacket_view_set_textview_background (self);
+	gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+static void
+brasero_jacket_view_update_image (BraseroJacketView *self);
+
+static gboolean
+brasero_jacket_view_scale_done (gpointer data)
+{
+	BraseroJacketScaleJob *job = data;
+	BraseroJacketViewPrivate *priv;
+	BraseroJacketSurface *entry;
+
+	priv = BRASERO_JACKET_VIEW_PRIVATE (job->self);
+	priv->scaling = FALSE;
+
+	/* Even if the size changed in between, that is still closer to what
+	 * should be displayed than what we have as long as the image and the
+	 * mode are the same. */
+	entry = job->entry;
+	if (entry->surface
+	&&  entry->image == priv->image
+	&&  entry->style == priv->image_style) {
+		brasero_jacket_view_add_surface (job->self, entry);
+		brasero_jacket_view_set_surface (job->self, entry->surface);
 	}
 	else
-		y = (gdk_pixbuf_get_height (priv->image) - height) / 2;
+		brasero_jacket_surface_free (entry);
+
+	if (job->generation != priv->generation)
+		brasero_jacket_view_update_image (job->self);
+
+	g_object_unref (job->self);
+	g_free (job);
+	return FALSE;
+}
+
+static gpointer
+brasero_jacket_view_scale_thread (gpointer data)
+{
+	BraseroJacketScaleJob *job = data;
 
-	return gdk_pixbuf_new_subpixbuf (priv->image,
-	                                 x,
-	                                 y,
-	                                 width,
-	                                 height);
+	job->entry->surface = brasero_jacket_view_render_image (job->entry);
+	g_idle_add (brasero_jacket_view_scale_done, job);
+	return NULL;
 }
 
 static void
 brasero_jacket_view_update_image (BraseroJacketView *self)
 {
 	BraseroJacketViewPrivate *priv;
+	BraseroJacketScaleJob *job;
+	cairo_surface_t *surface;
+	gdouble resolution = 0.0;
+	GError *error = NULL;
+	gint width, height;
 
 	priv = BRASERO_JACKET_VIEW_PRIVATE (self);
 
-	if (priv->scaled) {
-		g_object_unref (priv->scaled);
-		priv->scaled = NULL;
-	}
-
-	if (!priv->image)
+	if (!priv->image || !priv->edit)
 		return;
 
-	if (priv->image_style == BRASERO_JACKET_IMAGE_CENTER) {
-		GtkAllocation allocation;
-
-		gtk_widget_get_allocation (priv->edit, &allocation);
-		if (allocation.width < gdk_pixbuf_get_width (priv->image)
-		||  allocation.height < gdk_pixbuf_get_height (priv->image))
-			priv->scaled = brasero_jacket_view_crop_image (self,
-			                                               allocation.width,
-			                                               allocation.height);
-		else
-			priv->scaled = g_object_ref (priv->image);
-	}
-	else if (priv->image_style == BRASERO_JACKET_IMAGE_STRETCH) {
-		guint resolution;
+	if (priv->image_style == BRASERO_JACKET_IMAGE_STRETCH) {
 		GtkWidget *toplevel;
 
 		toplevel = gtk_widget_get_toplevel (GTK_WIDGET (self));
@@ -976,14 +1195,47 @@ brasero_jacket_view_update_image (BraseroJacketView *self)
 			return;
 
 		resolution = gdk_screen_get_resolution (gtk_window_get_screen (GTK_WINDOW (toplevel)));
-		priv->scaled = brasero_jacket_view_scale_image (self, resolution, resolution);
 	}
-	else if (priv->image_style == BRASERO_JACKET_IMAGE_TILE)
-		priv->scaled = g_object_ref (priv->image);
 
-	/* Create a pattern out of the image */
-	brasero_jacket_view_set_textview_background (self);
-	gtk_widget_queue_draw (GTK_WIDGET (self));
+	brasero_jacket_view_get_image_size (self,
+					    resolution,
+					    resolution,
+					    &width,
+					    &height);
+
+	surface = brasero_jacket_view_lookup_surface (self, width, height);
+	if (surface) {
+		if (surface != priv->surface)
+			brasero_jacket_view_set_surface (self, surface);
+		return;
+	}
+
+	/* Scaling a big image takes a while so it is done in a thread and in
+	 * the meantime we keep the current surface if there is one. Only one
+	 * job at a time; the one running restarts us if needed when done. */
+	priv->generation ++;
+	if (priv->scaling)
+		return;
+
+	job = g_new0 (BraseroJacketScaleJob, 1);
+	job->self = g_object_ref (self);
+	job->generation = priv->generation;
+	job->entry = brasero_jacket_surface_new (priv->image,
+						 priv->image_style,
+						 width,
+						 height);
+
+	priv->scaling = TRUE;
+	if (!g_thread_create (brasero_jacket_view_scale_thread,
+			      job,
+			      FALSE,
+			      &error)) {
+		g_warning ("Can't start thread : %s\n", error->message);
+		g_error_free (error);
+
+		/* Do it here then; the result is delivered the same way */
+		brasero_jacket_view_scale_thread (job);
+	}
 }
 
 const gchar *
@@ -1031,12 +1283,19 @@ brasero_jacket_view_set_image (BraseroJacketView *self,
 		}
 		priv->image_path = g_strdup (path);
 
+		brasero_jacket_view_clear_surfaces (self);
 		if (priv->image) {
 			g_object_unref (priv->image);
 			priv->image = NULL;
 		}
 		priv->image = image;
 	}
+	else if (priv->image_style != style && priv->surface) {
+		/* Don't display it in the wrong mode while the new one is
+		 * being prepared */
+		cairo_surface_destroy (priv->surface);
+		priv->surface = NULL;
+	}
 
 	priv->image_style = style;
 	brasero_jacket_view_update_image (self);
@@ -1063,11 +1322,7 @@ brasero_jacket_view_set_color (BraseroJacketView *self,
 		priv->image_path = NULL;
 	}
 
-	if (priv->scaled) {
-		g_object_unref (priv->scaled);
-		priv->scaled = NULL;
-	}
-
+	brasero_jacket_view_clear_surfaces (self);
 	if (priv->image) {
 		g_object_unref (priv->image);
 		priv->image = NULL;
@@ -1191,7 +1446,7 @@ brasero_jacket_view_draw (GtkWidget *widget,
 		brasero_jacket_view_render (BRASERO_JACKET_VIEW (widget),
 					    ctx,
 					    layout,
-					    priv->scaled,
+					    priv->surface,
 					    resolution,
 					    resolution,
 					    x,
@@ -1221,7 +1476,7 @@ brasero_jacket_view_draw (GtkWidget *widget,
 		brasero_jacket_view_render (BRASERO_JACKET_VIEW (widget),
 					    ctx,
 					    layout,
-					    priv->scaled,
+					    priv->surface,
 					    resolution,
 					    resolution,
 					    x,
@@ -1349,15 +1604,9 @@ brasero_jacket_view_size_allocate (GtkWidget *widget,
 	resolution = gdk_screen_get_resolution (gtk_window_get_screen (GTK_WINDOW (toplevel)));
 	priv = BRASERO_JACKET_VIEW_PRIVATE (widget);
 
-	if (priv->image && priv->image_style == BRASERO_JACKET_IMAGE_STRETCH) {
-		if (priv->scaled) {
-			g_object_unref (priv->scaled);
-			priv->scaled = NULL;
-		}
-
-		/* scale pixbuf */
+	/* This is cheap when the surface for this size is cached already */
+	if (priv->image)
 		brasero_jacket_view_update_image (BRASERO_JACKET_VIEW (widget));
-	}
 
 	view_alloc.x = BRASERO_JACKET_VIEW_MARGIN + COVER_TEXT_MARGIN * resolution;
 	view_alloc.y = BRASERO_JACKET_VIEW_MARGIN + COVER_TEXT_MARGIN * resolution;
@@ -1502,10 +1751,7 @@ brasero_jacket_view_finalize (GObject *object)
 		priv->image = NULL;
 	}
 
-	if (priv->scaled) {
-		g_object_unref (priv->scaled);
-		priv->scaled = NULL;
-	}
+	brasero_jacket_view_clear_surfaces (BRASERO_JACKET_VIEW (object));
 
 	if (priv->image_path) {
 		g_free (priv->image_path);
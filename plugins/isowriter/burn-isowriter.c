@@ -0,0 +1,612 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib-object.h>
+#include <glib/gstdio.h>
+#include <glib/gi18n-lib.h>
+#include <gmodule.h>
+
+#include "burn-job.h"
+#include "burn-iso-image.h"
+#include "brasero-plugin-registration.h"
+#include "brasero-track-data.h"
+#include "brasero-track-data-cfg-private.h"
+#include "brasero-track-image.h"
+
+
+#define BRASERO_TYPE_ISOWRITER         (brasero_isowriter_get_type ())
+#define BRASERO_ISOWRITER(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), BRASERO_TYPE_ISOWRITER, BraseroIsowriter))
+#define BRASERO_ISOWRITER_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), BRASERO_TYPE_ISOWRITER, BraseroIsowriterClass))
+#define BRASERO_IS_ISOWRITER(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), BRASERO_TYPE_ISOWRITER))
+#define BRASERO_IS_ISOWRITER_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), BRASERO_TYPE_ISOWRITER))
+#define BRASERO_ISOWRITER_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), BRASERO_TYPE_ISOWRITER, BraseroIsowriterClass))
+
+BRASERO_PLUGIN_BOILERPLATE (BraseroIsowriter, brasero_isowriter, BRASERO_TYPE_JOB, BraseroJob);
+
+struct _BraseroIsowriterPrivate {
+	BraseroIsoImage *image;
+
+	int fd;
+	gint64 written;
+
+	GError *error;
+	GThread *thread;
+	GMutex *mutex;
+	GCond *cond;
+	guint thread_id;
+
+	guint dedup:1;
+	guint cancel:1;
+	guint from_tree:1;
+	guint laid_out:1;
+};
+typedef struct _BraseroIsowriterPrivate BraseroIsowriterPrivate;
+
+#define BRASERO_ISOWRITER_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_ISOWRITER, BraseroIsowriterPrivate))
+
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_DEDUP_FILES		"dedup-files"
+
+static GObjectClass *parent_class = NULL;
+
+static gboolean
+brasero_isowriter_thread_finished (gpointer data)
+{
+	BraseroIsowriter *self = data;
+	BraseroIsowriterPrivate *priv;
+	BraseroJobAction action;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	priv->thread_id = 0;
+	if (priv->error) {
+		GError *error;
+
+		error = priv->error;
+		priv->error = NULL;
+		brasero_job_error (BRASERO_JOB (self), error);
+		return FALSE;
+	}
+
+	brasero_job_get_action (BRASERO_JOB (self), &action);
+	if (action == BRASERO_JOB_ACTION_IMAGE
+	&&  brasero_job_get_fd_out (BRASERO_JOB (self), NULL) != BRASERO_BURN_OK) {
+		BraseroTrackImage *track = NULL;
+		gchar *output = NULL;
+
+		/* Let's make a track */
+		track = brasero_track_image_new ();
+		brasero_job_get_image_output (BRASERO_JOB (self),
+					      &output,
+					      NULL);
+		brasero_track_image_set_source (track,
+						output,
+						NULL,
+						BRASERO_IMAGE_FORMAT_BIN);
+		brasero_track_image_set_block_num (track, brasero_iso_image_get_blocks (priv->image));
+		g_free (output);
+
+		brasero_job_add_track (BRASERO_JOB (self), BRASERO_TRACK (track));
+		g_object_unref (track);
+	}
+
+	brasero_job_finished_track (BRASERO_JOB (self));
+	return FALSE;
+}
+
+static gboolean
+brasero_isowriter_write_cb (const guchar *buffer,
+			    gsize bytes,
+			    gpointer user_data,
+			    GError **error)
+{
+	BraseroIsowriter *self = BRASERO_ISOWRITER (user_data);
+	BraseroIsowriterPrivate *priv;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	while (bytes) {
+		gssize written;
+
+		if (priv->cancel)
+			return FALSE;
+
+		written = write (priv->fd, buffer, bytes);
+		if (written < 0) {
+			struct pollfd pfd;
+			int errsv = errno;
+
+			if (errsv == EINTR)
+				continue;
+
+			if (errsv != EAGAIN) {
+				g_set_error (error,
+					     BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_GENERAL,
+					     _("Data could not be written (%s)"),
+					     g_strerror (errsv));
+				return FALSE;
+			}
+
+			/* The pipe is full: wait for the reader but wake up
+			 * from time to time to check for cancellation */
+			pfd.fd = priv->fd;
+			pfd.events = POLLOUT;
+			pfd.revents = 0;
+			poll (&pfd, 1, 200);
+			continue;
+		}
+
+		buffer += written;
+		bytes -= written;
+		priv->written += written;
+	}
+
+	brasero_job_set_written_track (BRASERO_JOB (self), priv->written);
+	return TRUE;
+}
+
+static BraseroBurnResult
+brasero_isowriter_write_image (BraseroIsowriter *self,
+			       GError **error)
+{
+	BraseroIsowriterPrivate *priv;
+	BraseroBurnResult result;
+	gboolean is_pipe;
+	gchar *output = NULL;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	priv->written = 0;
+	is_pipe = (brasero_job_get_fd_out (BRASERO_JOB (self), &priv->fd) == BRASERO_BURN_OK);
+	if (is_pipe) {
+		brasero_job_set_nonblocking (BRASERO_JOB (self), NULL);
+		BRASERO_JOB_LOG (self, "Writing to pipe");
+	}
+	else {
+		brasero_job_get_image_output (BRASERO_JOB (self), &output, NULL);
+		priv->fd = g_open (output, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+		if (priv->fd < 0) {
+			int errsv = errno;
+
+			if (errsv == EACCES)
+				g_set_error_literal (error,
+						     BRASERO_BURN_ERROR,
+						     BRASERO_BURN_ERROR_PERMISSION,
+						     _("You do not have the required permission to write at this location"));
+			else
+				g_set_error_literal (error,
+						     BRASERO_BURN_ERROR,
+						     BRASERO_BURN_ERROR_GENERAL,
+						     g_strerror (errsv));
+			g_free (output);
+			return BRASERO_BURN_ERR;
+		}
+
+		BRASERO_JOB_LOG (self, "Writing to file %s", output);
+		g_free (output);
+	}
+
+	brasero_job_start_progress (BRASERO_JOB (self), FALSE);
+	result = brasero_iso_image_write (priv->image,
+					  brasero_isowriter_write_cb,
+					  self,
+					  error);
+
+	if (!is_pipe) {
+		if (close (priv->fd) && result == BRASERO_BURN_OK) {
+			int errsv = errno;
+
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Data could not be written (%s)"),
+				     g_strerror (errsv));
+			result = BRASERO_BURN_ERR;
+		}
+	}
+	priv->fd = -1;
+
+	BRASERO_JOB_LOG (self, "%" G_GINT64_FORMAT " bytes written", priv->written);
+	return result;
+}
+
+/**
+ * Called from the main loop as the tree of a project can only be read there
+ */
+
+static BraseroBurnResult
+brasero_isowriter_new_image (BraseroIsowriter *self,
+			     GError **error)
+{
+	BraseroIsowriterPrivate *priv;
+	BraseroTrack *track = NULL;
+	gchar *label = NULL;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	brasero_job_get_data_label (BRASERO_JOB (self), &label);
+
+	priv->image = brasero_iso_image_new (brasero_track_data_get_fs (BRASERO_TRACK_DATA (track)), label);
+	g_free (label);
+
+	if (priv->dedup)
+		brasero_iso_image_share_duplicates (priv->image);
+
+	/* A project already knows its files and their sizes so there is no
+	 * need to explore the grafts again before the first block is out */
+	if (BRASERO_IS_TRACK_DATA_CFG (track)) {
+		BraseroBurnResult result;
+
+		result = brasero_track_data_cfg_add_to_image (BRASERO_TRACK_DATA_CFG (track),
+							      priv->image,
+							      error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+
+		BRASERO_JOB_LOG (self, "Using the tree of the project");
+		priv->from_tree = 1;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_isowriter_create_volume (BraseroIsowriter *self,
+				 GError **error)
+{
+	BraseroIsowriterPrivate *priv;
+	BraseroIsoImage *image;
+	BraseroBurnResult result;
+	BraseroTrack *track = NULL;
+	goffset blocks;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	image = priv->image;
+	if (!priv->from_tree) {
+		brasero_job_get_current_track (BRASERO_JOB (self), &track);
+		result = brasero_iso_image_add_grafts (image,
+						       brasero_track_data_get_grafts (BRASERO_TRACK_DATA (track)),
+						       brasero_track_data_get_excluded_list (BRASERO_TRACK_DATA (track)),
+						       error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+	}
+
+	result = brasero_iso_image_layout (image, error);
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	priv->laid_out = 1;
+
+	blocks = brasero_iso_image_get_blocks (image);
+	BRASERO_JOB_LOG (self,
+			 "Volume laid out: %" G_GUINT64_FORMAT " files, %" G_GINT64_FORMAT " blocks",
+			 brasero_iso_image_get_file_num (image),
+			 blocks);
+
+	brasero_job_set_output_size_for_current_track (BRASERO_JOB (self),
+						       blocks,
+						       blocks * 2048);
+	return BRASERO_BURN_OK;
+}
+
+static gpointer
+brasero_isowriter_thread (gpointer data)
+{
+	BraseroIsowriterPrivate *priv;
+	BraseroIsowriter *self;
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	BraseroJobAction action;
+	GError *error = NULL;
+
+	self = BRASERO_ISOWRITER (data);
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	BRASERO_JOB_LOG (self, "Entering thread");
+
+	brasero_job_get_action (BRASERO_JOB (self), &action);
+	if (!priv->laid_out)
+		result = brasero_isowriter_create_volume (self, &error);
+
+	if (result == BRASERO_BURN_OK && action == BRASERO_JOB_ACTION_IMAGE)
+		result = brasero_isowriter_write_image (self, &error);
+
+	if (result != BRASERO_BURN_OK && !error && !priv->cancel)
+		error = g_error_new_literal (BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_GENERAL,
+					     _("Volume could not be created"));
+
+	BRASERO_JOB_LOG (self, "Getting out thread");
+
+	/* End thread */
+	g_mutex_lock (priv->mutex);
+
+	if (priv->cancel) {
+		if (error)
+			g_error_free (error);
+	}
+	else {
+		priv->error = error;
+		priv->thread_id = g_idle_add (brasero_isowriter_thread_finished, self);
+	}
+
+	priv->thread = NULL;
+	g_cond_signal (priv->cond);
+	g_mutex_unlock (priv->mutex);
+
+	g_thread_exit (NULL);
+
+	return NULL;
+}
+
+static BraseroBurnResult
+brasero_isowriter_create_thread (BraseroIsowriter *self,
+				 GError **error)
+{
+	BraseroIsowriterPrivate *priv;
+	GError *thread_error = NULL;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+	if (priv->thread)
+		return BRASERO_BURN_RUNNING;
+
+	g_mutex_lock (priv->mutex);
+	priv->thread = g_thread_create (brasero_isowriter_thread,
+					self,
+					FALSE,
+					&thread_error);
+	g_mutex_unlock (priv->mutex);
+
+	/* Reminder: this is not necessarily an error as the thread may have finished */
+	if (thread_error) {
+		g_propagate_error (error, thread_error);
+		return BRASERO_BURN_ERR;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_isowriter_clean_output (BraseroIsowriter *self)
+{
+	BraseroIsowriterPrivate *priv;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	if (priv->image) {
+		brasero_iso_image_free (priv->image);
+		priv->image = NULL;
+	}
+
+	priv->from_tree = 0;
+	priv->laid_out = 0;
+
+	if (priv->error) {
+		g_error_free (priv->error);
+		priv->error = NULL;
+	}
+}
+
+static BraseroBurnResult
+brasero_isowriter_start (BraseroJob *job,
+			 GError **error)
+{
+	BraseroIsowriter *self;
+	BraseroJobAction action;
+	BraseroIsowriterPrivate *priv;
+
+	self = BRASERO_ISOWRITER (job);
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	brasero_job_get_action (job, &action);
+	if (action == BRASERO_JOB_ACTION_SIZE) {
+		BraseroBurnResult result;
+
+		/* The contents of the selection may have changed since last
+		 * time so always lay out the volume again */
+		brasero_isowriter_clean_output (self);
+		result = brasero_isowriter_new_image (self, error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+
+		brasero_job_set_current_action (job,
+						BRASERO_BURN_ACTION_GETTING_SIZE,
+						NULL,
+						FALSE);
+		return brasero_isowriter_create_thread (self, error);
+	}
+
+	if (action != BRASERO_JOB_ACTION_IMAGE)
+		BRASERO_JOB_NOT_SUPPORTED (self);
+
+	if (priv->error) {
+		g_error_free (priv->error);
+		priv->error = NULL;
+	}
+
+	/* If the volume was laid out when the size was
+	 * computed, the thread only writes it */
+	if (!priv->laid_out) {
+		BraseroBurnResult result;
+
+		brasero_isowriter_clean_output (self);
+		result = brasero_isowriter_new_image (self, error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+	}
+
+	brasero_job_set_current_action (job,
+					BRASERO_BURN_ACTION_CREATING_IMAGE,
+					NULL,
+					FALSE);
+	return brasero_isowriter_create_thread (self, error);
+}
+
+static void
+brasero_isowriter_stop_real (BraseroIsowriter *self)
+{
+	BraseroIsowriterPrivate *priv;
+	gboolean cancelled = FALSE;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (self);
+
+	/* Check whether we properly shut down or if we were cancelled */
+	g_mutex_lock (priv->mutex);
+	if (priv->thread) {
+		/* A thread is running. In this context we are probably cancelling */
+		if (priv->image)
+			brasero_iso_image_cancel (priv->image);
+
+		priv->cancel = 1;
+		g_cond_wait (priv->cond, priv->mutex);
+		priv->cancel = 0;
+		cancelled = TRUE;
+	}
+	g_mutex_unlock (priv->mutex);
+
+	if (priv->thread_id) {
+		g_source_remove (priv->thread_id);
+		priv->thread_id = 0;
+	}
+
+	/* A cancelled volume can't be written anymore */
+	if (cancelled)
+		brasero_isowriter_clean_output (self);
+}
+
+static BraseroBurnResult
+brasero_isowriter_stop (BraseroJob *job,
+			GError **error)
+{
+	brasero_isowriter_stop_real (BRASERO_ISOWRITER (job));
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_isowriter_class_init (BraseroIsowriterClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	BraseroJobClass *job_class = BRASERO_JOB_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (BraseroIsowriterPrivate));
+
+	parent_class = g_type_class_peek_parent(klass);
+	object_class->finalize = brasero_isowriter_finalize;
+
+	job_class->start = brasero_isowriter_start;
+	job_class->stop = brasero_isowriter_stop;
+}
+
+static void
+brasero_isowriter_init (BraseroIsowriter *obj)
+{
+	BraseroIsowriterPrivate *priv;
+	GSettings *settings;
+
+	priv = BRASERO_ISOWRITER_PRIVATE (obj);
+	priv->fd = -1;
+	priv->mutex = g_mutex_new ();
+	priv->cond = g_cond_new ();
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	priv->dedup = g_settings_get_boolean (settings, BRASERO_KEY_DEDUP_FILES);
+	g_object_unref (settings);
+}
+
+static void
+brasero_isowriter_finalize (GObject *object)
+{
+	BraseroIsowriter *cobj;
+	BraseroIsowriterPrivate *priv;
+
+	cobj = BRASERO_ISOWRITER (object);
+	priv = BRASERO_ISOWRITER_PRIVATE (object);
+
+	brasero_isowriter_stop_real (cobj);
+	brasero_isowriter_clean_output (cobj);
+
+	if (priv->mutex) {
+		g_mutex_free (priv->mutex);
+		priv->mutex = NULL;
+	}
+
+	if (priv->cond) {
+		g_cond_free (priv->cond);
+		priv->cond = NULL;
+	}
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+brasero_isowriter_export_caps (BraseroPlugin *plugin)
+{
+	GSList *output;
+	GSList *input;
+
+	/* NOTE: no flags are set so appending to or merging with a previous
+	 * session is left to genisoimage and libisofs. Neither does it write
+	 * files bigger than 4 GiB (ISO9660 level 3) nor symlinks. */
+	brasero_plugin_define (plugin,
+			       "isowriter",
+	                       NULL,
+			       _("Creates disc images from a file selection"),
+			       "Philippe Rouquier",
+			       4);
+
+	/* Duplicates point to the extent of the first copy */
+	brasero_plugin_set_shares_duplicates (plugin, TRUE);
+
+	output = brasero_caps_image_new (BRASERO_PLUGIN_IO_ACCEPT_FILE|
+					 BRASERO_PLUGIN_IO_ACCEPT_PIPE,
+					 BRASERO_IMAGE_FORMAT_BIN);
+
+	input = brasero_caps_data_new (BRASERO_IMAGE_FS_ISO|
+				       BRASERO_IMAGE_ISO_FS_DEEP_DIRECTORY|
+				       BRASERO_IMAGE_FS_JOLIET);
+	brasero_plugin_link_caps (plugin, output, input);
+	g_slist_free (input);
+
+	g_slist_free (output);
+}
@@ -389,6 +389,13 @@ brasero_libburn_common_status (BraseroJob *self,
 
 	if (ctx->status == BURN_DRIVE_WRITING) {
 		gint64 cur_sector;
+		gint fifo = -1;
+
+		if (progress.buffer_capacity > 0)
+			fifo = (progress.buffer_capacity - progress.buffer_available) * 100 /
+			       progress.buffer_capacity;
+
+		brasero_job_set_buffer_fill (self, fifo, -1);
 
 		if (ctx->track_num != progress.track) {
 			/* This is when we change tracks */
@@ -54,6 +54,7 @@
 #include "burn-libburnia.h"
 #include "brasero-track-image.h"
 #include "brasero-track-stream.h"
+#include "brasero-track-disc.h"
 
 
 #define BRASERO_TYPE_LIBBURN         (brasero_libburn_get_type ())
@@ -67,6 +68,12 @@ BRASERO_PLUGIN_BOILERPLATE (BraseroLibburn, brasero_libburn, BRASERO_TYPE_JOB, B
 
 #define BRASERO_PVD_SIZE	32ULL * 2048ULL
 
+/* When reading a file, how much is read ahead of the current position and
+ * how much is read before the kernel is told it can drop it from its cache
+ * (so that burning a BD image does not evict everything else). */
+#define BRASERO_LIBBURN_PREFETCH	(16 * 1024 * 1024)
+#define BRASERO_LIBBURN_DROP_BEHIND	(32 * 1024 * 1024)
+
 struct _BraseroLibburnPrivate {
 	BraseroLibburnCtx *ctx;
 
@@ -99,7 +106,14 @@ struct _BraseroLibburnSrcData {
 	int pvd_size;						/* in blocks */
 	unsigned char *pvd;
 
+	/* Used for regular files only */
+	off_t position;
+	off_t prefetched;
+	off_t dropped;
+	gint64 start;
+
 	int read_pvd:1;
+	int regular:1;
 };
 typedef struct _BraseroLibburnSrcData BraseroLibburnSrcData;
 
@@ -109,10 +123,48 @@ brasero_libburn_src_free_data (struct burn_source *src)
 	BraseroLibburnSrcData *data;
 
 	data = src->data;
+
+	if (data->regular && data->position) {
+		gint64 elapsed;
+
+		elapsed = g_get_monotonic_time () - data->start;
+		BRASERO_BURN_LOG ("Read %lli bytes from file at %lli bytes/s",
+				  (long long int) data->position,
+				  (long long int) (elapsed > 0 ? data->position * G_USEC_PER_SEC / elapsed : 0));
+	}
+
 	close (data->fd);
 	g_free (data);
 }
 
+static void
+brasero_libburn_src_advise (BraseroLibburnSrcData *data)
+{
+#ifdef POSIX_FADV_WILLNEED
+	/* Keep at least half the prefetch window ahead of libburn. The
+	 * kernel reads it asynchronously so the reads below don't wait. */
+	if (data->prefetched < data->position)
+		data->prefetched = data->position;
+
+	if (data->prefetched - data->position < BRASERO_LIBBURN_PREFETCH / 2
+	&&  data->prefetched < data->size) {
+		posix_fadvise (data->fd,
+			       data->prefetched,
+			       BRASERO_LIBBURN_PREFETCH,
+			       POSIX_FADV_WILLNEED);
+		data->prefetched += BRASERO_LIBBURN_PREFETCH;
+	}
+
+	if (data->position - data->dropped >= BRASERO_LIBBURN_DROP_BEHIND) {
+		posix_fadvise (data->fd,
+			       data->dropped,
+			       data->position - data->dropped,
+			       POSIX_FADV_DONTNEED);
+		data->dropped = data->position;
+	}
+#endif
+}
+
 static off_t
 brasero_libburn_src_get_size (struct burn_source *src)
 {
@@ -168,6 +220,11 @@ brasero_libburn_src_read_xt (struct burn_source *src,
 		total += bytes;
 	}
 
+	if (data->regular) {
+		data->position += total;
+		brasero_libburn_src_advise (data);
+	}
+
 	/* copy the primary volume descriptor if a buffer is provided */
 	if (data->pvd
 	&& !data->read_pvd
@@ -208,12 +265,23 @@ brasero_libburn_create_fd_source (int fd,
 {
 	struct burn_source *src;
 	BraseroLibburnSrcData *data;
+	struct stat info;
 
 	data = g_new0 (BraseroLibburnSrcData, 1);
 	data->fd = fd;
 	data->size = size;
 	data->pvd = pvd;
 
+	/* Images and audio files (not pipes) are read ahead */
+	if (!fstat (fd, &info) && S_ISREG (info.st_mode)) {
+		data->regular = 1;
+		data->start = g_get_monotonic_time ();
+#ifdef POSIX_FADV_SEQUENTIAL
+		posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+		brasero_libburn_src_advise (data);
+	}
+
 	/* FIXME: this could be wrapped into a fifo source to get a smoother
 	 * data delivery. But that means another thread ... */
 	src = g_new0 (struct burn_source, 1);
@@ -353,6 +421,33 @@ brasero_libburn_setup_session_fd (BraseroLibburn *self,
 			BraseroTrack *track;
 
 			track = tracks->data;
+
+			/* Audio CD copied on the fly: all the tracks of the
+			 * source disc come through the pipe, one after the
+			 * other, with the same sizes */
+			if (BRASERO_IS_TRACK_DISC (track)) {
+				BraseroMedium *medium;
+				guint track_num;
+				guint i;
+
+				medium = brasero_drive_get_medium (brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track)));
+				track_num = brasero_medium_get_track_num (medium);
+				for (i = 1; i <= track_num; i ++) {
+					goffset sectors = 0;
+
+					brasero_medium_get_track_space (medium, i, NULL, &sectors);
+					result = brasero_libburn_add_fd_track (session,
+									       dup (fd),
+									       BURN_AUDIO,
+									       sectors * 2352,
+									       NULL,
+									       error);
+					if (result != BRASERO_BURN_OK)
+						return result;
+				}
+				continue;
+			}
+
 			brasero_track_stream_get_length (BRASERO_TRACK_STREAM (track), &length);
 			bytes = BRASERO_DURATION_TO_BYTES (length);
 
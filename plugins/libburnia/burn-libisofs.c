@@ -49,6 +49,7 @@
 
 #include "burn-libburnia.h"
 #include "burn-job.h"
+#include "burn-dedup.h"
 #include "brasero-units.h"
 #include "brasero-plugin-registration.h"
 #include "burn-libburn-common.h"
@@ -77,12 +78,18 @@ struct _BraseroLibisofsPrivate {
 	GCond *cond;
 	guint thread_id;
 
+	BraseroDedup *dedup;
+
+	guint share_duplicates:1;
 	guint cancel:1;
 };
 typedef struct _BraseroLibisofsPrivate BraseroLibisofsPrivate;
 
 #define BRASERO_LIBISOFS_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_LIBISOFS, BraseroLibisofsPrivate))
 
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_DEDUP_FILES		"dedup-files"
+
 static GObjectClass *parent_class = NULL;
 
 static gboolean
@@ -539,6 +546,176 @@ brasero_libisofs_import_last_session (BraseroLibisofs *self,
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_libisofs_collect_files (BraseroDedup *dedup,
+				GHashTable *grafts,
+				IsoDir *directory,
+				const gchar *disc_path,
+				const gchar *local_path,
+				GPtrArray *nodes,
+				GPtrArray *paths)
+{
+	IsoDirIter *iter = NULL;
+	IsoNode *node;
+
+	iso_dir_get_children (directory, &iter);
+	while (iso_dir_iter_next (iter, &node) == 1) {
+		const gchar *name;
+		gchar *node_disc;
+		gchar *node_local;
+
+		name = iso_node_get_name (node);
+		if (!name)
+			continue;
+
+		/* Nodes imported from a previous session have no local path */
+		node_disc = g_build_path (G_DIR_SEPARATOR_S, disc_path, name, NULL);
+		node_local = g_strdup (g_hash_table_lookup (grafts, node_disc));
+		if (!node_local && local_path)
+			node_local = g_build_filename (local_path, name, NULL);
+
+		if (iso_node_get_type (node) == LIBISO_DIR)
+			brasero_libisofs_collect_files (dedup,
+							grafts,
+							ISO_DIR (node),
+							node_disc,
+							node_local,
+							nodes,
+							paths);
+		else if (iso_node_get_type (node) == LIBISO_FILE && node_local) {
+			brasero_dedup_add (dedup, node_local);
+			g_ptr_array_add (nodes, node);
+			g_ptr_array_add (paths, node_local);
+			node_local = NULL;
+		}
+
+		g_free (node_local);
+		g_free (node_disc);
+	}
+	iso_dir_iter_free (iter);
+}
+
+/* Replace the nodes of identical files by nodes of the first of them;
+ * libisofs writes the data of nodes created from the same file once */
+static void
+brasero_libisofs_share_duplicates (BraseroLibisofs *self,
+				   IsoImage *image,
+				   GSList *grafts)
+{
+	BraseroLibisofsPrivate *priv;
+	BraseroDedup *dedup;
+	GHashTable *table;
+	GPtrArray *nodes;
+	GPtrArray *paths;
+	guint shared = 0;
+	GSList *iter;
+	guint i;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+
+	/* disc path => local path */
+	table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	for (iter = grafts; iter; iter = iter->next) {
+		BraseroGraftPt *graft;
+		gchar *disc_path;
+		gchar *local_path;
+
+		graft = iter->data;
+		if (!graft->uri)
+			continue;
+
+		if (graft->uri [0] == '/')
+			local_path = g_strdup (graft->uri);
+		else
+			local_path = g_filename_from_uri (graft->uri, NULL, NULL);
+
+		if (!local_path)
+			continue;
+
+		disc_path = g_strdup (graft->path);
+		if (g_str_has_suffix (disc_path, G_DIR_SEPARATOR_S))
+			disc_path [strlen (disc_path) - 1] = '\0';
+
+		g_hash_table_replace (table, disc_path, local_path);
+	}
+
+	dedup = brasero_dedup_new ();
+	nodes = g_ptr_array_new ();
+	paths = g_ptr_array_new ();
+	brasero_libisofs_collect_files (dedup,
+					table,
+					iso_image_get_root (image),
+					G_DIR_SEPARATOR_S,
+					NULL,
+					nodes,
+					paths);
+	g_hash_table_destroy (table);
+
+	/* Publish it so that it can be cancelled */
+	g_mutex_lock (priv->mutex);
+	priv->dedup = dedup;
+	if (priv->cancel)
+		brasero_dedup_cancel (dedup);
+	g_mutex_unlock (priv->mutex);
+
+	if (brasero_dedup_run (dedup) == BRASERO_BURN_OK) {
+		for (i = 0; i < nodes->len; i ++) {
+			const gchar *original;
+			IsoNode *node;
+			IsoNode *copy;
+			IsoDir *parent;
+			gchar *name;
+			int err;
+
+			original = brasero_dedup_get_original (dedup, g_ptr_array_index (paths, i));
+			if (!original)
+				continue;
+
+			/* The new node keeps the attributes of the one it
+			 * replaces; only the data is shared */
+			node = g_ptr_array_index (nodes, i);
+			parent = iso_node_get_parent (node);
+			name = g_strdup (iso_node_get_name (node));
+
+			iso_node_ref (node);
+			iso_node_remove (node);
+
+			err = iso_tree_add_new_node (image, parent, name, original, &copy);
+			if (err < 0)
+				iso_dir_add_node (parent, node, 0);
+			else {
+				iso_node_set_permissions (copy, iso_node_get_permissions (node));
+				iso_node_set_uid (copy, iso_node_get_uid (node));
+				iso_node_set_gid (copy, iso_node_get_gid (node));
+				iso_node_set_mtime (copy, iso_node_get_mtime (node));
+				iso_node_set_atime (copy, iso_node_get_atime (node));
+				iso_node_set_ctime (copy, iso_node_get_ctime (node));
+				shared ++;
+			}
+			iso_node_unref (node);
+
+			if (err < 0)
+				BRASERO_JOB_LOG (self,
+						 "ERROR %s could not share the data of %s (%x)",
+						 name,
+						 original,
+						 err);
+			g_free (name);
+		}
+	}
+
+	g_mutex_lock (priv->mutex);
+	priv->dedup = NULL;
+	g_mutex_unlock (priv->mutex);
+
+	BRASERO_JOB_LOG (self, "%u files share the data of another one", shared);
+
+	brasero_dedup_free (dedup);
+	g_ptr_array_free (nodes, TRUE);
+	g_ptr_array_foreach (paths, (GFunc) g_free, NULL);
+	g_ptr_array_free (paths, TRUE);
+}
+
 static gpointer
 brasero_libisofs_create_volume_thread (gpointer data)
 {
@@ -818,6 +995,8 @@ brasero_libisofs_create_volume_thread (gpointer data)
 		g_free (path_name);
 	}
 
+	if (priv->share_duplicates && !priv->cancel)
+		brasero_libisofs_share_duplicates (self, image, grafts);
 
 end:
 
@@ -990,6 +1169,9 @@ brasero_libisofs_stop_real (BraseroLibisofs *self)
 		if (priv->libburn_src)
 			priv->libburn_src->cancel (priv->libburn_src);
 
+		if (priv->dedup)
+			brasero_dedup_cancel (priv->dedup);
+
 		priv->cancel = 1;
 		g_cond_wait (priv->cond, priv->mutex);
 		priv->cancel = 0;
@@ -1032,10 +1214,15 @@ static void
 brasero_libisofs_init (BraseroLibisofs *obj)
 {
 	BraseroLibisofsPrivate *priv;
+	GSettings *settings;
 
 	priv = BRASERO_LIBISOFS_PRIVATE (obj);
 	priv->mutex = g_mutex_new ();
 	priv->cond = g_cond_new ();
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	priv->share_duplicates = g_settings_get_boolean (settings, BRASERO_KEY_DEDUP_FILES);
+	g_object_unref (settings);
 }
 
 static void
@@ -1079,6 +1266,9 @@ brasero_libisofs_export_caps (BraseroPlugin *plugin)
 			       "Philippe Rouquier",
 			       3);
 
+	/* See brasero_libisofs_share_duplicates () */
+	brasero_plugin_set_shares_duplicates (plugin, TRUE);
+
 	brasero_plugin_set_flags (plugin,
 				  BRASERO_MEDIUM_CDR|
 				  BRASERO_MEDIUM_CDRW|
@@ -0,0 +1,1149 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ *
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib-object.h>
+#include <glib/gi18n-lib.h>
+#include <gmodule.h>
+
+#include "brasero-units.h"
+
+#include "burn-job.h"
+#include "brasero-plugin-registration.h"
+#include "brasero-medium.h"
+#include "brasero-drive.h"
+#include "brasero-track-disc.h"
+#include "brasero-track-stream.h"
+
+#include "scsi-device.h"
+#include "scsi-error.h"
+#include "scsi-mmc1.h"
+#include "scsi-read-cd.h"
+
+
+#define BRASERO_TYPE_READ_CDDA         (brasero_read_cdda_get_type ())
+#define BRASERO_READ_CDDA(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), BRASERO_TYPE_READ_CDDA, BraseroReadCdda))
+#define BRASERO_READ_CDDA_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), BRASERO_TYPE_READ_CDDA, BraseroReadCddaClass))
+#define BRASERO_IS_READ_CDDA(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), BRASERO_TYPE_READ_CDDA))
+#define BRASERO_IS_READ_CDDA_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), BRASERO_TYPE_READ_CDDA))
+#define BRASERO_READ_CDDA_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), BRASERO_TYPE_READ_CDDA, BraseroReadCddaClass))
+
+BRASERO_PLUGIN_BOILERPLATE (BraseroReadCdda, brasero_read_cdda, BRASERO_TYPE_JOB, BraseroJob);
+
+struct _BraseroReadCddaPrivate {
+	GError *error;
+	GThread *thread;
+	GMutex *mutex;
+	GCond *cond;
+	guint thread_id;
+
+	/* Ring of buffers between the reading/verifying thread and the
+	 * writing thread */
+	GAsyncQueue *free_buffers;
+	GAsyncQueue *full_buffers;
+	GError *write_error;
+
+	/* Only set when writing one file per track */
+	gchar *file_pattern;
+	FILE *output;
+
+	guint track_num;
+	goffset *track_addresses;
+	goffset *track_sectors;
+
+	/* set by the writing thread */
+	gint write_failed;
+
+	guint cancel:1;
+	guint big_endian:1;
+};
+typedef struct _BraseroReadCddaPrivate BraseroReadCddaPrivate;
+
+#define BRASERO_READ_CDDA_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_READ_CDDA, BraseroReadCddaPrivate))
+
+#define BRASERO_CDDA_SECTOR_SIZE	2352
+#define BRASERO_CDDA_SUB_Q_SIZE		16
+
+/* Sectors in one READ CD command (stays under 64 KiB with the Q sub-channel),
+ * number of buffers in the ring (about 4 seconds of audio) and number of
+ * reads that can wait to be verified */
+#define BRASERO_READ_CDDA_BLOCKS	24
+#define BRASERO_READ_CDDA_BUFFERS	12
+#define BRASERO_READ_CDDA_RAW_BUFFERS	4
+
+/* Each read starts that many sectors before the first sector needed. These
+ * must be identical to the end of the previous read or the drive jittered. */
+#define BRASERO_READ_CDDA_OVERLAP	2
+
+#define BRASERO_READ_CDDA_RETRIES	5
+
+struct _BraseroReadCddaBuffer {
+	guchar *data;
+	gint blocks;
+};
+typedef struct _BraseroReadCddaBuffer BraseroReadCddaBuffer;
+
+/* What one READ CD command returned, with the sectors overlapping the
+ * previous read and the Q sub-channel if any */
+struct _BraseroReadCddaRaw {
+	guchar *data;
+	goffset address;
+	gint blocks;
+	gint overlap;
+	gint stride;
+	guint generation;
+};
+typedef struct _BraseroReadCddaRaw BraseroReadCddaRaw;
+
+struct _BraseroReadCddaState {
+	BraseroReadCdda *self;
+	BraseroDeviceHandle *handle;
+
+	/* Ring of reads between the reading and the verifying thread */
+	BraseroReadCddaRaw raw [BRASERO_READ_CDDA_RAW_BUFFERS];
+	GAsyncQueue *free_raw;
+	GAsyncQueue *full_raw;
+	BraseroReadCddaBuffer write_end;
+
+	/* protected by lock: set by the verifying thread to have the reading
+	 * thread start again from an address or stop */
+	GMutex *lock;
+	GCond *cond;
+	guint generation;
+	goffset rewind;
+	guint rewind_pending:1;
+	guint verified:1;
+
+	gint use_sub_q;
+
+	/* reading thread only */
+	guint sub_q_tested:1;
+
+	/* verifying thread only */
+	guchar tail [BRASERO_READ_CDDA_OVERLAP * BRASERO_CDDA_SECTOR_SIZE];
+	GError *error;
+};
+typedef struct _BraseroReadCddaState BraseroReadCddaState;
+
+#define BCD_TO_INT(bcd)		((((bcd) >> 4) & 0x0F) * 10 + ((bcd) & 0x0F))
+
+static GObjectClass *parent_class = NULL;
+
+static goffset
+brasero_read_cdda_get_tracks (BraseroReadCdda *self)
+{
+	BraseroReadCddaPrivate *priv;
+	BraseroMedium *medium;
+	BraseroTrack *track;
+	BraseroDrive *drive;
+	goffset total = 0;
+	guint i;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
+	medium = brasero_drive_get_medium (drive);
+
+	g_free (priv->track_addresses);
+	g_free (priv->track_sectors);
+	priv->track_num = brasero_medium_get_track_num (medium);
+	priv->track_addresses = g_new0 (goffset, priv->track_num);
+	priv->track_sectors = g_new0 (goffset, priv->track_num);
+
+	for (i = 0; i < priv->track_num; i ++) {
+		brasero_medium_get_track_address (medium,
+						  i + 1,
+						  NULL,
+						  priv->track_addresses + i);
+		brasero_medium_get_track_space (medium,
+						i + 1,
+						NULL,
+						priv->track_sectors + i);
+		total += priv->track_sectors [i];
+	}
+
+	return total;
+}
+
+static gboolean
+brasero_read_cdda_thread_finished (gpointer data)
+{
+	BraseroReadCdda *self = data;
+	BraseroReadCddaPrivate *priv;
+	guint i;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+	priv->thread_id = 0;
+
+	if (priv->error) {
+		GError *error;
+
+		error = priv->error;
+		priv->error = NULL;
+		brasero_job_error (BRASERO_JOB (self), error);
+		return FALSE;
+	}
+
+	for (i = 0; i < priv->track_num; i ++) {
+		BraseroTrackStream *track;
+
+		track = brasero_track_stream_new ();
+		brasero_track_stream_set_format (track,
+						 priv->big_endian? BRASERO_AUDIO_FORMAT_RAW:
+								   BRASERO_AUDIO_FORMAT_RAW_LITTLE_ENDIAN);
+
+		if (priv->file_pattern) {
+			gchar *filename;
+			gchar *uri;
+
+			filename = g_strdup_printf ("%s_%02i.raw", priv->file_pattern, i + 1);
+			uri = g_filename_to_uri (filename, NULL, NULL);
+			g_free (filename);
+
+			brasero_track_stream_set_source (track, uri);
+			g_free (uri);
+		}
+
+		/* Always set the boundaries after the source as
+		 * brasero_track_stream_set_source () resets the length */
+		brasero_track_stream_set_boundaries (track,
+						     0,
+						     BRASERO_BYTES_TO_DURATION (priv->track_sectors [i] * BRASERO_CDDA_SECTOR_SIZE),
+						     0);
+		brasero_job_add_track (BRASERO_JOB (self), BRASERO_TRACK (track));
+		g_object_unref (track);
+	}
+
+	brasero_job_finished_session (BRASERO_JOB (self));
+	return FALSE;
+}
+
+static gboolean
+brasero_read_cdda_write (BraseroReadCdda *self,
+			 int fd,
+			 guchar *buffer,
+			 gint bytes_remaining)
+{
+	gint bytes_written = 0;
+	BraseroReadCddaPrivate *priv;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	if (priv->output) {
+		if (fwrite (buffer, 1, bytes_remaining, priv->output) == (gsize) bytes_remaining)
+			return TRUE;
+
+		priv->write_error = g_error_new (BRASERO_BURN_ERROR,
+						 BRASERO_BURN_ERROR_GENERAL,
+						 _("Data could not be written (%s)"),
+						 g_strerror (errno));
+		return FALSE;
+	}
+
+	while (bytes_remaining) {
+		gint written;
+
+		written = write (fd,
+				 buffer + bytes_written,
+				 bytes_remaining);
+
+		if (priv->cancel)
+			return FALSE;
+
+		if (written != bytes_remaining) {
+			if (errno != EINTR && errno != EAGAIN) {
+                                int errsv = errno;
+
+				/* unrecoverable error */
+				priv->write_error = g_error_new (BRASERO_BURN_ERROR,
+								 BRASERO_BURN_ERROR_GENERAL,
+								 _("Data could not be written (%s)"),
+								 g_strerror (errsv));
+				return FALSE;
+			}
+
+			g_thread_yield ();
+		}
+
+		if (written > 0) {
+			bytes_remaining -= written;
+			bytes_written += written;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_read_cdda_close_output (BraseroReadCdda *self)
+{
+	BraseroReadCddaPrivate *priv;
+	int res;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+	if (!priv->output)
+		return TRUE;
+
+	res = fclose (priv->output);
+	priv->output = NULL;
+
+	if (res && !priv->write_error) {
+		priv->write_error = g_error_new (BRASERO_BURN_ERROR,
+						 BRASERO_BURN_ERROR_GENERAL,
+						 _("Data could not be written (%s)"),
+						 g_strerror (errno));
+		return FALSE;
+	}
+
+	return (res == 0);
+}
+
+static gboolean
+brasero_read_cdda_next_track (BraseroReadCdda *self,
+			      guint track_index)
+{
+	BraseroReadCddaPrivate *priv;
+	gchar *string;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	string = g_strdup_printf (_("Copying audio track %02d"), track_index + 1);
+	brasero_job_set_current_action (BRASERO_JOB (self),
+					BRASERO_BURN_ACTION_DRIVE_COPY,
+					string,
+					TRUE);
+	g_free (string);
+
+	if (!priv->file_pattern)
+		return TRUE;
+
+	if (!brasero_read_cdda_close_output (self))
+		return FALSE;
+
+	string = g_strdup_printf ("%s_%02i.raw", priv->file_pattern, track_index + 1);
+	priv->output = fopen (string, "w");
+	if (!priv->output) {
+		int errsv = errno;
+
+		BRASERO_JOB_LOG (self, "Could not open %s", string);
+		priv->write_error = g_error_new_literal (BRASERO_BURN_ERROR,
+							 BRASERO_BURN_ERROR_GENERAL,
+							 g_strerror (errsv));
+		g_free (string);
+		return FALSE;
+	}
+	g_free (string);
+
+	return TRUE;
+}
+
+static gpointer
+brasero_read_cdda_write_thread (gpointer data)
+{
+	int fd = -1;
+	gint64 written = 0;
+	guint track_index = 0;
+	goffset track_remaining;
+	BraseroReadCdda *self = data;
+	BraseroReadCddaPrivate *priv;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	if (!priv->file_pattern)
+		brasero_job_get_fd_out (BRASERO_JOB (self), &fd);
+
+	track_remaining = priv->track_sectors [0];
+	if (!brasero_read_cdda_next_track (self, 0))
+		g_atomic_int_set (&priv->write_failed, 1);
+
+	/* Once writing failed, keep on handing the buffers back so that the
+	 * reading thread never blocks; it stops at its next read. */
+	while (1) {
+		BraseroReadCddaBuffer *buffer;
+		gint done = 0;
+
+		buffer = g_async_queue_pop (priv->full_buffers);
+		if (!buffer->blocks) {
+			g_async_queue_push (priv->free_buffers, buffer);
+			break;
+		}
+
+		if (priv->big_endian) {
+			guchar *iter;
+			guchar *end;
+
+			/* CDDA sectors are little endian samples */
+			end = buffer->data + buffer->blocks * BRASERO_CDDA_SECTOR_SIZE;
+			for (iter = buffer->data; iter < end; iter += 2) {
+				guchar tmp;
+
+				tmp = iter [0];
+				iter [0] = iter [1];
+				iter [1] = tmp;
+			}
+		}
+
+		/* a buffer may straddle two tracks */
+		while (done < buffer->blocks
+		&& !g_atomic_int_get (&priv->write_failed)
+		&& !priv->cancel) {
+			gint blocks;
+
+			blocks = MIN (buffer->blocks - done, track_remaining);
+			if (blocks > 0) {
+				if (!brasero_read_cdda_write (self,
+							      fd,
+							      buffer->data + done * BRASERO_CDDA_SECTOR_SIZE,
+							      blocks * BRASERO_CDDA_SECTOR_SIZE)) {
+					g_atomic_int_set (&priv->write_failed, 1);
+					break;
+				}
+
+				done += blocks;
+				track_remaining -= blocks;
+				written += blocks * BRASERO_CDDA_SECTOR_SIZE;
+				brasero_job_set_written_session (BRASERO_JOB (self), written);
+			}
+
+			if (!track_remaining && track_index + 1 < priv->track_num) {
+				track_index ++;
+				track_remaining = priv->track_sectors [track_index];
+				if (!brasero_read_cdda_next_track (self, track_index))
+					g_atomic_int_set (&priv->write_failed, 1);
+			}
+			else if (!track_remaining)
+				break;
+		}
+
+		g_async_queue_push (priv->free_buffers, buffer);
+	}
+
+	return NULL;
+}
+
+/* When the drive returns the formatted Q sub-channel, check that the
+ * absolute address of each sector is the one asked for. */
+
+static gboolean
+brasero_read_cdda_check_sub_q (BraseroReadCddaRaw *raw)
+{
+	goffset address;
+	gint i;
+
+	address = raw->address - raw->overlap;
+	for (i = 0; i < raw->blocks + raw->overlap; i ++) {
+		guchar *sub_q;
+		goffset lba;
+
+		sub_q = raw->data + i * raw->stride + BRASERO_CDDA_SECTOR_SIZE;
+
+		/* only mode 1 Q data carries a position */
+		if ((sub_q [0] & 0x0F) != 1)
+			continue;
+
+		lba = (BCD_TO_INT (sub_q [7]) * 60 + BCD_TO_INT (sub_q [8])) * 75 +
+		      BCD_TO_INT (sub_q [9]) - 150;
+		if (lba != address + i)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_read_cdda_read (BraseroReadCdda *self,
+			BraseroReadCddaState *state,
+			BraseroReadCddaRaw *raw,
+			GError **error)
+{
+	BraseroScsiResult result = BRASERO_SCSI_FAILURE;
+	BraseroScsiErrCode code = 0;
+	gint retries;
+
+	for (retries = 0; retries < BRASERO_READ_CDDA_RETRIES; retries ++) {
+		gboolean use_sub_q;
+
+		use_sub_q = g_atomic_int_get (&state->use_sub_q);
+
+		raw->stride = BRASERO_CDDA_SECTOR_SIZE;
+		if (use_sub_q)
+			raw->stride += BRASERO_CDDA_SUB_Q_SIZE;
+
+		result = brasero_mmc1_read_block (state->handle,
+						  TRUE,
+						  BRASERO_SCSI_BLOCK_TYPE_CDDA,
+						  BRASERO_SCSI_BLOCK_HEADER_NONE,
+						  use_sub_q? BRASERO_SCSI_BLOCK_SUB_Q:BRASERO_SCSI_BLOCK_NO_SUBCHANNEL,
+						  raw->address - raw->overlap,
+						  raw->blocks + raw->overlap,
+						  raw->data,
+						  (raw->blocks + raw->overlap) * raw->stride,
+						  &code);
+
+		if (result == BRASERO_SCSI_OK) {
+			state->sub_q_tested = TRUE;
+			return TRUE;
+		}
+
+		/* some drives can't return the Q sub-channel */
+		if (use_sub_q && !state->sub_q_tested) {
+			BRASERO_JOB_LOG (self, "Reading Q sub-channel failed (%s); disabling", brasero_scsi_strerror (code));
+			g_atomic_int_set (&state->use_sub_q, 0);
+			state->sub_q_tested = TRUE;
+			retries --;
+			continue;
+		}
+
+		BRASERO_JOB_LOG (self,
+				 "Reading %i sectors at %"G_GINT64_FORMAT" failed (%s)",
+				 raw->blocks + raw->overlap,
+				 raw->address - raw->overlap,
+				 brasero_scsi_strerror (code));
+	}
+
+	g_set_error (error,
+		     BRASERO_BURN_ERROR,
+		     BRASERO_BURN_ERROR_GENERAL,
+		     _("Sector %lli could not be read (%s)"),
+		     (long long int) raw->address,
+		     brasero_scsi_strerror (code));
+	return FALSE;
+}
+
+/**
+ * Asks the reading thread to read everything again from @raw on. All that
+ * it read after that is thrown away.
+ */
+
+static void
+brasero_read_cdda_rewind (BraseroReadCddaState *state,
+			  BraseroReadCddaRaw *raw)
+{
+	g_mutex_lock (state->lock);
+	state->generation ++;
+	state->rewind = raw->address;
+	state->rewind_pending = TRUE;
+	g_cond_broadcast (state->cond);
+	g_mutex_unlock (state->lock);
+}
+
+static gpointer
+brasero_read_cdda_verify_thread (gpointer data)
+{
+	BraseroReadCddaState *state = data;
+	BraseroReadCddaPrivate *priv;
+	BraseroReadCdda *self;
+	goffset retry_address = -1;
+	goffset tail_address = -1;
+	gboolean reader_done = FALSE;
+	goffset verified = 0;
+	goffset total = 0;
+	gint retries = 0;
+	guint i;
+
+	self = state->self;
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	for (i = 0; i < priv->track_num; i ++)
+		total += priv->track_sectors [i];
+
+	while (verified < total
+	&&    !priv->cancel
+	&&    !g_atomic_int_get (&priv->write_failed)) {
+		BraseroReadCddaBuffer *buffer;
+		BraseroReadCddaRaw *raw;
+		gboolean sub_q_ok;
+		gboolean jitter;
+		guint generation;
+		gint overlap;
+		gint j;
+
+		raw = g_async_queue_pop (state->full_raw);
+		if (!raw->blocks) {
+			reader_done = TRUE;
+			break;
+		}
+
+		g_mutex_lock (state->lock);
+		generation = state->generation;
+		g_mutex_unlock (state->lock);
+
+		/* read before a rewind */
+		if (raw->generation != generation) {
+			g_async_queue_push (state->free_raw, raw);
+			continue;
+		}
+
+		/* The overlapping sectors must be the ones kept last time. They
+		 * are not read at the start of a track. */
+		overlap = raw->overlap;
+		jitter = FALSE;
+		if (overlap && tail_address == raw->address) {
+			for (j = 0; j < overlap && !jitter; j ++)
+				jitter = memcmp (raw->data + j * raw->stride,
+						 state->tail + (BRASERO_READ_CDDA_OVERLAP - overlap + j) * BRASERO_CDDA_SECTOR_SIZE,
+						 BRASERO_CDDA_SECTOR_SIZE) != 0;
+		}
+
+		sub_q_ok = (raw->stride == BRASERO_CDDA_SECTOR_SIZE) || brasero_read_cdda_check_sub_q (raw);
+
+		if (jitter || !sub_q_ok) {
+			BRASERO_JOB_LOG (self,
+					 "Sectors at %"G_GINT64_FORMAT" could not be verified (%s)",
+					 raw->address,
+					 jitter? "jitter":"wrong Q address");
+
+			if (retry_address != raw->address) {
+				retry_address = raw->address;
+				retries = 0;
+			}
+
+			retries ++;
+			if (retries < BRASERO_READ_CDDA_RETRIES) {
+				brasero_read_cdda_rewind (state, raw);
+				g_async_queue_push (state->free_raw, raw);
+				continue;
+			}
+
+			if (jitter) {
+				/* Don't silently copy damaged audio */
+				state->error = g_error_new (BRASERO_BURN_ERROR,
+							    BRASERO_BURN_ERROR_GENERAL,
+							    _("Sector %lli could not be read reliably"),
+							    (long long int) raw->address);
+				g_async_queue_push (state->free_raw, raw);
+				break;
+			}
+
+			/* The data are consistent but the Q addresses never
+			 * match: the drive does not report them in a usable way.
+			 * The overlap is still checked. */
+			BRASERO_JOB_LOG (self, "Disabling Q sub-channel checks");
+			g_atomic_int_set (&state->use_sub_q, 0);
+		}
+
+		buffer = g_async_queue_pop (priv->free_buffers);
+		buffer->blocks = raw->blocks;
+		for (j = 0; j < raw->blocks; j ++)
+			memcpy (buffer->data + j * BRASERO_CDDA_SECTOR_SIZE,
+				raw->data + (j + overlap) * raw->stride,
+				BRASERO_CDDA_SECTOR_SIZE);
+
+		if (raw->blocks >= BRASERO_READ_CDDA_OVERLAP) {
+			memcpy (state->tail,
+				buffer->data + (raw->blocks - BRASERO_READ_CDDA_OVERLAP) * BRASERO_CDDA_SECTOR_SIZE,
+				sizeof (state->tail));
+			tail_address = raw->address + raw->blocks;
+		}
+		else
+			tail_address = -1;
+
+		verified += raw->blocks;
+		g_async_queue_push (priv->full_buffers, buffer);
+		g_async_queue_push (state->free_raw, raw);
+	}
+
+	g_mutex_lock (state->lock);
+	state->verified = TRUE;
+	g_cond_broadcast (state->cond);
+	g_mutex_unlock (state->lock);
+
+	/* Hand the buffers back until the reading thread stops */
+	while (!reader_done) {
+		BraseroReadCddaRaw *raw;
+
+		raw = g_async_queue_pop (state->full_raw);
+		if (!raw->blocks)
+			break;
+
+		g_async_queue_push (state->free_raw, raw);
+	}
+
+	g_async_queue_push (priv->full_buffers, &state->write_end);
+	return NULL;
+}
+
+/**
+ * Each track is read from its own address since, on multisession discs,
+ * there are sectors between sessions that can't be read.
+ */
+
+static guint
+brasero_read_cdda_find_track (BraseroReadCdda *self,
+			      goffset address)
+{
+	BraseroReadCddaPrivate *priv;
+	guint i;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+	for (i = 0; i < priv->track_num; i ++) {
+		if (address >= priv->track_addresses [i]
+		&&  address < priv->track_addresses [i] + priv->track_sectors [i])
+			break;
+	}
+
+	return i;
+}
+
+static gpointer
+brasero_read_cdda_read_thread (gpointer data)
+{
+	BraseroReadCddaBuffer buffers [BRASERO_READ_CDDA_BUFFERS];
+	BraseroReadCddaRaw end_marker = { NULL, 0, 0, 0, 0, 0 };
+	BraseroScsiErrCode code = 0;
+	BraseroReadCddaState state;
+	GThread *verify_thread = NULL;
+	GThread *write_thread = NULL;
+	BraseroReadCdda *self = data;
+	BraseroReadCddaPrivate *priv;
+	BraseroTrack *track = NULL;
+	BraseroDrive *drive = NULL;
+	GError *error = NULL;
+	guint generation = 0;
+	goffset address = 0;
+	guint track_index;
+	goffset total;
+	gint i;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	memset (buffers, 0, sizeof (buffers));
+	memset (&state, 0, sizeof (state));
+	state.self = self;
+	state.use_sub_q = TRUE;
+
+	total = brasero_read_cdda_get_tracks (self);
+	BRASERO_JOB_LOG (self, "Reading %i tracks (%"G_GINT64_FORMAT" sectors)", priv->track_num, total);
+
+	if (!priv->track_num)
+		goto end;
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
+	state.handle = brasero_device_handle_open (brasero_drive_get_device (drive), FALSE, &code);
+	if (!state.handle) {
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_GENERAL,
+					   _("The drive could not be opened (%s)"),
+					   brasero_scsi_strerror (code));
+		goto end;
+	}
+
+	if (brasero_job_get_fd_out (BRASERO_JOB (self), NULL) != BRASERO_BURN_OK) {
+		gchar *path = NULL;
+
+		brasero_job_get_tmp_dir (BRASERO_JOB (self), &path, &priv->error);
+		if (!path)
+			goto end;
+
+		priv->file_pattern = g_strdup_printf ("%s/cd_file", path);
+		g_free (path);
+	}
+
+	state.lock = g_mutex_new ();
+	state.cond = g_cond_new ();
+	state.free_raw = g_async_queue_new ();
+	state.full_raw = g_async_queue_new ();
+	for (i = 0; i < BRASERO_READ_CDDA_RAW_BUFFERS; i ++) {
+		state.raw [i].data = g_malloc ((BRASERO_READ_CDDA_BLOCKS + BRASERO_READ_CDDA_OVERLAP) *
+					       (BRASERO_CDDA_SECTOR_SIZE + BRASERO_CDDA_SUB_Q_SIZE));
+		g_async_queue_push (state.free_raw, state.raw + i);
+	}
+
+	priv->free_buffers = g_async_queue_new ();
+	priv->full_buffers = g_async_queue_new ();
+	for (i = 0; i < BRASERO_READ_CDDA_BUFFERS; i ++) {
+		buffers [i].data = g_malloc (BRASERO_READ_CDDA_BLOCKS * BRASERO_CDDA_SECTOR_SIZE);
+		g_async_queue_push (priv->free_buffers, buffers + i);
+	}
+
+	write_thread = g_thread_create (brasero_read_cdda_write_thread,
+					self,
+					TRUE,
+					&priv->error);
+	if (!write_thread)
+		goto end;
+
+	verify_thread = g_thread_create (brasero_read_cdda_verify_thread,
+					 &state,
+					 TRUE,
+					 &priv->error);
+	if (!verify_thread) {
+		g_async_queue_push (priv->full_buffers, &state.write_end);
+		g_thread_join (write_thread);
+		goto end;
+	}
+
+	brasero_job_start_progress (BRASERO_JOB (self), TRUE);
+
+	/* The verifying thread checks what was read while the next sectors
+	 * are being read. When it can't verify some, it makes us read again
+	 * from there. Once all is read we wait for it in case it does. */
+	track_index = 0;
+	address = priv->track_addresses [0];
+	while (!priv->cancel && !g_atomic_int_get (&priv->write_failed)) {
+		BraseroReadCddaRaw *raw;
+		goffset track_start;
+		goffset track_end;
+
+		g_mutex_lock (state.lock);
+		if (state.rewind_pending) {
+			state.rewind_pending = FALSE;
+			address = state.rewind;
+			generation = state.generation;
+			track_index = brasero_read_cdda_find_track (self, address);
+		}
+
+		if (!state.verified && track_index >= priv->track_num) {
+			GTimeVal timeout;
+
+			g_get_current_time (&timeout);
+			g_time_val_add (&timeout, 250000);
+			g_cond_timed_wait (state.cond, state.lock, &timeout);
+			g_mutex_unlock (state.lock);
+			continue;
+		}
+
+		if (state.verified) {
+			g_mutex_unlock (state.lock);
+			break;
+		}
+		g_mutex_unlock (state.lock);
+
+		track_start = priv->track_addresses [track_index];
+		track_end = track_start + priv->track_sectors [track_index];
+
+		raw = g_async_queue_pop (state.free_raw);
+		raw->address = address;
+		raw->blocks = MIN (track_end - address, BRASERO_READ_CDDA_BLOCKS);
+		raw->overlap = MIN (address - track_start, BRASERO_READ_CDDA_OVERLAP);
+		raw->generation = generation;
+
+		if (!brasero_read_cdda_read (self, &state, raw, &error)) {
+			g_async_queue_push (state.free_raw, raw);
+			break;
+		}
+
+		g_async_queue_push (state.full_raw, raw);
+
+		address += raw->blocks;
+		if (address >= track_end && ++ track_index < priv->track_num)
+			address = priv->track_addresses [track_index];
+	}
+
+	g_async_queue_push (state.full_raw, &end_marker);
+	g_thread_join (verify_thread);
+	g_thread_join (write_thread);
+
+	/* close the last file */
+	brasero_read_cdda_close_output (self);
+
+	if (priv->write_error) {
+		if (error)
+			g_error_free (error);
+
+		error = priv->write_error;
+		priv->write_error = NULL;
+	}
+
+	if (state.error) {
+		if (!error)
+			error = state.error;
+		else
+			g_error_free (state.error);
+
+		state.error = NULL;
+	}
+
+	if (error)
+		priv->error = error;
+
+end:
+
+	if (priv->output) {
+		fclose (priv->output);
+		priv->output = NULL;
+	}
+
+	if (priv->write_error) {
+		g_error_free (priv->write_error);
+		priv->write_error = NULL;
+	}
+
+	if (priv->free_buffers) {
+		g_async_queue_unref (priv->free_buffers);
+		priv->free_buffers = NULL;
+	}
+
+	if (priv->full_buffers) {
+		g_async_queue_unref (priv->full_buffers);
+		priv->full_buffers = NULL;
+	}
+
+	for (i = 0; i < BRASERO_READ_CDDA_BUFFERS; i ++)
+		g_free (buffers [i].data);
+
+	if (state.free_raw)
+		g_async_queue_unref (state.free_raw);
+
+	if (state.full_raw)
+		g_async_queue_unref (state.full_raw);
+
+	for (i = 0; i < BRASERO_READ_CDDA_RAW_BUFFERS; i ++)
+		g_free (state.raw [i].data);
+
+	if (state.lock)
+		g_mutex_free (state.lock);
+
+	if (state.cond)
+		g_cond_free (state.cond);
+
+	if (state.handle)
+		brasero_device_handle_close (state.handle);
+
+	g_atomic_int_set (&priv->write_failed, 0);
+
+	if (!priv->cancel)
+		priv->thread_id = g_idle_add (brasero_read_cdda_thread_finished, self);
+
+	/* End thread */
+	g_mutex_lock (priv->mutex);
+	priv->thread = NULL;
+	g_cond_signal (priv->cond);
+	g_mutex_unlock (priv->mutex);
+
+	g_thread_exit (NULL);
+
+	return NULL;
+}
+
+static BraseroBurnResult
+brasero_read_cdda_start (BraseroJob *job,
+			 GError **error)
+{
+	BraseroReadCdda *self;
+	BraseroJobAction action;
+	BraseroTrackType *output;
+	BraseroReadCddaPrivate *priv;
+	GError *thread_error = NULL;
+
+	self = BRASERO_READ_CDDA (job);
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	brasero_job_get_action (job, &action);
+	if (action == BRASERO_JOB_ACTION_SIZE) {
+		goffset blocks;
+
+		blocks = brasero_read_cdda_get_tracks (self);
+		brasero_job_set_output_size_for_current_track (job,
+							       blocks,
+							       blocks * BRASERO_CDDA_SECTOR_SIZE);
+		return BRASERO_BURN_NOT_RUNNING;
+	}
+
+	if (action != BRASERO_JOB_ACTION_IMAGE)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	if (priv->thread)
+		return BRASERO_BURN_RUNNING;
+
+	output = brasero_track_type_new ();
+	brasero_job_get_output_type (job, output);
+	priv->big_endian = (brasero_track_type_get_stream_format (output) & BRASERO_AUDIO_FORMAT_RAW) != 0;
+	brasero_track_type_free (output);
+
+	g_free (priv->file_pattern);
+	priv->file_pattern = NULL;
+
+	brasero_job_set_current_action (job,
+					BRASERO_BURN_ACTION_DRIVE_COPY,
+					_("Preparing to copy audio disc"),
+					FALSE);
+
+	g_mutex_lock (priv->mutex);
+	priv->thread = g_thread_create (brasero_read_cdda_read_thread,
+					self,
+					FALSE,
+					&thread_error);
+	g_mutex_unlock (priv->mutex);
+
+	/* Reminder: this is not necessarily an error as the thread may have finished */
+	if (thread_error) {
+		g_propagate_error (error, thread_error);
+		return BRASERO_BURN_ERR;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_read_cdda_stop_real (BraseroReadCdda *self)
+{
+	BraseroReadCddaPrivate *priv;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (self);
+
+	g_mutex_lock (priv->mutex);
+	if (priv->thread) {
+		priv->cancel = 1;
+		g_cond_wait (priv->cond, priv->mutex);
+		priv->cancel = 0;
+	}
+	g_mutex_unlock (priv->mutex);
+
+	if (priv->thread_id) {
+		g_source_remove (priv->thread_id);
+		priv->thread_id = 0;
+	}
+
+	if (priv->error) {
+		g_error_free (priv->error);
+		priv->error = NULL;
+	}
+}
+
+static BraseroBurnResult
+brasero_read_cdda_stop (BraseroJob *job,
+			GError **error)
+{
+	brasero_read_cdda_stop_real (BRASERO_READ_CDDA (job));
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_read_cdda_class_init (BraseroReadCddaClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	BraseroJobClass *job_class = BRASERO_JOB_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (BraseroReadCddaPrivate));
+
+	parent_class = g_type_class_peek_parent (klass);
+	object_class->finalize = brasero_read_cdda_finalize;
+
+	job_class->start = brasero_read_cdda_start;
+	job_class->stop = brasero_read_cdda_stop;
+}
+
+static void
+brasero_read_cdda_init (BraseroReadCdda *obj)
+{
+	BraseroReadCddaPrivate *priv;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (obj);
+
+	priv->mutex = g_mutex_new ();
+	priv->cond = g_cond_new ();
+}
+
+static void
+brasero_read_cdda_finalize (GObject *object)
+{
+	BraseroReadCddaPrivate *priv;
+
+	priv = BRASERO_READ_CDDA_PRIVATE (object);
+
+	brasero_read_cdda_stop_real (BRASERO_READ_CDDA (object));
+
+	if (priv->file_pattern) {
+		g_free (priv->file_pattern);
+		priv->file_pattern = NULL;
+	}
+
+	if (priv->track_addresses) {
+		g_free (priv->track_addresses);
+		priv->track_addresses = NULL;
+	}
+
+	if (priv->track_sectors) {
+		g_free (priv->track_sectors);
+		priv->track_sectors = NULL;
+	}
+
+	if (priv->mutex) {
+		g_mutex_free (priv->mutex);
+		priv->mutex = NULL;
+	}
+
+	if (priv->cond) {
+		g_cond_free (priv->cond);
+		priv->cond = NULL;
+	}
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+brasero_read_cdda_export_caps (BraseroPlugin *plugin)
+{
+	GSList *output;
+	GSList *input;
+
+	brasero_plugin_define (plugin,
+			       "readcdda",
+	                       NULL,
+			       _("Copy tracks from an audio CD"),
+			       "Philippe Rouquier",
+			       2);
+
+	input = brasero_caps_disc_new (BRASERO_MEDIUM_CDR|
+	                               BRASERO_MEDIUM_CDRW|
+	                               BRASERO_MEDIUM_CDROM|
+	                               BRASERO_MEDIUM_CLOSED|
+	                               BRASERO_MEDIUM_APPENDABLE|
+	                               BRASERO_MEDIUM_HAS_AUDIO);
+
+	/* One file per track */
+	output = brasero_caps_audio_new (BRASERO_PLUGIN_IO_ACCEPT_FILE,
+					 BRASERO_AUDIO_FORMAT_RAW|
+					 BRASERO_AUDIO_FORMAT_RAW_LITTLE_ENDIAN);
+	brasero_plugin_link_caps (plugin, output, input);
+	g_slist_free (output);
+
+	/* On the fly copying: all tracks through the same pipe. Only burners
+	 * that get the track sizes from the disc, without .inf files, can
+	 * take that as their input. */
+	output = brasero_caps_audio_new (BRASERO_PLUGIN_IO_ACCEPT_PIPE,
+					 BRASERO_AUDIO_FORMAT_RAW_LITTLE_ENDIAN);
+	brasero_plugin_link_caps (plugin, output, input);
+	g_slist_free (output);
+
+	g_slist_free (input);
+}
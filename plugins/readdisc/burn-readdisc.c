@@ -0,0 +1,729 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ *
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib-object.h>
+#include <glib/gi18n-lib.h>
+#include <gmodule.h>
+
+#include "burn-job.h"
+#include "brasero-plugin-registration.h"
+#include "brasero-medium.h"
+#include "brasero-drive.h"
+#include "brasero-track-image.h"
+#include "brasero-track-disc.h"
+
+#include "scsi-device.h"
+#include "scsi-error.h"
+#include "scsi-mmc1.h"
+#include "scsi-sbc.h"
+
+
+#define BRASERO_TYPE_READ_DISC         (brasero_read_disc_get_type ())
+#define BRASERO_READ_DISC(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), BRASERO_TYPE_READ_DISC, BraseroReadDisc))
+#define BRASERO_READ_DISC_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), BRASERO_TYPE_READ_DISC, BraseroReadDiscClass))
+#define BRASERO_IS_READ_DISC(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), BRASERO_TYPE_READ_DISC))
+#define BRASERO_IS_READ_DISC_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), BRASERO_TYPE_READ_DISC))
+#define BRASERO_READ_DISC_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), BRASERO_TYPE_READ_DISC, BraseroReadDiscClass))
+
+BRASERO_PLUGIN_BOILERPLATE (BraseroReadDisc, brasero_read_disc, BRASERO_TYPE_JOB, BraseroJob);
+
+struct _BraseroReadDiscPrivate {
+	GError *error;
+	GThread *thread;
+	GMutex *mutex;
+	GCond *cond;
+	guint thread_id;
+
+	/* Filled buffers go from the reading thread to the writing thread
+	 * through full_buffers and come back through free_buffers. */
+	GAsyncQueue *free_buffers;
+	GAsyncQueue *full_buffers;
+	GError *write_error;
+	FILE *output;
+
+	/* set by the writing thread */
+	gint write_failed;
+
+	guint cancel:1;
+};
+typedef struct _BraseroReadDiscPrivate BraseroReadDiscPrivate;
+
+#define BRASERO_READ_DISC_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_READ_DISC, BraseroReadDiscPrivate))
+
+#define BRASERO_READ_DISC_BLOCK_SIZE	2048
+
+/* Largest number of sectors asked in one READ command (64 KiB) and number of
+ * such buffers in flight between the drive and the output. */
+#define BRASERO_READ_DISC_MAX_BLOCKS	32
+#define BRASERO_READ_DISC_BUFFERS	8
+
+/* After that many successful reads, the size of a READ is doubled again
+ * once it was reduced because of an error. */
+#define BRASERO_READ_DISC_GROW_AFTER	16
+
+/* How many times a single unreadable sector is tried */
+#define BRASERO_READ_DISC_RETRIES	4
+
+struct _BraseroReadDiscBuffer {
+	guchar *data;
+	gint blocks;
+};
+typedef struct _BraseroReadDiscBuffer BraseroReadDiscBuffer;
+
+static GObjectClass *parent_class = NULL;
+
+static gboolean
+brasero_read_disc_thread_finished (gpointer data)
+{
+	goffset blocks = 0;
+	gchar *image = NULL;
+	BraseroReadDisc *self = data;
+	BraseroReadDiscPrivate *priv;
+	BraseroTrackImage *track = NULL;
+
+	priv = BRASERO_READ_DISC_PRIVATE (self);
+	priv->thread_id = 0;
+
+	if (priv->error) {
+		GError *error;
+
+		error = priv->error;
+		priv->error = NULL;
+		brasero_job_error (BRASERO_JOB (self), error);
+		return FALSE;
+	}
+
+	track = brasero_track_image_new ();
+	brasero_job_get_image_output (BRASERO_JOB (self),
+				      &image,
+				      NULL);
+	brasero_track_image_set_source (track,
+					image,
+					NULL,
+					BRASERO_IMAGE_FORMAT_BIN);
+	g_free (image);
+
+	brasero_job_get_session_output_size (BRASERO_JOB (self), &blocks, NULL);
+	brasero_track_image_set_block_num (track, blocks);
+
+	brasero_job_add_track (BRASERO_JOB (self), BRASERO_TRACK (track));
+	g_object_unref (track);
+
+	brasero_job_finished_track (BRASERO_JOB (self));
+
+	return FALSE;
+}
+
+/* Same boundaries as readcd/readom use for BIN images */
+
+static void
+brasero_read_disc_get_range (BraseroReadDisc *self,
+			     goffset *start_retval,
+			     goffset *blocks_retval)
+{
+	goffset start = 0;
+	goffset blocks = 0;
+	GValue *value = NULL;
+	BraseroTrack *track = NULL;
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	brasero_track_tag_lookup (track,
+				  BRASERO_TRACK_MEDIUM_ADDRESS_START_TAG,
+				  &value);
+	if (value) {
+		/* we were given an address to start */
+		start = g_value_get_uint64 (value);
+
+		value = NULL;
+		brasero_track_tag_lookup (track,
+					  BRASERO_TRACK_MEDIUM_ADDRESS_END_TAG,
+					  &value);
+		blocks = g_value_get_uint64 (value) - start;
+	}
+	/* 0 means all disc, -1 problem */
+	else if (brasero_track_disc_get_track_num (BRASERO_TRACK_DISC (track)) > 0) {
+		BraseroDrive *drive;
+		BraseroMedium *medium;
+
+		drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
+		medium = brasero_drive_get_medium (drive);
+		brasero_medium_get_track_space (medium,
+						brasero_track_disc_get_track_num (BRASERO_TRACK_DISC (track)),
+						NULL,
+						&blocks);
+		brasero_medium_get_track_address (medium,
+						  brasero_track_disc_get_track_num (BRASERO_TRACK_DISC (track)),
+						  NULL,
+						  &start);
+	}
+	else {
+		BraseroDrive *drive;
+		BraseroMedium *medium;
+
+		/* just read the last data track */
+		drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
+		medium = brasero_drive_get_medium (drive);
+		brasero_medium_get_last_data_track_space (medium,
+							  NULL,
+							  &blocks);
+		brasero_medium_get_last_data_track_address (medium,
+							    NULL,
+							    &start);
+	}
+
+	if (start_retval)
+		*start_retval = start;
+	if (blocks_retval)
+		*blocks_retval = blocks;
+}
+
+static gboolean
+brasero_read_disc_write_to_fd (BraseroReadDisc *self,
+			       int fd,
+			       guchar *buffer,
+			       gint bytes_remaining)
+{
+	gint bytes_written = 0;
+	BraseroReadDiscPrivate *priv;
+
+	priv = BRASERO_READ_DISC_PRIVATE (self);
+	while (bytes_remaining) {
+		gint written;
+
+		written = write (fd,
+				 buffer + bytes_written,
+				 bytes_remaining);
+
+		if (priv->cancel)
+			return FALSE;
+
+		if (written != bytes_remaining) {
+			if (errno != EINTR && errno != EAGAIN) {
+                                int errsv = errno;
+
+				/* unrecoverable error */
+				priv->write_error = g_error_new (BRASERO_BURN_ERROR,
+								 BRASERO_BURN_ERROR_GENERAL,
+								 _("Data could not be written (%s)"),
+								 g_strerror (errsv));
+				return FALSE;
+			}
+
+			g_thread_yield ();
+		}
+
+		if (written > 0) {
+			bytes_remaining -= written;
+			bytes_written += written;
+		}
+	}
+
+	return TRUE;
+}
+
+static gpointer
+brasero_read_disc_write_thread (gpointer data)
+{
+	int fd = -1;
+	gint64 written = 0;
+	BraseroReadDisc *self = data;
+	BraseroReadDiscPrivate *priv;
+
+	priv = BRASERO_READ_DISC_PRIVATE (self);
+
+	if (!priv->output)
+		brasero_job_get_fd_out (BRASERO_JOB (self), &fd);
+
+	/* Once writing failed, keep on handing the buffers back so that the
+	 * reading thread never blocks; it stops at its next read. */
+	while (1) {
+		BraseroReadDiscBuffer *buffer;
+		gsize size;
+
+		buffer = g_async_queue_pop (priv->full_buffers);
+		if (!buffer->blocks) {
+			g_async_queue_push (priv->free_buffers, buffer);
+			break;
+		}
+
+		size = buffer->blocks * BRASERO_READ_DISC_BLOCK_SIZE;
+		if (!g_atomic_int_get (&priv->write_failed) && !priv->cancel) {
+			gboolean success;
+
+			if (priv->output) {
+				success = (fwrite (buffer->data, 1, size, priv->output) == size);
+				if (!success) {
+					int errsv = errno;
+
+					priv->write_error = g_error_new (BRASERO_BURN_ERROR,
+									 BRASERO_BURN_ERROR_GENERAL,
+									 _("Data could not be written (%s)"),
+									 g_strerror (errsv));
+				}
+			}
+			else
+				success = brasero_read_disc_write_to_fd (self,
+									 fd,
+									 buffer->data,
+									 size);
+
+			if (success) {
+				written += size;
+				brasero_job_set_written_track (BRASERO_JOB (self), written);
+			}
+			else
+				g_atomic_int_set (&priv->write_failed, 1);
+		}
+
+		g_async_queue_push (priv->free_buffers, buffer);
+	}
+
+	return NULL;
+}
+
+static BraseroScsiResult
+brasero_read_disc_read (BraseroDeviceHandle *handle,
+			gboolean is_cd,
+			goffset address,
+			gint blocks,
+			guchar *buffer,
+			BraseroScsiErrCode *code)
+{
+	if (is_cd)
+		return brasero_mmc1_read_block (handle,
+						TRUE,
+						BRASERO_SCSI_BLOCK_TYPE_ANY,
+						BRASERO_SCSI_BLOCK_HEADER_NONE,
+						BRASERO_SCSI_BLOCK_NO_SUBCHANNEL,
+						address,
+						blocks,
+						buffer,
+						blocks * BRASERO_READ_DISC_BLOCK_SIZE,
+						code);
+
+	return brasero_sbc_read10_block (handle,
+					 address,
+					 blocks,
+					 buffer,
+					 blocks * BRASERO_READ_DISC_BLOCK_SIZE,
+					 code);
+}
+
+static gpointer
+brasero_read_disc_read_thread (gpointer data)
+{
+	BraseroReadDiscBuffer buffers [BRASERO_READ_DISC_BUFFERS];
+	BraseroReadDiscBuffer end_marker = { NULL, 0 };
+	gint chunk = BRASERO_READ_DISC_MAX_BLOCKS;
+	BraseroDeviceHandle *handle = NULL;
+	GThread *write_thread = NULL;
+	BraseroReadDisc *self = data;
+	BraseroReadDiscPrivate *priv;
+	BraseroTrack *track = NULL;
+	BraseroDrive *drive = NULL;
+	BraseroScsiErrCode code = 0;
+	GError *error = NULL;
+	gint successes = 0;
+	goffset remaining;
+	goffset address;
+	gboolean is_cd;
+	gint i;
+
+	priv = BRASERO_READ_DISC_PRIVATE (self);
+
+	memset (buffers, 0, sizeof (buffers));
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
+	is_cd = (brasero_medium_get_status (brasero_drive_get_medium (drive)) & BRASERO_MEDIUM_CD) != 0;
+
+	brasero_read_disc_get_range (self, &address, &remaining);
+	BRASERO_JOB_LOG (self,
+			 "Reading from sector %"G_GINT64_FORMAT" to %"G_GINT64_FORMAT" with %s",
+			 address,
+			 address + remaining,
+			 is_cd ? "READ CD":"READ10");
+
+	handle = brasero_device_handle_open (brasero_drive_get_device (drive), FALSE, &code);
+	if (!handle) {
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_GENERAL,
+					   _("The drive could not be opened (%s)"),
+					   brasero_scsi_strerror (code));
+		goto end;
+	}
+
+	if (brasero_job_get_fd_out (BRASERO_JOB (self), NULL) != BRASERO_BURN_OK) {
+		gchar *output = NULL;
+
+		brasero_job_get_image_output (BRASERO_JOB (self), &output, NULL);
+		priv->output = fopen (output, "w");
+		if (!priv->output) {
+			priv->error = g_error_new_literal (BRASERO_BURN_ERROR,
+							   BRASERO_BURN_ERROR_GENERAL,
+							   g_strerror (errno));
+			g_free (output);
+			goto end;
+		}
+		g_free (output);
+	}
+
+	priv->free_buffers = g_async_queue_new ();
+	priv->full_buffers = g_async_queue_new ();
+	for (i = 0; i < BRASERO_READ_DISC_BUFFERS; i ++) {
+		buffers [i].data = g_malloc (BRASERO_READ_DISC_MAX_BLOCKS * BRASERO_READ_DISC_BLOCK_SIZE);
+		g_async_queue_push (priv->free_buffers, buffers + i);
+	}
+
+	write_thread = g_thread_create (brasero_read_disc_write_thread,
+					self,
+					TRUE,
+					&priv->error);
+	if (!write_thread)
+		goto end;
+
+	brasero_job_set_current_action (BRASERO_JOB (self),
+					BRASERO_BURN_ACTION_DRIVE_COPY,
+					NULL,
+					FALSE);
+	brasero_job_start_progress (BRASERO_JOB (self), TRUE);
+
+	while (remaining > 0 && !priv->cancel && !g_atomic_int_get (&priv->write_failed)) {
+		BraseroReadDiscBuffer *buffer;
+		gint retries = 0;
+		gint wanted;
+
+		buffer = g_async_queue_pop (priv->free_buffers);
+		wanted = MIN (remaining, BRASERO_READ_DISC_MAX_BLOCKS);
+		buffer->blocks = 0;
+
+		while (buffer->blocks < wanted && !priv->cancel) {
+			BraseroScsiResult result;
+			gint blocks;
+
+			blocks = MIN (chunk, wanted - buffer->blocks);
+			result = brasero_read_disc_read (handle,
+							 is_cd,
+							 address + buffer->blocks,
+							 blocks,
+							 buffer->data + buffer->blocks * BRASERO_READ_DISC_BLOCK_SIZE,
+							 &code);
+			if (result == BRASERO_SCSI_OK) {
+				buffer->blocks += blocks;
+				retries = 0;
+
+				/* the drive recovered; speed up again */
+				if (chunk < BRASERO_READ_DISC_MAX_BLOCKS
+				&& ++ successes >= BRASERO_READ_DISC_GROW_AFTER) {
+					chunk = MIN (chunk * 2, BRASERO_READ_DISC_MAX_BLOCKS);
+					successes = 0;
+				}
+				continue;
+			}
+
+			successes = 0;
+
+			/* narrow down the range of failing sectors so that
+			 * the readable ones around it are still copied */
+			if (chunk > 1) {
+				BRASERO_JOB_LOG (self,
+						 "Reading %i sectors at %"G_GINT64_FORMAT" failed (%s), trying %i",
+						 blocks,
+						 address + buffer->blocks,
+						 brasero_scsi_strerror (code),
+						 chunk / 2);
+				chunk /= 2;
+				continue;
+			}
+
+			if (++ retries < BRASERO_READ_DISC_RETRIES) {
+				BRASERO_JOB_LOG (self,
+						 "Reading sector %"G_GINT64_FORMAT" failed (%s), retry %i",
+						 address + buffer->blocks,
+						 brasero_scsi_strerror (code),
+						 retries);
+				continue;
+			}
+
+			error = g_error_new (BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_GENERAL,
+					     _("Sector %lli could not be read (%s)"),
+					     (long long int) (address + buffer->blocks),
+					     brasero_scsi_strerror (code));
+			break;
+		}
+
+		address += buffer->blocks;
+		remaining -= buffer->blocks;
+
+		if (buffer->blocks)
+			g_async_queue_push (priv->full_buffers, buffer);
+		else
+			g_async_queue_push (priv->free_buffers, buffer);
+
+		if (error)
+			break;
+	}
+
+	g_async_queue_push (priv->full_buffers, &end_marker);
+	g_thread_join (write_thread);
+
+	if (priv->write_error) {
+		if (error)
+			g_error_free (error);
+
+		error = priv->write_error;
+		priv->write_error = NULL;
+	}
+
+	if (error)
+		priv->error = error;
+
+end:
+
+	if (priv->output) {
+		if (fclose (priv->output) && !priv->error && !priv->cancel) {
+			int errsv = errno;
+
+			priv->error = g_error_new (BRASERO_BURN_ERROR,
+						   BRASERO_BURN_ERROR_GENERAL,
+						   _("Data could not be written (%s)"),
+						   g_strerror (errsv));
+		}
+		priv->output = NULL;
+	}
+
+	if (priv->free_buffers) {
+		g_async_queue_unref (priv->free_buffers);
+		priv->free_buffers = NULL;
+	}
+
+	if (priv->full_buffers) {
+		g_async_queue_unref (priv->full_buffers);
+		priv->full_buffers = NULL;
+	}
+
+	for (i = 0; i < BRASERO_READ_DISC_BUFFERS; i ++)
+		g_free (buffers [i].data);
+
+	if (handle)
+		brasero_device_handle_close (handle);
+
+	g_atomic_int_set (&priv->write_failed, 0);
+
+	if (!priv->cancel)
+		priv->thread_id = g_idle_add (brasero_read_disc_thread_finished, self);
+
+	/* End thread */
+	g_mutex_lock (priv->mutex);
+	priv->thread = NULL;
+	g_cond_signal (priv->cond);
+	g_mutex_unlock (priv->mutex);
+
+	g_thread_exit (NULL);
+
+	return NULL;
+}
+
+static BraseroBurnResult
+brasero_read_disc_start (BraseroJob *job,
+			 GError **error)
+{
+	BraseroReadDisc *self;
+	BraseroJobAction action;
+	BraseroReadDiscPrivate *priv;
+	GError *thread_error = NULL;
+
+	self = BRASERO_READ_DISC (job);
+	priv = BRASERO_READ_DISC_PRIVATE (self);
+
+	brasero_job_get_action (job, &action);
+	if (action == BRASERO_JOB_ACTION_SIZE) {
+		goffset blocks = 0;
+
+		brasero_read_disc_get_range (self, NULL, &blocks);
+		brasero_job_set_output_size_for_current_track (job,
+							       blocks,
+							       blocks * BRASERO_READ_DISC_BLOCK_SIZE);
+		return BRASERO_BURN_NOT_RUNNING;
+	}
+
+	if (action != BRASERO_JOB_ACTION_IMAGE)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	if (priv->thread)
+		return BRASERO_BURN_RUNNING;
+
+	brasero_job_set_use_average_rate (job, TRUE);
+
+	g_mutex_lock (priv->mutex);
+	priv->thread = g_thread_create (brasero_read_disc_read_thread,
+					self,
+					FALSE,
+					&thread_error);
+	g_mutex_unlock (priv->mutex);
+
+	/* Reminder: this is not necessarily an error as the thread may have finished */
+	if (thread_error) {
+		g_propagate_error (error, thread_error);
+		return BRASERO_BURN_ERR;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_read_disc_stop_real (BraseroReadDisc *self)
+{
+	BraseroReadDiscPrivate *priv;
+
+	priv = BRASERO_READ_DISC_PRIVATE (self);
+
+	g_mutex_lock (priv->mutex);
+	if (priv->thread) {
+		priv->cancel = 1;
+		g_cond_wait (priv->cond, priv->mutex);
+		priv->cancel = 0;
+	}
+	g_mutex_unlock (priv->mutex);
+
+	if (priv->thread_id) {
+		g_source_remove (priv->thread_id);
+		priv->thread_id = 0;
+	}
+
+	if (priv->error) {
+		g_error_free (priv->error);
+		priv->error = NULL;
+	}
+}
+
+static BraseroBurnResult
+brasero_read_disc_stop (BraseroJob *job,
+			GError **error)
+{
+	brasero_read_disc_stop_real (BRASERO_READ_DISC (job));
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_read_disc_class_init (BraseroReadDiscClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	BraseroJobClass *job_class = BRASERO_JOB_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (BraseroReadDiscPrivate));
+
+	parent_class = g_type_class_peek_parent (klass);
+	object_class->finalize = brasero_read_disc_finalize;
+
+	job_class->start = brasero_read_disc_start;
+	job_class->stop = brasero_read_disc_stop;
+}
+
+static void
+brasero_read_disc_init (BraseroReadDisc *obj)
+{
+	BraseroReadDiscPrivate *priv;
+
+	priv = BRASERO_READ_DISC_PRIVATE (obj);
+
+	priv->mutex = g_mutex_new ();
+	priv->cond = g_cond_new ();
+}
+
+static void
+brasero_read_disc_finalize (GObject *object)
+{
+	BraseroReadDiscPrivate *priv;
+
+	priv = BRASERO_READ_DISC_PRIVATE (object);
+
+	brasero_read_disc_stop_real (BRASERO_READ_DISC (object));
+
+	if (priv->mutex) {
+		g_mutex_free (priv->mutex);
+		priv->mutex = NULL;
+	}
+
+	if (priv->cond) {
+		g_cond_free (priv->cond);
+		priv->cond = NULL;
+	}
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+brasero_read_disc_export_caps (BraseroPlugin *plugin)
+{
+	GSList *output;
+	GSList *input;
+
+	brasero_plugin_define (plugin,
+			       "readdisc",
+	                       NULL,
+			       _("Copies any data disc to a disc image"),
+			       "Philippe Rouquier",
+			       2);
+
+	/* Only 2048 bytes sectors; raw (clone) images need sub-channel data
+	 * and are left to readcd */
+	output = brasero_caps_image_new (BRASERO_PLUGIN_IO_ACCEPT_FILE|
+					 BRASERO_PLUGIN_IO_ACCEPT_PIPE,
+					 BRASERO_IMAGE_FORMAT_BIN);
+
+	input = brasero_caps_disc_new (BRASERO_MEDIUM_CD|
+				       BRASERO_MEDIUM_DVD|
+				       BRASERO_MEDIUM_DUAL_L|
+				       BRASERO_MEDIUM_PLUS|
+				       BRASERO_MEDIUM_SEQUENTIAL|
+				       BRASERO_MEDIUM_RESTRICTED|
+				       BRASERO_MEDIUM_ROM|
+				       BRASERO_MEDIUM_WRITABLE|
+				       BRASERO_MEDIUM_REWRITABLE|
+				       BRASERO_MEDIUM_CLOSED|
+				       BRASERO_MEDIUM_APPENDABLE|
+				       BRASERO_MEDIUM_HAS_DATA);
+
+	brasero_plugin_link_caps (plugin, output, input);
+	g_slist_free (output);
+	g_slist_free (input);
+}
@@ -33,10 +33,13 @@
 #endif
 
 #include <string.h>
+#include <math.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <glib/gi18n-lib.h>
 #include <gmodule.h>
+#include <gio/gio.h>
 
 #include <gst/gst.h>
 
@@ -56,73 +59,113 @@
 
 BRASERO_PLUGIN_BOILERPLATE (BraseroNormalize, brasero_normalize, BRASERO_TYPE_JOB, BraseroJob);
 
-typedef struct _BraseroNormalizePrivate BraseroNormalizePrivate;
-struct _BraseroNormalizePrivate
+/**
+ * Each track is analysed by its own filesrc ! decodebin ! audioresample !
+ * audioconvert ! rganalysis ! fakesink pipeline. Up to max_jobs of them run
+ * at the same time and album values are merged from the per-track results
+ * once they are all done.
+ */
+
+typedef struct _BraseroNormalizeAnalysis BraseroNormalizeAnalysis;
+struct _BraseroNormalizeAnalysis
 {
+	BraseroNormalize *normalize;
+	BraseroTrack *track;
+
 	GstElement *pipeline;
-	GstElement *analysis;
-	GstElement *decode;
 	GstElement *resample;
+	guint bus_watch;
+
+	gint64 duration;
+	gdouble track_peak;
+	gdouble track_gain;
+};
 
+typedef struct _BraseroNormalizePrivate BraseroNormalizePrivate;
+struct _BraseroNormalizePrivate
+{
 	GSList *tracks;
-	BraseroTrack *track;
+	GSList *analyses;
+
+	guint max_jobs;
+	guint num_tracks;
+	guint num_done;
 
 	gdouble album_peak;
-	gdouble album_gain;
-	gdouble track_peak;
-	gdouble track_gain;
+	gdouble album_power;
+	gdouble album_weight;
 };
 
 #define BRASERO_NORMALIZE_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_NORMALIZE, BraseroNormalizePrivate))
 
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_NORMALIZE_JOBS	"normalize-jobs"
+
+#define BRASERO_NORMALIZE_MAX_JOBS	16
+
 static GObjectClass *parent_class = NULL;
 
 
 static gboolean
 brasero_normalize_bus_messages (GstBus *bus,
 				GstMessage *msg,
-				BraseroNormalize *normalize);
+				BraseroNormalizeAnalysis *analysis);
 
 static void
-brasero_normalize_stop_pipeline (BraseroNormalize *normalize)
+brasero_normalize_analysis_free (BraseroNormalizeAnalysis *analysis)
+{
+	if (analysis->bus_watch) {
+		g_source_remove (analysis->bus_watch);
+		analysis->bus_watch = 0;
+	}
+
+	if (analysis->pipeline) {
+		gst_element_set_state (analysis->pipeline, GST_STATE_NULL);
+		gst_object_unref (GST_OBJECT (analysis->pipeline));
+		analysis->pipeline = NULL;
+		analysis->resample = NULL;
+	}
+
+	g_free (analysis);
+}
+
+static void
+brasero_normalize_stop_pipelines (BraseroNormalize *normalize)
 {
 	BraseroNormalizePrivate *priv;
 
 	priv = BRASERO_NORMALIZE_PRIVATE (normalize);
-	if (!priv->pipeline)
-		return;
-
-	gst_element_set_state (priv->pipeline, GST_STATE_NULL);
-	gst_object_unref (GST_OBJECT (priv->pipeline));
-	priv->pipeline = NULL;
-	priv->resample = NULL;
-	priv->analysis = NULL;
-	priv->decode = NULL;
+	g_slist_foreach (priv->analyses, (GFunc) brasero_normalize_analysis_free, NULL);
+	g_slist_free (priv->analyses);
+	priv->analyses = NULL;
 }
 
 static void
 brasero_normalize_new_decoded_pad_cb (GstElement *decode,
 				      GstPad *pad,
-				      BraseroNormalize *normalize)
+				      BraseroNormalizeAnalysis *analysis)
 {
 	GstPad *sink;
 	GstCaps *caps;
 	GstStructure *structure;
-	BraseroNormalizePrivate *priv;
+	BraseroNormalize *normalize;
 
-	priv = BRASERO_NORMALIZE_PRIVATE (normalize);
+	normalize = analysis->normalize;
 
-	sink = gst_element_get_static_pad (priv->resample, "sink");
+	sink = gst_element_get_static_pad (analysis->resample, "sink");
 	if (GST_PAD_IS_LINKED (sink)) {
 		BRASERO_JOB_LOG (normalize, "New decoded pad already linked");
+		gst_object_unref (sink);
 		return;
 	}
 
 	/* make sure we only have audio */
 	/* FIXME: get_current_caps() doesn't always seem to work yet here */
 	caps = gst_pad_query_caps (pad, NULL);
-	if (!caps)
+	if (!caps) {
+		gst_object_unref (sink);
 		return;
+	}
 
 	structure = gst_caps_get_structure (caps, 0);
 	if (structure && g_strrstr (gst_structure_get_name (structure), "audio")) {
@@ -140,10 +183,10 @@ brasero_normalize_new_decoded_pad_cb (GstElement *decode,
 	gst_caps_unref (caps);
 }
 
-  static gboolean
+static BraseroNormalizeAnalysis *
 brasero_normalize_build_pipeline (BraseroNormalize *normalize,
+                                  BraseroTrack *track,
                                   const gchar *uri,
-                                  GstElement *analysis,
                                   GError **error)
 {
 	GstBus *bus = NULL;
@@ -151,17 +194,22 @@ brasero_normalize_build_pipeline (BraseroNormalize *normalize,
 	GstElement *decode;
 	GstElement *pipeline;
 	GstElement *sink = NULL;
+	GstElement *analysis = NULL;
 	GstElement *convert = NULL;
 	GstElement *resample = NULL;
-	BraseroNormalizePrivate *priv;
-
-	priv = BRASERO_NORMALIZE_PRIVATE (normalize);
+	BraseroNormalizeAnalysis *data;
 
 	BRASERO_JOB_LOG (normalize, "Creating new pipeline");
 
+	data = g_new0 (BraseroNormalizeAnalysis, 1);
+	data->normalize = normalize;
+	data->track = track;
+	data->track_peak = 0.0;
+	data->track_gain = 0.0;
+
 	/* create filesrc ! decodebin ! audioresample ! audioconvert ! rganalysis ! fakesink */
 	pipeline = gst_pipeline_new (NULL);
-	priv->pipeline = pipeline;
+	data->pipeline = pipeline;
 
 	/* a new source is created */
 	source = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, NULL);
@@ -173,7 +221,7 @@ brasero_normalize_build_pipeline (BraseroNormalize *normalize,
 			     "\"Source\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), source);
+	gst_bin_add (GST_BIN (pipeline), source);
 	g_object_set (source,
 		      "typefind", FALSE,
 		      NULL);
@@ -189,7 +237,6 @@ brasero_normalize_build_pipeline (BraseroNormalize *normalize,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (pipeline), decode);
-	priv->decode = decode;
 
 	if (!gst_element_link (source, decode)) {
 		BRASERO_JOB_LOG (normalize, "Elements could not be linked");
@@ -223,10 +270,20 @@ brasero_normalize_build_pipeline (BraseroNormalize *normalize,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (pipeline), resample);
-	priv->resample = resample;
+	data->resample = resample;
 
-	/* rganalysis: set the number of tracks to be expected */
-	priv->analysis = analysis;
+	/* rganalysis: a new one for each track since every pipeline only ever
+	 * sees one track. Album values are computed in
+	 * brasero_normalize_merge_album (). */
+	analysis = gst_element_factory_make ("rganalysis", NULL);
+	if (analysis == NULL) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Rganalysis\"");
+		goto error;
+	}
 	gst_bin_add (GST_BIN (pipeline), analysis);
 
 	/* sink */
@@ -248,7 +305,7 @@ brasero_normalize_build_pipeline (BraseroNormalize *normalize,
 	g_signal_connect (G_OBJECT (decode),
 	                  "pad-added",
 	                  G_CALLBACK (brasero_normalize_new_decoded_pad_cb),
-	                  normalize);
+	                  data);
 	if (!gst_element_link_many (resample,
 	                            convert,
 	                            analysis,
@@ -258,18 +315,19 @@ brasero_normalize_build_pipeline (BraseroNormalize *normalize,
 			     BRASERO_BURN_ERROR,
 			     BRASERO_BURN_ERROR_GENERAL,
 		             _("Impossible to link plugin pads"));
+		goto error;
 	}
 
 	/* connect to the bus */	
-	bus = gst_pipeline_get_bus (GST_PIPELINE (priv->pipeline));
-	gst_bus_add_watch (bus,
-			   (GstBusFunc) brasero_normalize_bus_messages,
-			   normalize);
+	bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+	data->bus_watch = gst_bus_add_watch (bus,
+					     (GstBusFunc) brasero_normalize_bus_messages,
+					     data);
 	gst_object_unref (bus);
 
-	gst_element_set_state (priv->pipeline, GST_STATE_PLAYING);
+	gst_element_set_state (pipeline, GST_STATE_PLAYING);
 
-	return TRUE;
+	return data;
 
 error:
 
@@ -278,17 +336,14 @@ error:
 				 "can't create object : %s \n",
 				 (*error)->message);
 
-	gst_object_unref (GST_OBJECT (pipeline));
-	return FALSE;
+	brasero_normalize_analysis_free (data);
+	return NULL;
 }
 
-static BraseroBurnResult
-brasero_normalize_set_next_track (BraseroJob *job,
-                                  GError **error)
+static BraseroTrack *
+brasero_normalize_pop_track (BraseroJob *job)
 {
-	gchar *uri;
 	GValue *value;
-	GstElement *analysis;
 	BraseroTrackType *type;
 	BraseroTrack *track = NULL;
 	gboolean dts_allowed = FALSE;
@@ -319,52 +374,56 @@ brasero_normalize_set_next_track (BraseroJob *job,
 			BRASERO_JOB_LOG (job, "Skipped DTS track");
 		}
 
+		/* Skipped tracks count as analysed for progress */
+		priv->num_done ++;
 		track = NULL;
 	}
 	brasero_track_type_free (type);
 
-	if (!track)
-		return BRASERO_BURN_OK;
+	return track;
+}
 
-	if (!priv->analysis) {
-		analysis = gst_element_factory_make ("rganalysis", NULL);
-		if (analysis == NULL) {
-			g_set_error (error,
-				     BRASERO_BURN_ERROR,
-				     BRASERO_BURN_ERROR_GENERAL,
-				     _("%s element could not be created"),
-				     "\"Rganalysis\"");
-			return BRASERO_BURN_ERR;
-		}
+/**
+ * Starts as many new analyses as allowed by max_jobs.
+ * Returns BRASERO_BURN_OK when there is nothing left to start or analyse,
+ * BRASERO_BURN_RETRY when at least one analysis is running.
+ */
 
-		g_object_set (analysis,
-			      "num-tracks", g_slist_length (priv->tracks),
-			      NULL);
-	}
-	else {
-		/* destroy previous pipeline but save our plugin */
-		analysis = g_object_ref (priv->analysis);
-
-		/* NOTE: why lock state? because otherwise analysis would lose all 
-		 * information about tracks already analysed by going into the NULL
-		 * state. */
-		gst_element_set_locked_state (analysis, TRUE);
-		gst_bin_remove (GST_BIN (priv->pipeline), analysis);
-		brasero_normalize_stop_pipeline (BRASERO_NORMALIZE (job));
-		gst_element_set_locked_state (analysis, FALSE);
-	}
+static BraseroBurnResult
+brasero_normalize_fill_pool (BraseroJob *job,
+                             GError **error)
+{
+	BraseroNormalizePrivate *priv;
+
+	priv = BRASERO_NORMALIZE_PRIVATE (job);
+
+	while (g_slist_length (priv->analyses) < priv->max_jobs) {
+		BraseroNormalizeAnalysis *analysis;
+		BraseroTrack *track;
+		gchar *uri;
+
+		track = brasero_normalize_pop_track (job);
+		if (!track)
+			break;
 
-	/* create a new one */
-	priv->track = track;
-	uri = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), TRUE);
-	BRASERO_JOB_LOG (job, "Analysing track %s", uri);
+		uri = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), TRUE);
+		BRASERO_JOB_LOG (job, "Analysing track %s", uri);
 
-	if (!brasero_normalize_build_pipeline (BRASERO_NORMALIZE (job), uri, analysis, error)) {
+		analysis = brasero_normalize_build_pipeline (BRASERO_NORMALIZE (job),
+							     track,
+							     uri,
+							     error);
 		g_free (uri);
-		return BRASERO_BURN_ERR;
+
+		if (!analysis)
+			return BRASERO_BURN_ERR;
+
+		priv->analyses = g_slist_prepend (priv->analyses, analysis);
 	}
 
-	g_free (uri);
+	if (!priv->analyses)
+		return BRASERO_BURN_OK;
+
 	return BRASERO_BURN_RETRY;
 }
 
@@ -376,106 +435,148 @@ brasero_normalize_stop (BraseroJob *job,
 
 	priv = BRASERO_NORMALIZE_PRIVATE (job);
 
-	brasero_normalize_stop_pipeline (BRASERO_NORMALIZE (job));
+	brasero_normalize_stop_pipelines (BRASERO_NORMALIZE (job));
 	if (priv->tracks) {
 		g_slist_free (priv->tracks);
 		priv->tracks = NULL;
 	}
 
-	priv->track = NULL;
-
 	return BRASERO_BURN_OK;
 }
 
 static void
 foreach_tag (const GstTagList *list,
 	     const gchar *tag,
-	     BraseroNormalize *normalize)
+	     BraseroNormalizeAnalysis *analysis)
 {
 	gdouble value = 0.0;
-	BraseroNormalizePrivate *priv;
 
-	priv = BRASERO_NORMALIZE_PRIVATE (normalize);
-
-	/* Those next two are generated at the end only */
-	if (!strcmp (tag, GST_TAG_ALBUM_GAIN)) {
-		gst_tag_list_get_double (list, tag, &value);
-		priv->album_gain = value;
-	}
-	else if (!strcmp (tag, GST_TAG_ALBUM_PEAK)) {
+	/* Since each pipeline only analyses one track there are no album
+	 * values to expect here */
+	if (!strcmp (tag, GST_TAG_TRACK_PEAK)) {
 		gst_tag_list_get_double (list, tag, &value);
-		priv->album_peak = value;
-	}
-	else if (!strcmp (tag, GST_TAG_TRACK_PEAK)) {
-		gst_tag_list_get_double (list, tag, &value);
-		priv->track_peak = value;
+		analysis->track_peak = value;
 	}
 	else if (!strcmp (tag, GST_TAG_TRACK_GAIN)) {
 		gst_tag_list_get_double (list, tag, &value);
-		priv->track_gain = value;
+		analysis->track_gain = value;
 	}
 }
 
 static void
-brasero_normalize_song_end_reached (BraseroNormalize *normalize)
+brasero_normalize_merge_album (BraseroNormalize *normalize,
+                               BraseroNormalizeAnalysis *analysis)
+{
+	gdouble weight;
+	BraseroNormalizePrivate *priv;
+
+	priv = BRASERO_NORMALIZE_PRIVATE (normalize);
+
+	/* The album peak is the highest track peak. For the gain, the loudness
+	 * of each track (which is the opposite of its gain relative to the
+	 * reference level) is averaged in the power domain, weighted by the
+	 * duration of the track. This only approximates what rganalysis
+	 * computes on the whole album since it works on the percentile
+	 * statistics of all the samples, which we don't get. */
+	priv->album_peak = MAX (priv->album_peak, analysis->track_peak);
+
+	if (analysis->duration > 0)
+		weight = (gdouble) analysis->duration / (gdouble) GST_SECOND;
+	else
+		weight = 1.0;
+
+	priv->album_power += weight * pow (10.0, - analysis->track_gain / 10.0);
+	priv->album_weight += weight;
+}
+
+static void
+brasero_normalize_finished (BraseroNormalize *normalize)
+{
+	GValue *value;
+	gdouble album_gain;
+	BraseroNormalizePrivate *priv;
+
+	priv = BRASERO_NORMALIZE_PRIVATE (normalize);
+
+	if (priv->album_weight > 0.0)
+		album_gain = - 10.0 * log10 (priv->album_power / priv->album_weight);
+	else
+		album_gain = 0.0;
+
+	BRASERO_JOB_LOG (normalize,
+			 "Setting album peak (%lf) and gain (%lf)",
+			 priv->album_peak,
+			 album_gain);
+
+	/* finished: set tags */
+	value = g_new0 (GValue, 1);
+	g_value_init (value, G_TYPE_DOUBLE);
+	g_value_set_double (value, priv->album_peak);
+	brasero_job_tag_add (BRASERO_JOB (normalize),
+			     BRASERO_ALBUM_PEAK_VALUE,
+			     value);
+
+	value = g_new0 (GValue, 1);
+	g_value_init (value, G_TYPE_DOUBLE);
+	g_value_set_double (value, album_gain);
+	brasero_job_tag_add (BRASERO_JOB (normalize),
+			     BRASERO_ALBUM_GAIN_VALUE,
+			     value);
+
+	brasero_job_finished_session (BRASERO_JOB (normalize));
+}
+
+static void
+brasero_normalize_song_end_reached (BraseroNormalizeAnalysis *analysis)
 {
 	GValue *value;
 	GError *error = NULL;
 	BraseroBurnResult result;
+	BraseroNormalize *normalize;
 	BraseroNormalizePrivate *priv;
 
+	normalize = analysis->normalize;
 	priv = BRASERO_NORMALIZE_PRIVATE (normalize);
-	
+
 	/* finished track: set tags */
 	BRASERO_JOB_LOG (normalize,
 			 "Setting track peak (%lf) and gain (%lf)",
-			 priv->track_peak,
-			 priv->track_gain);
+			 analysis->track_peak,
+			 analysis->track_gain);
 
 	value = g_new0 (GValue, 1);
 	g_value_init (value, G_TYPE_DOUBLE);
-	g_value_set_double (value, priv->track_peak);
-	brasero_track_tag_add (priv->track,
+	g_value_set_double (value, analysis->track_peak);
+	brasero_track_tag_add (analysis->track,
 			       BRASERO_TRACK_PEAK_VALUE,
 			       value);
 
 	value = g_new0 (GValue, 1);
 	g_value_init (value, G_TYPE_DOUBLE);
-	g_value_set_double (value, priv->track_gain);
-	brasero_track_tag_add (priv->track,
+	g_value_set_double (value, analysis->track_gain);
+	brasero_track_tag_add (analysis->track,
 			       BRASERO_TRACK_GAIN_VALUE,
 			       value);
 
-	priv->track_peak = 0.0;
-	priv->track_gain = 0.0;
+	if (!gst_element_query_duration (analysis->pipeline, GST_FORMAT_TIME, &analysis->duration))
+		analysis->duration = -1;
 
-	result = brasero_normalize_set_next_track (BRASERO_JOB (normalize), &error);
+	brasero_normalize_merge_album (normalize, analysis);
+
+	priv->analyses = g_slist_remove (priv->analyses, analysis);
+	priv->num_done ++;
+
+	/* The bus watch is removed by the caller returning FALSE */
+	analysis->bus_watch = 0;
+	brasero_normalize_analysis_free (analysis);
+
+	/* start the next tracks if any */
+	result = brasero_normalize_fill_pool (BRASERO_JOB (normalize), &error);
 	if (result == BRASERO_BURN_OK) {
-		BRASERO_JOB_LOG (normalize,
-				 "Setting album peak (%lf) and gain (%lf)",
-				 priv->album_peak,
-				 priv->album_gain);
-
-		/* finished: set tags */
-		value = g_new0 (GValue, 1);
-		g_value_init (value, G_TYPE_DOUBLE);
-		g_value_set_double (value, priv->album_peak);
-		brasero_job_tag_add (BRASERO_JOB (normalize),
-				     BRASERO_ALBUM_PEAK_VALUE,
-				     value);
-
-		value = g_new0 (GValue, 1);
-		g_value_init (value, G_TYPE_DOUBLE);
-		g_value_set_double (value, priv->album_gain);
-		brasero_job_tag_add (BRASERO_JOB (normalize),
-				     BRASERO_ALBUM_GAIN_VALUE,
-				     value);
-
-		brasero_job_finished_session (BRASERO_JOB (normalize));
+		brasero_normalize_finished (normalize);
 		return;
 	}
 
-	/* jump to next track */
 	if (result == BRASERO_BURN_ERR) {
 		brasero_job_error (BRASERO_JOB (normalize), error);
 		return;
@@ -485,7 +586,7 @@ brasero_normalize_song_end_reached (BraseroNormalize *normalize)
 static gboolean
 brasero_normalize_bus_messages (GstBus *bus,
 				GstMessage *msg,
-				BraseroNormalize *normalize)
+				BraseroNormalizeAnalysis *analysis)
 {
 	GstTagList *tags = NULL;
 	GError *error = NULL;
@@ -493,23 +594,25 @@ brasero_normalize_bus_messages (GstBus *bus,
 
 	switch (GST_MESSAGE_TYPE (msg)) {
 	case GST_MESSAGE_TAG:
-		/* This is the information we've been waiting for.
-		 * NOTE: levels for whole album is delivered at the end */
+		/* This is the information we've been waiting for. */
 		gst_message_parse_tag (msg, &tags);
-		gst_tag_list_foreach (tags, (GstTagForeachFunc) foreach_tag, normalize);
+		gst_tag_list_foreach (tags, (GstTagForeachFunc) foreach_tag, analysis);
 		gst_tag_list_free (tags);
 		return TRUE;
 
 	case GST_MESSAGE_ERROR:
 		gst_message_parse_error (msg, &error, &debug);
-		BRASERO_JOB_LOG (normalize, debug);
+		BRASERO_JOB_LOG (analysis->normalize, debug);
 		g_free (debug);
 
-	        brasero_job_error (BRASERO_JOB (normalize), error);
+		/* The watch is removed when we return FALSE; the job will
+		 * free everything else when stopped. */
+		analysis->bus_watch = 0;
+	        brasero_job_error (BRASERO_JOB (analysis->normalize), error);
 		return FALSE;
 
 	case GST_MESSAGE_EOS:
-		brasero_normalize_song_end_reached (normalize);
+		brasero_normalize_song_end_reached (analysis);
 		return FALSE;
 
 	case GST_MESSAGE_STATE_CHANGED:
@@ -522,6 +625,23 @@ brasero_normalize_bus_messages (GstBus *bus,
 	return TRUE;
 }
 
+static guint
+brasero_normalize_get_max_jobs (void)
+{
+	GSettings *settings;
+	gint max_jobs;
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	max_jobs = g_settings_get_int (settings, BRASERO_KEY_NORMALIZE_JOBS);
+	g_object_unref (settings);
+
+	/* 0 means as many as there are processors */
+	if (max_jobs <= 0)
+		max_jobs = sysconf (_SC_NPROCESSORS_ONLN);
+
+	return CLAMP (max_jobs, 1, BRASERO_NORMALIZE_MAX_JOBS);
+}
+
 static BraseroBurnResult
 brasero_normalize_start (BraseroJob *job,
 			 GError **error)
@@ -531,8 +651,10 @@ brasero_normalize_start (BraseroJob *job,
 
 	priv = BRASERO_NORMALIZE_PRIVATE (job);
 
-	priv->album_gain = -1.0;
-	priv->album_peak = -1.0;
+	priv->album_peak = 0.0;
+	priv->album_power = 0.0;
+	priv->album_weight = 0.0;
+	priv->num_done = 0;
 
 	/* get tracks */
 	brasero_job_get_tracks (job, &priv->tracks);
@@ -540,8 +662,12 @@ brasero_normalize_start (BraseroJob *job,
 		return BRASERO_BURN_ERR;
 
 	priv->tracks = g_slist_copy (priv->tracks);
+	priv->num_tracks = g_slist_length (priv->tracks);
 
-	result = brasero_normalize_set_next_track (job, error);
+	priv->max_jobs = brasero_normalize_get_max_jobs ();
+	BRASERO_JOB_LOG (job, "Analysing up to %i tracks at a time", priv->max_jobs);
+
+	result = brasero_normalize_fill_pool (job, error);
 	if (result == BRASERO_BURN_ERR)
 		return BRASERO_BURN_ERR;
 
@@ -579,31 +705,31 @@ brasero_normalize_activate (BraseroJob *job,
 static BraseroBurnResult
 brasero_normalize_clock_tick (BraseroJob *job)
 {
-	gint64 position = 0.0;
-	gint64 duration = 0.0;
+	GSList *iter;
+	gdouble progress;
 	BraseroNormalizePrivate *priv;
 
 	priv = BRASERO_NORMALIZE_PRIVATE (job);
 
-	gst_element_query_duration (priv->pipeline, GST_FORMAT_TIME, &duration);
-	gst_element_query_position (priv->pipeline, GST_FORMAT_TIME, &position);
-
-	if (duration > 0) {
-		GSList *tracks;
-		gdouble progress;
+	if (!priv->num_tracks)
+		return BRASERO_BURN_OK;
 
-		brasero_job_get_tracks (job, &tracks);
-		progress = (gdouble) position / (gdouble) duration;
+	/* Sum the progress of all running analyses */
+	progress = priv->num_done;
+	for (iter = priv->analyses; iter; iter = iter->next) {
+		BraseroNormalizeAnalysis *analysis;
+		gint64 position = 0;
+		gint64 duration = 0;
 
-		if (tracks) {
-			gdouble num_tracks;
+		analysis = iter->data;
+		gst_element_query_duration (analysis->pipeline, GST_FORMAT_TIME, &duration);
+		gst_element_query_position (analysis->pipeline, GST_FORMAT_TIME, &position);
 
-			num_tracks = g_slist_length (tracks);
-			progress = (gdouble) (num_tracks - 1.0 - (gdouble) g_slist_length (priv->tracks) + progress) / (gdouble) num_tracks;
-			brasero_job_set_progress (job, progress);
-		}
+		if (duration > 0)
+			progress += MIN ((gdouble) position / (gdouble) duration, 1.0);
 	}
 
+	brasero_job_set_progress (job, progress / (gdouble) priv->num_tracks);
 	return BRASERO_BURN_OK;
 }
 
@@ -636,6 +762,7 @@ brasero_normalize_class_init (BraseroNormalizeClass *klass)
 static void
 brasero_normalize_export_caps (BraseroPlugin *plugin)
 {
+	BraseroPluginConfOption *jobs;
 	GSList *input;
 
 	brasero_plugin_define (plugin,
@@ -669,6 +796,13 @@ brasero_normalize_export_caps (BraseroPlugin *plugin)
 	 * See https://bugzilla.gnome.org/show_bug.cgi?id=699599 */
 	brasero_plugin_set_process_flags (plugin, BRASERO_PLUGIN_RUN_NEVER);
 
+	/* add some configure options */
+	jobs = brasero_plugin_conf_option_new (BRASERO_KEY_NORMALIZE_JOBS,
+					       _("Number of tracks analysed at the same time (0 means one per processor):"),
+					       BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (jobs, 0, BRASERO_NORMALIZE_MAX_JOBS);
+	brasero_plugin_add_conf_option (plugin, jobs);
+
 	brasero_plugin_set_compulsory (plugin, FALSE);
 }
 
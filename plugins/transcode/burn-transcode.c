@@ -41,6 +41,7 @@
 #include <glib/gi18n-lib.h>
 #include <glib/gstdio.h>
 #include <gmodule.h>
+#include <gio/gio.h>
 
 #include <gst/gst.h>
 
@@ -59,6 +60,10 @@
 #define BRASERO_IS_TRANSCODE_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), BRASERO_TYPE_TRANSCODE))
 #define BRASERO_TRANSCODE_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), BRASERO_TYPE_TRANSCODE, BraseroTranscodeClass))
 
+#define BRASERO_SCHEMA_CONFIG			"org.gnome.brasero.config"
+#define BRASERO_KEY_TRANSCODE_AHEAD		"transcode-ahead"
+#define BRASERO_KEY_TRANSCODE_SPOOL_SIZE	"transcode-spool-size"
+
 BRASERO_PLUGIN_BOILERPLATE (BraseroTranscode, brasero_transcode, BRASERO_TYPE_JOB, BraseroJob);
 
 static gboolean brasero_transcode_bus_messages (GstBus *bus,
@@ -68,6 +73,45 @@ static void brasero_transcode_new_decoded_pad_cb (GstElement *decode,
 						  GstPad *pad,
 						  BraseroTranscode *transcode);
 
+typedef struct _BraseroTranscodeSpool BraseroTranscodeSpool;
+
+static void brasero_transcode_spool_fill (BraseroTranscode *transcode);
+static void brasero_transcode_spool_clear (BraseroTranscode *transcode);
+static void brasero_transcode_spool_remove (BraseroTranscode *transcode,
+					    BraseroTranscodeSpool *spool);
+static BraseroTranscodeSpool *brasero_transcode_spool_find (BraseroTranscode *transcode,
+							    BraseroTrack *track);
+static gboolean brasero_transcode_create_pipeline_spooled (BraseroTranscode *transcode,
+							   BraseroTranscodeSpool *spool,
+							   GError **error);
+
+/* Used to trim the decoded stream to the track boundaries */
+struct _BraseroTranscodeSegment {
+	gint64 size;
+	gint64 pos;
+
+	gint64 segment_start;
+	gint64 segment_end;
+};
+typedef struct _BraseroTranscodeSegment BraseroTranscodeSegment;
+
+/* A track decoded ahead into a temporary file while piping */
+struct _BraseroTranscodeSpool {
+	BraseroTranscode *transcode;
+	BraseroTrack *track;
+	gchar *path;
+
+	GstElement *pipeline;
+	GstElement *convert;
+	GstElement *link;
+	guint bus_watch;
+
+	BraseroTranscodeSegment segment;
+	gint64 estimated;
+
+	guint complete:1;
+};
+
 struct BraseroTranscodePrivate {
 	GstElement *pipeline;
 	GstElement *convert;
@@ -82,15 +126,17 @@ struct BraseroTranscodePrivate {
 	gint pad_fd;
 	gint pad_id;
 
-	gint64 size;
-	gint64 pos;
-
+	BraseroTranscodeSegment segment;
 	gulong probe;
-	gint64 segment_start;
-	gint64 segment_end;
+
+	/* tracks decoded ahead when piping */
+	GSList *spool;
+	guint spool_jobs;
+	gint64 spool_max_size;
 
 	guint set_active_state:1;
 	guint mp3_size_pipeline:1;
+	guint keep_spool:1;
 };
 typedef struct BraseroTranscodePrivate BraseroTranscodePrivate;
 
@@ -105,36 +151,33 @@ brasero_transcode_buffer_handler (GstPad *pad,
                                   GstPadProbeInfo *info,
                                   gpointer user_data)
 {
-	BraseroTranscodePrivate *priv;
-	BraseroTranscode *self = user_data;
+	BraseroTranscodeSegment *segment = user_data;
 	GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
 	GstPad *peer;
 	gint64 size;
 
-	priv = BRASERO_TRANSCODE_PRIVATE (self);
-
 	size = gst_buffer_get_size (buffer);
 
-	if (priv->segment_start <= 0 && priv->segment_end <= 0)
+	if (segment->segment_start <= 0 && segment->segment_end <= 0)
 		return GST_PAD_PROBE_OK;
 
 	/* what we do here is more or less what gstreamer does when seeking:
 	 * it reads and process from 0 to the seek position (I tried).
 	 * It even forwards the data before the seek position to the sink (which
 	 * is a problem in our case as it would be written) */
-	if (priv->size > priv->segment_end) {
-		priv->size += size;
+	if (segment->size > segment->segment_end) {
+		segment->size += size;
 		return GST_PAD_PROBE_DROP;
 	}
 
-	if (priv->size + size > priv->segment_end) {
+	if (segment->size + size > segment->segment_end) {
 		GstBuffer *new_buffer;
 		int data_size;
 
 		/* the entire the buffer is not interesting for us */
 		/* create a new buffer and push it on the pad:
 		 * NOTE: we're going to receive it ... */
-		data_size = priv->segment_end - priv->size;
+		data_size = segment->segment_end - segment->size;
 		new_buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_METADATA, 0, data_size);
 
 		/* FIXME: we can now modify the probe buffer in 0.11 */
@@ -142,7 +185,7 @@ brasero_transcode_buffer_handler (GstPad *pad,
 		peer = gst_pad_get_peer (pad);
 		gst_pad_push (peer, new_buffer);
 
-		priv->size += size - data_size;
+		segment->size += size - data_size;
 
 		/* post an EOS event to stop pipeline */
 		gst_pad_push_event (peer, gst_event_new_eos ());
@@ -151,25 +194,25 @@ brasero_transcode_buffer_handler (GstPad *pad,
 	}
 
 	/* see if the buffer is in the segment */
-	if (priv->size < priv->segment_start) {
+	if (segment->size < segment->segment_start) {
 		GstBuffer *new_buffer;
 		gint data_size;
 
 		/* see if all the buffer is interesting for us */
-		if (priv->size + size < priv->segment_start) {
-			priv->size += size;
+		if (segment->size + size < segment->segment_start) {
+			segment->size += size;
 			return GST_PAD_PROBE_DROP;
 		}
 
 		/* create a new buffer and push it on the pad:
 		 * NOTE: we're going to receive it ... */
-		data_size = priv->size + size - priv->segment_start;
+		data_size = segment->size + size - segment->segment_start;
 		new_buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_METADATA, size - data_size, data_size);
 		/* FIXME: this looks dodgy (tpm) */
 		GST_BUFFER_TIMESTAMP (new_buffer) = GST_BUFFER_TIMESTAMP (buffer) + data_size;
 
 		/* move forward by the size of bytes we dropped */
-		priv->size += size - data_size;
+		segment->size += size - data_size;
 
 		/* FIXME: we can now modify the probe buffer in 0.11 */
 		/* this is recursive the following calls ourselves 
@@ -181,8 +224,8 @@ brasero_transcode_buffer_handler (GstPad *pad,
 		return GST_PAD_PROBE_DROP;
 	}
 
-	priv->size += size;
-	priv->pos += size;
+	segment->size += size;
+	segment->pos += size;
 
 	return GST_PAD_PROBE_OK;
 }
@@ -203,31 +246,27 @@ brasero_transcode_set_boundaries (BraseroTranscode *transcode)
 	start = brasero_track_stream_get_start (BRASERO_TRACK_STREAM (track));
 	end = brasero_track_stream_get_end (BRASERO_TRACK_STREAM (track));
 
-	priv->segment_start = BRASERO_DURATION_TO_BYTES (start);
-	priv->segment_end = BRASERO_DURATION_TO_BYTES (end);
+	priv->segment.segment_start = BRASERO_DURATION_TO_BYTES (start);
+	priv->segment.segment_end = BRASERO_DURATION_TO_BYTES (end);
 
 	BRASERO_JOB_LOG (transcode, "settings track boundaries time = %lli %lli / bytes = %lli %lli",
 			 start, end,
-			 priv->segment_start, priv->segment_end);
+			 priv->segment.segment_start, priv->segment.segment_end);
 
 	return BRASERO_BURN_OK;
 }
 
 static void
-brasero_transcode_send_volume_event (BraseroTranscode *transcode)
+brasero_transcode_send_volume_event (BraseroTranscode *transcode,
+				     BraseroTrack *track,
+				     GstElement *convert)
 {
-	BraseroTranscodePrivate *priv;
 	gdouble track_peak = 0.0;
 	gdouble track_gain = 0.0;
 	GstTagList *tag_list;
-	BraseroTrack *track;
 	GstEvent *event;
 	GValue *value;
 
-	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
-
-	brasero_job_get_current_track (BRASERO_JOB (transcode), &track);
-
 	BRASERO_JOB_LOG (transcode, "Sending audio levels tags");
 	if (brasero_track_tag_lookup (track, BRASERO_TRACK_PEAK_VALUE, &value) == BRASERO_BURN_OK)
 		track_peak = g_value_get_double (value);
@@ -242,7 +281,7 @@ brasero_transcode_send_volume_event (BraseroTranscode *transcode)
 
 	/* NOTE: that event is goind downstream */
 	event = gst_event_new_tag (tag_list);
-	if (!gst_element_send_event (priv->convert, event))
+	if (!gst_element_send_event (convert, event))
 		BRASERO_JOB_LOG (transcode, "Couldn't send tags to rgvolume");
 
 	BRASERO_JOB_LOG (transcode, "Set volume level %lf %lf", track_gain, track_peak);
@@ -331,17 +370,13 @@ brasero_transcode_create_pipeline_size_mp3 (BraseroTranscode *transcode,
 }
 
 static void
-brasero_transcode_error_on_pad_linking (BraseroTranscode *self,
-                                        const gchar *function_name)
+brasero_transcode_post_pad_linking_error (GstElement *pipeline,
+					  const gchar *function_name)
 {
-	BraseroTranscodePrivate *priv;
 	GstMessage *message;
 	GstBus *bus;
 
-	priv = BRASERO_TRANSCODE_PRIVATE (self);
-
-	BRASERO_JOB_LOG (self, "Error on pad linking");
-	message = gst_message_new_error (GST_OBJECT (priv->pipeline),
+	message = gst_message_new_error (GST_OBJECT (pipeline),
 					 g_error_new (BRASERO_BURN_ERROR,
 						      BRASERO_BURN_ERROR_GENERAL,
 						      /* Translators: This message is sent
@@ -354,11 +389,23 @@ brasero_transcode_error_on_pad_linking (BraseroTranscode *self,
 						      _("Impossible to link plugin pads")),
 					 function_name);
 
-	bus = gst_pipeline_get_bus (GST_PIPELINE (priv->pipeline));
+	bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
 	gst_bus_post (bus, message);
 	g_object_unref (bus);
 }
 
+static void
+brasero_transcode_error_on_pad_linking (BraseroTranscode *self,
+                                        const gchar *function_name)
+{
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (self);
+
+	BRASERO_JOB_LOG (self, "Error on pad linking");
+	brasero_transcode_post_pad_linking_error (priv->pipeline, function_name);
+}
+
 static gboolean
 brasero_transcode_create_pipeline (BraseroTranscode *transcode,
 				   GError **error)
@@ -527,12 +574,12 @@ brasero_transcode_create_pipeline (BraseroTranscode *transcode,
 		/* This is an ugly workaround for the lack of accuracy with
 		 * gstreamer. Yet this is unfortunately a necessary evil. */
 		/* FIXME: this does not look like it makes sense... (tpm) */
-		priv->pos = 0;
-		priv->size = 0;
+		priv->segment.pos = 0;
+		priv->segment.size = 0;
 		sinkpad = gst_element_get_static_pad (sink, "sink");
 		priv->probe = gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
 		                                 brasero_transcode_buffer_handler,
-		                                 transcode, NULL);
+		                                 &priv->segment, NULL);
 		gst_object_unref (sinkpad);
 
 
@@ -661,12 +708,12 @@ brasero_transcode_create_pipeline (BraseroTranscode *transcode,
 		/* This is an ugly workaround for the lack of accuracy with
 		 * gstreamer. Yet this is unfortunately a necessary evil. */
 		/* FIXME: this does not look like it makes sense... (tpm) */
-		priv->pos = 0;
-		priv->size = 0;
+		priv->segment.pos = 0;
+		priv->segment.size = 0;
 		sinkpad = gst_element_get_static_pad (sink, "sink");
 		priv->probe = gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
 		                                 brasero_transcode_buffer_handler,
-		                                 transcode, NULL);
+		                                 &priv->segment, NULL);
 		gst_object_unref (sinkpad);
 	}
 	else {
@@ -950,7 +997,32 @@ brasero_transcode_start (BraseroJob *job,
 		}
 
 		brasero_transcode_set_boundaries (transcode);
-		if (!brasero_transcode_create_pipeline (transcode, error))
+
+		if (brasero_job_get_fd_out (job, NULL) == BRASERO_BURN_OK) {
+			BraseroTranscodeSpool *spool;
+			BraseroTrack *track;
+
+			/* See if the track was decoded ahead. If it is still
+			 * being decoded, it's faster to start over directly. */
+			brasero_job_get_current_track (job, &track);
+			spool = brasero_transcode_spool_find (transcode, track);
+			if (spool && !spool->complete) {
+				BRASERO_JOB_LOG (job, "Track is not completely spooled");
+				brasero_transcode_spool_remove (transcode, spool);
+				spool = NULL;
+			}
+
+			if (spool) {
+				if (!brasero_transcode_create_pipeline_spooled (transcode, spool, error))
+					return BRASERO_BURN_ERR;
+			}
+			else if (!brasero_transcode_create_pipeline (transcode, error))
+				return BRASERO_BURN_ERR;
+
+			/* Start decoding upcoming tracks */
+			brasero_transcode_spool_fill (transcode);
+		}
+		else if (!brasero_transcode_create_pipeline (transcode, error))
 			return BRASERO_BURN_ERR;
 	}
 	else
@@ -1003,6 +1075,22 @@ brasero_transcode_stop (BraseroJob *job,
 	}
 
 	brasero_transcode_stop_pipeline (BRASERO_TRANSCODE (job));
+
+	/* Keep the tracks decoded ahead only if we are moving on to the next
+	 * track; otherwise we're cancelled or there was an error. */
+	if (priv->keep_spool) {
+		BraseroTranscodeSpool *spool;
+		BraseroTrack *track;
+
+		brasero_job_get_current_track (job, &track);
+		spool = brasero_transcode_spool_find (BRASERO_TRANSCODE (job), track);
+		if (spool)
+			brasero_transcode_spool_remove (BRASERO_TRANSCODE (job), spool);
+	}
+	else
+		brasero_transcode_spool_clear (BRASERO_TRANSCODE (job));
+
+	priv->keep_spool = FALSE;
 	return BRASERO_BURN_OK;
 }
 
@@ -1059,6 +1147,7 @@ brasero_transcode_pad_real (BraseroTranscode *transcode,
 static void
 brasero_transcode_push_track (BraseroTranscode *transcode)
 {
+	BraseroTranscodePrivate *priv;
 	guint64 length = 0;
 	gchar *output = NULL;
 	BraseroTrack *src = NULL;
@@ -1084,6 +1173,11 @@ brasero_transcode_push_track (BraseroTranscode *transcode)
 	 * anymore. BraseroTaskCtx refs it. */
 	g_object_unref (track);
 
+	/* ::stop is going to be called but we're not done with the tracks
+	 * decoded ahead */
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	priv->keep_spool = TRUE;
+
 	brasero_job_finished_track (BRASERO_JOB (transcode));
 }
 
@@ -1121,38 +1215,33 @@ brasero_transcode_pad_idle (BraseroTranscode *transcode)
 	return FALSE;
 }
 
-static gboolean
-brasero_transcode_pad (BraseroTranscode *transcode, int fd, GError **error)
+static gint64
+brasero_transcode_get_padding (BraseroTranscode *transcode,
+			       BraseroTrack *track,
+			       gint64 pos)
 {
 	guint64 length = 0;
 	gint64 bytes2write = 0;
-	BraseroTrack *track = NULL;
-	BraseroTranscodePrivate *priv;
-
-	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
-	if (priv->pos < 0)
-		return TRUE;
 
 	/* Padding is important for two reasons:
 	 * - first if didn't output enough bytes compared to what we should have
 	 * - second we must output a multiple of 2352 to respect sector
 	 *   boundaries */
-	brasero_job_get_current_track (BRASERO_JOB (transcode), &track);
 	brasero_track_stream_get_length (BRASERO_TRACK_STREAM (track), &length);
 
-	if (priv->pos < BRASERO_DURATION_TO_BYTES (length)) {
+	if (pos < BRASERO_DURATION_TO_BYTES (length)) {
 		gint64 b_written = 0;
 
 		/* Check bytes boundary for length */
 		b_written = BRASERO_DURATION_TO_BYTES (length);
 		b_written += (b_written % 2352) ? 2352 - (b_written % 2352):0;
-		bytes2write = b_written - priv->pos;
+		bytes2write = b_written - pos;
 
 		BRASERO_JOB_LOG (transcode,
 				 "wrote %lli bytes (= %lli ns) out of %lli (= %lli ns)"
 				 "\n=> padding %lli bytes",
-				 priv->pos,
-				 BRASERO_BYTES_TO_DURATION (priv->pos),
+				 pos,
+				 BRASERO_BYTES_TO_DURATION (pos),
 				 BRASERO_DURATION_TO_BYTES (length),
 				 length,
 				 bytes2write);
@@ -1161,16 +1250,35 @@ brasero_transcode_pad (BraseroTranscode *transcode, int fd, GError **error)
 		gint64 b_written = 0;
 
 		/* wrote more or the exact amount of bytes. Check bytes boundary */
-		b_written = priv->pos;
+		b_written = pos;
 		bytes2write = (b_written % 2352) ? 2352 - (b_written % 2352):0;
 		BRASERO_JOB_LOG (transcode,
 				 "wrote %lli bytes (= %lli ns)"
 				 "\n=> padding %lli bytes",
 				 b_written,
-				 priv->pos,
+				 pos,
 				 bytes2write);
 	}
 
+	return bytes2write;
+}
+
+static gboolean
+brasero_transcode_pad (BraseroTranscode *transcode, int fd, GError **error)
+{
+	gint64 bytes2write = 0;
+	BraseroTrack *track = NULL;
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	if (priv->segment.pos < 0)
+		return TRUE;
+
+	brasero_job_get_current_track (BRASERO_JOB (transcode), &track);
+	bytes2write = brasero_transcode_get_padding (transcode,
+						     track,
+						     priv->segment.pos);
+
 	if (!bytes2write)
 		return TRUE;
 
@@ -1247,6 +1355,596 @@ brasero_transcode_pad_file (BraseroTranscode *transcode, GError **error)
 	return result;
 }
 
+/**
+ * Transcode-ahead: when piping to a recorder, upcoming tracks are decoded in
+ * parallel into temporary files so that a slow to decode track does not
+ * starve the recorder. When its turn comes a spooled track is simply copied
+ * to the pipe.
+ */
+
+static gboolean
+brasero_transcode_is_dts_copy (BraseroTranscode *transcode,
+			       BraseroTrack *track)
+{
+	GValue *value = NULL;
+
+	brasero_job_tag_lookup (BRASERO_JOB (transcode),
+				BRASERO_SESSION_STREAM_AUDIO_FORMAT,
+				&value);
+	if (!value || (g_value_get_int (value) & BRASERO_AUDIO_FORMAT_DTS) == 0)
+		return FALSE;
+
+	return (brasero_track_stream_get_format (BRASERO_TRACK_STREAM (track)) & BRASERO_AUDIO_FORMAT_DTS) != 0;
+}
+
+static void
+brasero_transcode_spool_free (BraseroTranscodeSpool *spool)
+{
+	if (spool->bus_watch) {
+		g_source_remove (spool->bus_watch);
+		spool->bus_watch = 0;
+	}
+
+	if (spool->pipeline) {
+		gst_element_set_state (spool->pipeline, GST_STATE_NULL);
+		gst_object_unref (GST_OBJECT (spool->pipeline));
+		spool->pipeline = NULL;
+	}
+
+	if (spool->path) {
+		g_remove (spool->path);
+		g_free (spool->path);
+		spool->path = NULL;
+	}
+
+	g_object_unref (spool->track);
+	g_free (spool);
+}
+
+static void
+brasero_transcode_spool_update_depth (BraseroTranscode *transcode)
+{
+	BraseroTranscodePrivate *priv;
+	guint tracks = 0;
+	GSList *iter;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	for (iter = priv->spool; iter; iter = iter->next) {
+		BraseroTranscodeSpool *spool;
+
+		spool = iter->data;
+		if (spool->complete)
+			tracks ++;
+	}
+
+	brasero_job_set_spool_depth (BRASERO_JOB (transcode), tracks);
+}
+
+static void
+brasero_transcode_spool_remove (BraseroTranscode *transcode,
+				BraseroTranscodeSpool *spool)
+{
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	priv->spool = g_slist_remove (priv->spool, spool);
+	brasero_transcode_spool_free (spool);
+	brasero_transcode_spool_update_depth (transcode);
+}
+
+static void
+brasero_transcode_spool_clear (BraseroTranscode *transcode)
+{
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	if (!priv->spool)
+		return;
+
+	g_slist_foreach (priv->spool, (GFunc) brasero_transcode_spool_free, NULL);
+	g_slist_free (priv->spool);
+	priv->spool = NULL;
+
+	brasero_job_set_spool_depth (BRASERO_JOB (transcode), 0);
+}
+
+static BraseroTranscodeSpool *
+brasero_transcode_spool_find (BraseroTranscode *transcode,
+			      BraseroTrack *track)
+{
+	BraseroTranscodePrivate *priv;
+	GSList *iter;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	for (iter = priv->spool; iter; iter = iter->next) {
+		BraseroTranscodeSpool *spool;
+
+		spool = iter->data;
+		if (spool->track == track)
+			return spool;
+	}
+
+	return NULL;
+}
+
+static void
+brasero_transcode_spool_end_reached (BraseroTranscodeSpool *spool)
+{
+	BraseroTranscode *transcode;
+	GError *error = NULL;
+	gint64 bytes2write;
+	int fd;
+
+	transcode = spool->transcode;
+
+	/* the pipeline is not needed anymore. NOTE: the bus watch is removed
+	 * by the caller returning FALSE. */
+	spool->bus_watch = 0;
+	gst_element_set_state (spool->pipeline, GST_STATE_NULL);
+	gst_object_unref (GST_OBJECT (spool->pipeline));
+	spool->pipeline = NULL;
+
+	/* pad the file now so that it can be copied as is to the pipe */
+	bytes2write = brasero_transcode_get_padding (transcode,
+						     spool->track,
+						     spool->segment.pos);
+	if (bytes2write) {
+		fd = open (spool->path, O_WRONLY|O_APPEND);
+		if (fd == -1
+		||  brasero_transcode_pad_real (transcode, fd, bytes2write, &error) != 0) {
+			BRASERO_JOB_LOG (transcode,
+					 "Spooled track could not be padded (%s)",
+					 error ? error->message:g_strerror (errno));
+			if (error)
+				g_error_free (error);
+
+			if (fd != -1)
+				close (fd);
+
+			/* that track will be decoded when its turn comes */
+			brasero_transcode_spool_remove (transcode, spool);
+			return;
+		}
+
+		close (fd);
+		spool->segment.pos += bytes2write;
+	}
+
+	spool->complete = TRUE;
+	BRASERO_JOB_LOG (transcode,
+			 "Spooled %s (%lli bytes)",
+			 spool->path,
+			 spool->segment.pos);
+
+	brasero_transcode_spool_update_depth (transcode);
+	brasero_transcode_spool_fill (transcode);
+}
+
+static gboolean
+brasero_transcode_spool_bus_messages (GstBus *bus,
+				      GstMessage *msg,
+				      BraseroTranscodeSpool *spool)
+{
+	GError *error = NULL;
+	gchar *debug;
+
+	switch (GST_MESSAGE_TYPE (msg)) {
+	case GST_MESSAGE_ERROR:
+		/* This is not fatal: the track will be decoded when its turn
+		 * comes and the error reported then if it happens again */
+		gst_message_parse_error (msg, &error, &debug);
+		BRASERO_JOB_LOG (spool->transcode,
+				 "Spooling failed: %s (%s)",
+				 error ? error->message:"",
+				 debug);
+		g_free (debug);
+		if (error)
+			g_error_free (error);
+
+		spool->bus_watch = 0;
+		brasero_transcode_spool_remove (spool->transcode, spool);
+		return FALSE;
+
+	case GST_MESSAGE_EOS:
+		brasero_transcode_spool_end_reached (spool);
+		return FALSE;
+
+	default:
+		return TRUE;
+	}
+
+	return TRUE;
+}
+
+static void
+brasero_transcode_spool_new_decoded_pad_cb (GstElement *decode,
+					    GstPad *pad,
+					    BraseroTranscodeSpool *spool)
+{
+	GstPad *sink;
+	GstCaps *caps;
+	GstElement *element;
+	GstStructure *structure;
+
+	caps = gst_pad_query_caps (pad, NULL);
+	if (!caps)
+		return;
+
+	structure = gst_caps_get_structure (caps, 0);
+	if (!structure) {
+		gst_caps_unref (caps);
+		return;
+	}
+
+	if (g_strrstr (gst_structure_get_name (structure), "audio")) {
+		brasero_transcode_send_volume_event (spool->transcode,
+						     spool->track,
+						     spool->convert);
+
+		/* see brasero_transcode_new_decoded_pad_cb () */
+		element = gst_element_factory_make ("queue", NULL);
+		gst_bin_add (GST_BIN (spool->pipeline), element);
+		if (!gst_element_link (element, spool->link)) {
+			brasero_transcode_post_pad_linking_error (spool->pipeline, "Sent by brasero_transcode_spool_new_decoded_pad_cb");
+			gst_caps_unref (caps);
+			return;
+		}
+	}
+	else if (g_strrstr (gst_structure_get_name (structure), "video")) {
+		element = gst_element_factory_make ("fakesink", NULL);
+		if (!element) {
+			brasero_transcode_post_pad_linking_error (spool->pipeline, "Sent by brasero_transcode_spool_new_decoded_pad_cb");
+			gst_caps_unref (caps);
+			return;
+		}
+		gst_bin_add (GST_BIN (spool->pipeline), element);
+	}
+	else {
+		gst_caps_unref (caps);
+		return;
+	}
+
+	sink = gst_element_get_static_pad (element, "sink");
+	if (GST_PAD_IS_LINKED (sink)
+	||  gst_pad_link (pad, sink) != GST_PAD_LINK_OK)
+		brasero_transcode_post_pad_linking_error (spool->pipeline, "Sent by brasero_transcode_spool_new_decoded_pad_cb");
+	else
+		gst_element_set_state (element, GST_STATE_PLAYING);
+
+	gst_object_unref (sink);
+	gst_caps_unref (caps);
+}
+
+static BraseroTranscodeSpool *
+brasero_transcode_spool_new (BraseroTranscode *transcode,
+			     BraseroTrack *track,
+			     GError **error)
+{
+	gchar *uri;
+	GstBus *bus;
+	GstPad *sinkpad;
+	GstCaps *filtercaps;
+	GstElement *source;
+	GstElement *decode;
+	GstElement *resample;
+	GstElement *convert;
+	GstElement *filter;
+	GstElement *volume;
+	GstElement *sink;
+	gboolean res;
+	guint64 length = 0;
+	BraseroTrackType *output_type;
+	BraseroTranscodeSpool *spool;
+	BraseroStreamFormat session_format;
+
+	spool = g_new0 (BraseroTranscodeSpool, 1);
+	spool->transcode = transcode;
+	spool->track = g_object_ref (track);
+
+	if (brasero_job_get_tmp_file (BRASERO_JOB (transcode),
+				      ".cdda",
+				      &spool->path,
+				      error) != BRASERO_BURN_OK)
+		goto error;
+
+	brasero_track_stream_get_length (BRASERO_TRACK_STREAM (track), &length);
+	spool->estimated = BRASERO_DURATION_TO_BYTES (length);
+	spool->segment.segment_start = BRASERO_DURATION_TO_BYTES (brasero_track_stream_get_start (BRASERO_TRACK_STREAM (track)));
+	spool->segment.segment_end = BRASERO_DURATION_TO_BYTES (brasero_track_stream_get_end (BRASERO_TRACK_STREAM (track)));
+
+	/* uri ! decodebin ! queue ! audioresample ! (rgvolume) ! audioconvert !
+	 * audio/x-raw,format=S16BE,rate=44100 ! filesink */
+	spool->pipeline = gst_pipeline_new (NULL);
+
+	uri = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), TRUE);
+	source = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, NULL);
+	g_free (uri);
+
+	decode = gst_element_factory_make ("decodebin", NULL);
+	resample = gst_element_factory_make ("audioresample", NULL);
+	convert = gst_element_factory_make ("audioconvert", NULL);
+	filter = gst_element_factory_make ("capsfilter", NULL);
+	sink = gst_element_factory_make ("filesink", NULL);
+
+	if (!source || !decode || !resample || !convert || !filter || !sink) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Spool\"");
+
+		/* those that weren't added to the pipeline yet */
+		if (source)
+			gst_object_unref (source);
+		if (decode)
+			gst_object_unref (decode);
+		if (resample)
+			gst_object_unref (resample);
+		if (convert)
+			gst_object_unref (convert);
+		if (filter)
+			gst_object_unref (filter);
+		if (sink)
+			gst_object_unref (sink);
+		goto error;
+	}
+
+	gst_bin_add_many (GST_BIN (spool->pipeline),
+			  source,
+			  decode,
+			  resample,
+			  convert,
+			  filter,
+			  sink,
+			  NULL);
+
+	g_object_set (source,
+		      "typefind", FALSE,
+		      NULL);
+	g_object_set (sink,
+		      "location", spool->path,
+		      "sync", FALSE,
+		      NULL);
+
+	output_type = brasero_track_type_new ();
+	brasero_job_get_output_type (BRASERO_JOB (transcode), output_type);
+	session_format = brasero_track_type_get_stream_format (output_type);
+	brasero_track_type_free (output_type);
+
+	filtercaps = gst_caps_new_full (gst_structure_new ("audio/x-raw",
+							   "format", G_TYPE_STRING, (session_format & BRASERO_AUDIO_FORMAT_RAW_LITTLE_ENDIAN) != 0 ? "S16LE" : "S16BE",
+							   "channels", G_TYPE_INT, 2,
+							   "rate", G_TYPE_INT, 44100,
+							   NULL),
+					NULL);
+	g_object_set (GST_OBJECT (filter), "caps", filtercaps, NULL);
+	gst_caps_unref (filtercaps);
+
+	volume = brasero_transcode_create_volume (transcode, track);
+	if (volume) {
+		gst_bin_add (GST_BIN (spool->pipeline), volume);
+		res = gst_element_link_many (resample,
+					     volume,
+					     convert,
+					     filter,
+					     sink,
+					     NULL);
+	}
+	else
+		res = gst_element_link_many (resample,
+					     convert,
+					     filter,
+					     sink,
+					     NULL);
+
+	if (!res || !gst_element_link (source, decode)) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("Impossible to link plugin pads"));
+		goto error;
+	}
+
+	spool->link = resample;
+	spool->convert = convert;
+	g_signal_connect (G_OBJECT (decode),
+			  "pad-added",
+			  G_CALLBACK (brasero_transcode_spool_new_decoded_pad_cb),
+			  spool);
+
+	sinkpad = gst_element_get_static_pad (sink, "sink");
+	gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+			   brasero_transcode_buffer_handler,
+			   &spool->segment, NULL);
+	gst_object_unref (sinkpad);
+
+	bus = gst_pipeline_get_bus (GST_PIPELINE (spool->pipeline));
+	spool->bus_watch = gst_bus_add_watch (bus,
+					      (GstBusFunc) brasero_transcode_spool_bus_messages,
+					      spool);
+	gst_object_unref (bus);
+
+	gst_element_set_state (spool->pipeline, GST_STATE_PLAYING);
+	return spool;
+
+error:
+
+	if (error && (*error))
+		BRASERO_JOB_LOG (transcode,
+				 "can't spool track : %s",
+				 (*error)->message);
+
+	brasero_transcode_spool_free (spool);
+	return NULL;
+}
+
+static void
+brasero_transcode_spool_fill (BraseroTranscode *transcode)
+{
+	BraseroTranscodePrivate *priv;
+	BraseroTrack *current = NULL;
+	GSList *tracks = NULL;
+	gint64 spooled = 0;
+	guint running = 0;
+	GSList *iter;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	if (!priv->spool_jobs || !priv->spool_max_size)
+		return;
+
+	for (iter = priv->spool; iter; iter = iter->next) {
+		BraseroTranscodeSpool *spool;
+
+		spool = iter->data;
+		if (spool->complete)
+			spooled += spool->segment.pos;
+		else {
+			spooled += spool->estimated;
+			running ++;
+		}
+	}
+
+	/* Go through the upcoming tracks in the order they will be written */
+	brasero_job_get_current_track (BRASERO_JOB (transcode), &current);
+	brasero_job_get_tracks (BRASERO_JOB (transcode), &tracks);
+	iter = g_slist_find (tracks, current);
+	if (!iter)
+		return;
+
+	for (iter = iter->next; iter; iter = iter->next) {
+		BraseroTranscodeSpool *spool;
+		BraseroTrack *track;
+		GError *error = NULL;
+
+		if (running >= priv->spool_jobs)
+			break;
+
+		/* Always allow at least the next track */
+		if (priv->spool && spooled >= priv->spool_max_size)
+			break;
+
+		track = iter->data;
+		if (brasero_transcode_spool_find (transcode, track))
+			continue;
+
+		if (brasero_transcode_is_dts_copy (transcode, track))
+			continue;
+
+		spool = brasero_transcode_spool_new (transcode, track, &error);
+		if (!spool) {
+			/* Not fatal, the track will be decoded in turn */
+			if (error)
+				g_error_free (error);
+			break;
+		}
+
+		BRASERO_JOB_LOG (transcode, "Spooling track to %s", spool->path);
+		priv->spool = g_slist_append (priv->spool, spool);
+		spooled += spool->estimated;
+		running ++;
+	}
+}
+
+static gboolean
+brasero_transcode_create_pipeline_spooled (BraseroTranscode *transcode,
+					   BraseroTranscodeSpool *spool,
+					   GError **error)
+{
+	int fd;
+	GstBus *bus;
+	GstPad *sinkpad;
+	GstElement *sink;
+	GstElement *source;
+	GstElement *pipeline;
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+
+	BRASERO_JOB_LOG (transcode, "Piping spooled track %s", spool->path);
+
+	priv->set_active_state = 0;
+
+	/* filesrc ! fdsink: the data is already decoded, trimmed and padded */
+	pipeline = gst_pipeline_new (NULL);
+
+	bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+	gst_bus_add_watch (bus,
+			   (GstBusFunc) brasero_transcode_bus_messages,
+			   transcode);
+	gst_object_unref (bus);
+
+	source = gst_element_factory_make ("filesrc", NULL);
+	if (!source) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Filesrc\"");
+		goto error;
+	}
+	gst_bin_add (GST_BIN (pipeline), source);
+	g_object_set (source,
+		      "location", spool->path,
+		      "blocksize", 32 * 2352,
+		      NULL);
+
+	sink = gst_element_factory_make ("fdsink", NULL);
+	if (!sink) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Fdsink\"");
+		goto error;
+	}
+	gst_bin_add (GST_BIN (pipeline), sink);
+
+	brasero_job_get_fd_out (BRASERO_JOB (transcode), &fd);
+	g_object_set (sink,
+		      "fd", fd,
+		      "sync", FALSE,
+		      NULL);
+
+	if (!gst_element_link (source, sink)) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("Impossible to link plugin pads"));
+		goto error;
+	}
+
+	/* only used to count bytes */
+	priv->segment.pos = 0;
+	priv->segment.size = 0;
+	priv->segment.segment_start = 0;
+	priv->segment.segment_end = spool->segment.pos;
+	sinkpad = gst_element_get_static_pad (sink, "sink");
+	priv->probe = gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+					 brasero_transcode_buffer_handler,
+					 &priv->segment, NULL);
+	gst_object_unref (sinkpad);
+
+	priv->link = NULL;
+	priv->sink = sink;
+	priv->decode = NULL;
+	priv->source = source;
+	priv->convert = NULL;
+	priv->pipeline = pipeline;
+
+	gst_element_set_state (pipeline, GST_STATE_PLAYING);
+	return TRUE;
+
+error:
+
+	if (error && (*error))
+		BRASERO_JOB_LOG (transcode,
+				 "can't create object : %s \n",
+				 (*error)->message);
+
+	gst_object_unref (GST_OBJECT (pipeline));
+	return FALSE;
+}
+
 static gboolean
 brasero_transcode_is_mp3 (BraseroTranscode *transcode)
 {
@@ -1607,10 +2305,12 @@ brasero_transcode_new_decoded_pad_cb (GstElement *decode,
 		if (g_strrstr (gst_structure_get_name (structure), "audio")) {
 			GstPad *sink;
 			GstElement *queue;
+			BraseroTrack *track;
 			GstPadLinkReturn res;
 
 			/* before linking pads (before any data reach grvolume), send tags */
-			brasero_transcode_send_volume_event (transcode);
+			brasero_job_get_current_track (BRASERO_JOB (transcode), &track);
+			brasero_transcode_send_volume_event (transcode, track, priv->convert);
 
 			/* This is necessary in case there is a video stream
 			 * (see brasero-metadata.c). we need to queue to avoid
@@ -1683,7 +2383,7 @@ brasero_transcode_clock_tick (BraseroJob *job)
 	if (!priv->pipeline)
 		return BRASERO_BURN_ERR;
 
-	brasero_job_set_written_track (job, priv->pos);
+	brasero_job_set_written_track (job, priv->segment.pos);
 	return BRASERO_BURN_OK;
 }
 
@@ -1705,7 +2405,24 @@ brasero_transcode_class_init (BraseroTranscodeClass *klass)
 
 static void
 brasero_transcode_init (BraseroTranscode *obj)
-{ }
+{
+	GSettings *settings;
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (obj);
+
+	/* load our "configuration" */
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	if (g_settings_get_boolean (settings, BRASERO_KEY_TRANSCODE_AHEAD)) {
+		glong processors;
+
+		/* One processor is left for the track being piped */
+		processors = sysconf (_SC_NPROCESSORS_ONLN);
+		priv->spool_jobs = MAX (processors - 1, 1);
+		priv->spool_max_size = (gint64) g_settings_get_int (settings, BRASERO_KEY_TRANSCODE_SPOOL_SIZE) * 1048576LL;
+	}
+	g_object_unref (settings);
+}
 
 static void
 brasero_transcode_finalize (GObject *object)
@@ -1721,12 +2438,19 @@ brasero_transcode_finalize (GObject *object)
 
 	brasero_transcode_stop_pipeline (BRASERO_TRANSCODE (object));
 
+	if (priv->spool) {
+		g_slist_foreach (priv->spool, (GFunc) brasero_transcode_spool_free, NULL);
+		g_slist_free (priv->spool);
+		priv->spool = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static void
 brasero_transcode_export_caps (BraseroPlugin *plugin)
 {
+	BraseroPluginConfOption *ahead, *spool_size;
 	GSList *input;
 	GSList *output;
 
@@ -1774,4 +2498,16 @@ brasero_transcode_export_caps (BraseroPlugin *plugin)
 	brasero_plugin_link_caps (plugin, output, input);
 	g_slist_free (output);
 	g_slist_free (input);
+
+	/* add some configure options */
+	ahead = brasero_plugin_conf_option_new (BRASERO_KEY_TRANSCODE_AHEAD,
+						_("Decode upcoming tracks ahead when burning on the fly"),
+						BRASERO_PLUGIN_OPTION_BOOL);
+	spool_size = brasero_plugin_conf_option_new (BRASERO_KEY_TRANSCODE_SPOOL_SIZE,
+						     _("Maximum size of the tracks decoded ahead (in MiB):"),
+						     BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (spool_size, 16, 4096);
+
+	brasero_plugin_conf_option_bool_add_suboption (ahead, spool_size);
+	brasero_plugin_add_conf_option (plugin, ahead);
 }
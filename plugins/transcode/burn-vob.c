@@ -33,12 +33,16 @@
 #endif
 
 #include <string.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
 #include <gmodule.h>
+#include <gio/gio.h>
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 #include "brasero-tags.h"
 #include "burn-job.h"
@@ -54,6 +58,40 @@
 
 BRASERO_PLUGIN_BOILERPLATE (BraseroVob, brasero_vob, BRASERO_TYPE_JOB, BraseroJob);
 
+#define BRASERO_SCHEMA_CONFIG			"org.gnome.brasero.config"
+#define BRASERO_KEY_VOB_PARALLEL		"vob-parallel"
+#define BRASERO_KEY_VOB_SEGMENT_LENGTH		"vob-segment-length"
+
+typedef enum {
+	BRASERO_VOB_SEGMENT_WAITING,
+	BRASERO_VOB_SEGMENT_SEEKING,
+	BRASERO_VOB_SEGMENT_RUNNING
+} BraseroVobSegmentState;
+
+/* A part of the video encoded in its own pipeline. Each part starts with a new
+ * sequence and a closed GOP so the resulting MPEG2 elementary streams can be
+ * concatenated before being multiplexed with the audio. */
+typedef struct _BraseroVobSegment BraseroVobSegment;
+struct _BraseroVobSegment {
+	BraseroVob *vob;
+
+	GstElement *pipeline;
+	GstElement *video;
+	guint bus_watch;
+	guint seek_id;
+
+	gchar *path;
+
+	gint64 start;
+	gint64 end;
+
+	/* Only accessed from the streaming thread */
+	GstSegment segment;
+
+	gint state;
+	guint complete:1;
+};
+
 typedef struct _BraseroVobPrivate BraseroVobPrivate;
 struct _BraseroVobPrivate
 {
@@ -64,10 +102,24 @@ struct _BraseroVobPrivate
 
 	GstElement *source;
 
+	GSList *audio_queues;
+
+	GSList *segments;
+	guint segments_done;
+	gint64 duration;
+
+	GList *audio_decoders;
+	GList *video_decoders;
+
 	BraseroStreamFormat format;
 
+	glong processors;
+	gint64 segment_length;
+	gint encoder_threads;
+
 	guint svcd:1;
 	guint is_video_dvd:1;
+	guint parallel:1;
 };
 
 #define BRASERO_VOB_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_VOB, BraseroVobPrivate))
@@ -80,12 +132,125 @@ static GObjectClass *parent_class = NULL;
 #define MAX_SIZE_BYTES		10485760	/* Use unlimited (0) if it does not work */
 #define MAX_SIZE_TIME		3000000000LL    /* Use unlimited (0) if it does not work */
 
+/* With the performance profile, queues hold 3 seconds of the stream going
+ * through them whatever its bitrate, within a memory limit. The fixed byte
+ * limit above only holds a fraction of a second of raw video. */
+#define QUEUE_SECONDS		3
+#define QUEUE_MAX_BYTES		67108864
+
+/* Rates (in bytes per second) of the streams produced by encoders */
+#define DVD_VIDEO_RATE		(9800000 / 8)
+#define SVCD_VIDEO_RATE		(2600000 / 8)
+#define VCD_VIDEO_RATE		(1150000 / 8)
+#define PCM_AUDIO_RATE		(48000 * 2 * 2)
+
+/* How much of the whole conversion the concurrent encoding of the segments
+ * represents; the rest is the multiplexing with audio. */
+#define SEGMENTS_PROGRESS	0.75
+
+static void brasero_vob_segment_clear (BraseroVob *vob);
+
+static void
+brasero_vob_set_queue_size (BraseroVob *vob,
+			    GstElement *queue,
+			    guint64 rate)
+{
+	BraseroVobPrivate *priv;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+	if (!priv->parallel || !rate) {
+		g_object_set (queue,
+			      "max-size-buffers", MAX_SIZE_BUFFER,
+			      "max-size-bytes", MAX_SIZE_BYTES,
+			      "max-size-time", MAX_SIZE_TIME,
+			      NULL);
+		return;
+	}
+
+	g_object_set (queue,
+		      "max-size-buffers", 0,
+		      "max-size-bytes", (guint) MIN (rate * QUEUE_SECONDS, QUEUE_MAX_BYTES),
+		      "max-size-time", (guint64) QUEUE_SECONDS * GST_SECOND,
+		      NULL);
+}
+
+static guint64
+brasero_vob_get_raw_rate (GstCaps *caps)
+{
+	GstStructure *structure;
+	GstVideoInfo info;
+	gint channels = 0;
+	gint rate = 0;
+
+	if (!caps || !gst_caps_is_fixed (caps))
+		return 0;
+
+	if (gst_video_info_from_caps (&info, caps)) {
+		if (GST_VIDEO_INFO_FPS_D (&info) <= 0
+		||  GST_VIDEO_INFO_FPS_N (&info) <= 0)
+			return 0;
+
+		return (guint64) GST_VIDEO_INFO_SIZE (&info) *
+			GST_VIDEO_INFO_FPS_N (&info) /
+			GST_VIDEO_INFO_FPS_D (&info);
+	}
+
+	structure = gst_caps_get_structure (caps, 0);
+	if (gst_structure_get_int (structure, "rate", &rate)
+	&&  gst_structure_get_int (structure, "channels", &channels))
+		/* Samples are at most 32 bits wide */
+		return (guint64) rate * channels * 4;
+
+	return 0;
+}
+
+static guint64
+brasero_vob_get_video_rate (BraseroVob *vob)
+{
+	BraseroVobPrivate *priv;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+	if (priv->is_video_dvd)
+		return DVD_VIDEO_RATE;
+
+	if (priv->svcd)
+		return SVCD_VIDEO_RATE;
+
+	return VCD_VIDEO_RATE;
+}
+
+static void
+brasero_vob_set_encoder_threads (BraseroVob *vob,
+				 GstElement *encode)
+{
+	BraseroVobPrivate *priv;
+	GParamSpecInt *spec;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+	if (priv->encoder_threads < 2)
+		return;
+
+	/* Not all versions of mpeg2enc have this property */
+	spec = (GParamSpecInt *) g_object_class_find_property (G_OBJECT_GET_CLASS (encode), "threads");
+	if (!spec || !G_IS_PARAM_SPEC_INT (spec))
+		return;
+
+	BRASERO_JOB_LOG (vob, "Encoding with %i threads", priv->encoder_threads);
+	g_object_set (encode,
+		      "threads", CLAMP (priv->encoder_threads, spec->minimum, spec->maximum),
+		      NULL);
+}
+
 static void
 brasero_vob_stop_pipeline (BraseroVob *vob)
 {
 	BraseroVobPrivate *priv;
 
 	priv = BRASERO_VOB_PRIVATE (vob);
+
+	g_slist_free (priv->audio_queues);
+	priv->audio_queues = NULL;
+
 	if (!priv->pipeline)
 		return;
 
@@ -101,6 +266,7 @@ brasero_vob_stop (BraseroJob *job,
 		  GError **error)
 {
 	brasero_vob_stop_pipeline (BRASERO_VOB (job));
+	brasero_vob_segment_clear (BRASERO_VOB (job));
 	return BRASERO_BURN_OK;
 }
 
@@ -167,16 +333,14 @@ brasero_vob_bus_messages (GstBus *bus,
 
 static void
 brasero_vob_error_on_pad_linking (BraseroVob *self,
+                                  GstElement *pipeline,
                                   const gchar *function_name)
 {
-	BraseroVobPrivate *priv;
 	GstMessage *message;
 	GstBus *bus;
 
-	priv = BRASERO_VOB_PRIVATE (self);
-
 	BRASERO_JOB_LOG (self, "Error on pad linking");
-	message = gst_message_new_error (GST_OBJECT (priv->pipeline),
+	message = gst_message_new_error (GST_OBJECT (pipeline),
 					 g_error_new (BRASERO_BURN_ERROR,
 						      BRASERO_BURN_ERROR_GENERAL,
 						      /* Translators: This message is sent
@@ -189,7 +353,7 @@ brasero_vob_error_on_pad_linking (BraseroVob *self,
 						      _("Impossible to link plugin pads")),
 					 function_name);
 
-	bus = gst_pipeline_get_bus (GST_PIPELINE (priv->pipeline));
+	bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
 	gst_bus_post (bus, message);
 	g_object_unref (bus);
 }
@@ -213,28 +377,51 @@ brasero_vob_new_decoded_pad_cb (GstElement *decode,
 
 	structure = gst_caps_get_structure (caps, 0);
 	if (structure) {
-		if (g_strrstr (gst_structure_get_name (structure), "video")) {
+		guint64 rate = 0;
+
+		if (priv->parallel) {
+			GstCaps *current;
+
+			current = gst_pad_get_current_caps (pad);
+			if (current) {
+				rate = brasero_vob_get_raw_rate (current);
+				gst_caps_unref (current);
+			}
+		}
+
+		/* When video was encoded by segments, it is not decoded
+		 * again (see brasero_vob_autoplug_continue_cb) and there
+		 * is no video bin to link the pad to. */
+		if (g_strrstr (gst_structure_get_name (structure), "video")
+		&&  priv->video) {
 			GstPadLinkReturn res;
 
+			if (rate)
+				brasero_vob_set_queue_size (vob, priv->video, rate);
+
 			sink = gst_element_get_static_pad (priv->video, "sink");
 			res = gst_pad_link (pad, sink);
 			gst_object_unref (sink);
 
 			if (res != GST_PAD_LINK_OK)
-				brasero_vob_error_on_pad_linking (vob, "Sent by brasero_vob_new_decoded_pad_cb");
+				brasero_vob_error_on_pad_linking (vob, priv->pipeline, "Sent by brasero_vob_new_decoded_pad_cb");
 
 			gst_element_set_state (priv->video, GST_STATE_PLAYING);
 		}
 
 		if (g_strrstr (gst_structure_get_name (structure), "audio")) {
 			GstPadLinkReturn res;
+			GSList *iter;
+
+			for (iter = priv->audio_queues; iter && rate; iter = iter->next)
+				brasero_vob_set_queue_size (vob, iter->data, rate);
 
 			sink = gst_element_get_static_pad (priv->audio, "sink");
 			res = gst_pad_link (pad, sink);
 			gst_object_unref (sink);
 
 			if (res != GST_PAD_LINK_OK)
-				brasero_vob_error_on_pad_linking (vob, "Sent by brasero_vob_new_decoded_pad_cb");
+				brasero_vob_error_on_pad_linking (vob, priv->pipeline, "Sent by brasero_vob_new_decoded_pad_cb");
 
 			gst_element_set_state (priv->audio, GST_STATE_PLAYING);
 		}
@@ -243,6 +430,27 @@ brasero_vob_new_decoded_pad_cb (GstElement *decode,
 	gst_caps_unref (caps);
 }
 
+static gboolean
+brasero_vob_autoplug_continue_cb (GstElement *decode,
+				  GstPad *pad,
+				  GstCaps *caps,
+				  GList *skipped)
+{
+	GList *factories;
+
+	/* Stop before decoding the streams that won't be used. They are then
+	 * exposed as they are and left unlinked. */
+	factories = gst_element_factory_list_filter (skipped,
+						     caps,
+						     GST_PAD_SINK,
+						     FALSE);
+	if (!factories)
+		return TRUE;
+
+	gst_plugin_feature_list_free (factories);
+	return FALSE;
+}
+
 static gboolean
 brasero_vob_link_audio (BraseroVob *vob,
 			GstElement *start,
@@ -253,6 +461,7 @@ brasero_vob_link_audio (BraseroVob *vob,
 	GstPad *srcpad;
 	GstPad *sinkpad;
 	GstPadLinkReturn res;
+	BraseroVobPrivate *priv;
 
 	srcpad = gst_element_get_request_pad (tee, "src_%u");
 	sinkpad = gst_element_get_static_pad (start, "sink");
@@ -264,6 +473,10 @@ brasero_vob_link_audio (BraseroVob *vob,
 	if (res != GST_PAD_LINK_OK)
 		return FALSE;
 
+	/* Sized again once we know the rate of decoded audio */
+	priv = BRASERO_VOB_PRIVATE (vob);
+	priv->audio_queues = g_slist_prepend (priv->audio_queues, start);
+
 	sinkpad = gst_element_get_request_pad (muxer, "audio_%u");
 	srcpad = gst_element_get_static_pad (end, "src");
 	res = gst_pad_link (srcpad, sinkpad);
@@ -310,11 +523,7 @@ brasero_vob_build_audio_pcm (BraseroVob *vob,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (priv->pipeline), queue);
-	g_object_set (queue,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
+	brasero_vob_set_queue_size (vob, queue, PCM_AUDIO_RATE);
 
 	/* audioresample */
 	resample = gst_element_factory_make ("audioresample", NULL);
@@ -357,11 +566,7 @@ brasero_vob_build_audio_pcm (BraseroVob *vob,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (priv->pipeline), queue1);
-	g_object_set (queue1,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
+	brasero_vob_set_queue_size (vob, queue1, PCM_AUDIO_RATE);
 
 	/* create a filter */
 	filter = gst_element_factory_make ("capsfilter", NULL);
@@ -416,6 +621,7 @@ brasero_vob_build_audio_mp2 (BraseroVob *vob,
 	GstCaps *filtercaps;
 	GstElement *resample;
 	BraseroVobPrivate *priv;
+	gint bitrate = 0;
 
 	priv = BRASERO_VOB_PRIVATE (vob);
 
@@ -430,11 +636,7 @@ brasero_vob_build_audio_mp2 (BraseroVob *vob,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (priv->pipeline), queue);
-	g_object_set (queue,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
+	brasero_vob_set_queue_size (vob, queue, PCM_AUDIO_RATE);
 
 	/* audioconvert */
 	convert = gst_element_factory_make ("audioconvert", NULL);
@@ -483,12 +685,7 @@ brasero_vob_build_audio_mp2 (BraseroVob *vob,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (priv->pipeline), queue1);
-	g_object_set (queue1,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
-	
+
 	/* create a filter */
 	filter = gst_element_factory_make ("capsfilter", NULL);
 	if (filter == NULL) {
@@ -503,6 +700,7 @@ brasero_vob_build_audio_mp2 (BraseroVob *vob,
 
 	if (priv->is_video_dvd) {
 		BRASERO_JOB_LOG (vob, "Setting mp2 bitrate to 448000, 48000 khz");
+		bitrate = 448000;
 		g_object_set (encode,
 			      "bitrate", 448000, /* it could go up to 912k */
 			      NULL);
@@ -513,6 +711,7 @@ brasero_vob_build_audio_mp2 (BraseroVob *vob,
 	else if (!priv->svcd) {
 		/* VCD */
 		BRASERO_JOB_LOG (vob, "Setting mp2 bitrate to 224000, 44100 khz");
+		bitrate = 224000;
 		g_object_set (encode,
 			      "bitrate", 224000,
 			      NULL);
@@ -526,6 +725,7 @@ brasero_vob_build_audio_mp2 (BraseroVob *vob,
 	else {
 		/* SVCDs */
 		BRASERO_JOB_LOG (vob, "Setting mp2 bitrate to 384000, 44100 khz");
+		bitrate = 384000;
 		g_object_set (encode,
 			      "bitrate", 384000,
 			      NULL);
@@ -537,6 +737,8 @@ brasero_vob_build_audio_mp2 (BraseroVob *vob,
 	g_object_set (GST_OBJECT (filter), "caps", filtercaps, NULL);
 	gst_caps_unref (filtercaps);
 
+	brasero_vob_set_queue_size (vob, queue1, bitrate / 8);
+
 	if (!gst_element_link_many (queue, convert, resample, filter, encode, queue1, NULL)) {
 		BRASERO_JOB_LOG (vob, "Error while linking pads");
 		g_set_error (error,
@@ -584,11 +786,7 @@ brasero_vob_build_audio_ac3 (BraseroVob *vob,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (priv->pipeline), queue);;
-	g_object_set (queue,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
+	brasero_vob_set_queue_size (vob, queue, PCM_AUDIO_RATE);
 
 	/* audioconvert */
 	convert = gst_element_factory_make ("audioconvert", NULL);
@@ -661,11 +859,7 @@ brasero_vob_build_audio_ac3 (BraseroVob *vob,
 		goto error;
 	}
 	gst_bin_add (GST_BIN (priv->pipeline), queue1);
-	g_object_set (queue1,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
+	brasero_vob_set_queue_size (vob, queue1, 448000 / 8);
 
 	if (!gst_element_link_many (queue, convert, resample, filter, encode, queue1, NULL)) {
 		BRASERO_JOB_LOG (vob, "Error while linking pads");
@@ -755,7 +949,8 @@ error:
 
 static GstElement *
 brasero_vob_build_video_bin (BraseroVob *vob,
-			     GstElement *muxer,
+			     GstElement *pipeline,
+			     GstElement *sink,
 			     GError **error)
 {
 	GValue *value;
@@ -783,12 +978,9 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 			     "\"Queue\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), queue);
-	g_object_set (queue,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
+	gst_bin_add (GST_BIN (pipeline), queue);
+	/* Sized again once we know the rate of decoded video */
+	brasero_vob_set_queue_size (vob, queue, 0);
 
 	/* framerate and video type control */
 	framerate = gst_element_factory_make ("videorate", NULL);
@@ -800,7 +992,7 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 			     "\"Framerate\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), framerate);
+	gst_bin_add (GST_BIN (pipeline), framerate);
 	g_object_set (framerate,
 		      "silent", TRUE,
 		      NULL);
@@ -815,7 +1007,7 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 			     "\"Videoscale\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), scale);
+	gst_bin_add (GST_BIN (pipeline), scale);
 
 	/* create a filter */
 	filter = gst_element_factory_make ("capsfilter", NULL);
@@ -827,7 +1019,7 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 			     "\"Filter\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), filter);
+	gst_bin_add (GST_BIN (pipeline), filter);
 
 	colorspace = gst_element_factory_make ("videoconvert", NULL);
 	if (colorspace == NULL) {
@@ -838,7 +1030,7 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 			     "\"videoconvert\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), colorspace);
+	gst_bin_add (GST_BIN (pipeline), colorspace);
 
 	encode = gst_element_factory_make ("mpeg2enc", NULL);
 	if (encode == NULL) {
@@ -849,7 +1041,9 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 			     "\"Mpeg2enc\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), encode);
+	gst_bin_add (GST_BIN (pipeline), encode);
+
+	brasero_vob_set_encoder_threads (vob, encode);
 
 	if (priv->is_video_dvd)
 		g_object_set (encode,
@@ -1024,12 +1218,8 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 			     "\"Queue1\"");
 		goto error;
 	}
-	gst_bin_add (GST_BIN (priv->pipeline), queue1);
-	g_object_set (queue1,
-		      "max-size-buffers", MAX_SIZE_BUFFER,
-		      "max-size-bytes", MAX_SIZE_BYTES,
-		      "max-size-time", MAX_SIZE_TIME,
-		      NULL);
+	gst_bin_add (GST_BIN (pipeline), queue1);
+	brasero_vob_set_queue_size (vob, queue1, brasero_vob_get_video_rate (vob));
 
 	if (!gst_element_link_many (queue, framerate, scale, colorspace, filter, encode, queue1, NULL)) {
 		BRASERO_JOB_LOG (vob, "Error while linking pads");
@@ -1040,10 +1230,13 @@ brasero_vob_build_video_bin (BraseroVob *vob,
 		goto error;
 	}
 
+	/* Either the muxer or a filesink when encoding a segment */
 	srcpad = gst_element_get_static_pad (queue1, "src");
-	sinkpad = gst_element_get_request_pad (muxer, "video_%u");
+	sinkpad = gst_element_get_static_pad (sink, "sink");
+	if (!sinkpad)
+		sinkpad = gst_element_get_request_pad (sink, "video_%u");
 	res = gst_pad_link (srcpad, sinkpad);
-	BRASERO_JOB_LOG (vob, "Linked video bin to muxer == %d", res)
+	BRASERO_JOB_LOG (vob, "Linked video bin to sink == %d", res)
 	gst_object_unref (sinkpad);
 	gst_object_unref (srcpad);
 
@@ -1054,47 +1247,36 @@ error:
 	return NULL;
 }
 
-static gboolean
-brasero_vob_build_pipeline (BraseroVob *vob,
-			    GError **error)
+static GstElement *
+brasero_vob_build_decoder (BraseroVob *vob,
+			   GstElement *pipeline,
+			   GstElement **source_ret,
+			   GError **error)
 {
 	gchar *uri;
-	GstBus *bus;
-	gchar *output;
-	GstElement *sink;
-	GstElement *muxer;
 	GstElement *source;
 	GstElement *decode;
 	BraseroTrack *track;
-	GstElement *pipeline;
-	BraseroVobPrivate *priv;
-
-	priv = BRASERO_VOB_PRIVATE (vob);
-
-	BRASERO_JOB_LOG (vob, "Creating new pipeline");
-
-	pipeline = gst_pipeline_new (NULL);
-	priv->pipeline = pipeline;
 
 	/* source */
 	brasero_job_get_current_track (BRASERO_JOB (vob), &track);
 	uri = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), TRUE);
 	source = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, NULL);
+	g_free (uri);
+
 	if (!source) {
 		g_set_error (error,
 			     BRASERO_BURN_ERROR,
 			     BRASERO_BURN_ERROR_GENERAL,
 			     _("%s element could not be created"),
 			     "\"Source\"");
-		goto error;
+		return NULL;
 	}
 	gst_bin_add (GST_BIN (pipeline), source);
 	g_object_set (source,
 		      "typefind", FALSE,
 		      NULL);
 
-	priv->source = source;
-
 	/* decode */
 	decode = gst_element_factory_make ("decodebin", NULL);
 	if (!decode) {
@@ -1103,7 +1285,7 @@ brasero_vob_build_pipeline (BraseroVob *vob,
 			     BRASERO_BURN_ERROR_GENERAL,
 			     _("%s element could not be created"),
 			     "\"Decodebin\"");
-		goto error;
+		return NULL;
 	}
 	gst_bin_add (GST_BIN (pipeline), decode);
 
@@ -1113,9 +1295,149 @@ brasero_vob_build_pipeline (BraseroVob *vob,
 			     BRASERO_BURN_ERROR,
 			     BRASERO_BURN_ERROR_GENERAL,
 		             _("Impossible to link plugin pads"));
-		goto error;
+		return NULL;
 	}
 
+	if (source_ret)
+		*source_ret = source;
+
+	return decode;
+}
+
+static gboolean
+brasero_vob_build_segments_bin (BraseroVob *vob,
+				GstElement *muxer,
+				GError **error)
+{
+	GSList *iter;
+	GstPad *srcpad;
+	GstPad *sinkpad;
+	GstElement *queue;
+	GstElement *parse;
+	GstElement *concat;
+	GstPadLinkReturn res;
+	BraseroVobPrivate *priv;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	/* The elementary streams of all segments are read one after the
+	 * other and parsed again as a single stream for the muxer. */
+	concat = gst_element_factory_make ("concat", NULL);
+	if (concat == NULL) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Concat\"");
+		return FALSE;
+	}
+	gst_bin_add (GST_BIN (priv->pipeline), concat);
+
+	for (iter = priv->segments; iter; iter = iter->next) {
+		BraseroVobSegment *segment;
+		GstElement *source;
+
+		segment = iter->data;
+
+		source = gst_element_factory_make ("filesrc", NULL);
+		if (source == NULL) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("%s element could not be created"),
+				     "\"Filesrc\"");
+			return FALSE;
+		}
+		gst_bin_add (GST_BIN (priv->pipeline), source);
+		g_object_set (source,
+			      "location", segment->path,
+			      NULL);
+
+		/* concat pads are requested in the order of the segments */
+		if (!gst_element_link (source, concat)) {
+			BRASERO_JOB_LOG (vob, "Error while linking pads");
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Impossible to link plugin pads"));
+			return FALSE;
+		}
+	}
+
+	parse = gst_element_factory_make ("mpegvideoparse", NULL);
+	if (parse == NULL) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Mpegvideoparse\"");
+		return FALSE;
+	}
+	gst_bin_add (GST_BIN (priv->pipeline), parse);
+
+	queue = gst_element_factory_make ("queue", NULL);
+	if (queue == NULL) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Queue\"");
+		return FALSE;
+	}
+	gst_bin_add (GST_BIN (priv->pipeline), queue);
+	brasero_vob_set_queue_size (vob, queue, brasero_vob_get_video_rate (vob));
+
+	if (!gst_element_link_many (concat, parse, queue, NULL)) {
+		BRASERO_JOB_LOG (vob, "Error while linking pads");
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+		             _("Impossible to link plugin pads"));
+		return FALSE;
+	}
+
+	srcpad = gst_element_get_static_pad (queue, "src");
+	sinkpad = gst_element_get_request_pad (muxer, "video_%u");
+	res = gst_pad_link (srcpad, sinkpad);
+	BRASERO_JOB_LOG (vob, "Linked segments to muxer == %d", res);
+	gst_object_unref (sinkpad);
+	gst_object_unref (srcpad);
+
+	if (res != GST_PAD_LINK_OK) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+		             _("Impossible to link plugin pads"));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_vob_build_pipeline (BraseroVob *vob,
+			    GError **error)
+{
+	GstBus *bus;
+	gchar *output;
+	GstElement *sink;
+	GstElement *muxer;
+	GstElement *decode;
+	GstElement *pipeline;
+	BraseroVobPrivate *priv;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	BRASERO_JOB_LOG (vob, "Creating new pipeline");
+
+	pipeline = gst_pipeline_new (NULL);
+	priv->pipeline = pipeline;
+	priv->video = NULL;
+
+	decode = brasero_vob_build_decoder (vob, pipeline, &priv->source, error);
+	if (!decode)
+		goto error;
+
 	/* muxer: "mplex" */
 	muxer = gst_element_factory_make ("mplex", NULL);
 	if (muxer == NULL) {
@@ -1168,9 +1490,21 @@ brasero_vob_build_pipeline (BraseroVob *vob,
 	}
 
 	/* video encoding */
-	priv->video = brasero_vob_build_video_bin (vob, muxer, error);
-	if (!priv->video)
-		goto error;
+	if (priv->segments) {
+		/* Video was already encoded; only audio is decoded */
+		if (!brasero_vob_build_segments_bin (vob, muxer, error))
+			goto error;
+
+		g_signal_connect (G_OBJECT (decode),
+				  "autoplug-continue",
+				  G_CALLBACK (brasero_vob_autoplug_continue_cb),
+				  priv->video_decoders);
+	}
+	else {
+		priv->video = brasero_vob_build_video_bin (vob, pipeline, muxer, error);
+		if (!priv->video)
+			goto error;
+	}
 
 	/* audio encoding */
 	priv->audio = brasero_vob_build_audio_bins (vob, muxer, error);
@@ -1201,15 +1535,415 @@ error:
 
 	gst_object_unref (GST_OBJECT (pipeline));
 	priv->pipeline = NULL;
+	priv->source = NULL;
+	return FALSE;
+}
+
+static void
+brasero_vob_segments_finished (BraseroVob *vob)
+{
+	BraseroVobPrivate *priv;
+	GError *error = NULL;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	BRASERO_JOB_LOG (vob, "All segments were encoded");
+	if (!brasero_vob_build_pipeline (vob, &error)) {
+		brasero_job_error (BRASERO_JOB (vob), error);
+		return;
+	}
+
+	gst_element_set_state (priv->pipeline, GST_STATE_PLAYING);
+}
+
+static gboolean
+brasero_vob_segment_bus_messages (GstBus *bus,
+				  GstMessage *msg,
+				  BraseroVobSegment *segment)
+{
+	BraseroVobPrivate *priv;
+	GError *error = NULL;
+	BraseroVob *vob;
+	gchar *debug;
+
+	vob = segment->vob;
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	switch (GST_MESSAGE_TYPE (msg)) {
+	case GST_MESSAGE_ERROR:
+		gst_message_parse_error (msg, &error, &debug);
+		BRASERO_JOB_LOG (vob, debug);
+		g_free (debug);
+
+		/* The segment is destroyed when the job stops */
+		segment->bus_watch = 0;
+	        brasero_job_error (BRASERO_JOB (vob), error);
+		return FALSE;
+
+	case GST_MESSAGE_EOS:
+		BRASERO_JOB_LOG (vob,
+				 "Segment %" G_GINT64_FORMAT " - %" G_GINT64_FORMAT " encoded",
+				 segment->start,
+				 segment->end);
+
+		segment->bus_watch = 0;
+		segment->complete = TRUE;
+		gst_element_set_state (segment->pipeline, GST_STATE_NULL);
+
+		priv->segments_done ++;
+		if (priv->segments_done == g_slist_length (priv->segments))
+			brasero_vob_segments_finished (vob);
+
+		return FALSE;
+
+	default:
+		return TRUE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_vob_segment_seek (gpointer data)
+{
+	BraseroVobSegment *segment = data;
+
+	segment->seek_id = 0;
+
+	BRASERO_JOB_LOG (segment->vob,
+			 "Seeking segment %" G_GINT64_FORMAT " - %" G_GINT64_FORMAT,
+			 segment->start,
+			 segment->end);
+
+	/* The last segment goes up to the end of the stream */
+	if (!gst_element_seek (segment->pipeline,
+			       1.0,
+			       GST_FORMAT_TIME,
+			       GST_SEEK_FLAG_FLUSH|GST_SEEK_FLAG_ACCURATE,
+			       GST_SEEK_TYPE_SET,
+			       segment->start,
+			       segment->end > 0 ? GST_SEEK_TYPE_SET:GST_SEEK_TYPE_NONE,
+			       segment->end > 0 ? segment->end:GST_CLOCK_TIME_NONE)) {
+		/* Frames outside the segment are dropped by the probe */
+		BRASERO_JOB_LOG (segment->vob, "Seeking failed, decoding segment from start");
+		g_atomic_int_set (&segment->state, BRASERO_VOB_SEGMENT_RUNNING);
+	}
+
 	return FALSE;
 }
 
+static GstPadProbeReturn
+brasero_vob_segment_probe_cb (GstPad *pad,
+			      GstPadProbeInfo *info,
+			      BraseroVobSegment *segment)
+{
+	GstClockTime timestamp;
+	GstBuffer *buffer;
+	GstEvent *event;
+
+	if (info->type & (GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM|GST_PAD_PROBE_TYPE_EVENT_FLUSH)) {
+		event = GST_PAD_PROBE_INFO_EVENT (info);
+		if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT)
+			gst_event_copy_segment (event, &segment->segment);
+		else if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+			g_atomic_int_compare_and_exchange (&segment->state,
+							   BRASERO_VOB_SEGMENT_SEEKING,
+							   BRASERO_VOB_SEGMENT_RUNNING);
+		return GST_PAD_PROBE_OK;
+	}
+
+	/* No frame reaches the encoder before the pipeline was moved to the
+	 * start of the segment. The seek is done from the main loop. */
+	if (g_atomic_int_compare_and_exchange (&segment->state,
+					       BRASERO_VOB_SEGMENT_WAITING,
+					       BRASERO_VOB_SEGMENT_SEEKING)) {
+		segment->seek_id = g_idle_add (brasero_vob_segment_seek, segment);
+		return GST_PAD_PROBE_DROP;
+	}
+
+	if (g_atomic_int_get (&segment->state) != BRASERO_VOB_SEGMENT_RUNNING)
+		return GST_PAD_PROBE_DROP;
+
+	/* In case the demuxer could not seek accurately */
+	buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+	if (!GST_BUFFER_PTS_IS_VALID (buffer))
+		return GST_PAD_PROBE_OK;
+
+	timestamp = gst_segment_to_stream_time (&segment->segment,
+						GST_FORMAT_TIME,
+						GST_BUFFER_PTS (buffer));
+	if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+		return GST_PAD_PROBE_OK;
+
+	if ((gint64) timestamp < segment->start)
+		return GST_PAD_PROBE_DROP;
+
+	if (segment->end > 0 && (gint64) timestamp >= segment->end)
+		return GST_PAD_PROBE_DROP;
+
+	return GST_PAD_PROBE_OK;
+}
+
+static void
+brasero_vob_segment_new_decoded_pad_cb (GstElement *decode,
+					GstPad *pad,
+					BraseroVobSegment *segment)
+{
+	GstPad *sink;
+	GstCaps *caps;
+	GstPadLinkReturn res;
+	GstStructure *structure;
+
+	/* Audio is not decoded (see brasero_vob_autoplug_continue_cb) and is
+	 * left unlinked: it is encoded while multiplexing. */
+	caps = gst_pad_get_current_caps (pad);
+	if (!caps)
+		caps = gst_pad_query_caps (pad, NULL);
+	if (!caps)
+		return;
+
+	structure = gst_caps_get_structure (caps, 0);
+	if (!structure
+	||  !g_strrstr (gst_structure_get_name (structure), "video")) {
+		gst_caps_unref (caps);
+		return;
+	}
+
+	brasero_vob_set_queue_size (segment->vob,
+				    segment->video,
+				    brasero_vob_get_raw_rate (caps));
+	gst_caps_unref (caps);
+
+	sink = gst_element_get_static_pad (segment->video, "sink");
+	res = gst_pad_link (pad, sink);
+	gst_object_unref (sink);
+
+	if (res != GST_PAD_LINK_OK)
+		brasero_vob_error_on_pad_linking (segment->vob,
+						  segment->pipeline,
+						  "Sent by brasero_vob_segment_new_decoded_pad_cb");
+}
+
+static void
+brasero_vob_segment_free (BraseroVobSegment *segment)
+{
+	if (segment->pipeline) {
+		gst_element_set_state (segment->pipeline, GST_STATE_NULL);
+		gst_object_unref (segment->pipeline);
+	}
+
+	/* Streaming threads are stopped now */
+	if (segment->seek_id)
+		g_source_remove (segment->seek_id);
+
+	if (segment->bus_watch)
+		g_source_remove (segment->bus_watch);
+
+	if (segment->path) {
+		g_remove (segment->path);
+		g_free (segment->path);
+	}
+
+	g_free (segment);
+}
+
+static void
+brasero_vob_segment_clear (BraseroVob *vob)
+{
+	BraseroVobPrivate *priv;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	g_slist_foreach (priv->segments, (GFunc) brasero_vob_segment_free, NULL);
+	g_slist_free (priv->segments);
+	priv->segments = NULL;
+	priv->segments_done = 0;
+}
+
+static BraseroVobSegment *
+brasero_vob_segment_new (BraseroVob *vob,
+			 gint64 start,
+			 gint64 end,
+			 GError **error)
+{
+	GstBus *bus;
+	GstPad *pad;
+	GstElement *sink;
+	GstElement *decode;
+	BraseroVobPrivate *priv;
+	BraseroVobSegment *segment;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	segment = g_new0 (BraseroVobSegment, 1);
+	segment->vob = vob;
+	segment->start = start;
+	segment->end = end;
+	segment->state = BRASERO_VOB_SEGMENT_WAITING;
+	gst_segment_init (&segment->segment, GST_FORMAT_TIME);
+
+	if (brasero_job_get_tmp_file (BRASERO_JOB (vob),
+				      ".m2v",
+				      &segment->path,
+				      error) != BRASERO_BURN_OK)
+		goto error;
+
+	segment->pipeline = gst_pipeline_new (NULL);
+
+	decode = brasero_vob_build_decoder (vob, segment->pipeline, NULL, error);
+	if (!decode)
+		goto error;
+
+	sink = gst_element_factory_make ("filesink", NULL);
+	if (sink == NULL) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("%s element could not be created"),
+			     "\"Sink\"");
+		goto error;
+	}
+	g_object_set (sink,
+		      "location", segment->path,
+		      NULL);
+	gst_bin_add (GST_BIN (segment->pipeline), sink);
+
+	/* Each segment has its own encoder so it starts with a new sequence
+	 * header and a closed GOP. */
+	segment->video = brasero_vob_build_video_bin (vob, segment->pipeline, sink, error);
+	if (!segment->video)
+		goto error;
+
+	pad = gst_element_get_static_pad (segment->video, "sink");
+	gst_pad_add_probe (pad,
+			   GST_PAD_PROBE_TYPE_BUFFER|
+			   GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM|
+			   GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+			   (GstPadProbeCallback) brasero_vob_segment_probe_cb,
+			   segment,
+			   NULL);
+	gst_object_unref (pad);
+
+	g_signal_connect (G_OBJECT (decode),
+			  "autoplug-continue",
+			  G_CALLBACK (brasero_vob_autoplug_continue_cb),
+			  priv->audio_decoders);
+	g_signal_connect (G_OBJECT (decode),
+			  "pad-added",
+			  G_CALLBACK (brasero_vob_segment_new_decoded_pad_cb),
+			  segment);
+
+	bus = gst_pipeline_get_bus (GST_PIPELINE (segment->pipeline));
+	segment->bus_watch = gst_bus_add_watch (bus,
+						(GstBusFunc) brasero_vob_segment_bus_messages,
+						segment);
+	gst_object_unref (bus);
+
+	return segment;
+
+error:
+
+	if (error && (*error))
+		BRASERO_JOB_LOG (vob,
+				 "can't create segment : %s \n",
+				 (*error)->message);
+
+	brasero_vob_segment_free (segment);
+	return NULL;
+}
+
+static gboolean
+brasero_vob_has_element (const gchar *name)
+{
+	GstElementFactory *factory;
+
+	factory = gst_element_factory_find (name);
+	if (!factory)
+		return FALSE;
+
+	gst_object_unref (factory);
+	return TRUE;
+}
+
+static BraseroBurnResult
+brasero_vob_start_segments (BraseroVob *vob,
+			    GError **error)
+{
+	BraseroVobPrivate *priv;
+	BraseroTrack *track;
+	GSList *iter;
+	gint64 end;
+	guint num;
+	guint i;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	if (!priv->parallel || priv->processors < 2 || priv->segment_length <= 0)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	/* Only long videos are split so that each segment is worth a new
+	 * encoder and a new GOP. */
+	brasero_job_get_current_track (BRASERO_JOB (vob), &track);
+	end = brasero_track_stream_get_end (BRASERO_TRACK_STREAM (track));
+	if (end <= 0)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	num = MIN (priv->processors, end / priv->segment_length);
+	if (num < 2)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	if (!brasero_vob_has_element ("concat")
+	||  !brasero_vob_has_element ("mpegvideoparse")) {
+		BRASERO_JOB_LOG (vob, "Missing elements to encode video by segments");
+		return BRASERO_BURN_NOT_SUPPORTED;
+	}
+
+	if (!priv->audio_decoders)
+		priv->audio_decoders = gst_element_factory_list_get_elements (GST_ELEMENT_FACTORY_TYPE_DECODER|
+									      GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO,
+									      GST_RANK_MARGINAL);
+	if (!priv->video_decoders)
+		priv->video_decoders = gst_element_factory_list_get_elements (GST_ELEMENT_FACTORY_TYPE_DECODER|
+									      GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+									      GST_RANK_MARGINAL);
+
+	/* Encoders share the processors */
+	priv->encoder_threads = priv->processors / num;
+
+	BRASERO_JOB_LOG (vob, "Encoding video in %i segments", num);
+	for (i = 0; i < num; i ++) {
+		BraseroVobSegment *segment;
+
+		segment = brasero_vob_segment_new (vob,
+						   end * i / num,
+						   i < num - 1 ? end * (i + 1) / num:-1,
+						   error);
+		if (!segment) {
+			brasero_vob_segment_clear (vob);
+			return BRASERO_BURN_ERR;
+		}
+
+		priv->segments = g_slist_append (priv->segments, segment);
+	}
+
+	priv->duration = end;
+	for (iter = priv->segments; iter; iter = iter->next) {
+		BraseroVobSegment *segment;
+
+		segment = iter->data;
+		gst_element_set_state (segment->pipeline, GST_STATE_PLAYING);
+	}
+
+	return BRASERO_BURN_OK;
+}
+
 static BraseroBurnResult
 brasero_vob_start (BraseroJob *job,
 		   GError **error)
 {
 	BraseroVobPrivate *priv;
 	BraseroJobAction action;
+	BraseroBurnResult result;
 	BraseroTrackType *output = NULL;
 
 	brasero_job_get_action (job, &action);
@@ -1242,9 +1976,17 @@ brasero_vob_start (BraseroJob *job,
 
 	brasero_track_type_free (output);
 
-	if (!brasero_vob_build_pipeline (BRASERO_VOB (job), error))
+	result = brasero_vob_start_segments (BRASERO_VOB (job), error);
+	if (result == BRASERO_BURN_ERR)
 		return BRASERO_BURN_ERR;
 
+	if (result != BRASERO_BURN_OK) {
+		/* A single encoder uses all processors */
+		priv->encoder_threads = priv->parallel ? priv->processors:0;
+		if (!brasero_vob_build_pipeline (BRASERO_VOB (job), error))
+			return BRASERO_BURN_ERR;
+	}
+
 	/* ready to go */
 	brasero_job_set_current_action (job,
 					BRASERO_BURN_ACTION_ANALYSING,
@@ -1252,14 +1994,15 @@ brasero_vob_start (BraseroJob *job,
 					FALSE);
 	brasero_job_start_progress (job, FALSE);
 
-	gst_element_set_state (priv->pipeline, GST_STATE_PLAYING);
+	if (priv->pipeline)
+		gst_element_set_state (priv->pipeline, GST_STATE_PLAYING);
 
 	return BRASERO_BURN_OK;
 }
 
-static gdouble
-brasero_vob_get_progress_from_element (BraseroJob *job,
-				       GstElement *element)
+static gboolean
+brasero_vob_get_progress_from_element (GstElement *element,
+				       gdouble *progress)
 {
 	gint64 position = 0;
 	gint64 duration = 0;
@@ -1276,31 +2019,77 @@ brasero_vob_get_progress_from_element (BraseroJob *job,
 	}
 
 	if (duration > 0 && position >= 0) {
-		gdouble progress;
-
-		progress = (gdouble) position / (gdouble) duration;
-		brasero_job_set_progress (job, progress);
+		*progress = (gdouble) position / (gdouble) duration;
 		return TRUE;
 	}
 
 	return FALSE;
 }
 
+static gdouble
+brasero_vob_get_segments_progress (BraseroVob *vob)
+{
+	BraseroVobPrivate *priv;
+	gint64 encoded = 0;
+	GSList *iter;
+
+	priv = BRASERO_VOB_PRIVATE (vob);
+
+	for (iter = priv->segments; iter; iter = iter->next) {
+		BraseroVobSegment *segment;
+		gint64 position = 0;
+		gint64 end;
+
+		segment = iter->data;
+		end = segment->end > 0 ? segment->end:priv->duration;
+
+		if (segment->complete)
+			position = end;
+		else if (!gst_element_query_position (segment->pipeline, GST_FORMAT_TIME, &position))
+			continue;
+
+		encoded += CLAMP (position, segment->start, end) - segment->start;
+	}
+
+	return (gdouble) encoded / (gdouble) priv->duration;
+}
+
 static BraseroBurnResult
 brasero_vob_clock_tick (BraseroJob *job)
 {
-
 	BraseroVobPrivate *priv;
+	gdouble progress = 0.0;
 
 	priv = BRASERO_VOB_PRIVATE (job);
 
-	if (brasero_vob_get_progress_from_element (job, priv->pipeline))
+	if (priv->segments) {
+		if (!priv->pipeline) {
+			progress = brasero_vob_get_segments_progress (BRASERO_VOB (job));
+			brasero_job_set_progress (job, progress * SEGMENTS_PROGRESS);
+			return BRASERO_BURN_OK;
+		}
+
+		if (brasero_vob_get_progress_from_element (priv->pipeline, &progress)
+		||  brasero_vob_get_progress_from_element (priv->source, &progress))
+			brasero_job_set_progress (job, SEGMENTS_PROGRESS + progress * (1.0 - SEGMENTS_PROGRESS));
+
+		return BRASERO_BURN_OK;
+	}
+
+	if (!priv->pipeline)
 		return BRASERO_BURN_OK;
 
+	if (brasero_vob_get_progress_from_element (priv->pipeline, &progress)) {
+		brasero_job_set_progress (job, progress);
+		return BRASERO_BURN_OK;
+	}
+
 	BRASERO_JOB_LOG (job, "Pipeline failed to report position");
 
-	if (brasero_vob_get_progress_from_element (job, priv->source))
+	if (brasero_vob_get_progress_from_element (priv->source, &progress)) {
+		brasero_job_set_progress (job, progress);
 		return BRASERO_BURN_OK;
+	}
 
 	BRASERO_JOB_LOG (job, "Source failed to report position");
 
@@ -1309,7 +2098,20 @@ brasero_vob_clock_tick (BraseroJob *job)
 
 static void
 brasero_vob_init (BraseroVob *object)
-{}
+{
+	GSettings *settings;
+	BraseroVobPrivate *priv;
+
+	priv = BRASERO_VOB_PRIVATE (object);
+
+	/* load our "configuration" */
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	priv->parallel = g_settings_get_boolean (settings, BRASERO_KEY_VOB_PARALLEL);
+	priv->segment_length = (gint64) g_settings_get_int (settings, BRASERO_KEY_VOB_SEGMENT_LENGTH) * 60 * GST_SECOND;
+	g_object_unref (settings);
+
+	priv->processors = MAX (sysconf (_SC_NPROCESSORS_ONLN), 1);
+}
 
 static void
 brasero_vob_finalize (GObject *object)
@@ -1323,6 +2125,18 @@ brasero_vob_finalize (GObject *object)
 		priv->pipeline = NULL;
 	}
 
+	brasero_vob_segment_clear (BRASERO_VOB (object));
+
+	if (priv->audio_decoders) {
+		gst_plugin_feature_list_free (priv->audio_decoders);
+		priv->audio_decoders = NULL;
+	}
+
+	if (priv->video_decoders) {
+		gst_plugin_feature_list_free (priv->video_decoders);
+		priv->video_decoders = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1344,6 +2158,7 @@ brasero_vob_class_init (BraseroVobClass *klass)
 static void
 brasero_vob_export_caps (BraseroPlugin *plugin)
 {
+	BraseroPluginConfOption *parallel, *segment_length;
 	GSList *input;
 	GSList *output;
 
@@ -1392,6 +2207,18 @@ brasero_vob_export_caps (BraseroPlugin *plugin)
 	brasero_plugin_link_caps (plugin, output, input);
 	g_slist_free (output);
 	g_slist_free (input);
+
+	/* add some configure options */
+	parallel = brasero_plugin_conf_option_new (BRASERO_KEY_VOB_PARALLEL,
+						   _("Use all processors to convert videos"),
+						   BRASERO_PLUGIN_OPTION_BOOL);
+	segment_length = brasero_plugin_conf_option_new (BRASERO_KEY_VOB_SEGMENT_LENGTH,
+							 _("Minimum length of the parts of a video converted at the same time (in minutes):"),
+							 BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (segment_length, 1, 120);
+
+	brasero_plugin_conf_option_bool_add_suboption (parallel, segment_length);
+	brasero_plugin_add_conf_option (plugin, parallel);
 }
 
 G_MODULE_EXPORT void
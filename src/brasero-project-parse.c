@@ -30,12 +30,15 @@
 #  include <config.h>
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <glib/gi18n.h>
 
 #include <libxml/xmlerror.h>
 #include <libxml/xmlwriter.h>
+#include <libxml/xmlreader.h>
 #include <libxml/parser.h>
 #include <libxml/xmlstring.h>
 #include <libxml/uri.h>
@@ -64,46 +67,101 @@ brasero_project_invalid_project_dialog (const char *reason)
 			   GTK_MESSAGE_ERROR);
 }
 
+/**
+ * Project loading
+ *
+ * Projects are read with a streaming parser: the document is never loaded
+ * entirely in memory which matters for data projects with a lot of grafts.
+ */
+
+typedef struct _BraseroProjectLoad BraseroProjectLoad;
+struct _BraseroProjectLoad {
+	xmlTextReaderPtr reader;
+
+	gchar *label;
+	gchar *cover;
+};
+
+/* Moves the reader to the next child element of the element at @depth.
+ * Returns 1 if there is one, 0 once the element is finished and -1 on error */
+static gint
+_read_next_child (xmlTextReaderPtr reader,
+		  gint depth)
+{
+	gint res;
+
+	while ((res = xmlTextReaderRead (reader)) == 1) {
+		gint node_depth;
+
+		node_depth = xmlTextReaderDepth (reader);
+		if (node_depth <= depth)
+			return 0;
+
+		/* Skip text nodes and the contents of children */
+		if (node_depth == depth + 1
+		&&  xmlTextReaderNodeType (reader) == XML_READER_TYPE_ELEMENT)
+			return 1;
+	}
+
+	/* The document cannot end in the middle of an element */
+	return -1;
+}
+
+static gchar *
+_read_string (xmlTextReaderPtr reader)
+{
+	if (xmlTextReaderIsEmptyElement (reader))
+		return NULL;
+
+	return (gchar *) xmlTextReaderReadString (reader);
+}
+
 static GSList *
-_read_graft_point (xmlDocPtr project,
-		   xmlNodePtr graft,
+_read_graft_point (xmlTextReaderPtr reader,
 		   GSList *grafts)
 {
 	BraseroGraftPt *retval;
+	gint depth;
+	gint res;
 
 	retval = g_new0 (BraseroGraftPt, 1);
         grafts = g_slist_prepend (grafts, retval);
-	while (graft) {
-		if (!xmlStrcmp (graft->name, (const xmlChar *) "uri")) {
-			xmlChar *uri;
+
+	if (xmlTextReaderIsEmptyElement (reader))
+		return grafts;
+
+	depth = xmlTextReaderDepth (reader);
+	while ((res = _read_next_child (reader, depth)) == 1) {
+		const xmlChar *name;
+
+		name = xmlTextReaderConstName (reader);
+		if (!xmlStrcmp (name, (const xmlChar *) "uri")) {
+			gchar *uri;
 
 			if (retval->uri)
 				goto error;
 
-			uri = xmlNodeListGetString (project,
-						    graft->xmlChildrenNode,
-						    1);
-			retval->uri = g_uri_unescape_string ((char *)uri, NULL);
+			uri = _read_string (reader);
+			retval->uri = g_uri_unescape_string (uri, NULL);
 			g_free (uri);
 			if (!retval->uri)
 				goto error;
 		}
-		else if (!xmlStrcmp (graft->name, (const xmlChar *) "path")) {
+		else if (!xmlStrcmp (name, (const xmlChar *) "path")) {
 			if (retval->path)
 				goto error;
 
-			retval->path = (char *) xmlNodeListGetString (project,
-								      graft->xmlChildrenNode,
-								      1);
+			retval->path = _read_string (reader);
 			if (!retval->path)
 				goto error;
 		}
-		else if (graft->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		graft = graft->next;
 	}
 
+	if (res < 0)
+		goto error;
+
 	return grafts;
 
 error:
@@ -115,62 +173,75 @@ error:
 }
 
 static BraseroTrack *
-_read_data_track (xmlDocPtr project,
-		  xmlNodePtr item)
+_read_data_track (BraseroProjectLoad *load)
 {
 	BraseroTrackDataCfg *track;
-        GSList *grafts= NULL;
+        GSList *grafts = NULL;
         GSList *excluded = NULL;
+        GSList *restored = NULL;
+	gchar *icon_path = NULL;
+	GSList *iter;
+	gint depth;
+	gint res;
 
 	track = brasero_track_data_cfg_new ();
 
-	while (item) {
-		if (!xmlStrcmp (item->name, (const xmlChar *) "graft")) {
-			if (!(grafts = _read_graft_point (project, item->xmlChildrenNode, grafts)))
+	depth = xmlTextReaderDepth (load->reader);
+	res = xmlTextReaderIsEmptyElement (load->reader) ? 0:1;
+	while (res && (res = _read_next_child (load->reader, depth)) == 1) {
+		const xmlChar *name;
+
+		name = xmlTextReaderConstName (load->reader);
+		if (!xmlStrcmp (name, (const xmlChar *) "graft")) {
+			if (!(grafts = _read_graft_point (load->reader, grafts)))
 				goto error;
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "icon")) {
-			xmlChar *icon_path;
-
-			icon_path = xmlNodeListGetString (project,
-							  item->xmlChildrenNode,
-							  1);
+		else if (!xmlStrcmp (name, (const xmlChar *) "icon")) {
+			g_free (icon_path);
+			icon_path = _read_string (load->reader);
 			if (!icon_path)
 				goto error;
-
-			brasero_track_data_cfg_set_icon (track, (gchar *) icon_path, NULL);
-                        g_free (icon_path);
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "restored")) {
-			xmlChar *restored;
+		else if (!xmlStrcmp (name, (const xmlChar *) "restored")) {
+			gchar *uri;
 
-			restored = xmlNodeListGetString (project,
-							 item->xmlChildrenNode,
-							 1);
-			if (!restored)
+			uri = _read_string (load->reader);
+			if (!uri)
 				goto error;
 
-                        brasero_track_data_cfg_dont_filter_uri (track, (gchar *) restored);
-                        g_free (restored);
+			restored = g_slist_prepend (restored, uri);
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "excluded")) {
-			xmlChar *excluded_uri;
+		else if (!xmlStrcmp (name, (const xmlChar *) "excluded")) {
+			gchar *excluded_uri;
 
-			excluded_uri = xmlNodeListGetString (project,
-							     item->xmlChildrenNode,
-							     1);
+			excluded_uri = _read_string (load->reader);
 			if (!excluded_uri)
 				goto error;
 
-			excluded = g_slist_prepend (excluded, xmlURIUnescapeString ((char*) excluded_uri, 0, NULL));
+			excluded = g_slist_prepend (excluded, xmlURIUnescapeString (excluded_uri, 0, NULL));
 			g_free (excluded_uri);
 		}
-		else if (item->type == XML_ELEMENT_NODE)
+		else
 			goto error;
+	}
+
+	if (res < 0)
+		goto error;
 
-		item = item->next;
+	if (icon_path) {
+		brasero_track_data_cfg_set_icon (track, icon_path, NULL);
+		g_free (icon_path);
 	}
 
+	restored = g_slist_reverse (restored);
+	for (iter = restored; iter; iter = iter->next)
+		brasero_track_data_cfg_dont_filter_uri (track, iter->data);
+
+	g_slist_foreach (restored, (GFunc) g_free, NULL);
+	g_slist_free (restored);
+
+	/* All grafts are handed at once to the track which loads them in a
+	 * single pass. */
         grafts = g_slist_reverse (grafts);
         excluded = g_slist_reverse (excluded);
         brasero_track_data_set_source (BRASERO_TRACK_DATA (track),
@@ -180,38 +251,47 @@ _read_data_track (xmlDocPtr project,
 
 error:
 
+	g_free (icon_path);
+
         g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
         g_slist_free (grafts);
 
         g_slist_foreach (excluded, (GFunc) g_free, NULL);
         g_slist_free (excluded);
 
+        g_slist_foreach (restored, (GFunc) g_free, NULL);
+        g_slist_free (restored);
+
 	g_object_unref (track);
 
 	return NULL;
 }
 
 static BraseroTrack *
-_read_audio_track (xmlDocPtr project,
-		   xmlNodePtr uris,
+_read_audio_track (xmlTextReaderPtr reader,
                    gboolean is_video)
 {
 	BraseroTrackStreamCfg *track;
+	gint depth;
+	gint res;
 
 	track = brasero_track_stream_cfg_new ();
 
-	while (uris) {
-		if (!xmlStrcmp (uris->name, (const xmlChar *) "uri")) {
-			xmlChar *uri;
+	depth = xmlTextReaderDepth (reader);
+	res = xmlTextReaderIsEmptyElement (reader) ? 0:1;
+	while (res && (res = _read_next_child (reader, depth)) == 1) {
+		const xmlChar *name;
+
+		name = xmlTextReaderConstName (reader);
+		if (!xmlStrcmp (name, (const xmlChar *) "uri")) {
+			gchar *uri;
                         gchar *unescaped_uri;
 
-			uri = xmlNodeListGetString (project,
-						    uris->xmlChildrenNode,
-						    1);
+			uri = _read_string (reader);
 			if (!uri)
 				goto error;
 
-                        unescaped_uri = g_uri_unescape_string ((char *) uri, NULL);
+                        unescaped_uri = g_uri_unescape_string (uri, NULL);
                         g_free (uri);
 
 			/* Note: this must come before brasero_track_stream_set_boundaries ()
@@ -226,16 +306,14 @@ _read_audio_track (xmlDocPtr project,
 
                         g_free (unescaped_uri);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "silence")) {
+		else if (!xmlStrcmp (name, (const xmlChar *) "silence")) {
 			gchar *silence;
 
 			/* impossible to have two gaps in a row */
 			if (brasero_track_stream_get_gap (BRASERO_TRACK_STREAM (track)) > 0)
 				goto error;
 
-			silence = (gchar *) xmlNodeListGetString (project,
-								  uris->xmlChildrenNode,
-								  1);
+			silence = _read_string (reader);
 			if (!silence)
 				goto error;
 
@@ -245,12 +323,10 @@ _read_audio_track (xmlDocPtr project,
                                                              g_ascii_strtoull (silence, NULL, 10));
 			g_free (silence);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "start")) {
+		else if (!xmlStrcmp (name, (const xmlChar *) "start")) {
 			gchar *start;
 
-			start = (gchar *) xmlNodeListGetString (project,
-								uris->xmlChildrenNode,
-								1);
+			start = _read_string (reader);
 			if (!start)
 				goto error;
 
@@ -260,12 +336,10 @@ _read_audio_track (xmlDocPtr project,
                                                              -1);
 			g_free (start);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "end")) {
+		else if (!xmlStrcmp (name, (const xmlChar *) "end")) {
 			gchar *end;
 
-			end = (gchar *) xmlNodeListGetString (project,
-							      uris->xmlChildrenNode,
-							      1);
+			end = _read_string (reader);
 			if (!end)
 				goto error;
 
@@ -275,84 +349,42 @@ _read_audio_track (xmlDocPtr project,
                                                              -1);
 			g_free (end);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "title")) {
-			xmlChar *title;
-			gchar *unescaped_title;
-
-			title = xmlNodeListGetString (project,
-						      uris->xmlChildrenNode,
-						      1);
-			if (!title)
-				goto error;
-
-                        unescaped_title = g_uri_unescape_string ((char *) title, NULL);
-                        g_free (title);
-
-                        brasero_track_tag_add_string (BRASERO_TRACK (track),
-                                                      BRASERO_TRACK_STREAM_TITLE_TAG,
-                                                      unescaped_title);
-        		g_free (unescaped_title);
-		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "artist")) {
-			xmlChar *artist;
-                        gchar *unescaped_artist;
-
-			artist = xmlNodeListGetString (project,
-						      uris->xmlChildrenNode,
-						      1);
-			if (!artist)
+		else if (!xmlStrcmp (name, (const xmlChar *) "title")
+		     ||  !xmlStrcmp (name, (const xmlChar *) "artist")
+		     ||  !xmlStrcmp (name, (const xmlChar *) "composer")
+		     ||  !xmlStrcmp (name, (const xmlChar *) "isrc")) {
+			const gchar *tag;
+			gchar *unescaped;
+			gchar *value;
+
+			value = _read_string (reader);
+			if (!value)
 				goto error;
 
-			unescaped_artist = g_uri_unescape_string ((char *) artist, NULL);
-			g_free (artist);
+			unescaped = g_uri_unescape_string (value, NULL);
+			g_free (value);
 
-                        brasero_track_tag_add_string (BRASERO_TRACK (track),
-                                                      BRASERO_TRACK_STREAM_ARTIST_TAG,
-                                                      unescaped_artist);
-        		g_free (unescaped_artist);
-		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "composer")) {
-			xmlChar *composer;
-                        gchar *unescaped_composer;
-
-			composer = xmlNodeListGetString (project,
-							 uris->xmlChildrenNode,
-							 1);
-			if (!composer)
-				goto error;
-
-			unescaped_composer = g_uri_unescape_string ((char *) composer, NULL);
-			g_free (composer);
-
-                        brasero_track_tag_add_string (BRASERO_TRACK (track),
-                                                      BRASERO_TRACK_STREAM_COMPOSER_TAG,
-                                                      unescaped_composer);
-        		g_free (unescaped_composer);
-		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "isrc")) {
-			xmlChar *isrc;
-                        gchar *unescaped_isrc;
-
-			isrc = xmlNodeListGetString (project,
-						     uris->xmlChildrenNode,
-						     1);
-			if (!isrc)
-				goto error;
-
-			unescaped_isrc = g_uri_unescape_string ((char *) isrc, NULL);
-			g_free (isrc);
+			if (!xmlStrcmp (name, (const xmlChar *) "title"))
+				tag = BRASERO_TRACK_STREAM_TITLE_TAG;
+			else if (!xmlStrcmp (name, (const xmlChar *) "artist"))
+				tag = BRASERO_TRACK_STREAM_ARTIST_TAG;
+			else if (!xmlStrcmp (name, (const xmlChar *) "composer"))
+				tag = BRASERO_TRACK_STREAM_COMPOSER_TAG;
+			else
+				tag = BRASERO_TRACK_STREAM_ISRC_TAG;
 
                         brasero_track_tag_add_string (BRASERO_TRACK (track),
-                                                      BRASERO_TRACK_STREAM_ISRC_TAG,
-                                                      unescaped_isrc);
-        		g_free (unescaped_isrc);
+                                                      tag,
+                                                      unescaped);
+        		g_free (unescaped);
 		}
-		else if (uris->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		uris = uris->next;
 	}
 
+	if (res < 0)
+		goto error;
+
 	return BRASERO_TRACK (track);
 
 error:
@@ -363,50 +395,42 @@ error:
 }
 
 static gboolean
-_get_tracks (xmlDocPtr project,
-	     xmlNodePtr track_node,
+_get_tracks (BraseroProjectLoad *load,
 	     BraseroBurnSession *session)
 {
 	GSList *tracks = NULL;
 	GSList *iter;
+	gint depth;
+	gint res;
 
-	track_node = track_node->xmlChildrenNode;
+	if (xmlTextReaderIsEmptyElement (load->reader))
+		return FALSE;
 
-	while (track_node) {
+	depth = xmlTextReaderDepth (load->reader);
+	while ((res = _read_next_child (load->reader, depth)) == 1) {
 		BraseroTrack *newtrack;
+		const xmlChar *name;
+
+		name = xmlTextReaderConstName (load->reader);
+		if (!xmlStrcmp (name, (const xmlChar *) "audio"))
+			newtrack = _read_audio_track (load->reader, FALSE);
+		else if (!xmlStrcmp (name, (const xmlChar *) "data"))
+			newtrack = _read_data_track (load);
+		else if (!xmlStrcmp (name, (const xmlChar *) "video"))
+			newtrack = _read_audio_track (load->reader, TRUE);
+		else
+			goto error;
 
-		if (!xmlStrcmp (track_node->name, (const xmlChar *) "audio")) {
-			newtrack = _read_audio_track (project, track_node->xmlChildrenNode, FALSE);
-			if (!newtrack)
-				goto error;
-
-			tracks = g_slist_append (tracks, newtrack);
-		}
-		else if (!xmlStrcmp (track_node->name, (const xmlChar *) "data")) {
-			newtrack = _read_data_track (project, track_node->xmlChildrenNode);
-
-			if (!newtrack)
-				goto error;
-
-			tracks = g_slist_append (tracks, newtrack);
-		}
-		else if (!xmlStrcmp (track_node->name, (const xmlChar *) "video")) {
-			newtrack = _read_audio_track (project, track_node->xmlChildrenNode, TRUE);
-
-			if (!newtrack)
-				goto error;
-
-			tracks = g_slist_append (tracks, newtrack);
-		}
-		else if (track_node->type == XML_ELEMENT_NODE)
+		if (!newtrack)
 			goto error;
 
-		track_node = track_node->next;
+		tracks = g_slist_prepend (tracks, newtrack);
 	}
 
-	if (!tracks)
+	if (res < 0 || !tracks)
 		goto error;
 
+	tracks = g_slist_reverse (tracks);
 	for (iter = tracks; iter; iter = iter->next) {
 		BraseroTrack *newtrack;
 
@@ -434,14 +458,12 @@ brasero_project_open_project_xml (const gchar *uri,
 				  BraseroBurnSession *session,
 				  gboolean warn_user)
 {
-	xmlNodePtr track_node = NULL;
-	gchar *label = NULL;
-	gchar *cover = NULL;
-	xmlDocPtr project;
-	xmlNodePtr item;
+	BraseroProjectLoad load = { NULL, };
+	gboolean has_tracks = FALSE;
 	gboolean retval;
 	GFile *file;
 	gchar *path;
+	gint res;
 
 	file = g_file_new_for_commandline_arg (uri);
 	path = g_file_get_path (file);
@@ -450,98 +472,113 @@ brasero_project_open_project_xml (const gchar *uri,
 		return FALSE;
 
 	/* start parsing xml doc */
-	project = xmlParseFile (path);
-    	g_free (path);
-
-	if (!project) {
+	load.reader = xmlReaderForFile (path, NULL, 0);
+	if (!load.reader) {
+		g_free (path);
 	    	if (warn_user)
 			brasero_project_invalid_project_dialog (_("The project could not be opened"));
 
 		return FALSE;
 	}
 
+    	g_free (path);
+
 	/* parses the "header" */
-	item = xmlDocGetRootElement (project);
-	if (!item) {
-	    	if (warn_user)
-			brasero_project_invalid_project_dialog (_("The file is empty"));
+	do {
+		res = xmlTextReaderRead (load.reader);
+	} while (res == 1 && xmlTextReaderNodeType (load.reader) != XML_READER_TYPE_ELEMENT);
+
+	if (res != 1) {
+		xmlFreeTextReader (load.reader);
+
+		if (warn_user) {
+			if (res == 0)
+				brasero_project_invalid_project_dialog (_("The file is empty"));
+			else
+				brasero_project_invalid_project_dialog (_("The project could not be opened"));
+		}
 
-		xmlFreeDoc (project);
 		return FALSE;
 	}
 
-	if (xmlStrcmp (item->name, (const xmlChar *) "braseroproject")
-	||  item->next)
+	if (xmlStrcmp (xmlTextReaderConstName (load.reader), (const xmlChar *) "braseroproject")
+	||  xmlTextReaderIsEmptyElement (load.reader))
 		goto error;
 
-	item = item->children;
-	while (item) {
-		if (!xmlStrcmp (item->name, (const xmlChar *) "version")) {
+	while ((res = _read_next_child (load.reader, 0)) == 1) {
+		const xmlChar *name;
+
+		name = xmlTextReaderConstName (load.reader);
+		if (!xmlStrcmp (name, (const xmlChar *) "version")) {
 			/* simply ignore it */
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "label")) {
-			label = (gchar *) xmlNodeListGetString (project,
-								item->xmlChildrenNode,
-								1);
-			if (!(label))
+		else if (!xmlStrcmp (name, (const xmlChar *) "label")) {
+			g_free (load.label);
+			load.label = _read_string (load.reader);
+			if (!load.label)
 				goto error;
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "cover")) {
-			xmlChar *escaped;
+		else if (!xmlStrcmp (name, (const xmlChar *) "cover")) {
+			gchar *escaped;
 
-			escaped = xmlNodeListGetString (project,
-							item->xmlChildrenNode,
-							1);
+			escaped = _read_string (load.reader);
 			if (!escaped)
 				goto error;
 
-			cover = g_uri_unescape_string ((char *) escaped, NULL);
+			g_free (load.cover);
+			load.cover = g_uri_unescape_string (escaped, NULL);
 			g_free (escaped);
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "track")) {
-			if (track_node)
+		else if (!xmlStrcmp (name, (const xmlChar *) "track")) {
+			if (has_tracks)
 				goto error;
 
-			track_node = item;
+			has_tracks = TRUE;
+			if (!_get_tracks (&load, session))
+				goto error;
 		}
-		else if (item->type == XML_ELEMENT_NODE)
+		else
 			goto error;
+	}
 
-		item = item->next;
+	/* Nothing but comments can follow the root element */
+	while (res == 0 && (res = xmlTextReaderRead (load.reader)) == 1) {
+		if (xmlTextReaderNodeType (load.reader) == XML_READER_TYPE_ELEMENT)
+			goto error;
 	}
 
-	retval = _get_tracks (project, track_node, session);
-	if (!retval)
+	if (res < 0 || !has_tracks)
 		goto error;
 
-	xmlFreeDoc (project);
+	retval = TRUE;
+	xmlFreeTextReader (load.reader);
 
-        brasero_burn_session_set_label (session, label);
-        g_free (label);
+        brasero_burn_session_set_label (session, load.label);
+        g_free (load.label);
 
-        if (cover) {
+        if (load.cover) {
                 GValue *value;
 
                 value = g_new0 (GValue, 1);
                 g_value_init (value, G_TYPE_STRING);
-                g_value_set_string (value, cover);
+                g_value_set_string (value, load.cover);
                 brasero_burn_session_tag_add (session,
                                                BRASERO_COVER_URI,
                                                value);
 
-                g_free (cover);
+                g_free (load.cover);
         }
 
         return retval;
 
 error:
 
-	if (cover)
-		g_free (cover);
-	if (label)
-		g_free (label);
+	if (load.cover)
+		g_free (load.cover);
+	if (load.label)
+		g_free (load.label);
 
-	xmlFreeDoc (project);
+	xmlFreeTextReader (load.reader);
     	if (warn_user)
 		brasero_project_invalid_project_dialog (_("It does not seem to be a valid Brasero project"));
 
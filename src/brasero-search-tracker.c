@@ -25,6 +25,22 @@
 #include "brasero-search-tracker.h"
 #include "brasero-search-engine.h"
 
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_SEARCH_PAGE_SIZE	"search-page-size"
+
+#define BRASERO_SEARCH_TRACKER_PAGE_SIZE	500
+#define BRASERO_SEARCH_TRACKER_CACHE_SIZE	16
+
+/* In microseconds; files keep being indexed, so results get stale */
+#define BRASERO_SEARCH_TRACKER_CACHE_LIFETIME	(30 * G_USEC_PER_SEC)
+
+typedef struct _BraseroSearchTrackerCached BraseroSearchTrackerCached;
+struct _BraseroSearchTrackerCached
+{
+	GPtrArray *results;
+	gint64 time;
+};
+
 typedef struct _BraseroSearchTrackerPrivate BraseroSearchTrackerPrivate;
 struct _BraseroSearchTrackerPrivate
 {
@@ -37,7 +53,17 @@ struct _BraseroSearchTrackerPrivate
 	gchar **mimes;
 	gchar *keywords;
 
-	guint current_call_id;
+	/* Hits already received for the current page */
+	gint page_size;
+	gint page_hits;
+
+	/* Results of the last completed queries indexed by their
+	 * keywords, scope and mimes; they expire after a short while */
+	GHashTable *cache;
+	GQueue *cache_keys;
+
+	guint replay_id;
+	guint querying:1;
 };
 
 #define BRASERO_SEARCH_TRACKER_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_SEARCH_TRACKER, BraseroSearchTrackerPrivate))
@@ -128,6 +154,98 @@ brasero_search_tracker_score_from_hit (BraseroSearchEngine *engine,
 	return 0;
 }
 
+static void
+brasero_search_tracker_cached_free (BraseroSearchTrackerCached *cached)
+{
+	g_ptr_array_unref (cached->results);
+	g_free (cached);
+}
+
+static gchar *
+brasero_search_tracker_cache_key (BraseroSearchTrackerPrivate *priv)
+{
+	GString *key;
+
+	key = g_string_new (priv->keywords);
+	g_string_append_printf (key, "\x1f%i", priv->scope);
+	if (priv->mimes) {
+		gint i;
+
+		for (i = 0; priv->mimes [i]; i ++) {
+			g_string_append_c (key, '\x1f');
+			g_string_append (key, priv->mimes [i]);
+		}
+	}
+
+	return g_string_free (key, FALSE);
+}
+
+static void
+brasero_search_tracker_cache_results (BraseroSearchTracker *search)
+{
+	BraseroSearchTrackerCached *cached;
+	BraseroSearchTrackerPrivate *priv;
+	gchar *key;
+
+	priv = BRASERO_SEARCH_TRACKER_PRIVATE (search);
+	if (!priv->results)
+		return;
+
+	key = brasero_search_tracker_cache_key (priv);
+	if (g_hash_table_lookup (priv->cache, key)) {
+		g_free (key);
+		return;
+	}
+
+	/* Forget about the oldest query */
+	if (g_queue_get_length (priv->cache_keys) >= BRASERO_SEARCH_TRACKER_CACHE_SIZE) {
+		gchar *oldest;
+
+		oldest = g_queue_pop_head (priv->cache_keys);
+		g_hash_table_remove (priv->cache, oldest);
+	}
+
+	cached = g_new0 (BraseroSearchTrackerCached, 1);
+	cached->results = g_ptr_array_ref (priv->results);
+	cached->time = g_get_monotonic_time ();
+
+	/* The key is owned by the hash table */
+	g_hash_table_insert (priv->cache, key, cached);
+	g_queue_push_tail (priv->cache_keys, key);
+}
+
+static void
+brasero_search_tracker_finished (BraseroSearchTracker *search)
+{
+	BraseroSearchTrackerPrivate *priv;
+
+	priv = BRASERO_SEARCH_TRACKER_PRIVATE (search);
+	priv->querying = FALSE;
+
+	brasero_search_tracker_cache_results (search);
+	brasero_search_engine_query_finished (BRASERO_SEARCH_ENGINE (search));
+}
+
+static void
+brasero_search_tracker_error (BraseroSearchTracker *search,
+                              GError *error)
+{
+	BraseroSearchTrackerPrivate *priv;
+
+	/* The query was cancelled by a new one or by the
+	 * destruction of the object; don't touch anything. */
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	priv = BRASERO_SEARCH_TRACKER_PRIVATE (search);
+	priv->querying = FALSE;
+
+	brasero_search_engine_query_error (BRASERO_SEARCH_ENGINE (search), error);
+}
+
+static gboolean brasero_search_tracker_query_start_real (BraseroSearchEngine *search,
+							 gint index);
+
 static void brasero_search_tracker_cursor_callback (GObject      *object,
 						    GAsyncResult *result,
 						    gpointer      user_data);
@@ -150,40 +268,53 @@ brasero_search_tracker_cursor_callback (GObject      *object,
 					GAsyncResult *result,
 					gpointer      user_data)
 {
+	BraseroSearchTrackerPrivate *priv;
 	BraseroSearchEngine *search;
 	GError *error = NULL;
 	TrackerSparqlCursor *cursor;
-	GList *hits;
 	gboolean success;
+	gchar **hit;
+	gint i;
 
+	search = BRASERO_SEARCH_ENGINE (user_data);
 	cursor = TRACKER_SPARQL_CURSOR (object);
 	success = tracker_sparql_cursor_next_finish (cursor, result, &error);
 
 	if (error) {
-		brasero_search_engine_query_error (search, error);
+		brasero_search_tracker_error (BRASERO_SEARCH_TRACKER (search), error);
 		g_error_free (error);
+		g_object_unref (cursor);
+		return;
+	}
 
-		if (cursor) {
-			g_object_unref (cursor);
-		}
-
+	priv = BRASERO_SEARCH_TRACKER_PRIVATE (search);
+	if (!priv->querying || !priv->results) {
+		/* The query was stopped meanwhile */
+		g_object_unref (cursor);
 		return;
 	}
 
 	if (!success) {
-		brasero_search_engine_query_finished (search);
+		g_object_unref (cursor);
 
-		if (cursor) {
-			g_object_unref (cursor);
-		}
+		/* A full page means there could be more results */
+		if (priv->page_hits >= priv->page_size)
+			brasero_search_tracker_query_start_real (search, priv->results->len);
+		else
+			brasero_search_tracker_finished (BRASERO_SEARCH_TRACKER (search));
 
 		return;
 	}
 
-	/* We iterate result by result, not n at a time. */
-	hits = g_list_append (NULL, (gchar*) tracker_sparql_cursor_get_string (cursor, 0, NULL));
-	brasero_search_engine_hit_added (search, hits);
-	g_list_free (hits);
+	/* Hits are kept in the order they arrive: ?file ?url ?mime rank */
+	hit = g_new0 (gchar *, 5);
+	for (i = 0; i < 4; i ++)
+		hit [i] = g_strdup (tracker_sparql_cursor_get_string (cursor, i, NULL));
+
+	g_ptr_array_add (priv->results, hit);
+	priv->page_hits ++;
+
+	brasero_search_engine_hit_added (search, hit);
 
 	/* Get next */
 	brasero_search_tracker_cursor_next (search, cursor);
@@ -195,39 +326,29 @@ brasero_search_tracker_reply (GObject      *object,
 			      gpointer user_data)
 {
 	BraseroSearchEngine *search = BRASERO_SEARCH_ENGINE (user_data);
-	GError *error = NULL;
-	
 	TrackerSparqlCursor *cursor;
-	GList *hits;
-	gboolean success;
+	GError *error = NULL;
 
-	cursor = TRACKER_SPARQL_CURSOR (object);
-	success = tracker_sparql_cursor_next_finish (cursor, result, &error);
+	cursor = tracker_sparql_connection_query_finish (TRACKER_SPARQL_CONNECTION (object),
+							 result,
+							 &error);
+	if (error) {
+		brasero_search_tracker_error (BRASERO_SEARCH_TRACKER (search), error);
+		g_error_free (error);
 
-	if (cursor) {
-		g_object_unref (cursor);
-	}
+		if (cursor)
+			g_object_unref (cursor);
 
-	if (error) {
-		brasero_search_engine_query_error (search, error);
 		return;
 	}
 
-	if (!success) {
-		brasero_search_engine_query_finished (search);
-		
-		if (cursor) {
-			g_object_unref (cursor);
-		}
+	if (!cursor) {
+		brasero_search_tracker_finished (BRASERO_SEARCH_TRACKER (search));
 		return;
-    
 	}
 
-	hits = g_list_append (NULL, (gchar*) tracker_sparql_cursor_get_string (cursor, 0, NULL));
-	brasero_search_engine_hit_added (search, result);
-	g_list_free (hits);
-
-	brasero_search_engine_query_finished (search);
+	/* The cursor is released once all its hits were read */
+	brasero_search_tracker_cursor_next (search, cursor);
 }
 
 static gboolean
@@ -304,17 +425,19 @@ brasero_search_tracker_query_start_real (BraseroSearchEngine *search,
 					"  ?file fts:match \"%s\" ",		/* File must match possible keywords */
 					priv->keywords);
 
-	g_string_append (query,
-			 " } "
-			 "ORDER BY ASC(fts:rank(?file)) "
-			 "OFFSET 0 "
-			 "LIMIT 10000");
-
-	g_string_append (query, ")");
-
-	g_string_append (query,
-			 "} ORDER BY DESC(nie:url(?urn)) DESC(nfo:fileName(?urn))");
-
+	/* Results are requested one page at a time so that the first hits
+	 * are shown quickly; the next page is requested once this one has
+	 * been read. ?url is added to the ordering so that pages are stable. */
+	g_string_append_printf (query,
+				" } "
+				"ORDER BY ASC(fts:rank(?file)) ASC(?url) "
+				"OFFSET %i "
+				"LIMIT %i",
+				index,
+				priv->page_size);
+
+	priv->page_hits = 0;
+	priv->querying = TRUE;
 	tracker_sparql_connection_query_async (priv->connection,
 					       query->str,
 					       priv->cancellable,
@@ -325,9 +448,59 @@ brasero_search_tracker_query_start_real (BraseroSearchEngine *search,
 	return res;
 }
 
+static gboolean
+brasero_search_tracker_replay (gpointer data)
+{
+	BraseroSearchTracker *search = BRASERO_SEARCH_TRACKER (data);
+	BraseroSearchTrackerPrivate *priv;
+	guint i;
+
+	priv = BRASERO_SEARCH_TRACKER_PRIVATE (search);
+	priv->replay_id = 0;
+
+	for (i = 0; i < priv->results->len; i ++)
+		brasero_search_engine_hit_added (BRASERO_SEARCH_ENGINE (search),
+						 g_ptr_array_index (priv->results, i));
+
+	brasero_search_engine_query_finished (BRASERO_SEARCH_ENGINE (search));
+	return FALSE;
+}
+
 static gboolean
 brasero_search_tracker_query_start (BraseroSearchEngine *search)
 {
+	BraseroSearchTrackerCached *cached;
+	BraseroSearchTrackerPrivate *priv;
+	gchar *key;
+
+	priv = BRASERO_SEARCH_TRACKER_PRIVATE (search);
+
+	if (priv->results)
+		g_ptr_array_unref (priv->results);
+
+	/* The same query was run not long ago; signal its hits again
+	 * from the main loop as a real query would do. */
+	key = brasero_search_tracker_cache_key (priv);
+	cached = g_hash_table_lookup (priv->cache, key);
+	if (cached
+	&&  g_get_monotonic_time () - cached->time > BRASERO_SEARCH_TRACKER_CACHE_LIFETIME) {
+		GList *link;
+
+		/* Files may have been indexed or removed since */
+		link = g_queue_find_custom (priv->cache_keys, key, (GCompareFunc) g_strcmp0);
+		g_queue_delete_link (priv->cache_keys, link);
+		g_hash_table_remove (priv->cache, key);
+		cached = NULL;
+	}
+	g_free (key);
+
+	if (cached) {
+		priv->results = g_ptr_array_ref (cached->results);
+		priv->replay_id = g_idle_add (brasero_search_tracker_replay, search);
+		return TRUE;
+	}
+
+	priv->results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
 	return brasero_search_tracker_query_start_real (search, 0);
 }
 
@@ -345,7 +518,8 @@ brasero_search_tracker_add_hit_to_tree (BraseroSearchEngine *search,
 	if (!priv->results)
 		return FALSE;
 
-	for (i = range_start; g_ptr_array_index (priv->results, i) && i < range_end; i ++) {
+	range_end = MIN (range_end, priv->results->len);
+	for (i = range_start; i < range_end; i ++) {
 		gchar **hit;
 		GtkTreeIter row;
 
@@ -393,12 +567,22 @@ brasero_search_tracker_clean (BraseroSearchTracker *search)
 
 	priv = BRASERO_SEARCH_TRACKER_PRIVATE (search);
 
-	if (priv->current_call_id)
+	if (priv->querying) {
+		/* A cancelled GCancellable can't be reused */
 		g_cancellable_cancel (priv->cancellable);
+		g_object_unref (priv->cancellable);
+		priv->cancellable = g_cancellable_new ();
+		priv->querying = FALSE;
+	}
+
+	if (priv->replay_id) {
+		g_source_remove (priv->replay_id);
+		priv->replay_id = 0;
+	}
 
+	/* Results may still be referenced by the cache */
 	if (priv->results) {
-		g_ptr_array_foreach (priv->results, (GFunc) g_strfreev, NULL);
-		g_ptr_array_free (priv->results, TRUE);
+		g_ptr_array_unref (priv->results);
 		priv->results = NULL;
 	}
 
@@ -449,8 +633,23 @@ brasero_search_tracker_init (BraseroSearchTracker *object)
 {
 	BraseroSearchTrackerPrivate *priv;
 	GError *error = NULL;
+	GSettings *settings;
 
 	priv = BRASERO_SEARCH_TRACKER_PRIVATE (object);
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	priv->page_size = g_settings_get_int (settings, BRASERO_KEY_SEARCH_PAGE_SIZE);
+	g_object_unref (settings);
+
+	if (priv->page_size <= 0)
+		priv->page_size = BRASERO_SEARCH_TRACKER_PAGE_SIZE;
+
+	priv->cache = g_hash_table_new_full (g_str_hash,
+					     g_str_equal,
+					     g_free,
+					     (GDestroyNotify) brasero_search_tracker_cached_free);
+	priv->cache_keys = g_queue_new ();
+
 	priv->cancellable = g_cancellable_new ();
 	priv->connection = tracker_sparql_connection_get (priv->cancellable, &error);
 
@@ -458,11 +657,13 @@ brasero_search_tracker_init (BraseroSearchTracker *object)
 		g_warning ("Could not establish a connection to Tracker: %s", error->message);
 		g_error_free (error);
 		g_object_unref (priv->cancellable);
+		priv->cancellable = NULL;
 		
 		return;
 	} else if (!priv->connection) {
 		g_warning ("Could not establish a connection to Tracker, no TrackerSparqlConnection was returned");
 		g_object_unref (priv->cancellable);
+		priv->cancellable = NULL;
 		
 		return;
 	}
@@ -477,6 +678,21 @@ brasero_search_tracker_finalize (GObject *object)
 
 	brasero_search_tracker_clean (BRASERO_SEARCH_TRACKER (object));
 
+	if (priv->cancellable) {
+		g_object_unref (priv->cancellable);
+		priv->cancellable = NULL;
+	}
+
+	if (priv->cache) {
+		g_hash_table_destroy (priv->cache);
+		priv->cache = NULL;
+	}
+
+	if (priv->cache_keys) {
+		g_queue_free (priv->cache_keys);
+		priv->cache_keys = NULL;
+	}
+
 	if (priv->connection) {
 		g_object_unref (priv->connection);
 		priv->connection = NULL;